@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+
+// Sends one note-off; false if it couldn't be sent (the note stays tracked)
+typedef bool (*NoteReleaseFunction)(uint8_t note, uint8_t channel);
+
+/**
+ * Every note this unit has switched on and not yet off: one 128-bit set per
+ * MIDI channel, plus how many note-ons hold each note (2.25 KB in all).
+ *
+ * Panic and settings changes release exactly what is sounding instead of
+ * blasting All Notes Off on every channel, and a note-off for a note that
+ * isn't on can be skipped. Two sensors on one channel can play the same
+ * note; it only goes off on the wire when the last of them releases it.
+ */
+class ActiveNotes {
+public:
+    // channel 1-16, note 0-127; anything else is ignored. Each note-on adds
+    // an owner, each note-off takes one away
+    void noteOn(uint8_t channel, uint8_t note);
+    void noteOff(uint8_t channel, uint8_t note);
+    bool isOn(uint8_t channel, uint8_t note) const;
+    // Note-ons holding the note (0 = off)
+    uint8_t owners(uint8_t channel, uint8_t note) const;
+
+    // Notes sounding on one channel / on all channels
+    uint8_t count(uint8_t channel) const;
+    uint16_t count() const;
+
+    // Send a note-off for every sounding note (on one channel), lowest channel
+    // and note first, whatever its owners; returns how many were released
+    uint16_t releaseAll(NoteReleaseFunction release);
+    uint16_t releaseChannel(uint8_t channel, NoteReleaseFunction release);
+
+private:
+    uint32_t notes[16][4] = {{0}};
+    uint8_t ownerCount[16][128] = {{0}};
+};
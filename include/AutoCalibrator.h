@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "ColorEnum.h"
+#include "ColorInfo.h"
+
+// One calibrated reading captured while the disk spins
+struct ColorSample {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+};
+
+/**
+ * Rotation-based auto-calibration for one sensor.
+ *
+ * Record a revolution or two of calibrated readings with addSample(), in
+ * disk order, then cluster() drops the readings taken across patch
+ * boundaries, groups the rest into NUM_COLORS clusters with k-means seeded
+ * from a reference database (normally colorCalibrationDefaultDatabase) and
+ * maps each cluster back to a Color. Clusters that were never seen (patch missing from
+ * this ring) are flagged so the caller can keep the old centroid.
+ *
+ * No hardware access in here, so it can be fed recorded revolutions off-device.
+ */
+class AutoCalibrator {
+public:
+    void reset();
+
+    // Store one reading; returns false once the buffer is full
+    bool addSample(float r, float g, float b);
+    uint16_t sampleCount() const; // after cluster(): less boundaryCount()
+    const ColorSample& sample(uint16_t i) const { return samples[i]; }
+    // Readings cluster() dropped as taken across a patch boundary
+    uint16_t boundaryCount() const { return boundaryReadings; }
+
+    /**
+     * Run k-means on the recorded samples.
+     * @param seeds     starting centroids, indexed by Color
+     * @param centroids result centroids, indexed by Color (unseen colors keep their seed)
+     * @param counts    samples assigned to each color (0 = color not seen)
+     * @return number of k-means iterations used (0 if there were no samples)
+     */
+    uint8_t cluster(const ColorCalibration seeds[NUM_COLORS],
+                    ColorCalibration centroids[NUM_COLORS],
+                    uint16_t counts[NUM_COLORS]);
+
+private:
+    ColorSample samples[AUTO_CAL_MAX_SAMPLES];
+    uint16_t numSamples = 0;
+    uint16_t boundaryReadings = 0;
+
+    static float distanceSq(const ColorSample& s, const float c[3]);
+
+    // Remove readings far from both neighbours (blends of two patches)
+    void dropBoundaryReadings();
+
+    // Move every seed by the median shift of the clusters that found their
+    // patch; false if too few did
+    bool shiftSeeds(const ColorCalibration seeds[NUM_COLORS], float centers[][3],
+                    const uint16_t clusterSize[]) const;
+
+    // Lloyd iterations until assignments stop changing; fills clusterSize
+    uint8_t runKMeans(float centers[][3], uint8_t assignment[],
+                      uint16_t clusterSize[], uint8_t maxIterations);
+
+    // Try splitting cluster k in two; returns split SSE / unsplit SSE (1 = no split)
+    float splitRatio(uint8_t k, const float center[3], const uint8_t assignment[],
+                     float a[3], float b[3]) const;
+};
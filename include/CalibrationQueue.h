@@ -0,0 +1,113 @@
+#pragma once
+#include <Arduino.h>
+#include "ColorEnum.h"
+#include "SystemConfig.h"
+
+/**
+ * One calibration action. The first twelve values line up with the rows of the
+ * per-sensor calibration submenu ("No-Op", "Dark Offset", "Gains", colors...,
+ * "Reset Defaults"), so a submenu index can be cast straight to a step.
+ * Replaces the old PendingCalibrationA..D enums.
+ */
+enum class CalibrationStep : uint8_t {
+    NONE = 0,
+    DARK_OFFSET,
+    GAINS,
+    RED,
+    GREEN,
+    PURPLE,
+    BLUE,
+    ORANGE,
+    YELLOW,
+    SILVER,
+    WHITE,
+    RESET_DEFAULTS,
+    TRANSFER_FROM_A, // map sensor A's centroids onto the masked sensors via their reference colors
+    AUTO_ROTATION    // record the spinning disk and cluster it into every centroid at once
+};
+
+// Bit i set = sensor i (0=A, 1=B, ...)
+typedef uint64_t SensorMask;
+static_assert(MAX_SENSORS <= 64, "SensorMask has one bit per sensor");
+#define ALL_SENSORS_MASK ((NUM_SENSORS >= 64) ? ~(SensorMask)0 : (((SensorMask)1 << NUM_SENSORS) - 1))
+
+inline SensorMask sensorBit(uint8_t sensor) {
+    return (SensorMask)1 << sensor;
+}
+
+/**
+ * A queued calibration. One job covers every sensor in its mask, so all of
+ * those sensors are sampled in the same pass while the patch sits under them.
+ */
+struct CalibrationJob {
+    CalibrationStep step;
+    SensorMask sensorMask;
+};
+
+/**
+ * Get the color centroid a step writes to
+ * @return Color for RED..WHITE steps, UNKNOWN otherwise
+ */
+Color calibrationStepToColor(CalibrationStep step);
+
+/**
+ * Get the calibration step that writes a color centroid
+ */
+CalibrationStep colorToCalibrationStep(Color color);
+
+/**
+ * Get the patch the operator has to place under the sensors for a step.
+ * GAINS uses the white patch; steps that don't sample a patch return UNKNOWN.
+ */
+Color calibrationStepPatch(CalibrationStep step);
+
+/**
+ * Short display name for a step (for the queue screen and debug output)
+ */
+const char* calibrationStepName(CalibrationStep step);
+
+/**
+ * Fixed-size FIFO of calibration jobs.
+ *
+ * Queuing a step that is already waiting in the queue just ORs the new sensors
+ * into the existing job, so "Red on A" + "Red on C" becomes one pass over A and C.
+ */
+class CalibrationQueue {
+public:
+    // Add a job at the back (merging with a pending job of the same step)
+    bool enqueue(CalibrationStep step, SensorMask sensorMask);
+
+    // Add a job at the front so it runs next (used by "run now" from a submenu)
+    bool enqueueFront(CalibrationStep step, SensorMask sensorMask);
+
+    // Queue white gains followed by every color centroid for the given sensors
+    void enqueueFullPass(SensorMask sensorMask);
+
+    /**
+     * Queue white gains + white for the given sensors, then the reference
+     * colors (bit i = indexToColor(i)), then a transfer from A. New gains
+     * forget every centroid measured before them, so color jobs already
+     * waiting for these sensors are taken out and measured after white as
+     * references too.
+     */
+    void enqueueTransferPass(SensorMask sensorMask, uint8_t referenceColors);
+
+    bool peek(CalibrationJob& job) const;
+    bool pop(CalibrationJob& job);
+    void clear();
+
+    uint8_t size() const;
+    bool isEmpty() const;
+
+private:
+    // Take `sensorMask` out of every waiting color job except white, dropping
+    // jobs left empty; returns the colors it found (bit i = indexToColor(i))
+    uint8_t takeColorJobs(SensorMask sensorMask);
+    // Like enqueue(), but only merge with a job at `position` or later;
+    // `position` moves past the job used
+    bool enqueueFrom(uint8_t& position, CalibrationStep step, SensorMask sensorMask);
+
+    CalibrationJob jobs[CALIBRATION_QUEUE_CAPACITY];
+    uint8_t head = 0;
+    uint8_t count = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "ColorInfo.h"
+
+// How much of the mapping could be solved from the reference colors available
+enum class TransferModel : uint8_t {
+    NONE = 0,      // no usable reference, nothing transferred
+    SCALE,         // 1 reference (white): per-channel gain
+    SCALE_OFFSET,  // 2+ references spread out on every channel: per-channel gain + offset
+    AFFINE         // TRANSFER_AFFINE_MIN_REFERENCES+ spanning color space: full 3x3 matrix + offset
+};
+
+/**
+ * Maps a centroid measured on one sensor into another sensor's calibrated
+ * space: out = matrix * in + offset.
+ */
+struct AffineMap {
+    float matrix[3][3];
+    float offset[3];
+
+    void setIdentity();
+    ColorCalibration apply(const ColorCalibration& in) const;
+};
+
+/**
+ * Solve the mapping from a fully calibrated source sensor to a target sensor
+ * from the colors calibrated on both (at least white).
+ * No hardware access, so it can be checked off-device.
+ *
+ * @param source      source sensor centroids, indexed by Color
+ * @param target      target sensor centroids, indexed by Color
+ * @param isReference colors actually measured on the target
+ * @param map         result (identity if nothing could be solved)
+ * @return model used; richer models fall back to simpler ones when the
+ *         references are too close together to pin them down
+ */
+TransferModel solveCalibrationTransfer(const ColorCalibration source[NUM_COLORS],
+                                       const ColorCalibration target[NUM_COLORS],
+                                       const bool isReference[NUM_COLORS],
+                                       AffineMap& map);
+
+const char* transferModelName(TransferModel model);
@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "SampleHistory.h"
+
+enum ColorCcParam : uint8_t {
+    COLOR_CC_HUE = 0,
+    COLOR_CC_SATURATION,
+    COLOR_CC_BRIGHTNESS,
+    COLOR_CC_PARAMS
+};
+
+// Sends one controller value (0-16383); wide = as a 14-bit MSB/LSB pair,
+// otherwise only the top 7 bits
+typedef bool (*ColorCcSendCallback)(uint8_t control, uint16_t value, bool wide, uint8_t channel);
+
+/**
+ * Streams each sensor's calibrated reading as continuous controllers: hue,
+ * saturation and brightness, on controllers COLOR_CC_FIRST_CONTROL + 3 *
+ * sensor onwards, on the sensor's MIDI channel.
+ *
+ * Values are worked out at 14 bits and only sent once they have moved
+ * COLOR_CC_THRESHOLD from the value last sent (hue measured around the
+ * circle). Each sensor sends at most one update per interval: at least
+ * COLOR_CC_MIN_INTERVAL_MS, and long enough that every active sensor
+ * updating all three controllers fits in MIDI_TX_CC_SHARE_PERCENT of the
+ * wire. The transmit queue's governor enforces that share as well; pacing
+ * here keeps the sensors' updates evenly spread instead of coalesced away
+ * by whoever queued last.
+ */
+class ColorCcStream {
+public:
+    /**
+     * A new reading of `sensor` is in `history`: send whatever moved.
+     * @param activeSensors sensors in the scan, for the bandwidth pacing
+     */
+    void update(uint8_t sensor, const SampleRing& history, uint8_t channel, uint8_t activeSensors,
+                unsigned long nowMs, ColorCcSendCallback send);
+
+    // Send every controller of `sensor` on its next reading (new channel, say)
+    void resend(uint8_t sensor);
+
+    // Controller number for a sensor's parameter, 0xFF if it runs out of range
+    static uint8_t controlFor(uint8_t sensor, ColorCcParam param);
+    // Calibrated RGB and raw clear to hue, saturation, brightness (0-16383)
+    static void toHsb(uint16_t r, uint16_t g, uint16_t b, uint16_t clear, uint16_t hsb[COLOR_CC_PARAMS]);
+    // Shortest update interval per sensor for this many active sensors
+    static uint32_t intervalMs(uint8_t activeSensors);
+
+    // Values sent, moves below the threshold, and updates held back by the rate cap
+    uint32_t sent() const { return sentCount; }
+    uint32_t belowThreshold() const { return belowCount; }
+    uint32_t rateLimited() const { return limitedCount; }
+
+private:
+    uint16_t lastSent[NUM_SENSORS][COLOR_CC_PARAMS] = {{0}};
+    uint8_t sentMask[NUM_SENSORS] = {0};  // bit per parameter: lastSent is valid
+    unsigned long lastUpdateMs[NUM_SENSORS] = {0};
+    uint32_t sentCount = 0;
+    uint32_t belowCount = 0;
+    uint32_t limitedCount = 0;
+};
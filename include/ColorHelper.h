@@ -5,6 +5,9 @@
 #include "PinDefinitions.h"
 #include "ColorEnum.h"
 #include "ColorInfo.h"
+#include "CalibrationTransfer.h"
+#include "SensorHealth.h"
+#include "SampleHistory.h"
 
 /*
       case 0:
@@ -69,50 +72,140 @@ extern ColorCalibration colorCalibrationDefaultDatabase[NUM_COLORS];
 
 class MenuManager;
 
+// Streaming statistics for one calibration pass (Welford mean/variance, so no
+// sums that can overflow). Kept outside the sensor so several sensors can be
+// sampled in lockstep while the same patch is under all of them.
+struct CalibrationAccumulator {
+    float mean[3] = {};
+    float m2[3] = {};
+    uint16_t count = 0;
+    uint16_t rejected = 0;
+    uint16_t failed = 0; // I2C reads that failed, left out (see ColorHelper::sampleCalibrated)
+    uint8_t consecutiveRejects = 0;
+
+    // Add one reading; returns false if it was rejected as an outlier
+    bool add(float r, float g, float b);
+    void average(uint16_t* avgR, uint16_t* avgG, uint16_t* avgB) const;
+    // Sample variance per channel (0 with fewer than two samples)
+    void variance(float* varR, float* varG, float* varB) const;
+    // RMS of the three channel std devs, saturated to fit a uint16
+    uint16_t spread() const;
+    // True once the confidence interval on every channel's mean is narrow enough
+    bool converged() const;
+};
+
+// Stored spread for a centroid that was never measured; a stored 0 (never
+// written) loads as this too
+#define CALIBRATION_SPREAD_UNKNOWN 0xFFFF
+
 class ColorHelper {
 public:
     ColorHelper(bool normalizeReadings = true, MenuManager* menuPtr = nullptr);
     void setMenu(MenuManager* menuPtr);
+    // Ring that getCurrentColorEnum() records every good reading into (optional)
+    void setHistory(SampleRing* ring);
     // Initialize the color sensor
     bool begin();
     // Get the currently detected color enum (EFFICIENT!)
     Color getCurrentColorEnum();
     // Get the currently detected color name (for backwards compatibility)
     const char* getCurrentColor();
-    // Get raw color readings
-    void getRawData(uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* c);
+    // Get raw color readings; false (and all zeros) on an I2C error
+    bool getRawData(uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* c);
     // Get normalized color readings (0.0 - 1.0)
     void getNormalizedData(float* r, float* g, float* b);
 
-    // Get data using new calibration scheme
-    void getCalibratedData(float* r, float* g, float* b);
+    // Get data using new calibration scheme; false on an I2C error (the
+    // values are then from zeros, not a reading)
+    bool getCalibratedData(float* r, float* g, float* b);
 
     // Check if sensor is available
     bool isAvailable() const;
+    // Taken out of / put back into service by the sensor health checks
+    void setAvailable(bool available);
+
+    // Re-probe steps for a sensor that dropped out, each a short transaction
+    // instead of the library's begin() with its power-up and integration delays
+    // (see SensorHealth). Talk to the sensor behind the currently selected mux channel.
+    ProbeResult probe();             // check the ID, configure, power on
+    ProbeResult enableConversions(); // start the ADC (SENSOR_POWER_ON_MS after probe)
+    ProbeResult conversionReady();   // PENDING until the first reading is complete
 
     // Set or update the color database (copy up to NUM_COLORS entries)
     void setColorDatabase(const ColorCalibration db[], int numColors);
 
     void getSamplesAverage(uint16_t* avgR, uint16_t* avgG, uint16_t* avgB);
 
+    // Sample this sensor until the mean settles (or NUM_CALIBRATION_STEPS);
+    // white = clear-normalized raw readings for the white reference
+    void getSamplesStats(CalibrationAccumulator& acc, bool white);
+
     void calibrateWhiteGains(); // Calibration function prototype
 
     void calibrateDark();
     
     void calibrateColor(Color color);
 
+    // Calibration building blocks (used by the calibration job queue to sample
+    // several sensors in one pass). The apply/reset functions EEPROM.put their
+    // results but leave EEPROM.commit() to the caller.
+    // Each takes one reading into `acc`; a failed read only counts in acc.failed
+    // (its zeros would drag the mean before the outlier gate has a spread to go on)
+    bool sampleCalibrated(CalibrationAccumulator& acc); // dark/gain/clear-corrected reading
+    bool sampleWhite(CalibrationAccumulator& acc);      // clear-normalized raw reading for the white reference
+    void applyWhiteCalibration(uint16_t avgRw, uint16_t avgGw, uint16_t avgBw,
+                               uint16_t spread = CALIBRATION_SPREAD_UNKNOWN);
+    void applyColorCalibration(Color color, uint16_t avgR, uint16_t avgG, uint16_t avgB,
+                               uint16_t spread = CALIBRATION_SPREAD_UNKNOWN);
+    void resetCalibrationDefaults();
+
+    /**
+     * Fill in this sensor's centroids from a fully calibrated source sensor.
+     * Colors measured on this sensor (known spread - at least white) are kept
+     * and used as references to solve the mapping; every other centroid is the
+     * source centroid pushed through that mapping. Dark offset and gains stay
+     * this sensor's own. Recalibrating those forgets the references (the
+     * centroids were measured under the old ones), so the references have to
+     * be measured after them: CalibrationQueue::enqueueTransferPass() queues
+     * gains, white, the reference colors and then the transfer, in that order.
+     * EEPROM.puts the result, caller commits.
+     */
+    TransferModel transferCalibrationFrom(const ColorHelper& source);
+
+    // Read/write this sensor's dark offset, white reference, centroids and
+    // spreads from its EEPROM block (selected by SensorNum; save doesn't commit)
+    void loadCalibration();
+    void saveCalibration();
+
+    // Read/write this sensor's spreads in EEPROM (save doesn't commit)
+    void loadCalibrationSpread();
+    void saveCalibrationSpread();
+    // Mark every centroid as not measured under the current dark/gains (puts, doesn't commit)
+    void forgetColorSpreads();
+
+    // Recompute rGain/gGain/bGain from rW/gW/bW
+    void updateGains();
+
     // ColorCenter* colorDatabase = nullptr;
     ColorCalibration calibrationDatabase[NUM_COLORS];
 
+    // Sample std dev behind each centroid / the white reference, in the same
+    // counts as the centroids (CALIBRATION_SPREAD_UNKNOWN if not measured)
+    uint16_t calibrationSpread[NUM_COLORS];
+    uint16_t whiteSpread = CALIBRATION_SPREAD_UNKNOWN;
+
   //default values gotten from sensor A -- actually got all zeroes
   uint32_t rDark = 0;
   uint32_t gDark = 0;
   uint32_t bDark = 0;
 
   // default white calibration values (from sensor A)
-  uint32_t rW = 24519u;
-  uint32_t gW = 24150u;
-  uint32_t bW = 14495u;
+  static constexpr uint32_t DEFAULT_RW = 24519u;
+  static constexpr uint32_t DEFAULT_GW = 24150u;
+  static constexpr uint32_t DEFAULT_BW = 14495u;
+  uint32_t rW = DEFAULT_RW;
+  uint32_t gW = DEFAULT_GW;
+  uint32_t bW = DEFAULT_BW;
 
   // Use floating-point gains so we don't lose fractional precision
   float avgW = (rW + gW + bW) / 3.0f;
@@ -124,15 +217,28 @@ public:
 
 
     
+    // Wire status of the last getRawData() (0 = ok)
+    uint8_t lastI2CError = 0;
+    // Consecutive identical raw readings. The ADC noise alone moves a working
+    // sensor by a count or two, so a long run means it stopped converting.
+    uint16_t rawRepeats = 0;
+
+    // How clearly the last reading matched: 1 - nearest/second-nearest distance.
+    // 0 = halfway between two colors, 1 = right on a centroid
+    float lastMargin = 1.0f;
+
 private:
     Adafruit_TCS34725 tcs;
     bool normalize;
     MenuManager* menu = nullptr;
+    SampleRing* history = nullptr;
     bool sensorAvailable;
+    uint16_t lastRaw[4] = {0}; // c, r, g, b of the previous read, for rawRepeats
 
     // Internal color database access
     void* getColorDatabase(int& numColors);
     // Find nearest color match (returns enum - EFFICIENT!)
+    // Also sets lastMargin
     Color findNearestColorEnum(float r, float g, float b);
     // Find nearest color match (returns string - for backwards compatibility)
     const char* findNearestColor(float r, float g, float b);
@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "ColorEnum.h"
+
+/**
+ * Measures how long the disk takes to go round, from the color changes the
+ * sensors report, so the MIDI clock can follow the spin.
+ *
+ * The pattern on a ring comes back once per revolution, so the same change
+ * (say RED -> BLUE) on the same sensor comes back one revolution later. Each
+ * repeat gives a candidate period; the estimate is the value most of the
+ * last DISK_TEMPO_CANDIDATES candidates agree on (within
+ * DISK_TEMPO_TOLERANCE_PERCENT), which throws out the odd misread and the
+ * short gaps from a change that appears twice on one ring. A ring whose
+ * pattern repeats exactly within a turn measures that repeat instead.
+ *
+ * Only the first DISK_TEMPO_SENSORS sensors take part (1 KB of timestamps at
+ * four). No hardware access, so it can be fed recorded changes off-device.
+ */
+class DiskTempo {
+public:
+    void colorChange(uint8_t sensor, Color from, Color to, unsigned long nowMs);
+
+    // Revolution period in ms; 0 until enough candidates agree, or once the
+    // disk has stopped changing for three periods
+    uint32_t revolutionMs(unsigned long nowMs) const;
+    // DISK_TEMPO_BEATS_PER_REV beats per revolution; 0 when not locked
+    float bpm(unsigned long nowMs) const;
+
+private:
+    uint32_t lastSeen[DISK_TEMPO_SENSORS][NUM_COLORS][NUM_COLORS] = {{{0}}}; // ms of the last from -> to, 0 = never
+    uint16_t candidates[DISK_TEMPO_CANDIDATES] = {0};
+    uint8_t candidateCount = 0;
+    uint8_t nextCandidate = 0;
+    uint32_t estimateMs = 0;
+    unsigned long lastCandidateMs = 0;
+
+    void estimate();
+};
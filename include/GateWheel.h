@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+// A note event waiting for its time (see GateWheel)
+struct GateEvent {
+    uint8_t note;
+    uint8_t channel;  // 1-16
+    uint8_t velocity;
+    bool on;          // note-on (a ratchet repeat) or note-off
+    uint8_t repeats;  // note-on: repeats still to come after this one
+    uint8_t seq;      // owner's tag, e.g. which note-on this belongs to
+    bool gated;       // note-on: its note-off is scheduled when it goes out
+};
+
+// Called for each event that falls due
+typedef void (*GateFireFunction)(const GateEvent& event, void* context);
+
+/**
+ * Hashed timer wheel: GATE_WHEEL_SLOTS lists, one per tick, and each event
+ * goes in the list for its due tick modulo the wheel. An event further away
+ * than one turn of the wheel waits in its list for the number of turns
+ * left (`rounds`). Insert is O(1), and each tick only looks at one list, so
+ * the cost doesn't grow with the number of events pending elsewhere.
+ *
+ * Events live in a fixed pool of GATE_MAX_EVENTS, linked by index; a full
+ * pool refuses the new event and counts it. No hardware access and no
+ * locking: one task owns it, and it can be driven off-device.
+ */
+class GateWheel {
+public:
+    GateWheel();
+
+    // Due `delayTicks` after the current tick (0 counts as 1: the next tick)
+    bool schedule(uint32_t delayTicks, const GateEvent& event);
+
+    // Move the wheel on to `tick`, firing everything due on the way, in tick
+    // order (same-tick events in the order they were scheduled)
+    void advanceTo(uint32_t tick, GateFireFunction fire, void* context);
+
+    // Fire every pending event now, slot by slot from the next tick, and
+    // empty the wheel (`fire` must not schedule)
+    void flush(GateFireFunction fire, void* context);
+
+    uint32_t now() const { return currentTick; }
+    uint16_t pending() const { return pendingCount; }
+
+    // Statistics
+    uint16_t maxPending() const { return pendingMax; }
+    uint32_t overflows() const { return overflowCount; } // pool full
+    void resetMaxima() { pendingMax = pendingCount; }
+
+private:
+    static const uint8_t NONE = 0xFF;
+
+    struct Node {
+        GateEvent event;
+        uint16_t rounds; // whole turns of the wheel still to wait
+        uint8_t next;    // NONE = end of list
+    };
+
+    Node nodes[GATE_MAX_EVENTS];
+    uint8_t head[GATE_WHEEL_SLOTS]; // first node due in this slot
+    uint8_t tail[GATE_WHEEL_SLOTS]; // last, so a list keeps scheduling order
+    uint8_t freeList = NONE;
+    uint32_t currentTick = 0;
+    uint16_t pendingCount = 0;
+    uint16_t pendingMax = 0;
+    uint32_t overflowCount = 0;
+
+    void expireSlot(uint16_t slot, GateFireFunction fire, void* context);
+    void append(uint16_t slot, uint8_t index);
+};
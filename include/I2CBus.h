@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+/**
+ * The shared I2C bus (OLED, muxes, color sensors).
+ *
+ * Every transaction is bounded by I2C_TIMEOUT_MS, so a device holding the bus
+ * costs at most that per access instead of freezing loop().
+ */
+
+// Start Wire on the OLED pins at I2C_CLOCK_HZ with the transaction timeout
+void beginI2CBus();
+
+// True if SDA or SCL is being held low while the bus should be idle
+bool i2cBusHeld();
+
+/**
+ * Recover a stuck bus: a slave interrupted mid-byte can hold SDA low forever.
+ * Clocks SCL by hand (up to 9 pulses) until SDA is released, sends a STOP and
+ * restarts Wire. Muxes may have seen garbage, so the caller should reset them.
+ * @return true if both lines are high afterwards
+ */
+bool clearI2CBus();
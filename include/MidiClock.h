@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "SystemConfig.h"
+#include "MidiTxQueue.h"
+
+/**
+ * MIDI clock output, 24 ticks per quarter note, timed by a hardware timer.
+ *
+ * The timer interrupt hands each tick to the transmit queue, which sends it
+ * ahead of everything else and keeps the wire clear just before a tick is
+ * due (see MidiTxQueue). Nothing in loop() - rendering, sensor reads, EEPROM
+ * writes - can move a tick.
+ *
+ * A tempo change takes effect from the next tick: the interrupt loads the
+ * new period right after its own alarm, when the counter has just restarted.
+ */
+class MidiClock {
+public:
+    explicit MidiClock(MidiTxQueue& queue);
+
+    // Set up the timer (stopped)
+    void begin();
+
+    // MIDI_CLOCK_MIN_BPM to MIDI_CLOCK_MAX_BPM; clamped
+    void setTempo(float bpm);
+    float tempo() const { return bpmSetting; }
+
+    void start();
+    void stop();
+    bool running() const { return isRunning; }
+
+    // Ticks sent since start()
+    uint32_t ticks() const { return tickCount.load(std::memory_order_relaxed); }
+
+    // Timer period for a tempo, us (rounded to the us: under 0.01% off even at 300 BPM)
+    static uint32_t periodUs(float bpm);
+
+private:
+    MidiTxQueue& txQueue;
+    hw_timer_t* timer = nullptr;
+    float bpmSetting = MIDI_CLOCK_DEFAULT_BPM;
+    bool isRunning = false;
+    std::atomic<uint32_t> period{0};        // us, what the timer runs at
+    std::atomic<uint32_t> pendingPeriod{0}; // us, loaded by the next interrupt; 0 = none
+    std::atomic<uint32_t> tickCount{0};
+
+    static MidiClock* instance; // for the interrupt
+    static void IRAM_ATTR onTimer();
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "MidiRecorder.h"
+
+/**
+ * Turns MIDI messages into bytes on the output port, as few as possible.
+ *
+ * Every byte is MIDI_BYTE_US on the wire, so two modes (both on by default,
+ * see SystemConfig.h) trim a typical color change from 6 bytes to 4-5:
+ *  - running status: a message with the same status byte as the previous one
+ *    leaves it out;
+ *  - note-off as note-on velocity 0: note-offs share the note-on status byte,
+ *    so an off/on pair on one channel is a single run.
+ * The status byte is sent again after MIDI_RUNNING_STATUS_REFRESH_MS so a
+ * receiver plugged in mid-run picks up the stream.
+ *
+ * Channel messages for a channel outside 1-16 are dropped, as the MIDI
+ * library did before.
+ *
+ * With a recorder set, every channel message written is also handed to it,
+ * whole (status byte included), with the time it went out.
+ */
+class MidiEncoder {
+public:
+    explicit MidiEncoder(Print& port);
+
+    void noteOn(uint8_t note, uint8_t velocity, uint8_t channel);
+    void noteOff(uint8_t note, uint8_t velocity, uint8_t channel);
+    void controlChange(uint8_t control, uint8_t value, uint8_t channel);
+    // Any channel message, status byte including the channel (forwarded
+    // input): sent as it is, one or two data bytes as the status requires
+    void message(uint8_t status, uint8_t data1, uint8_t data2);
+    // System real-time (0xF8-0xFF): single byte, leaves running status alone
+    void realTime(uint8_t status);
+
+    void setRunningStatus(bool enabled);
+    void setNoteOffAsNoteOn(bool enabled);
+    // Forget the last status byte; the next message sends it in full
+    void resetRunningStatus();
+    // nullptr = none
+    void setRecorder(MidiRecorder* midiRecorder) { recorder = midiRecorder; }
+
+    // Bytes written, and bytes the two modes left out, since startup
+    uint32_t bytesSent() const { return sent; }
+    uint32_t bytesSaved() const { return saved; }
+    // Wire time saved per minute of playback, ms, averaged over `elapsedMs`
+    float wireTimeSavedMsPerMinute(unsigned long elapsedMs) const;
+
+private:
+    Print& out;
+    bool runningStatus = MIDI_RUNNING_STATUS;
+    bool noteOffAsNoteOn = MIDI_NOTE_OFF_AS_VELOCITY_0;
+    uint8_t lastStatus = 0;            // 0 = none
+    unsigned long lastStatusMs = 0;
+    uint32_t sent = 0;
+    uint32_t saved = 0;
+    MidiRecorder* recorder = nullptr;
+
+    void channelMessage(uint8_t status, uint8_t data1, uint8_t data2, uint8_t channel);
+    void send(uint8_t status, uint8_t data1, uint8_t data2, uint8_t dataBytes);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+// One complete message off the MIDI input
+struct MidiInMessage {
+    uint8_t status;  // 0x80-0xEF channel message (channel in the low nibble), 0xF8-0xFF real-time
+    uint8_t data1;   // 0 if the message has none
+    uint8_t data2;
+};
+
+/**
+ * MIDI input byte parser: one byte in, at most one message out, no buffers
+ * beyond the message being assembled (3 bytes of state).
+ *
+ *  - Running status: data bytes after a complete channel message start
+ *    another one with the same status.
+ *  - Real-time bytes (clock, start, stop...) may arrive anywhere, even
+ *    between the data bytes of another message; they come out at once and
+ *    the message in progress carries on.
+ *  - System common messages and SysEx are skipped, and cancel running status
+ *    as the spec says. Stray data bytes with no status are dropped.
+ */
+class MidiInParser {
+public:
+    /**
+     * Feed one byte off the wire.
+     * @return true if `out` now holds a complete channel or real-time message
+     */
+    bool feed(uint8_t byte, MidiInMessage& out);
+
+    // Forget any message in progress (and running status)
+    void reset();
+
+    // Bytes dropped: stray data bytes, system common and SysEx contents
+    uint32_t skippedBytes() const { return skipped; }
+
+private:
+    uint8_t status = 0;     // running status, 0 = none
+    uint8_t needed = 0;     // data bytes in a message with this status
+    uint8_t count = 0;      // data bytes received so far
+    uint8_t data1 = 0;
+    uint32_t skipped = 0;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "SystemConfig.h"
+#include "MidiInParser.h"
+
+// A setting change requested over MIDI (see MidiInput)
+enum RemoteTarget : uint8_t {
+    REMOTE_SCALE,    // value = scale index
+    REMOTE_ROOT,     // value = 0-11 semitones above C
+    REMOTE_OCTAVE,   // value = 0-8 for `sensor`
+    REMOTE_CHANNEL,      // value = MIDI channel 1-16 for `sensor`
+    REMOTE_SENSOR_SCALE, // value = scale index for `sensor`
+    REMOTE_SENSOR_ROOT   // value = 0-11 for `sensor`
+};
+
+struct RemoteCommand {
+    RemoteTarget target;
+    uint8_t sensor;  // REMOTE_OCTAVE and later only
+    uint8_t value;
+};
+
+// Every complete message received, as it arrives (MIDI Thru)
+typedef void (*MidiThruCallback)(const MidiInMessage& msg);
+
+// What the incoming start/stop messages say
+enum MidiTransport : uint8_t {
+    MIDI_TRANSPORT_FREE = 0, // nothing heard yet: play as always
+    MIDI_TRANSPORT_RUNNING,
+    MIDI_TRANSPORT_STOPPED
+};
+
+/**
+ * MIDI input on the RX side of the MIDI port: clock, transport and remote
+ * control of the note settings.
+ *
+ * Bytes are parsed in the UART's receive callback, as they arrive, so clock
+ * ticks are timed to within a byte. Clock and start/stop/continue are handled
+ * there; control changes on MIDI_IN_CONTROL_CHANNEL are queued (lock-free,
+ * single producer/single consumer) and turned into RemoteCommands by
+ * nextCommand() in loop(), where the menu state lives:
+ *
+ *   CC MIDI_IN_CC_SCALE      scale index
+ *   CC MIDI_IN_CC_ROOT       root, 0-11 semitones above C
+ *   NRPN 0/0, 0/1            scale, root (data entry MSB, CC 6)
+ *   NRPN 1/s                 octave 0-8 of sensor s
+ *   NRPN 2/s                 MIDI channel of sensor s (data 0-15 = channel 1-16)
+ *   NRPN 3/s, 4/s            scale, root of sensor s only
+ *
+ * Everything else on the input is ignored here, but with setThru() every
+ * complete channel and real-time message is also handed on as it arrives,
+ * from the receive callback, so it can be merged into the output.
+ */
+class MidiInput {
+public:
+    explicit MidiInput(HardwareSerial& port);
+
+    // Start listening (after the port is begun with an RX pin)
+    void begin();
+    // Forward every complete message to `callback` (nullptr: none)
+    void setThru(MidiThruCallback callback) { thru = callback; }
+
+    // Parse everything waiting on the port; the receive callback calls this
+    void receive();
+    // One byte off the wire at `nowUs`; exposed so it can be driven off-device
+    void feed(uint8_t byte, uint32_t nowUs);
+
+    // loop(): the next setting change, if any
+    bool nextCommand(RemoteCommand& command);
+
+    MidiTransport transport() const { return transportState.load(std::memory_order_relaxed); }
+    // Tempo of the incoming clock (24 per quarter note), 0 without one
+    float bpm() const;
+    // Clock ticks since the last start
+    uint32_t clockTicks() const { return ticks.load(std::memory_order_relaxed); }
+    // Largest gap between one tick period and the smoothed period, us, since
+    // the last reset. Loop MIDI out back to MIDI in to measure our own clock.
+    uint32_t clockJitterUs() const { return jitterMaxUs.load(std::memory_order_relaxed); }
+    void resetClockJitter() { jitterMaxUs.store(0, std::memory_order_relaxed); }
+
+    // Statistics
+    uint32_t bytesReceived() const { return bytes; }
+    uint32_t messagesDropped() const { return dropped; } // control queue full
+    // Average parse cost per byte in CPU cycles, over receive() calls
+    uint32_t cyclesPerByte() const;
+    const MidiInParser& parserState() const { return parser; }
+
+private:
+    HardwareSerial& port;
+    MidiInParser parser;
+    MidiThruCallback thru = nullptr;
+
+    // Receive callback -> loop(): control changes on the control channel
+    MidiInMessage queue[MIDI_IN_QUEUE_LENGTH];
+    std::atomic<uint8_t> head{0};
+    std::atomic<uint8_t> tail{0};
+
+    // Clock, written by the receive callback only
+    std::atomic<MidiTransport> transportState{MIDI_TRANSPORT_FREE};
+    std::atomic<uint32_t> ticks{0};
+    std::atomic<uint32_t> lastClockUs{0};
+    std::atomic<uint32_t> clockPeriodUs{0}; // smoothed, 0 = no clock yet
+    std::atomic<uint32_t> jitterMaxUs{0};
+
+    uint32_t bytes = 0;
+    uint32_t dropped = 0;
+    uint64_t parseCycles = 0;
+    uint32_t timedBytes = 0;
+
+    // NRPN address being written, loop() side; 0x7F = none
+    uint8_t nrpnMsb = 0x7F;
+    uint8_t nrpnLsb = 0x7F;
+
+    void clock(uint32_t nowUs);
+    bool decode(const MidiInMessage& msg, RemoteCommand& command);
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "SystemConfig.h"
+
+/**
+ * Keeps what went out on MIDI OUT, for saving a set afterwards.
+ *
+ * Every channel message the encoder writes (notes, CCs, forwarded input) is
+ * appended to a byte ring of MIDI_RECORDER_BYTES: the time since the
+ * previous event in ms as a variable-length quantity, then the message with
+ * its status byte. A note or CC a few ms after the last one takes 4 bytes.
+ * When the ring is full the oldest events are overwritten, so it always
+ * holds the most recent part of the performance. Clock ticks and other
+ * real-time bytes aren't kept.
+ *
+ * record() runs in the MIDI transmit task, right after the bytes go to the
+ * UART: a few stores, no locks and nothing on loop()'s side. writeSmf()
+ * turns the capture into a Standard MIDI File (format 0, one tick per ms)
+ * and dump() prints that as hex lines over Serial for
+ * tools/midi_record_decode.py. Recording pauses while it is read; events
+ * sent meanwhile are counted as missed.
+ */
+class MidiRecorder {
+public:
+    // Transmit task: one message as it went out (data2 ignored for 1-byte messages)
+    void record(uint32_t ms, uint8_t status, uint8_t data1, uint8_t data2);
+
+    // Forget the capture
+    void clear();
+
+    /**
+     * Write the capture as a Standard MIDI File. The tempo meta event is
+     * `bpm` rounded so a tick stays exactly 1 ms, which lines the recording
+     * up with the bar grid in a DAW when the clock ran at that tempo.
+     * @return bytes written
+     */
+    uint32_t writeSmf(Print& out, float bpm);
+    // writeSmf() as hex, 32 bytes a line, between "MIDIREC BEGIN <bytes>"
+    // and "MIDIREC END <sum of the bytes, 16 bits, hex>" lines
+    void dump(Print& out, float bpm);
+
+    // Statistics: events held, ring bytes in use, the time they span (ms),
+    // events overwritten to make room, and events missed while paused
+    uint16_t events() const { return eventCount; }
+    uint16_t bytesUsed() const { return used; }
+    uint32_t spanMs() const { return eventCount > 0 ? lastMs - firstMs : 0; }
+    uint32_t overwritten() const { return overwrittenCount; }
+    uint32_t missed() const { return missedCount.load(std::memory_order_relaxed); }
+    static constexpr uint32_t budgetBytes() { return MIDI_RECORDER_BYTES; }
+
+private:
+    uint8_t ring[MIDI_RECORDER_BYTES];
+    uint16_t head = 0;  // next write
+    uint16_t tail = 0;  // oldest event
+    uint16_t used = 0;
+    uint16_t eventCount = 0;
+    uint32_t firstMs = 0; // time of the oldest event
+    uint32_t lastMs = 0;  // time of the newest
+    uint32_t overwrittenCount = 0;
+    std::atomic<uint32_t> missedCount{0};
+    std::atomic<bool> paused{false};
+    std::atomic<bool> writing{false};
+
+    void dropOldest();
+    uint8_t at(uint16_t offset) const;
+    void pause();
+    void resume();
+    void writeTrack(Print& out, float bpm);
+    uint32_t writeFile(Print& out, float bpm);
+};
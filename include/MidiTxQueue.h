@@ -0,0 +1,270 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "SystemConfig.h"
+#include "MidiEncoder.h"
+#include "GateWheel.h"
+
+// Lower value goes out first
+enum MidiPriority : uint8_t {
+    MIDI_PRIORITY_URGENT = 0, // panic and note-offs: a late note-off is a stuck note
+    MIDI_PRIORITY_THRU,       // forwarded from the MIDI input, in arrival order
+    MIDI_PRIORITY_NOTE,       // note-ons
+    MIDI_PRIORITY_CONTROL,    // control changes, coalesced and rate-limited
+    MIDI_PRIORITY_COUNT
+};
+
+struct MidiMessage {
+    uint8_t type;      // 0x80 note-off, 0x90 note-on, 0xB0 control change; thru: the status byte as received
+    uint8_t channel;   // 1-16 (0 for thru)
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t offGen;    // note-ons: the note's note-off count when queued
+    uint32_t queuedUs; // micros() when queued
+};
+
+/**
+ * MIDI output that never blocks the caller.
+ *
+ * loop() queues messages and returns at once; a task on the other core
+ * encodes them (MidiEncoder, so running status follows the real wire order)
+ * and feeds the UART. The task keeps no more than MIDI_TX_FIFO_LEAD_BYTES in
+ * the UART FIFO, so a note-off queued behind a pile of CCs still goes out
+ * next instead of waiting for the FIFO to drain.
+ *
+ * Note-offs and note-ons each have a queue: a lock-free single-producer/
+ * single-consumer ring, so call the queueing functions from loop() only. A
+ * full queue drops the new message and counts it. Since note-offs overtake
+ * note-ons, a note-on still queued when its note-off is queued is dropped
+ * rather than sent after it (each note-on carries the note's note-off count
+ * from when it was queued).
+ *
+ * Control changes are governed so continuous controllers can't crowd out the
+ * notes:
+ *  - coalescing: a CC waits in a slot keyed by (channel, controller), and a
+ *    newer value for the same controller replaces it, so under load the
+ *    intermediate values are dropped and only the latest goes out;
+ *  - token bucket: CCs spend wire time from a bucket that refills at
+ *    MIDI_TX_CC_SHARE_PERCENT of the line rate, up to MIDI_TX_CC_BURST_BYTES.
+ *    Every note byte sent is charged to it as well, so CCs back off while
+ *    notes are busy and the UART FIFO stays near empty.
+ * Note-offs never wait for tokens, nor for the FIFO lead: only for FIFO room.
+ *
+ * MIDI Thru: forward() merges messages from the MIDI input into the
+ * output, whole messages only, in the order they arrived. They go out right
+ * after the note-offs, under the same FIFO lead as the notes (real-time
+ * bytes only need FIFO room), and every byte goes through the one encoder,
+ * so running status stays right across the two streams. The thru queue has
+ * its own ring, filled from the UART receive callback; when the input is
+ * busier than the output can carry, new messages are dropped and counted as
+ * dropped(MIDI_PRIORITY_THRU).
+ *
+ * Gate mode (setGate): a note-on queued as gated gets its note-off from
+ * here, a fixed time after the note-on actually went out, and optionally
+ * repeats (ratchets). The scheduled events wait in a GateWheel owned by the
+ * drain task, moved on by a GATE_TICK_US hardware timer, and go out ahead of
+ * the queues with the clock's precedence rules. Any later note-on or
+ * note-off for the same channel and note cancels what is still scheduled
+ * for it, so a re-struck note is never cut short by its predecessor's gate.
+ *
+ * Arpeggios (arpNoteOn): the notes after the first are queued in order
+ * with it, and when the drain task reaches one it is scheduled on the same
+ * wheel, `step` arpeggio steps after the first note went out, so loop()
+ * never waits for a step and the steps don't move with it.
+ *
+ * MIDI clock ticks (0xF8, from MidiClock's timer interrupt) go ahead of
+ * everything. While the clock runs, nothing else is started unless it will
+ * have left the FIFO MIDI_CLOCK_GUARD_US before the next tick is due, so the
+ * tick finds the wire idle and goes out within the task's wake-up time.
+ */
+class MidiTxQueue {
+public:
+    MidiTxQueue(HardwareSerial& port, MidiEncoder& encoder);
+
+    // Start the drain task (after the port is begun)
+    void begin();
+
+    // `gated`: the note-off (and any repeats) will come from the gate engine
+    bool noteOn(uint8_t note, uint8_t velocity, uint8_t channel, bool gated = false);
+    bool noteOff(uint8_t note, uint8_t velocity, uint8_t channel);
+    /**
+     * Note-on for arpeggio step `step` (1-7): it goes out `step` arpeggio
+     * steps after the last note-on queued with noteOn(). Queue it right
+     * after that one. A note-off or new note-on for the same note before
+     * then cancels it.
+     */
+    bool arpNoteOn(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t step, bool gated = false);
+    /**
+     * Queue a control change. At MIDI_PRIORITY_CONTROL it is coalesced and
+     * rate-limited; at a higher priority it is queued in order with the notes
+     * (for CCs that must not be skipped, such as All Sound Off).
+     */
+    bool controlChange(uint8_t control, uint8_t value, uint8_t channel,
+                       MidiPriority priority = MIDI_PRIORITY_CONTROL);
+    /**
+     * Queue a 14-bit control change: MSB on `control` (0-31), LSB on
+     * control + 32. The pair is coalesced as one value and always goes out
+     * together, so a receiver never sees a new MSB with an old LSB.
+     */
+    bool controlChange14(uint8_t control, uint16_t value, uint8_t channel);
+
+    /**
+     * Forward a complete message from the MIDI input (MidiInput's receive
+     * callback only). Incoming clock and start/stop/continue are left out
+     * while our own clock runs, so the receiver hears one clock.
+     * @return false if dropped
+     */
+    bool forward(uint8_t status, uint8_t data1, uint8_t data2);
+
+    /**
+     * Gate length and ratchets for gated note-ons; gateMs 0 = gate mode off.
+     * Starts the gate timer the first time it's needed.
+     */
+    void setGate(uint16_t gateMs, uint8_t repeats, uint16_t ratchetMs);
+    uint16_t gateTimeMs() const { return gateMs.load(std::memory_order_relaxed); }
+    // Send every scheduled note-off now and drop pending repeats (panic)
+    bool releaseGates();
+    // Time between arpeggio steps; starts the gate timer like setGate()
+    void setArpeggio(uint16_t stepMs);
+
+    /**
+     * Timer interrupt: a clock tick is due now, and the next one at
+     * `nextTickUs` (micros()). Sends 0xF8 ahead of anything queued.
+     */
+    void IRAM_ATTR clockTickFromISR(uint32_t nowUs, uint32_t nextTickUs);
+    // The next tick is at `nextTickUs` (clock started or tempo changed)
+    void scheduleClockTick(uint32_t nextTickUs);
+    // Clock stopped: no more holding back for ticks
+    void clockStopped();
+
+    /**
+     * Send the most urgent queued message if the FIFO has room.
+     * The drain task calls this; exposed so it can be driven off-device.
+     * @return true if a message was written
+     */
+    bool drainOnce();
+
+    // Statistics, per priority (control: depth is slots waiting, dropped is
+    // slot table full)
+    uint16_t depth(MidiPriority priority) const;
+    uint16_t maxDepth(MidiPriority priority) const { return stats[priority].maxDepth; }
+    uint32_t dropped(MidiPriority priority) const { return stats[priority].dropped; }
+    uint32_t sent(MidiPriority priority) const { return stats[priority].sent; }
+    // Queue time + FIFO wait + own bytes on the wire, until the last byte is out (us)
+    uint32_t maxLatencyUs(MidiPriority priority) const { return stats[priority].maxLatencyUs; }
+    uint32_t averageLatencyUs(MidiPriority priority) const { return stats[priority].averageLatencyUs; }
+    // CC values replaced by a newer one before they were sent
+    uint32_t coalesced() const { return ccCoalesced; }
+    // Note-ons dropped because their note-off was queued before they went out
+    uint32_t staleNoteOns() const { return staleNoteOnCount; }
+    // Clock ticks sent, and the most any started on the wire after it was due (us)
+    uint32_t clockTicksSent() const { return clockSent; }
+    uint32_t maxClockLatenessUs() const { return clockLatenessMaxUs; }
+    // Gate engine: events sent, scheduled at most at once, dropped (no room),
+    // and the most any started on the wire after its tick (us)
+    uint32_t gateEventsSent() const { return gateSent; }
+    uint16_t maxGatesPending() const { return gates.maxPending(); }
+    uint32_t gatesDropped() const { return gates.overflows() + gateDueDropped; }
+    uint32_t maxGateLatenessUs() const { return gateLatenessMaxUs; }
+    void resetMaxima();
+
+private:
+    struct Ring {
+        MidiMessage slots[MIDI_TX_QUEUE_LENGTH];
+        std::atomic<uint16_t> head{0}; // next write, producer only
+        std::atomic<uint16_t> tail{0}; // next read, consumer only
+    };
+    // One waiting CC, packed so both cores see it change in a single step:
+    // bit 31 pending, bit 30 14-bit pair, bits 16-29 value (16-22 for a
+    // 7-bit CC), 8-14 controller, 0-3 channel - 1
+    struct CcSlot {
+        std::atomic<uint32_t> word{0};
+        std::atomic<uint32_t> queuedUs{0}; // when the oldest unsent value arrived
+    };
+    struct Stats {
+        uint16_t maxDepth = 0;
+        uint32_t dropped = 0;
+        uint32_t sent = 0;
+        uint32_t maxLatencyUs = 0;
+        uint32_t averageLatencyUs = 0; // smoothed
+    };
+
+    HardwareSerial& port;
+    MidiEncoder& encoder;
+    Ring rings[MIDI_PRIORITY_CONTROL]; // urgent, thru and note
+    CcSlot ccSlots[MIDI_TX_CC_SLOTS];
+    uint32_t ccCoalesced = 0;
+    Stats stats[MIDI_PRIORITY_COUNT];
+    // Note-offs queued per channel/note (loop() writes, the drain task reads)
+    std::atomic<uint8_t> noteOffGen[16][128];
+    uint32_t staleNoteOnCount = 0;
+    TaskHandle_t task = nullptr;
+
+    // Token bucket, drain task only: wire time CCs may spend (us, may go
+    // negative after a run of notes), and when it was last topped up
+    int32_t ccTokensUs = MIDI_TX_CC_BURST_BYTES * MIDI_BYTE_US;
+    uint32_t ccRefilledUs = 0;
+    uint8_t ccNextSlot = 0;           // round-robin start, so one busy controller can't starve the rest
+
+    // Clock: ticks waiting (set by the timer interrupt), when the oldest was
+    // due, and when the next one is
+    std::atomic<uint8_t> clockPending{0};
+    std::atomic<uint32_t> clockDueUs{0};
+    std::atomic<uint32_t> nextClockUs{0};
+    std::atomic<bool> clockRunning{false};
+    uint32_t clockSent = 0;
+    uint32_t clockLatenessMaxUs = 0;
+
+    // Gate engine, drain task only apart from the tick count and settings.
+    // Fired events wait in gateDue until the FIFO has room; noteSeq tags
+    // each channel/note's latest note-on or note-off so stale events are
+    // skipped when they come due.
+    struct GateDue {
+        GateEvent event;
+        uint32_t dueUs;
+    };
+    GateWheel gates;
+    GateDue gateDue[GATE_MAX_EVENTS];
+    uint8_t gateDueHead = 0;
+    uint8_t gateDueCount = 0;
+    uint8_t noteSeq[16][128] = {{0}};
+    uint32_t gateSent = 0;
+    uint32_t gateDueDropped = 0;
+    uint32_t gateLatenessMaxUs = 0;
+    std::atomic<uint16_t> gateMs{0};
+    std::atomic<uint8_t> gateRepeats{0};
+    std::atomic<uint16_t> gateRatchetMs{0};
+    std::atomic<uint16_t> arpStepMs{0};
+    uint32_t arpAnchorUs = 0;             // when the note-on arpeggio steps count from went out
+    std::atomic<uint32_t> gateTicks{0};   // timer interrupts so far
+    std::atomic<uint32_t> gateTickUs{0};  // micros() of the latest
+    std::atomic<bool> gatesBusy{false};   // anything scheduled: wake the task on each tick
+    hw_timer_t* gateTimer = nullptr;
+    static MidiTxQueue* gateInstance;     // for the interrupt
+
+    static void IRAM_ATTR onGateTimer();
+    static void gateFired(const GateEvent& event, void* self);
+    static void gateReleased(const GateEvent& event, void* self);
+    void queueDue(const GateEvent& event, uint32_t dueUs);
+    void startGateTimer();
+    uint32_t ticksAfterNow(uint32_t us) const;
+    void scheduleGate(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t repeats, uint8_t seq);
+    void scheduleArpStep(const MidiMessage& msg);
+    void serviceGates();
+    bool sendGateEvent(int fifoUsed);
+    void flushGates();
+
+    bool sendClockTick(int fifoUsed);
+    bool clockGuard(int fifoUsed) const;
+    bool push(MidiPriority priority, uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel,
+              uint8_t offGen = 0);
+    uint8_t offGenFor(uint8_t note, uint8_t channel) const;
+    bool isStaleNoteOn(const MidiMessage& msg) const;
+    bool pushControl(uint8_t control, uint16_t value, bool wide, uint8_t channel);
+    bool popMessage(MidiPriority priority, MidiMessage& msg);
+    bool nextIsRealTime(MidiPriority priority) const;
+    bool popControl(uint32_t& word, uint32_t& queuedUs);
+    void refillTokens();
+    void wake();
+    static void drainTask(void* self);
+};
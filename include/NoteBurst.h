@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "CalibrationQueue.h"
+#include "Voicing.h"
+
+// One sensor moving to a new color: release what it was playing (if
+// anything), start the new color's note or chord (if any)
+struct NoteChange {
+    uint32_t onsetUs;   // integration midpoint of the sample that saw the new color
+    uint8_t sensor;
+    Voicing off;        // empty if nothing was sounding
+    uint8_t offChannel;
+    Voicing on;         // empty for a color that only silences (WHITE)
+    uint8_t onChannel;
+    uint8_t velocity;
+    bool arpeggio;      // on.notes after the first are arpeggio steps
+};
+
+// Sends one note message; on = false is a note-off. `step` > 0: a note-on
+// for that arpeggio step, timed from the chord's first note.
+typedef void (*NoteSendCallback)(bool on, uint8_t note, uint8_t velocity, uint8_t channel, uint8_t step);
+
+/**
+ * Collects the note changes of one scan cycle and sends them together.
+ *
+ * Sensors are read one after another, so a chord hitting several rings in the
+ * same slice of the revolution would otherwise go out spread over the cycle,
+ * in sensor order (flamming). Instead, changes whose onsets lie within
+ * NOTE_BURST_WINDOW_MS of the first one are held until every active sensor
+ * has been read since the burst opened, or the window has passed, whichever
+ * comes first, and then sent as one burst: all note-offs, then all note-ons,
+ * each grouped by channel so running status drops the repeated status bytes.
+ * A chord's notes stay together, so a burst of chords on one channel is a
+ * single run of note/velocity pairs.
+ */
+class NoteBurst {
+public:
+    /**
+     * Add a change. A change too far from the open burst's onset, or a second
+     * change from the same sensor, sends the open burst first.
+     */
+    void add(const NoteChange& change, uint32_t nowUs, NoteSendCallback send);
+
+    // Every read of an active sensor, changed or not; completes the cycle
+    void sensorRead(uint8_t sensor);
+
+    // Send the burst if its cycle is complete or its window has passed
+    void service(uint32_t nowUs, uint8_t activeSensors, NoteSendCallback send);
+
+    // Send whatever is held right now
+    void flush(NoteSendCallback send);
+
+    uint8_t pending() const { return count; }
+    // Largest burst sent since startup
+    uint8_t largestBurst() const { return largest; }
+
+private:
+    NoteChange changes[NUM_SENSORS];
+    uint8_t count = 0;
+    uint8_t largest = 0;
+    uint32_t openedUs = 0;     // micros() when the first change arrived
+    SensorMask readMask = 0;   // sensors read since then
+    uint8_t readCount = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include "ActiveNotes.h"
+#include "MidiTxQueue.h"
+#include "NoteBurst.h"
+#include "SensorChannel.h"
+
+/**
+ * The note path from the sensors to the transmit queue. Every note-on and
+ * note-off goes through send(), so ActiveNotes always matches the wire:
+ *
+ *  - an arpeggio step (step > 0) counts as on from when it's queued, so the
+ *    note-off that cancels it is sent even if the step hasn't sounded yet;
+ *  - a note two sensors share on one channel goes off when the last one
+ *    releases it;
+ *  - in gate mode the transmit task ends each note, so gated notes are never
+ *    tracked and the note-off at the next color change finds nothing to send.
+ *
+ * Color changes go through the NoteBurst, which calls back into send(). The
+ * callbacks are plain functions, so they go to the one NoteOutput there is
+ * (the last one constructed).
+ */
+class NoteOutput {
+public:
+    NoteOutput(MidiTxQueue& queue, ActiveNotes& activeNotes, NoteBurst& burst);
+
+    // One note message; on = false is a note-off (NoteSendCallback)
+    static void send(bool on, uint8_t note, uint8_t velocity, uint8_t channel, uint8_t step = 0);
+
+    // A sensor's color change, held with the rest of its burst
+    void change(const NoteChange& change, uint32_t nowUs) { burst.add(change, nowUs, send); }
+    // Send the held burst once its cycle is complete (see NoteBurst::service)
+    void service(uint32_t nowUs, uint8_t activeSensors) { burst.service(nowUs, activeSensors, send); }
+    // Send whatever is held now, e.g. before releasing anything
+    void flush() { burst.flush(send); }
+
+    // Note-offs for everything a sensor's last color started
+    void releasePlaying(SensorChannel& channel);
+    // Before a setting moves the sensor's notes: anything held goes out
+    // first, then its notes are released and its color forgotten, so the
+    // next reading starts it afresh
+    void releaseSensor(SensorChannel& channel);
+    // Everything sounding off, gated notes and their repeats included;
+    // returns how many tracked notes were released
+    uint16_t panic(SensorChannel channels[], uint8_t count);
+
+private:
+    static NoteOutput* instance;
+
+    MidiTxQueue& queue;
+    ActiveNotes& notes;
+    NoteBurst& burst;
+
+    static bool queueNoteOff(uint8_t note, uint8_t channel);
+};
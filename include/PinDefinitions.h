@@ -28,4 +28,4 @@
 
 // MIDI pins
 #define MIDI_OUT_PIN 17
-#define MIDI_IN_PIN -1 // Not used
+#define MIDI_IN_PIN 16 // from the input optocoupler (6N138)
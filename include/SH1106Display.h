@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SH110X.h>
+#include "SystemConfig.h"
+
+/**
+ * SH1106 OLED that only sends what changed on the panel.
+ *
+ * The library's display() pushes the whole 1 KB frame, ~25 ms of the I2C
+ * bus the color sensors share, and since every render starts from
+ * clearDisplay() that happens on every frame. This keeps a shadow copy of
+ * what the panel holds and, in each of the SH1106's eight 128-byte pages,
+ * sends only the column runs that differ from it: a menu cursor moving one
+ * row or a note changing in one Troubleshoot cell is a few short runs.
+ * Runs closer together than the cost of addressing a new one are merged.
+ *
+ * The bus stays at I2C_CLOCK_HZ throughout (by default the library leaves
+ * it at 100 kHz once the display is set up, which slowed every sensor read).
+ */
+class SH1106Display : public Adafruit_SH1106G {
+public:
+    SH1106Display(uint16_t width, uint16_t height, TwoWire* wire, int8_t resetPin);
+
+    // Adafruit_SH1106G::begin(), then a full frame on the next display()
+    bool begin(uint8_t address = OLED_I2C_ADDRESS, bool reset = true);
+    void display() override;
+    // Forget what the panel holds: the next display() sends every page
+    void invalidate() { shadowValid = false; }
+
+    // Statistics since startup: frames sent, I2C bytes they took (addresses,
+    // control and command bytes included), and what full frames would have
+    void resetStats();
+    uint32_t frames() const { return frameCount; }
+    uint32_t bytesSent() const { return sentBytes; }
+    uint32_t fullFrameBytes() const { return frameCount * runBytes(SCREEN_WIDTH) * PAGES; }
+    // Bus time the skipped bytes would have taken, ms
+    uint32_t busTimeSavedMs() const;
+
+private:
+    static const uint8_t PAGES = SCREEN_HEIGHT / 8;
+
+    uint8_t shadow[PAGES][SCREEN_WIDTH];
+    bool shadowValid = false;
+    uint32_t frameCount = 0;
+    uint32_t sentBytes = 0;
+
+    uint32_t runBytes(uint16_t length) const;
+    void sendRun(uint8_t page, uint8_t first, uint8_t last);
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "ColorEnum.h"
+
+static_assert((SAMPLE_HISTORY_LENGTH & (SAMPLE_HISTORY_LENGTH - 1)) == 0,
+              "SAMPLE_HISTORY_LENGTH must be a power of two");
+static_assert(SAMPLE_HISTORY_LENGTH <= 32768, "ring indices are 16 bits");
+
+#define SAMPLE_HISTORY_MASK (SAMPLE_HISTORY_LENGTH - 1)
+
+/**
+ * Read-only window onto one field of a SampleRing, oldest sample first.
+ * Points straight into the ring, so it costs nothing to make, but it is only
+ * good until the next push() on that ring (i.e. use it within one loop pass).
+ */
+template <typename T>
+struct RingView {
+    const T* data;  // the ring's array for this field
+    uint16_t start; // array index of the oldest sample in the view
+    uint16_t count;
+
+    uint16_t size() const { return count; }
+    // i = 0 is the oldest sample in the view, size() - 1 the newest
+    T operator[](uint16_t i) const { return data[(start + i) & SAMPLE_HISTORY_MASK]; }
+    T latest() const { return (*this)[count - 1]; }
+
+    // The same samples as at most two contiguous runs (first, then second),
+    // for loops that want plain pointer walks
+    const T* first() const { return data + start; }
+    uint16_t firstLength() const { return min((uint16_t)(SAMPLE_HISTORY_LENGTH - start), count); }
+    const T* second() const { return data; }
+    uint16_t secondLength() const { return count - firstLength(); }
+};
+
+// Raw channel order, as the TCS34725 returns them
+enum SampleChannel : uint8_t {
+    SAMPLE_CLEAR = 0,
+    SAMPLE_RED,
+    SAMPLE_GREEN,
+    SAMPLE_BLUE
+};
+
+/**
+ * The last SAMPLE_HISTORY_LENGTH readings of one sensor.
+ *
+ * Stored as a structure of arrays: each field is its own array, so a filter
+ * running over, say, the red channel touches only those 2-byte values.
+ * 20 bytes per sample plus a 4-byte counter (644 bytes at 32 samples).
+ */
+struct SampleRing {
+    uint32_t timeUs[SAMPLE_HISTORY_LENGTH];                // micros() at the estimated integration midpoint
+    uint16_t raw[4][SAMPLE_HISTORY_LENGTH];                // counts, SampleChannel order
+    uint16_t calibrated[3][SAMPLE_HISTORY_LENGTH];         // r, g, b after dark/gain/clear correction
+    Color color[SAMPLE_HISTORY_LENGTH];                    // classification
+    uint8_t margin[SAMPLE_HISTORY_LENGTH];                 // classification margin, 0-255 (ColorHelper::lastMargin)
+    uint32_t written = 0;                                  // samples pushed since startup
+
+    void push(uint32_t timeUs, const uint16_t rawCRGB[4], const float calibratedRGB[3],
+              Color color, float margin);
+
+    // Samples held (grows to SAMPLE_HISTORY_LENGTH, then stays)
+    uint16_t size() const;
+    // Samples pushed since startup; a consumer that remembers it can tell how many are new
+    uint32_t sequence() const { return written; }
+
+    // Views over the newest `count` samples (clamped to size())
+    RingView<uint32_t> times(uint16_t count = SAMPLE_HISTORY_LENGTH) const;
+    RingView<uint16_t> rawChannel(SampleChannel channel, uint16_t count = SAMPLE_HISTORY_LENGTH) const;
+    RingView<uint16_t> calibratedChannel(uint8_t channel, uint16_t count = SAMPLE_HISTORY_LENGTH) const; // 0 = r, 1 = g, 2 = b
+    RingView<Color> colors(uint16_t count = SAMPLE_HISTORY_LENGTH) const;
+    RingView<uint8_t> margins(uint16_t count = SAMPLE_HISTORY_LENGTH) const;
+
+private:
+    template <typename T>
+    RingView<T> view(const T* field, uint16_t count) const;
+};
+
+static_assert(sizeof(SampleRing) == 20 * SAMPLE_HISTORY_LENGTH + 4,
+              "SampleRing layout changed; update the RAM figures in SystemConfig.h");
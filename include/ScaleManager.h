@@ -17,19 +17,51 @@ enum class RootNote : uint8_t {
     B4 = 71
 };
 
+/**
+ * Scales are rows of a table (ScaleManager.cpp), each an interval mask: bit n
+ * set = the note n semitones above the root is in the scale. The colors take
+ * the scale's degrees in Color enum order, carrying on into the next octave
+ * when the scale has fewer notes than there are colors (pentatonics).
+ *
+ * The built-in rows are constexpr, so their color offsets are worked out by
+ * the compiler and sit in flash. USER_SCALE_COUNT user scales follow them;
+ * their masks are edited on the device and kept in EEPROM.
+ */
 class ScaleManager {
 public:
+    // A scale is its row in the table; these rows keep their numbers
     enum ScaleType: uint8_t {
         MAJOR = 0,
         MINOR = 1,
-        // Future: PENTATONIC, BLUES, etc.
     };
-    
+
+    static const uint8_t NUM_BUILTIN_SCALES;
+    static const uint8_t NUM_SCALES;  // built-in, then user
+    static const char* scaleName(uint8_t scale);
+    static uint16_t scaleMask(uint8_t scale); // interval mask (Major if out of range)
+
+    // User scales (slot 0 = row NUM_BUILTIN_SCALES). The root is always in.
+    static void setUserScale(uint8_t slot, uint16_t mask);
+    static uint16_t userScaleMask(uint8_t slot);
+    static void loadUserScales();  // from EEPROM; blank or invalid slots read as Major
+    static void saveUserScale(uint8_t slot);
+
     ScaleManager(ScaleType initialScale = MAJOR, uint8_t initialOctave = 4, uint8_t initialRootNote = 60); // Default to C4
     
     // Get MIDI note number for a detected color (EFFICIENT - use this!)
     uint8_t colorToMIDINote(Color color);
     
+    // Final note for every color (Color enum order) with a scale, root (60-71)
+    // and octave (0-8, 4 = no shift), clamped to 0-127; MIDI_NOTE_OFF for the
+    // note-off color. Done once per settings change, so the note path only
+    // has to index the table.
+    static void buildNoteTable(ScaleType scale, uint8_t rootNote, uint8_t octave, uint8_t table[NUM_COLORS]);
+    // The same for chords: each color's note, then VOICING_MAX_NOTES - 1 more
+    // stacked in scale thirds. Upper notes past 127 are MIDI_NOTE_OFF rather
+    // than clamped, so a chord never doubles a note.
+    static void buildChordTable(ScaleType scale, uint8_t rootNote, uint8_t octave,
+                                uint8_t table[][VOICING_MAX_NOTES]);
+
     // Get MIDI note number for a detected color (backwards compatibility - slower)
     uint8_t colorToMIDINote(const char* colorName);
     
@@ -61,4 +93,7 @@ private:
     
     // Get MIDI note offset for color index in current scale
     uint8_t getScaleOffset(int colorIndex);
+
+    // Offsets of a scale, NUM_COLORS entries (Major if out of range)
+    static const uint8_t* scaleOffsets(ScaleType scale);
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+#include "ColorEnum.h"
+#include "Voicing.h"
+
+/**
+ * Per-sensor note state, one entry per ring in MenuManager::sensorChannels.
+ * Everything the note path touches for a sample sits in one small struct, so
+ * the loop indexes by sensor number instead of switching over A/B/C/D copies.
+ * Hot fields first; the troubleshoot reading goes last.
+ */
+struct SensorChannel {
+    // notes[] value for a color that only releases (WHITE)
+    static const uint8_t NO_NOTE = 0xFF;
+
+    // Final note for each color (Color enum order), with this sensor's scale,
+    // root and octave already applied; MenuManager::rebuildNotes() fills it
+    uint8_t notes[NUM_COLORS];
+    // Chord for each color: its note, then the scale notes a third, fifth and
+    // seventh above; NO_NOTE past note 127. Built along with notes[].
+    uint8_t chords[NUM_COLORS][VOICING_MAX_NOTES];
+    Color currentColor = Color::UNKNOWN; // last color that produced a note
+    uint8_t lastNote = 0;                // last note started (shown on the troubleshoot page)
+    Voicing playing;                     // notes started and not yet released, on midiChannel
+    uint8_t midiChannel = 1;             // 1-16
+    uint8_t velocity = 127;
+    uint8_t octave = 4;                  // 0-8, 4 = no shift
+    uint8_t scale = 0;                   // ScaleManager::ScaleType
+    uint8_t root = 0;                    // 0-11 semitones above C
+    uint16_t rgb[3] = {0};               // last calibrated reading (troubleshoot mode 1)
+    bool online = true;                  // false while SensorHealth has it out of the scan
+};
+
+// Letter shown for a sensor on screen and in debug output ('A' for sensor 0).
+// Single characters keep the grids readable up to MAX_SENSORS.
+inline char sensorLetter(uint8_t sensor) {
+    static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+#";
+    static_assert(sizeof(letters) - 1 >= MAX_SENSORS, "need a letter for every sensor");
+    return (sensor < MAX_SENSORS) ? letters[sensor] : '?';
+}
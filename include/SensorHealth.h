@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+enum class SensorStatus : uint8_t {
+    ONLINE = 0,  // in the scan
+    OFFLINE,     // waiting for its next re-probe
+    POWERING_UP, // answered the probe, oscillator starting
+    WARMING_UP   // converting, waiting for the first complete reading
+};
+
+// Outcome of one re-probe step
+enum class ProbeResult : uint8_t {
+    FAILED = 0, // I2C error or wrong chip: back to OFFLINE, probe less often
+    PENDING,    // fine so far, try this step again shortly
+    PASSED      // move on to the next step
+};
+
+/**
+ * Tracks whether each color sensor is working and walks failed ones back in.
+ *
+ * A sensor leaves the scan after SENSOR_MAX_CONSECUTIVE_ERRORS failed reads
+ * in a row, or when its raw reading hasn't moved for SENSOR_STUCK_READS reads
+ * (a TCS34725 that browned out stops converting but still answers). Offline
+ * sensors are re-probed in the background, one short step per call:
+ * OFFLINE -> POWERING_UP -> WARMING_UP -> ONLINE, with the probe interval
+ * doubling (up to SENSOR_REPROBE_MAX_INTERVAL_MS) while a sensor stays absent,
+ * so an unplugged head costs one NAKed transaction every few seconds.
+ *
+ * No hardware access in here; the loop does the probing and bus recovery.
+ */
+class SensorHealth {
+public:
+    /**
+     * Record a scan read.
+     * @param ok      the I2C transfer succeeded
+     * @param repeats consecutive identical raw readings (ColorHelper::rawRepeats)
+     * @return true if the sensor should leave the scan now
+     */
+    bool reportRead(uint8_t sensor, bool ok, uint16_t repeats);
+
+    // Take a sensor out (failed read, or not found at startup); first re-probe
+    // after SENSOR_REPROBE_INTERVAL_MS
+    void takeOffline(uint8_t sensor, unsigned long now);
+
+    // Offline sensor whose next re-probe step is due, if any
+    bool nextProbe(unsigned long now, uint8_t& sensor);
+
+    // Outcome of the step nextProbe() asked for; true once the sensor is back online
+    bool reportProbe(uint8_t sensor, unsigned long now, ProbeResult result);
+
+    // Enough reads failed in a row, across sensors, that the bus itself is suspect
+    bool busSuspect() const;
+    void busCleared();
+
+    SensorStatus status(uint8_t sensor) const;
+    uint32_t errorCount(uint8_t sensor) const; // failed reads and probes since startup
+    uint16_t dropCount(uint8_t sensor) const;  // times taken out of the scan
+    uint16_t busClears() const;
+
+private:
+    struct State {
+        SensorStatus status = SensorStatus::ONLINE;
+        uint8_t consecutiveErrors = 0;
+        uint8_t pendingSteps = 0;
+        uint16_t drops = 0;
+        uint16_t probeInterval = SENSOR_REPROBE_INTERVAL_MS;
+        uint32_t errors = 0;
+        unsigned long nextProbe = 0;
+    };
+
+    State state[NUM_SENSORS];
+    uint8_t probeCursor = 0;       // round-robin over offline sensors
+    uint8_t busErrorRun = 0;       // failed reads in a row, any sensor
+    uint16_t numBusClears = 0;
+};
+
+const char* sensorStatusName(SensorStatus status);
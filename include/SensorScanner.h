@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+/**
+ * Decides which color sensor the loop reads next.
+ *
+ * Only sensors that answered at startup are scanned. A sensor is only worth
+ * reading once it has finished a new conversion (SENSOR_INTEGRATION_MS after
+ * its last read); among those, the one furthest past its target interval goes
+ * first. The target interval shrinks from SCAN_IDLE_INTERVAL_MS down to one
+ * integration period while a sensor has attention:
+ *  - it changed color within the last SCAN_ATTENTION_HOLD_MS, or
+ *  - its last reading sat close to the boundary between two colors.
+ * When the bus has time for everyone, every sensor is still read once per
+ * conversion; when it doesn't, busy heads keep their rate and quiet ones give
+ * way. Nobody goes longer than SCAN_MAX_INTERVAL_MS without a read.
+ *
+ * No hardware access in here; the loop does the selecting and reading.
+ */
+class SensorScanner {
+public:
+    // Add or remove a sensor from the scan (O(NUM_SENSORS), setup/fault time only)
+    void setActive(uint8_t sensor, bool active);
+    bool isActive(uint8_t sensor) const;
+    uint8_t activeCount() const;
+
+    /**
+     * Pick the next sensor to read and mark it read at `now`.
+     * O(active sensors) per call.
+     * @param now    millis()
+     * @param sensor sensor index to read
+     * @return false if no sensor has a new conversion yet
+     */
+    bool next(unsigned long now, uint8_t& sensor);
+
+    /**
+     * Feed back what the read showed.
+     * @param changed true if the detected color differs from the previous one
+     * @param margin  classification margin, 0 (halfway between two colors) .. 1
+     */
+    void report(uint8_t sensor, unsigned long now, bool changed, float margin);
+
+    // Smoothed time between reads of a sensor, ms (1000 / its sample rate)
+    float averageIntervalMs(uint8_t sensor) const;
+
+    // Reads forced by SCAN_MAX_INTERVAL_MS since startup (nonzero = bus overloaded)
+    uint32_t forcedReads() const;
+
+private:
+    struct SensorState {
+        unsigned long lastRead = 0;
+        unsigned long lastChange = 0;
+        float margin = 1.0f;
+        float avgInterval = SENSOR_INTEGRATION_MS;
+        bool active = false;
+    };
+
+    SensorState state[NUM_SENSORS];
+    uint8_t order[NUM_SENSORS];          // active sensors, in sensor (= topology) order
+    uint8_t numActive = 0;
+    uint32_t numForced = 0;
+
+    // 0 = quiet, 1 = needs reading every conversion
+    float attention(const SensorState& s, unsigned long now) const;
+};
+
+/**
+ * Per-sensor sample rate a plain round-robin can sustain (Hz): each sweep
+ * takes the longer of one integration period and the time to read every
+ * sensor once.
+ * @param numSensors    active sensors
+ * @param perSensorUs   bus + processing time to read and handle one sensor
+ */
+float estimateSampleRateHz(uint8_t numSensors, float perSensorUs);
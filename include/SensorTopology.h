@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+/**
+ * Where a color sensor is wired: which TCA9548A and which of its channels.
+ * Every TCS34725 answers on 0x29, so exactly one mux channel may be open at a
+ * time across all muxes.
+ */
+struct SensorLocation {
+    uint8_t muxAddress; // TCA_BASE_ADDR..TCA_BASE_ADDR+7
+    uint8_t muxChannel; // 0-7
+};
+
+// Indexed by sensor number. Edit SensorTopology.cpp to match the wiring.
+extern const SensorLocation sensorTopology[MAX_SENSORS];
+
+static_assert(NUM_SENSORS <= MAX_SENSORS, "NUM_SENSORS exceeds the mux topology");
+
+/**
+ * Open the mux channel for a sensor. Closes the previously used mux first if
+ * it's a different one, and skips the write entirely if the channel is
+ * already open, so a sweep costs at most two mux writes per sensor.
+ */
+void selectSensor(uint8_t sensor);
+
+// Close every mux channel that selectSensor() may have opened
+void deselectSensors();
+
+// Close all channels on every possible mux (startup, unknown state)
+void deselectAllMuxes();
@@ -1,10 +1,53 @@
 //MIDI
 #define MIDI_BAUD_RATE 31250
+#define MIDI_BYTE_US 320                   // 10 bits per byte at 31250 baud
+#define MIDI_RUNNING_STATUS 1              // leave out repeated status bytes
+#define MIDI_NOTE_OFF_AS_VELOCITY_0 1      // note-off as note-on velocity 0, so offs and ons share one run
+#define MIDI_RUNNING_STATUS_REFRESH_MS 1000 // resend the status byte at least this often
+#define MIDI_TX_QUEUE_LENGTH 64            // queued messages per priority (power of two)
+#define MIDI_TX_FIFO_SIZE 128              // ESP32 UART hardware TX FIFO
+#define MIDI_TX_FIFO_LEAD_BYTES 6          // bytes kept queued in the FIFO, ~2 ms: covers one task tick
+#define MIDI_TX_TASK_PRIORITY 5
+#define MIDI_TX_TASK_STACK 3072
+#define MIDI_TX_CC_SLOTS 32                // distinct (channel, controller) pairs awaiting send; newer values replace older
+#define MIDI_TX_CC_SHARE_PERCENT 50        // token bucket: share of the wire CCs may use while notes are quiet
+#define MIDI_TX_CC_BURST_BYTES 12          // token bucket depth: CC bytes that may go out back to back
+#define MIDI_IN_CONTROL_CHANNEL 16         // remote control CCs/NRPNs are only taken on this channel
+#define MIDI_IN_CC_SCALE 102               // remote control: scale index (102-119 are undefined in MIDI)
+#define MIDI_IN_CC_ROOT 103                // remote control: root, 0-11 semitones above C
+#define MIDI_IN_QUEUE_LENGTH 16            // control changes waiting for loop() (power of two)
+#define MIDI_IN_CLOCK_TIMEOUT_MS 500       // no clock for this long = tempo unknown
+#define MIDI_THRU 1                        // merge everything received (except SysEx/system common) into the output
+#define MIDI_CLOCK_OUT 1                   // send MIDI clock (24 ppqn) at the tempo from the Tempo menu
+#define MIDI_CLOCK_TIMER 0                 // hardware timer for the clock (0-3)
+#define MIDI_CLOCK_DEFAULT_BPM 120
+#define MIDI_CLOCK_MIN_BPM 20
+#define MIDI_CLOCK_MAX_BPM 300
+#define MIDI_CLOCK_GUARD_US 100            // wire kept idle this long before a tick (covers the task wake-up)
+#define GATE_TIME_MS 0                     // 0: a note lasts until its ring changes color; else each note-on gets its note-off this long after
+#define GATE_REPEATS 0                     // ratchets: each gated note sounds this many more times...
+#define GATE_RATCHET_MS 125                // ...this far apart (the gate is cut to fit between them)
+#define GATE_TIMER 1                       // hardware timer for the gate tick (0-3, not MIDI_CLOCK_TIMER)
+#define GATE_TICK_US 1000                  // gate resolution
+#define GATE_WHEEL_SLOTS 256               // one turn of the timer wheel, in ticks; longer gates wait whole turns (power of two)
+#define GATE_MAX_EVENTS 128                // scheduled note-offs and repeats pending at once (< 255)
+#define MIDI_RECORDER 1                    // keep what goes out in RAM; 'd' on the serial monitor dumps it as a MIDI file
+#define MIDI_RECORDER_BYTES 16384          // recorder RAM (power of two): ~4 bytes per event, oldest overwritten
+
+// Tempo from the disk (see DiskTempo.h)
+#define DISK_TEMPO_BEATS_PER_REV 4         // one revolution = one bar of 4/4
+#define DISK_TEMPO_SENSORS 4               // sensors whose color changes are timed
+#define DISK_TEMPO_MIN_REV_MS 500          // shorter repeats are ignored (480 BPM at 4 beats per revolution)
+#define DISK_TEMPO_MAX_REV_MS 20000
+#define DISK_TEMPO_CANDIDATES 16           // recent period candidates voted over
+#define DISK_TEMPO_MIN_VOTES 3             // candidates that must agree before the tempo is trusted
+#define DISK_TEMPO_TOLERANCE_PERCENT 5     // candidates this close count as the same period
 
 // Display Configuration - SH1106 OLED
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_I2C_ADDRESS 0x3C
+#define MENU_MAX_FPS 20 // OLED redraws per second at most; requests in between are folded into the next frame
 
 #define MARGIN_TOP 2
 #define MARGIN_LEFT 2
@@ -24,8 +67,71 @@
 // Legacy TFT colors (commented out for reference)
 // #define TFT_WHITE, TFT_BLACK, TFT_RED, etc.
 
-#define NUM_CALIBRATION_STEPS 20
+#define NUM_SENSORS 4 // color sensor rings; where each one is wired is in SensorTopology.cpp
+#define MAX_SENSORS 64 // 8 TCA9548A muxes (0x70-0x77) x 8 channels
+#define NUM_CALIBRATION_STEPS 20 // max samples per calibration pass (stops earlier once the mean has settled)
+#define CALIBRATION_MIN_SAMPLES 6 // never stop before this many accepted samples
+#define CALIBRATION_CI_Z 1.96f // 95% confidence interval on the mean
+#define CALIBRATION_CI_HALF_WIDTH 60.0f // stop once every channel's mean is known to +/- this many counts
+#define CALIBRATION_OUTLIER_SIGMA 4.0f // reject a sample this many std devs from the running mean...
+#define CALIBRATION_OUTLIER_FLOOR 250.0f // ...and at least this many counts away (a steady sensor has almost no spread)
+#define CALIBRATION_QUEUE_CAPACITY 16 // max pending calibration jobs (one job = one step over any set of sensors)
 #define NUM_COLORS 8 // includes white
+#define USER_SCALE_COUNT 4 // scales edited on the device (User Scales menu), after the built-in ones
+
+// Rotation auto-calibration: record the spinning disk, then k-means the readings
+#define AUTO_CAL_RECORD_MS 6000           // recording window, set to cover 1-2 disk revolutions
+#define AUTO_CAL_MAX_SAMPLES 320          // per sensor (~40 Hz * 8 s), 6 bytes each
+#define AUTO_CAL_BATCH_SENSORS 8          // sensors recorded per rotation pass (buffers are ~2 KB per sensor)
+#define AUTO_CAL_MAX_ITERATIONS 25        // k-means iteration cap
+#define AUTO_CAL_TRIM_FACTOR 2.0f         // drop boundary readings beyond this many mean distances
+#define AUTO_CAL_BOUNDARY_FACTOR 3.0f     // before clustering, drop readings this many median steps from both neighbours
+#define AUTO_CAL_MIN_CLUSTER_SAMPLES 5    // smaller clusters are treated as "patch not seen"
+#define AUTO_CAL_SPLIT_SSE_RATIO 0.35f    // split a cluster for an empty seed only if halving cuts its spread this much
+#define AUTO_CAL_DUMP_SAMPLES 0           // 1: print every recorded reading over serial, as a test fixture
+
+// Calibration transfer (fully calibrated sensor A -> B/C/D from a few reference colors)
+#define TRANSFER_AFFINE_MIN_REFERENCES 5  // references needed before solving a full 3x3 affine map
+#define TRANSFER_MIN_SPREAD 500.0         // counts; references closer than this on a channel can't fix a slope
+#define TRANSFER_REFERENCE_COLORS 0x09   // colors measured on each target ring after white, bit i = indexToColor(i) (0x09: red, blue)
+
+// Sensor scanning
+#define I2C_CLOCK_HZ 400000        // TCS34725, TCA9548A and SH1106 all run at fast-mode
+#define SENSOR_INTEGRATION_MS 24   // TCS34725_INTEGRATIONTIME_24MS; a sensor has a fresh reading this often
+#define SENSOR_READ_ESTIMATE_US 530 // mux switch + burst read + classify, per sensor (see tools/scan_rate_sim.py)
+#define SCAN_IDLE_INTERVAL_MS 72   // target read interval for a sensor sitting on one patch
+#define SCAN_MAX_INTERVAL_MS 120   // guaranteed refresh: no sensor waits longer, however busy the bus
+#define SCAN_ATTENTION_HOLD_MS 1000 // a color change keeps a sensor on the fast rate for up to this long
+#define SCAN_ATTENTION_MARGIN 0.25f // classification margins below this count as "near a boundary"
+
+// Note output
+#define NOTE_BURST_WINDOW_MS 6 // note changes with onsets this close go out together (0 = send each at once)
+#define VOICING_MODE 0         // per color: 0 = one note, 1 = chord, 2 = arpeggio (see Voicing.h)
+#define VOICING_NOTES 3        // chord/arpeggio size: 3 = triad, 4 = seventh chord (<= VOICING_MAX_NOTES)
+#define VOICING_MAX_NOTES 4    // size of the per-color chord tables (<= 8)
+#define VOICING_ARP_STEP_MS 60 // arpeggio: time between steps, timed by the gate engine
+
+// Color controllers (see ColorCcStream.h): hue, saturation, brightness per sensor
+#define COLOR_CC_MODE 1                  // 0 = off, 1 = 7-bit CCs, 2 = 14-bit CC pairs (MSB + LSB at +32)
+#define COLOR_CC_FIRST_CONTROL 20        // sensor s sends on controllers 20 + 3s .. 22 + 3s (20-31 are undefined in MIDI)
+#define COLOR_CC_THRESHOLD 128           // 14-bit steps a value has to move before it is sent again (128 = one 7-bit step)
+#define COLOR_CC_MIN_INTERVAL_MS 20      // per sensor, at most one update this often (also paced to MIDI_TX_CC_SHARE_PERCENT)
+#define COLOR_CC_HUE_MIN_SATURATION 1024 // 14-bit; below this the hue is noise and is held
+#define COLOR_CC_CLEAR_FULL_SCALE 10240  // raw clear count sent as full brightness (1024 per 2.4 ms of integration)
+
+// Sample history (see SampleHistory.h): 20 bytes per sample, so 32 samples
+// = 644 bytes per sensor, 2.5 KB for 4 sensors, 41 KB for 64
+#define SAMPLE_HISTORY_LENGTH 32 // per sensor, power of two; ~0.8 s at the full 41 Hz rate
+
+// Sensor health
+#define I2C_TIMEOUT_MS 10               // upper bound on one Wire transaction; a hung bus can't stall loop() longer
+#define I2C_BUS_ERROR_LIMIT 4           // failed reads in a row (any sensors) before the bus itself gets cleared
+#define SENSOR_MAX_CONSECUTIVE_ERRORS 3 // failed reads in a row before a sensor leaves the scan
+#define SENSOR_STUCK_READS 125          // identical raw readings in a row (~3 s) = sensor stopped converting
+#define SENSOR_REPROBE_INTERVAL_MS 250  // first re-probe of an offline sensor; doubles after each failure
+#define SENSOR_REPROBE_MAX_INTERVAL_MS 8000
+#define SENSOR_POWER_ON_MS 3            // TCS34725 oscillator start-up before conversions can be enabled
 
 // I2C addresses
-#define TCA_ADDR 0x70
\ No newline at end of file
+#define TCA_BASE_ADDR 0x70 // first mux; the address pins select 0x70-0x77
+#define TCA_MAX_MUXES 8
\ No newline at end of file
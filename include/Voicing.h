@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemConfig.h"
+
+static_assert(VOICING_NOTES >= 1 && VOICING_NOTES <= VOICING_MAX_NOTES && VOICING_MAX_NOTES <= 8,
+              "VOICING_NOTES must fit the chord tables, which hold at most 8 notes");
+
+// What one color change plays
+enum VoicingMode : uint8_t {
+    VOICING_SINGLE = 0, // the color's note
+    VOICING_CHORD,      // its chord, all notes at once
+    VOICING_ARPEGGIO    // its chord one note after another, upwards, VOICING_ARP_STEP_MS apart
+};
+
+/**
+ * The notes a color change starts, or the ones it has to stop: the color's
+ * note first, then the rest of its chord (arpeggio steps in order). Built
+ * from a row of the sensor's chord table, so nothing is computed per note.
+ */
+struct Voicing {
+    uint8_t notes[VOICING_MAX_NOTES];
+    uint8_t count = 0; // 0 = nothing
+
+    // `row`: VOICING_MAX_NOTES entries, 0xFF = no note (SensorChannel::chords)
+    void fromChord(const uint8_t row[VOICING_MAX_NOTES], VoicingMode mode, uint8_t size) {
+        count = 0;
+        uint8_t wanted = (mode == VOICING_SINGLE) ? 1 : size;
+        for (uint8_t i = 0; i < VOICING_MAX_NOTES && count < wanted; i++) {
+            if (row[i] != 0xFF) {
+                notes[count++] = row[i];
+            }
+        }
+    }
+};
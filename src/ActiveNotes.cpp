@@ -0,0 +1,79 @@
+#include "ActiveNotes.h"
+
+static bool validNote(uint8_t channel, uint8_t note) {
+    return channel >= 1 && channel <= 16 && note < 128;
+}
+
+void ActiveNotes::noteOn(uint8_t channel, uint8_t note) {
+    if (!validNote(channel, note)) return;
+    uint8_t& owners = ownerCount[channel - 1][note];
+    if (owners < 255) {
+        owners++;
+    }
+    notes[channel - 1][note >> 5] |= (1UL << (note & 31));
+}
+
+void ActiveNotes::noteOff(uint8_t channel, uint8_t note) {
+    if (!validNote(channel, note)) return;
+    uint8_t& owners = ownerCount[channel - 1][note];
+    if (owners > 0) {
+        owners--;
+    }
+    if (owners == 0) {
+        notes[channel - 1][note >> 5] &= ~(1UL << (note & 31));
+    }
+}
+
+uint8_t ActiveNotes::owners(uint8_t channel, uint8_t note) const {
+    if (!validNote(channel, note)) return 0;
+    return ownerCount[channel - 1][note];
+}
+
+bool ActiveNotes::isOn(uint8_t channel, uint8_t note) const {
+    if (!validNote(channel, note)) return false;
+    return (notes[channel - 1][note >> 5] >> (note & 31)) & 1;
+}
+
+uint8_t ActiveNotes::count(uint8_t channel) const {
+    if (channel < 1 || channel > 16) return 0;
+    uint8_t n = 0;
+    for (int word = 0; word < 4; word++) {
+        n += __builtin_popcount(notes[channel - 1][word]);
+    }
+    return n;
+}
+
+uint16_t ActiveNotes::count() const {
+    uint16_t n = 0;
+    for (uint8_t channel = 1; channel <= 16; channel++) {
+        n += count(channel);
+    }
+    return n;
+}
+
+uint16_t ActiveNotes::releaseAll(NoteReleaseFunction release) {
+    uint16_t n = 0;
+    for (uint8_t channel = 1; channel <= 16; channel++) {
+        n += releaseChannel(channel, release);
+    }
+    return n;
+}
+
+uint16_t ActiveNotes::releaseChannel(uint8_t channel, NoteReleaseFunction release) {
+    if (channel < 1 || channel > 16) return 0;
+    uint16_t n = 0;
+    for (int word = 0; word < 4; word++) {
+        uint32_t bits = notes[channel - 1][word];
+        while (bits != 0) {
+            uint8_t bit = __builtin_ctz(bits);
+            bits &= bits - 1;
+            uint8_t note = word * 32 + bit;
+            if (release(note, channel)) {
+                ownerCount[channel - 1][note] = 0;
+                noteOff(channel, note);
+                n++;
+            }
+        }
+    }
+    return n;
+}
@@ -0,0 +1,379 @@
+#include "AutoCalibrator.h"
+#include <algorithm>
+
+void AutoCalibrator::reset() {
+    numSamples = 0;
+    boundaryReadings = 0;
+}
+
+bool AutoCalibrator::addSample(float r, float g, float b) {
+    if (numSamples >= AUTO_CAL_MAX_SAMPLES) {
+        return false;
+    }
+    samples[numSamples].r = (uint16_t)constrain(r, 0.0f, 65535.0f);
+    samples[numSamples].g = (uint16_t)constrain(g, 0.0f, 65535.0f);
+    samples[numSamples].b = (uint16_t)constrain(b, 0.0f, 65535.0f);
+    numSamples++;
+    return true;
+}
+
+uint16_t AutoCalibrator::sampleCount() const {
+    return numSamples;
+}
+
+float AutoCalibrator::distanceSq(const ColorSample& s, const float c[3]) {
+    float dr = s.r - c[0];
+    float dg = s.g - c[1];
+    float db = s.b - c[2];
+    return dr*dr + dg*dg + db*db;
+}
+
+void AutoCalibrator::dropBoundaryReadings() {
+    if (numSamples < 3) {
+        return;
+    }
+    // Readings are in disk order, so one on a patch sits close to the reading
+    // before or after it, and one taken across a boundary is a blend far from
+    // both. "Far" is against the median step, which is the sensor's noise.
+    static float steps[AUTO_CAL_MAX_SAMPLES];
+    static float sorted[AUTO_CAL_MAX_SAMPLES];
+    uint16_t numSteps = numSamples - 1;
+    for (uint16_t i = 0; i < numSteps; i++) {
+        float next[3] = {(float)samples[i + 1].r, (float)samples[i + 1].g, (float)samples[i + 1].b};
+        steps[i] = sorted[i] = distanceSq(samples[i], next);
+    }
+    std::nth_element(sorted, sorted + numSteps / 2, sorted + numSteps);
+    float limit = AUTO_CAL_BOUNDARY_FACTOR * AUTO_CAL_BOUNDARY_FACTOR * sorted[numSteps / 2];
+
+    uint16_t boundaries = 0;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        bool nearPrevious = i > 0 && steps[i - 1] <= limit;
+        bool nearNext = i < numSteps && steps[i] <= limit;
+        boundaries += (nearPrevious || nearNext) ? 0 : 1;
+    }
+    // That many boundaries means only a reading or two per patch: the disk
+    // spun too fast for this, so leave it to the trim after clustering
+    if (boundaries > numSamples / 4) {
+        return;
+    }
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        bool nearPrevious = i > 0 && steps[i - 1] <= limit;
+        bool nearNext = i < numSteps && steps[i] <= limit;
+        if (nearPrevious || nearNext) {
+            samples[kept++] = samples[i];
+        }
+    }
+    boundaryReadings += numSamples - kept;
+    numSamples = kept;
+}
+
+uint8_t AutoCalibrator::runKMeans(float centers[][3], uint8_t assignment[],
+                                  uint16_t clusterSize[], uint8_t maxIterations) {
+    uint8_t iteration = 0;
+    for (; iteration < maxIterations; iteration++) {
+        // Assignment step
+        bool changed = false;
+        for (uint16_t i = 0; i < numSamples; i++) {
+            uint8_t best = 0;
+            float bestDist = distanceSq(samples[i], centers[0]);
+            for (uint8_t k = 1; k < NUM_COLORS; k++) {
+                float d = distanceSq(samples[i], centers[k]);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = k;
+                }
+            }
+            if (iteration == 0 || assignment[i] != best) {
+                assignment[i] = best;
+                changed = true;
+            }
+        }
+
+        // Update step (empty clusters stay where they are)
+        float sums[NUM_COLORS][3] = {};
+        for (int k = 0; k < NUM_COLORS; k++) clusterSize[k] = 0;
+        for (uint16_t i = 0; i < numSamples; i++) {
+            uint8_t k = assignment[i];
+            sums[k][0] += samples[i].r;
+            sums[k][1] += samples[i].g;
+            sums[k][2] += samples[i].b;
+            clusterSize[k]++;
+        }
+        if (!changed) {
+            break;
+        }
+        for (int k = 0; k < NUM_COLORS; k++) {
+            if (clusterSize[k] > 0) {
+                centers[k][0] = sums[k][0] / clusterSize[k];
+                centers[k][1] = sums[k][1] / clusterSize[k];
+                centers[k][2] = sums[k][2] / clusterSize[k];
+            }
+        }
+    }
+    return iteration;
+}
+
+bool AutoCalibrator::shiftSeeds(const ColorCalibration seeds[NUM_COLORS], float centers[][3],
+                                const uint16_t clusterSize[]) const {
+    float shifts[3][NUM_COLORS];
+    uint8_t found = 0;
+    for (uint8_t k = 0; k < NUM_COLORS; k++) {
+        if (clusterSize[k] < AUTO_CAL_MIN_CLUSTER_SAMPLES) continue;
+        shifts[0][found] = centers[k][0] - seeds[k].red;
+        shifts[1][found] = centers[k][1] - seeds[k].green;
+        shifts[2][found] = centers[k][2] - seeds[k].blue;
+        found++;
+    }
+    if (found < NUM_COLORS / 2) {
+        return false;
+    }
+    float shift[3];
+    for (int c = 0; c < 3; c++) {
+        std::nth_element(shifts[c], shifts[c] + found / 2, shifts[c] + found);
+        shift[c] = shifts[c][found / 2];
+    }
+    for (uint8_t k = 0; k < NUM_COLORS; k++) {
+        centers[k][0] = seeds[k].red + shift[0];
+        centers[k][1] = seeds[k].green + shift[1];
+        centers[k][2] = seeds[k].blue + shift[2];
+    }
+    return true;
+}
+
+float AutoCalibrator::splitRatio(uint8_t k, const float center[3], const uint8_t assignment[],
+                                 float a[3], float b[3]) const {
+    // Only look at the cluster's core: a couple of boundary blends sit far out
+    // and would otherwise dominate both the spread and the split direction
+    float meanDist = 0;
+    uint16_t size = 0;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        if (assignment[i] != k) continue;
+        meanDist += sqrtf(distanceSq(samples[i], center));
+        size++;
+    }
+    if (size < 2 * AUTO_CAL_MIN_CLUSTER_SAMPLES) {
+        return 1.0f;
+    }
+    float coreRadius = AUTO_CAL_TRIM_FACTOR * meanDist / size;
+    float coreRadiusSq = coreRadius * coreRadius;
+
+    // Cut the core across its principal axis (a few power iterations on the
+    // covariance), then let 2-means settle the halves
+    float cov[3][3] = {};
+    float sse = 0;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        if (assignment[i] != k || distanceSq(samples[i], center) > coreRadiusSq) continue;
+        float d[3] = {samples[i].r - center[0], samples[i].g - center[1], samples[i].b - center[2]};
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) cov[r][c] += d[r] * d[c];
+        }
+        sse += d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+    }
+    if (sse <= 0) {
+        return 1.0f;
+    }
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int step = 0; step < 8; step++) {
+        float next[3];
+        for (int r = 0; r < 3; r++) {
+            next[r] = cov[r][0]*axis[0] + cov[r][1]*axis[1] + cov[r][2]*axis[2];
+        }
+        float len = sqrtf(next[0]*next[0] + next[1]*next[1] + next[2]*next[2]);
+        if (len <= 0) {
+            return 1.0f;
+        }
+        for (int r = 0; r < 3; r++) axis[r] = next[r] / len;
+    }
+    float spread = sqrtf(sse / size);
+    for (int c = 0; c < 3; c++) {
+        a[c] = center[c] + axis[c] * spread;
+        b[c] = center[c] - axis[c] * spread;
+    }
+
+    float splitSse = 0;
+    uint16_t sizeA = 0;
+    uint16_t sizeB = 0;
+    for (int step = 0; step < 5; step++) {
+        float sumA[3] = {};
+        float sumB[3] = {};
+        splitSse = 0;
+        sizeA = 0;
+        sizeB = 0;
+        for (uint16_t i = 0; i < numSamples; i++) {
+            if (assignment[i] != k || distanceSq(samples[i], center) > coreRadiusSq) continue;
+            float da = distanceSq(samples[i], a);
+            float db = distanceSq(samples[i], b);
+            float* sum = sumA;
+            if (da <= db) {
+                sizeA++;
+                splitSse += da;
+            } else {
+                sum = sumB;
+                sizeB++;
+                splitSse += db;
+            }
+            sum[0] += samples[i].r;
+            sum[1] += samples[i].g;
+            sum[2] += samples[i].b;
+        }
+        if (sizeA == 0 || sizeB == 0) {
+            return 1.0f;
+        }
+        for (int c = 0; c < 3; c++) {
+            a[c] = sumA[c] / sizeA;
+            b[c] = sumB[c] / sizeB;
+        }
+    }
+
+    // Both halves have to look like a patch, not a handful of stray readings
+    if (sizeA < AUTO_CAL_MIN_CLUSTER_SAMPLES || sizeB < AUTO_CAL_MIN_CLUSTER_SAMPLES) {
+        return 1.0f;
+    }
+    return splitSse / sse;
+}
+
+uint8_t AutoCalibrator::cluster(const ColorCalibration seeds[NUM_COLORS],
+                                ColorCalibration centroids[NUM_COLORS],
+                                uint16_t counts[NUM_COLORS]) {
+    for (int k = 0; k < NUM_COLORS; k++) {
+        centroids[k] = seeds[k];
+        counts[k] = 0;
+    }
+    if (numSamples == 0) {
+        return 0;
+    }
+
+    // A blend of a patch and the background, left in, can be nearer a seed
+    // than either and take it, while two real patches share one cluster
+    dropBoundaryReadings();
+
+    // Cluster k starts on seed k
+    float centers[NUM_COLORS][3];
+    for (int k = 0; k < NUM_COLORS; k++) {
+        centers[k][0] = seeds[k].red;
+        centers[k][1] = seeds[k].green;
+        centers[k][2] = seeds[k].blue;
+    }
+
+    // Shared scratch buffer: sensors are clustered one at a time
+    static uint8_t assignment[AUTO_CAL_MAX_SAMPLES];
+    uint16_t clusterSize[NUM_COLORS];
+    uint8_t iteration = runKMeans(centers, assignment, clusterSize, AUTO_CAL_MAX_ITERATIONS);
+
+    // A sensor that reads off the defaults reads off by about as much on every
+    // patch. Two close patches (silver and the white background) can then both
+    // be nearer one seed, and with the background several times the size, the
+    // split below can't tell them apart. Start again from seeds moved by the
+    // shift of the patches that were found, and each gets its own seed back.
+    if (shiftSeeds(seeds, centers, clusterSize)) {
+        iteration += runKMeans(centers, assignment, clusterSize, AUTO_CAL_MAX_ITERATIONS - iteration);
+    }
+
+    // A sensor that reads noticeably off the defaults can pull two close patches
+    // (silver and the white background) onto one seed and leave another cluster
+    // empty. Give each empty cluster the better half of whichever cluster splits
+    // most cleanly in two - but only if the split is real. A patch that simply
+    // isn't on this ring shouldn't get a centroid carved out of one blob.
+    for (int attempt = 0; attempt < NUM_COLORS && iteration < AUTO_CAL_MAX_ITERATIONS; attempt++) {
+        int empty = -1;
+        for (int k = 0; k < NUM_COLORS; k++) {
+            if (clusterSize[k] == 0) {
+                empty = k;
+                break;
+            }
+        }
+        if (empty == -1) {
+            break;
+        }
+
+        int bestSplit = -1;
+        float bestRatio = AUTO_CAL_SPLIT_SSE_RATIO;
+        float bestA[3], bestB[3];
+        for (uint8_t k = 0; k < NUM_COLORS; k++) {
+            float a[3], b[3];
+            float ratio = splitRatio(k, centers[k], assignment, a, b);
+            if (ratio < bestRatio) {
+                bestRatio = ratio;
+                bestSplit = k;
+                memcpy(bestA, a, sizeof(bestA));
+                memcpy(bestB, b, sizeof(bestB));
+            }
+        }
+        if (bestSplit == -1) {
+            break; // remaining empty clusters are genuinely absent
+        }
+        memcpy(centers[bestSplit], bestA, sizeof(bestA));
+        memcpy(centers[empty], bestB, sizeof(bestB));
+        iteration += runKMeans(centers, assignment, clusterSize, AUTO_CAL_MAX_ITERATIONS - iteration);
+    }
+
+    // Readings taken across a patch boundary are blends of two colors. Drop the
+    // ones far from their centroid (relative to the cluster's mean spread) and
+    // recompute, so the centroids sit on the patches themselves.
+    float meanDist[NUM_COLORS] = {};
+    for (int k = 0; k < NUM_COLORS; k++) clusterSize[k] = 0;
+    for (uint16_t i = 0; i < numSamples; i++) {
+        uint8_t k = assignment[i];
+        meanDist[k] += sqrtf(distanceSq(samples[i], centers[k]));
+        clusterSize[k]++;
+    }
+    float sums[NUM_COLORS][3] = {};
+    uint16_t kept[NUM_COLORS] = {};
+    for (int k = 0; k < NUM_COLORS; k++) {
+        if (clusterSize[k] > 0) meanDist[k] /= clusterSize[k];
+    }
+    for (uint16_t i = 0; i < numSamples; i++) {
+        uint8_t k = assignment[i];
+        if (sqrtf(distanceSq(samples[i], centers[k])) <= AUTO_CAL_TRIM_FACTOR * meanDist[k]) {
+            sums[k][0] += samples[i].r;
+            sums[k][1] += samples[i].g;
+            sums[k][2] += samples[i].b;
+            kept[k]++;
+        }
+    }
+    for (int k = 0; k < NUM_COLORS; k++) {
+        if (kept[k] > 0) {
+            centers[k][0] = sums[k][0] / kept[k];
+            centers[k][1] = sums[k][1] / kept[k];
+            centers[k][2] = sums[k][2] / kept[k];
+        }
+    }
+
+    // Map clusters to colors with the lowest total squared distance to the
+    // seeds. Greedy nearest-seed matching swaps silver and white as soon as a
+    // sensor reads a little off; 8! orderings over a precomputed cost table is
+    // only a few milliseconds. Clusters too small to be a real patch don't count.
+    float cost[NUM_COLORS][NUM_COLORS];
+    for (int c = 0; c < NUM_COLORS; c++) {
+        for (int k = 0; k < NUM_COLORS; k++) {
+            float dr = centers[c][0] - seeds[k].red;
+            float dg = centers[c][1] - seeds[k].green;
+            float db = centers[c][2] - seeds[k].blue;
+            cost[c][k] = (kept[c] < AUTO_CAL_MIN_CLUSTER_SAMPLES) ? 0 : dr*dr + dg*dg + db*db;
+        }
+    }
+    uint8_t order[NUM_COLORS];
+    uint8_t bestOrder[NUM_COLORS];
+    for (int c = 0; c < NUM_COLORS; c++) order[c] = bestOrder[c] = c;
+    float bestCost = -1;
+    do {
+        float total = 0;
+        for (int c = 0; c < NUM_COLORS; c++) total += cost[c][order[c]];
+        if (bestCost < 0 || total < bestCost) {
+            bestCost = total;
+            memcpy(bestOrder, order, sizeof(order));
+        }
+    } while (std::next_permutation(order, order + NUM_COLORS));
+
+    for (int c = 0; c < NUM_COLORS; c++) {
+        if (kept[c] < AUTO_CAL_MIN_CLUSTER_SAMPLES) continue;
+        uint8_t k = bestOrder[c];
+        centroids[k].red = (uint)(centers[c][0] + 0.5f);
+        centroids[k].green = (uint)(centers[c][1] + 0.5f);
+        centroids[k].blue = (uint)(centers[c][2] + 0.5f);
+        counts[k] = kept[c];
+    }
+
+    return iteration;
+}
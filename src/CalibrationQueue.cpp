@@ -0,0 +1,169 @@
+#include "CalibrationQueue.h"
+
+Color calibrationStepToColor(CalibrationStep step) {
+    if (step < CalibrationStep::RED || step > CalibrationStep::WHITE) {
+        return Color::UNKNOWN;
+    }
+    // RED..WHITE steps are contiguous and in Color enum order
+    return indexToColor(static_cast<int>(step) - static_cast<int>(CalibrationStep::RED));
+}
+
+CalibrationStep colorToCalibrationStep(Color color) {
+    int index = colorToIndex(color);
+    if (index == -1) {
+        return CalibrationStep::NONE;
+    }
+    return static_cast<CalibrationStep>(static_cast<int>(CalibrationStep::RED) + index);
+}
+
+Color calibrationStepPatch(CalibrationStep step) {
+    if (step == CalibrationStep::GAINS) {
+        return Color::WHITE;
+    }
+    return calibrationStepToColor(step);
+}
+
+const char* calibrationStepName(CalibrationStep step) {
+    switch (step) {
+        case CalibrationStep::NONE:            return "No-Op";
+        case CalibrationStep::DARK_OFFSET:     return "Dark Offset";
+        case CalibrationStep::GAINS:           return "Gains";
+        case CalibrationStep::RESET_DEFAULTS:  return "Reset Defaults";
+        case CalibrationStep::TRANSFER_FROM_A: return "From A";
+        case CalibrationStep::AUTO_ROTATION:   return "Auto Spin";
+        default:                               return colorToString(calibrationStepToColor(step));
+    }
+}
+
+bool CalibrationQueue::enqueue(CalibrationStep step, SensorMask sensorMask) {
+    if (step == CalibrationStep::NONE || sensorMask == 0) {
+        return false;
+    }
+
+    // Same step already waiting? Sample the new sensors in that pass too.
+    for (uint8_t i = 0; i < count; i++) {
+        CalibrationJob& job = jobs[(head + i) % CALIBRATION_QUEUE_CAPACITY];
+        if (job.step == step) {
+            job.sensorMask |= sensorMask;
+            return true;
+        }
+    }
+
+    if (count >= CALIBRATION_QUEUE_CAPACITY) {
+        Serial.println("WARNING: calibration queue full, job dropped");
+        return false;
+    }
+    jobs[(head + count) % CALIBRATION_QUEUE_CAPACITY] = CalibrationJob{step, sensorMask};
+    count++;
+    return true;
+}
+
+bool CalibrationQueue::enqueueFront(CalibrationStep step, SensorMask sensorMask) {
+    if (step == CalibrationStep::NONE || sensorMask == 0) {
+        return false;
+    }
+    if (count >= CALIBRATION_QUEUE_CAPACITY) {
+        Serial.println("WARNING: calibration queue full, job dropped");
+        return false;
+    }
+    head = (head + CALIBRATION_QUEUE_CAPACITY - 1) % CALIBRATION_QUEUE_CAPACITY;
+    jobs[head] = CalibrationJob{step, sensorMask};
+    count++;
+    return true;
+}
+
+void CalibrationQueue::enqueueFullPass(SensorMask sensorMask) {
+    // Gains first: every color centroid is measured in white-balanced space.
+    // WHITE comes right after GAINS so both run on the same patch without a prompt.
+    enqueue(CalibrationStep::GAINS, sensorMask);
+    enqueue(CalibrationStep::WHITE, sensorMask);
+    for (int i = 0; i < NUM_COLORS; i++) {
+        Color color = indexToColor(i);
+        if (color != Color::WHITE) {
+            enqueue(colorToCalibrationStep(color), sensorMask);
+        }
+    }
+}
+
+void CalibrationQueue::enqueueTransferPass(SensorMask sensorMask, uint8_t referenceColors) {
+    referenceColors |= takeColorJobs(sensorMask);
+    // Each step goes after the one before it, even when it merges into a job
+    // that was already waiting
+    uint8_t position = 0;
+    enqueueFrom(position, CalibrationStep::GAINS, sensorMask);
+    enqueueFrom(position, CalibrationStep::WHITE, sensorMask);
+    for (int i = 0; i < NUM_COLORS; i++) {
+        Color color = indexToColor(i);
+        if ((referenceColors & (1 << i)) && color != Color::WHITE) {
+            enqueueFrom(position, colorToCalibrationStep(color), sensorMask);
+        }
+    }
+    enqueueFrom(position, CalibrationStep::TRANSFER_FROM_A, sensorMask);
+}
+
+uint8_t CalibrationQueue::takeColorJobs(SensorMask sensorMask) {
+    uint8_t colors = 0;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        CalibrationJob job = jobs[(head + i) % CALIBRATION_QUEUE_CAPACITY];
+        Color color = calibrationStepToColor(job.step);
+        if (color != Color::UNKNOWN && color != Color::WHITE && (job.sensorMask & sensorMask)) {
+            colors |= 1 << colorToIndex(color);
+            job.sensorMask &= ~sensorMask;
+        }
+        if (job.sensorMask != 0) {
+            jobs[(head + kept++) % CALIBRATION_QUEUE_CAPACITY] = job;
+        }
+    }
+    count = kept;
+    return colors;
+}
+
+bool CalibrationQueue::enqueueFrom(uint8_t& position, CalibrationStep step, SensorMask sensorMask) {
+    for (uint8_t i = position; i < count; i++) {
+        CalibrationJob& job = jobs[(head + i) % CALIBRATION_QUEUE_CAPACITY];
+        if (job.step == step) {
+            job.sensorMask |= sensorMask;
+            position = i + 1;
+            return true;
+        }
+    }
+    if (count >= CALIBRATION_QUEUE_CAPACITY) {
+        Serial.println("WARNING: calibration queue full, job dropped");
+        return false;
+    }
+    jobs[(head + count) % CALIBRATION_QUEUE_CAPACITY] = CalibrationJob{step, sensorMask};
+    count++;
+    position = count;
+    return true;
+}
+
+bool CalibrationQueue::peek(CalibrationJob& job) const {
+    if (count == 0) {
+        return false;
+    }
+    job = jobs[head];
+    return true;
+}
+
+bool CalibrationQueue::pop(CalibrationJob& job) {
+    if (!peek(job)) {
+        return false;
+    }
+    head = (head + 1) % CALIBRATION_QUEUE_CAPACITY;
+    count--;
+    return true;
+}
+
+void CalibrationQueue::clear() {
+    head = 0;
+    count = 0;
+}
+
+uint8_t CalibrationQueue::size() const {
+    return count;
+}
+
+bool CalibrationQueue::isEmpty() const {
+    return count == 0;
+}
@@ -0,0 +1,185 @@
+#include "CalibrationTransfer.h"
+
+void AffineMap::setIdentity() {
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            matrix[r][c] = (r == c) ? 1.0f : 0.0f;
+        }
+        offset[r] = 0;
+    }
+}
+
+ColorCalibration AffineMap::apply(const ColorCalibration& in) const {
+    float x[3] = {(float)in.red, (float)in.green, (float)in.blue};
+    float y[3];
+    for (int r = 0; r < 3; r++) {
+        y[r] = matrix[r][0] * x[0] + matrix[r][1] * x[1] + matrix[r][2] * x[2] + offset[r];
+        y[r] = constrain(y[r] + 0.5f, 0.0f, 65535.0f);
+    }
+    return ColorCalibration{(uint)y[0], (uint)y[1], (uint)y[2]};
+}
+
+static void toVector(const ColorCalibration& cal, double v[3]) {
+    v[0] = cal.red;
+    v[1] = cal.green;
+    v[2] = cal.blue;
+}
+
+// Solve the 3x3 system a * x = b in place (Gaussian elimination, partial
+// pivoting). Returns false if a pivot is negligible next to the matrix scale.
+static bool solve3x3(double a[3][3], double b[3], double x[3]) {
+    double scale = fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]);
+    if (scale <= 0) {
+        return false;
+    }
+    for (int col = 0; col < 3; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < 3; r++) {
+            if (fabs(a[r][col]) > fabs(a[pivot][col])) pivot = r;
+        }
+        if (fabs(a[pivot][col]) < 1e-6 * scale) {
+            return false;
+        }
+        if (pivot != col) {
+            for (int c = 0; c < 3; c++) {
+                double t = a[col][c];
+                a[col][c] = a[pivot][c];
+                a[pivot][c] = t;
+            }
+            double t = b[col];
+            b[col] = b[pivot];
+            b[pivot] = t;
+        }
+        for (int r = col + 1; r < 3; r++) {
+            double f = a[r][col] / a[col][col];
+            for (int c = col; c < 3; c++) a[r][c] -= f * a[col][c];
+            b[r] -= f * b[col];
+        }
+    }
+    for (int r = 2; r >= 0; r--) {
+        double sum = b[r];
+        for (int c = r + 1; c < 3; c++) sum -= a[r][c] * x[c];
+        x[r] = sum / a[r][r];
+    }
+    return true;
+}
+
+TransferModel solveCalibrationTransfer(const ColorCalibration source[NUM_COLORS],
+                                       const ColorCalibration target[NUM_COLORS],
+                                       const bool isReference[NUM_COLORS],
+                                       AffineMap& map) {
+    map.setIdentity();
+
+    // Work on centered data in double: raw sums of squares of 16-bit counts
+    // lose too much precision in float
+    int n = 0;
+    double meanX[3] = {};
+    double meanY[3] = {};
+    for (int k = 0; k < NUM_COLORS; k++) {
+        if (!isReference[k]) continue;
+        double x[3], y[3];
+        toVector(source[k], x);
+        toVector(target[k], y);
+        for (int c = 0; c < 3; c++) {
+            meanX[c] += x[c];
+            meanY[c] += y[c];
+        }
+        n++;
+    }
+    if (n == 0) {
+        return TransferModel::NONE;
+    }
+    for (int c = 0; c < 3; c++) {
+        meanX[c] /= n;
+        meanY[c] /= n;
+    }
+
+    double cov[3][3] = {};   // source x source
+    double cross[3][3] = {}; // source x target
+    for (int k = 0; k < NUM_COLORS; k++) {
+        if (!isReference[k]) continue;
+        double x[3], y[3];
+        toVector(source[k], x);
+        toVector(target[k], y);
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                cov[i][j] += (x[i] - meanX[i]) * (x[j] - meanX[j]);
+                cross[i][j] += (x[i] - meanX[i]) * (y[j] - meanY[j]);
+            }
+        }
+    }
+
+    // Full affine: one least-squares row per target channel. Four references
+    // would fit exactly (noise and all), so it waits for at least one spare;
+    // references that sit on a plane fall through to per-channel fits.
+    if (n >= TRANSFER_AFFINE_MIN_REFERENCES) {
+        float matrix[3][3];
+        bool solved = true;
+        for (int out = 0; out < 3 && solved; out++) {
+            double a[3][3];
+            double b[3];
+            double w[3];
+            memcpy(a, cov, sizeof(a));
+            for (int i = 0; i < 3; i++) b[i] = cross[i][out];
+            solved = solve3x3(a, b, w);
+            for (int i = 0; i < 3; i++) matrix[out][i] = (float)w[i];
+        }
+        if (solved) {
+            for (int out = 0; out < 3; out++) {
+                double offset = meanY[out];
+                for (int i = 0; i < 3; i++) {
+                    map.matrix[out][i] = matrix[out][i];
+                    offset -= matrix[out][i] * meanX[i];
+                }
+                map.offset[out] = (float)offset;
+            }
+            return TransferModel::AFFINE;
+        }
+    }
+
+    // Gain + offset per channel, if the references spread out enough on every
+    // channel to fix a slope
+    if (n >= 2) {
+        bool spreadOk = true;
+        for (int c = 0; c < 3; c++) {
+            if (sqrt(cov[c][c] / n) < TRANSFER_MIN_SPREAD) spreadOk = false;
+        }
+        if (spreadOk) {
+            for (int c = 0; c < 3; c++) {
+                double slope = cross[c][c] / cov[c][c];
+                map.matrix[c][c] = (float)slope;
+                map.offset[c] = (float)(meanY[c] - slope * meanX[c]);
+            }
+            return TransferModel::SCALE_OFFSET;
+        }
+    }
+
+    // Per-channel gain through the origin (least squares over all references)
+    for (int c = 0; c < 3; c++) {
+        double sxy = 0;
+        double sxx = 0;
+        for (int k = 0; k < NUM_COLORS; k++) {
+            if (!isReference[k]) continue;
+            double x[3], y[3];
+            toVector(source[k], x);
+            toVector(target[k], y);
+            sxy += x[c] * y[c];
+            sxx += x[c] * x[c];
+        }
+        if (sxx <= 0) {
+            map.setIdentity();
+            return TransferModel::NONE;
+        }
+        map.matrix[c][c] = (float)(sxy / sxx);
+    }
+    return TransferModel::SCALE;
+}
+
+const char* transferModelName(TransferModel model) {
+    switch (model) {
+        case TransferModel::SCALE:        return "gain";
+        case TransferModel::SCALE_OFFSET: return "gain+offset";
+        case TransferModel::AFFINE:       return "affine";
+        default:                          return "none";
+    }
+}
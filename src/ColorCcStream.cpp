@@ -0,0 +1,105 @@
+#include "ColorCcStream.h"
+
+#define CC_FULL_SCALE 16383
+#define CC_BYTES_PER_VALUE ((COLOR_CC_MODE == 2) ? 6 : 3) // worst case: no running status
+
+uint8_t ColorCcStream::controlFor(uint8_t sensor, ColorCcParam param) {
+    uint16_t control = COLOR_CC_FIRST_CONTROL + sensor * COLOR_CC_PARAMS + param;
+    // 14-bit pairs need an LSB controller at +32; 120-127 are channel mode messages
+    uint16_t last = (COLOR_CC_MODE == 2) ? 31 : 119;
+    return (control <= last) ? control : 0xFF;
+}
+
+void ColorCcStream::toHsb(uint16_t r, uint16_t g, uint16_t b, uint16_t clear, uint16_t hsb[COLOR_CC_PARAMS]) {
+    uint16_t hi = max(r, max(g, b));
+    uint16_t lo = min(r, min(g, b));
+    hsb[COLOR_CC_SATURATION] = (hi == 0) ? 0 : (uint32_t)(hi - lo) * CC_FULL_SCALE / hi;
+    hsb[COLOR_CC_BRIGHTNESS] = (uint32_t)min(clear, (uint16_t)COLOR_CC_CLEAR_FULL_SCALE) * CC_FULL_SCALE /
+                               COLOR_CC_CLEAR_FULL_SCALE;
+    if (hi == lo) {
+        hsb[COLOR_CC_HUE] = 0;
+        return;
+    }
+    // Sector 0-6 around the color wheel, red at 0
+    float d = hi - lo;
+    float h;
+    if (hi == r) {
+        h = ((float)g - b) / d;
+    } else if (hi == g) {
+        h = 2 + ((float)b - r) / d;
+    } else {
+        h = 4 + ((float)r - g) / d;
+    }
+    if (h < 0) {
+        h += 6;
+    }
+    hsb[COLOR_CC_HUE] = (uint16_t)(h * (CC_FULL_SCALE + 1) / 6) & CC_FULL_SCALE;
+}
+
+uint32_t ColorCcStream::intervalMs(uint8_t activeSensors) {
+    uint32_t us = (uint32_t)activeSensors * COLOR_CC_PARAMS * CC_BYTES_PER_VALUE * MIDI_BYTE_US * 100 /
+                  MIDI_TX_CC_SHARE_PERCENT;
+    return max((uint32_t)COLOR_CC_MIN_INTERVAL_MS, (us + 999) / 1000);
+}
+
+void ColorCcStream::resend(uint8_t sensor) {
+    if (sensor < NUM_SENSORS) {
+        sentMask[sensor] = 0;
+    }
+}
+
+void ColorCcStream::update(uint8_t sensor, const SampleRing& history, uint8_t channel, uint8_t activeSensors,
+                           unsigned long nowMs, ColorCcSendCallback send) {
+    if (COLOR_CC_MODE == 0 || sensor >= NUM_SENSORS || history.size() == 0) {
+        return;
+    }
+    uint16_t hsb[COLOR_CC_PARAMS];
+    toHsb(history.calibratedChannel(0, 1).latest(), history.calibratedChannel(1, 1).latest(),
+          history.calibratedChannel(2, 1).latest(), history.rawChannel(SAMPLE_CLEAR, 1).latest(), hsb);
+
+    bool wide = COLOR_CC_MODE == 2;
+    uint8_t moved = 0;
+    for (uint8_t p = 0; p < COLOR_CC_PARAMS; p++) {
+        if (controlFor(sensor, (ColorCcParam)p) == 0xFF) {
+            continue; // no controller left for this one
+        }
+        if (!(sentMask[sensor] & (1 << p))) {
+            moved |= 1 << p;
+            continue;
+        }
+        if (p == COLOR_CC_HUE && hsb[COLOR_CC_SATURATION] < COLOR_CC_HUE_MIN_SATURATION) {
+            continue; // grey: hold the last hue
+        }
+        uint16_t last = lastSent[sensor][p];
+        uint16_t delta = (hsb[p] > last) ? hsb[p] - last : last - hsb[p];
+        if (p == COLOR_CC_HUE && delta > (CC_FULL_SCALE + 1) / 2) {
+            delta = CC_FULL_SCALE + 1 - delta; // the short way round
+        }
+        bool changed = wide ? hsb[p] != last : (hsb[p] >> 7) != (last >> 7);
+        if (changed && delta >= COLOR_CC_THRESHOLD) {
+            moved |= 1 << p;
+        } else {
+            belowCount++;
+        }
+    }
+    if (moved == 0) {
+        return;
+    }
+    if (sentMask[sensor] != 0 && nowMs - lastUpdateMs[sensor] < intervalMs(activeSensors)) {
+        limitedCount++; // still moved on a later reading, so sent then
+        return;
+    }
+
+    for (uint8_t p = 0; p < COLOR_CC_PARAMS; p++) {
+        uint8_t control = controlFor(sensor, (ColorCcParam)p);
+        if (!(moved & (1 << p))) {
+            continue;
+        }
+        if (send(control, hsb[p], wide, channel)) {
+            lastSent[sensor][p] = hsb[p];
+            sentMask[sensor] |= 1 << p;
+            sentCount++;
+        }
+    }
+    lastUpdateMs[sensor] = nowMs;
+}
@@ -51,11 +51,43 @@ ColorCalibration colorCalibrationDefaultDatabase[NUM_COLORS] = {
 
 //todo: maybe do sample counts in the menu as well.
 
+// Command register type bits 01: read/write consecutive registers in one transaction
+#define TCS34725_AUTO_INCREMENT 0x20
+
+// Sensor settings, given to the library and rewritten by probe() after a re-probe
+#define SENSOR_INTEGRATION_TIME TCS34725_INTEGRATIONTIME_24MS
+#define SENSOR_GAIN TCS34725_GAIN_4X
+// Full scale of each channel: 1024 counts per integration cycle (256 - ATIME
+// cycles), capped at 16 bits. 10240 at 24 ms, so well short of 0xFFFF.
+#define SENSOR_SATURATION_COUNT \
+    ((256 - SENSOR_INTEGRATION_TIME) * 1024UL > 0xFFFF ? 0xFFFFUL : (256 - SENSOR_INTEGRATION_TIME) * 1024UL)
+
+// Single-register access for the re-probe steps; Wire status, 0 = ok
+static uint8_t writeRegister(uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(TCS34725_ADDRESS);
+    Wire.write(TCS34725_COMMAND_BIT | reg);
+    Wire.write(value);
+    return Wire.endTransmission();
+}
+
+static bool readRegister(uint8_t reg, uint8_t& value) {
+    Wire.beginTransmission(TCS34725_ADDRESS);
+    Wire.write(TCS34725_COMMAND_BIT | reg);
+    if (Wire.endTransmission() != 0 || Wire.requestFrom((uint8_t)TCS34725_ADDRESS, (uint8_t)1) != 1) {
+        return false;
+    }
+    value = Wire.read();
+    return true;
+}
+
 ColorHelper::ColorHelper(bool normalizeReadings, MenuManager* menuPtr) 
-    : tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X), 
+    : tcs(SENSOR_INTEGRATION_TIME, SENSOR_GAIN), 
       normalize(normalizeReadings), 
       sensorAvailable(false),
       menu(menuPtr) {
+    for (int i = 0; i < NUM_COLORS; i++) {
+        calibrationSpread[i] = CALIBRATION_SPREAD_UNKNOWN;
+    }
 }
 
 // Set or update the color database by copying entries into the internal array
@@ -79,6 +111,10 @@ void ColorHelper::setMenu(MenuManager* menuPtr) {
     menu = menuPtr;
 }
 
+void ColorHelper::setHistory(SampleRing* ring) {
+    history = ring;
+}
+
 bool ColorHelper::begin() {
     // Don't re-initialize Wire - assume it's already been set up by main.cpp
     // The color sensor will use the same I2C bus as the OLED display
@@ -99,13 +135,87 @@ bool ColorHelper::isAvailable() const {
     return sensorAvailable;
 }
 
-void ColorHelper::getRawData(uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* c) {
+void ColorHelper::setAvailable(bool available) {
+    sensorAvailable = available;
+    rawRepeats = 0;
+    lastI2CError = 0;
+}
+
+ProbeResult ColorHelper::probe() {
+    uint8_t id;
+    if (!readRegister(TCS34725_ID, id)) {
+        return ProbeResult::FAILED;
+    }
+    // Same IDs the library accepts: TCS34725, TCS34727 and a common clone
+    if (id != 0x44 && id != 0x4D && id != 0x10) {
+        return ProbeResult::FAILED;
+    }
+    if (writeRegister(TCS34725_ATIME, SENSOR_INTEGRATION_TIME) != 0 ||
+        writeRegister(TCS34725_CONTROL, SENSOR_GAIN) != 0 ||
+        writeRegister(TCS34725_ENABLE, TCS34725_ENABLE_PON) != 0) {
+        return ProbeResult::FAILED;
+    }
+    return ProbeResult::PASSED;
+}
+
+ProbeResult ColorHelper::enableConversions() {
+    if (writeRegister(TCS34725_ENABLE, TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN) != 0) {
+        return ProbeResult::FAILED;
+    }
+    return ProbeResult::PASSED;
+}
+
+ProbeResult ColorHelper::conversionReady() {
+    uint8_t status;
+    if (!readRegister(TCS34725_STATUS, status)) {
+        return ProbeResult::FAILED;
+    }
+    // Until AVALID the data registers hold zeros, which would classify as a color
+    return (status & TCS34725_STATUS_AVALID) ? ProbeResult::PASSED : ProbeResult::PENDING;
+}
+
+bool ColorHelper::getRawData(uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* c) {
     if (!sensorAvailable) {
         *r = *g = *b = *c = 0;
-        return;
+        return false;
     }
-    
-    tcs.getRawData(r, g, b, c);
+
+    // One auto-increment burst over CDATAL..BDATAH instead of the library's four
+    // register reads plus a full integration-time delay(). The sensor integrates
+    // continuously, so the registers always hold the last complete cycle and a
+    // sweep over many sensors costs bus time only.
+    // A missing or wedged sensor fails here within I2C_TIMEOUT_MS.
+    Wire.beginTransmission(TCS34725_ADDRESS);
+    Wire.write(TCS34725_COMMAND_BIT | TCS34725_AUTO_INCREMENT | TCS34725_CDATAL);
+    lastI2CError = Wire.endTransmission();
+    if (lastI2CError == 0 && Wire.requestFrom((uint8_t)TCS34725_ADDRESS, (uint8_t)8) != 8) {
+        lastI2CError = 4; // "other error", as endTransmission() reports it
+    }
+    if (lastI2CError != 0) {
+        *r = *g = *b = *c = 0;
+        return false;
+    }
+    uint16_t data[4];
+    bool same = true;
+    for (int i = 0; i < 4; i++) {
+        uint8_t low = Wire.read();
+        data[i] = low | (Wire.read() << 8);
+        same = same && data[i] == lastRaw[i];
+        lastRaw[i] = data[i];
+    }
+    // Dark (0) and saturated readings legitimately repeat (a bright patch or
+    // stray light can hold full scale for good); anything else repeating
+    // exactly means the registers aren't being updated
+    if (same && data[0] != 0 && data[0] < SENSOR_SATURATION_COUNT) {
+        if (rawRepeats < 0xFFFF) rawRepeats++;
+    } else {
+        rawRepeats = 0;
+    }
+    *c = data[0];
+    *r = data[1];
+    *g = data[2];
+    *b = data[3];
+    return true;
 }
 
 // void ColorHelper::getNormalizedData(float* r, float* g, float* b) {
@@ -125,9 +235,9 @@ void ColorHelper::getRawData(uint16_t* r, uint16_t* g, uint16_t* b, uint16_t* c)
 //     }
 // }
 
-void ColorHelper::getCalibratedData(float* r, float* g, float* b) {
+bool ColorHelper::getCalibratedData(float* r, float* g, float* b) {
     uint16_t rawR, rawG, rawB, rawC;
-    getRawData(&rawR, &rawG, &rawB, &rawC);
+    bool ok = getRawData(&rawR, &rawG, &rawB, &rawC);
     // Serial.print("Raw R: ");
     // Serial.println(rawR);
     // Serial.print("rDark");
@@ -159,6 +269,7 @@ void ColorHelper::getCalibratedData(float* r, float* g, float* b) {
 *r = rAdj;
 *g = gAdj;
 *b = bAdj;
+return ok;
 }
 
 Color ColorHelper::getCurrentColorEnum() {
@@ -166,13 +277,24 @@ Color ColorHelper::getCurrentColorEnum() {
         return Color::UNKNOWN;
     }
     
-    float r, g, b;
+    float rgb[3];
+    uint32_t readStart = micros();
     // Serial.println("DEBUG:  about to call getNormalizedData [getCurrentColorEnum]");
-    getCalibratedData(&r, &g, &b);
+    getCalibratedData(&rgb[0], &rgb[1], &rgb[2]);
+    if (lastI2CError != 0) {
+        return Color::UNKNOWN; // zeros from a failed read aren't a color
+    }
     // Serial.println("DEBUG: About to call findNearestColorEnum [getCurrentColorEnum]");
     // Serial.print("calibrated R: ");
     // Serial.println(r);
-    return findNearestColorEnum(r, g, b);
+    Color color = findNearestColorEnum(rgb[0], rgb[1], rgb[2]);
+    if (history != nullptr) {
+        // The registers hold the last complete integration, which ended at
+        // some point in the last period; on average its midpoint lies one
+        // full period before the read. That's when the color was actually seen.
+        history->push(readStart - SENSOR_INTEGRATION_MS * 1000UL, lastRaw, rgb, color, lastMargin);
+    }
+    return color;
 }
 
 const char* ColorHelper::getCurrentColor() {
@@ -197,6 +319,7 @@ Color ColorHelper::findNearestColorEnum(float r, float g, float b) {
     // Serial.println("DEBUG: inside findNearestColorEnum");
     Color nearestColor = Color::UNKNOWN;
     float minDistance = 1e9f;
+    float secondDistance = 1e9f;
     // Serial.print("[DEBUG]: numColorDatabase is: ");
     // Serial.println(numColorDatabase);
     for (int i = 0; i < numColorDatabase; i++) {
@@ -215,10 +338,16 @@ Color ColorHelper::findNearestColorEnum(float r, float g, float b) {
         float distance = calculateColorDistance(r, g, b, storedR, storedG, storedB);
         
         if (distance < minDistance) {
+            secondDistance = minDistance;
             minDistance = distance;
             nearestColor = indexToColor(i);
+        } else if (distance < secondDistance) {
+            secondDistance = distance;
         }
     }
+
+    // Distances are squared
+    lastMargin = (secondDistance > 0) ? 1.0f - sqrtf(minDistance / secondDistance) : 0.0f;
     
     return nearestColor;
 }
@@ -238,33 +367,170 @@ float ColorHelper::calculateColorDistance(float r1, float g1, float b1,
     return dr*dr + dg*dg + db*db;
 }
 
-void ColorHelper::getSamplesAverage(uint16_t* avgR, uint16_t* avgG, uint16_t* avgB){
-    float sumR, sumG, sumB;
-    sumR = 0;
-    sumG = 0;
-    sumB = 0;
-    delay(50);
-    for(int i = 0; i < NUM_CALIBRATION_STEPS; i++){
-        Serial.print("Sample # ");
-        Serial.println(i);
-        float r, g, b;
-        menu->calibrationIncrementProgressBar(i);
-        getCalibratedData(&r, &g, &b);
+// Per-sensor calibration records are laid out in EEPROMAddresses.h; values are
+// stored as 16-bit counts and widened again on load
+static int calibrationAddress(byte sensorNum, int offset) {
+    return (sensorNum < NUM_SENSORS) ? SENSOR_CAL_ADDR(sensorNum) + offset : -1;
+}
 
-        // I think maybe I shouldn't be normalizing here-- I already normalize when I get calibrated data.
+static int colorCalibrationAddress(byte sensorNum, Color color) {
+    int colorIndex = colorToIndex(color);
+    if (colorIndex == -1) {
+        return -1;
+    }
+    return calibrationAddress(sensorNum, CAL_COLOR_OFFSET + colorIndex * COLOR_BLOCK_SIZE);
+}
 
-        sumR += r;
-        sumG += g;
-        sumB += b;
-        // 
-        delay(100);
-        Serial.print("sum R:");
-        Serial.println(sumR);
+// Color spreads in Color enum order, then the white reference's spread
+static int spreadAddress(byte sensorNum) {
+    return calibrationAddress(sensorNum, CAL_SPREAD_OFFSET);
+}
+
+static void putCounts(int addr, uint32_t r, uint32_t g, uint32_t b) {
+    EEPROM.put(addr, (uint16_t)min(r, (uint32_t)65535));
+    EEPROM.put(addr + 2, (uint16_t)min(g, (uint32_t)65535));
+    EEPROM.put(addr + 4, (uint16_t)min(b, (uint32_t)65535));
+}
+
+static void getCounts(int addr, uint32_t* r, uint32_t* g, uint32_t* b) {
+    uint16_t v[3];
+    EEPROM.get(addr, v[0]);
+    EEPROM.get(addr + 2, v[1]);
+    EEPROM.get(addr + 4, v[2]);
+    *r = v[0];
+    *g = v[1];
+    *b = v[2];
+}
+
+static void putColorCalibration(int addr, const ColorCalibration& cal) {
+    putCounts(addr, cal.red, cal.green, cal.blue);
+}
+
+static void getColorCalibration(int addr, ColorCalibration& cal) {
+    uint32_t r, g, b;
+    getCounts(addr, &r, &g, &b);
+    cal = ColorCalibration{r, g, b};
+}
+
+bool CalibrationAccumulator::add(float r, float g, float b) {
+    float x[3] = {r, g, b};
+
+    // Once there's a little history, drop readings that jump well outside the
+    // spread seen so far (a hand in the way, the patch still being placed)
+    if (count >= CALIBRATION_MIN_SAMPLES / 2) {
+        bool outlier = false;
+        for (int c = 0; c < 3; c++) {
+            float sd = (count > 1) ? sqrtf(m2[c] / (count - 1)) : 0;
+            float limit = max(CALIBRATION_OUTLIER_SIGMA * sd, CALIBRATION_OUTLIER_FLOOR);
+            if (fabsf(x[c] - mean[c]) > limit) {
+                outlier = true;
+            }
+        }
+        if (outlier) {
+            rejected++;
+            consecutiveRejects++;
+            // A run of "outliers" means the reading really moved (the first few
+            // samples were the odd ones out), so start over from here
+            if (consecutiveRejects >= CALIBRATION_MIN_SAMPLES) {
+                Serial.println("Calibration reading moved, restarting statistics");
+                count = 0;
+                consecutiveRejects = 0;
+            } else {
+                return false;
+            }
+        }
     }
-    // Compute averages
-    *avgR = (uint16_t)(sumR / NUM_CALIBRATION_STEPS);
-    *avgG = (uint16_t)(sumG / NUM_CALIBRATION_STEPS);
-    *avgB = (uint16_t)(sumB / NUM_CALIBRATION_STEPS);
+    consecutiveRejects = 0;
+
+    count++;
+    for (int c = 0; c < 3; c++) {
+        if (count == 1) {
+            mean[c] = x[c];
+            m2[c] = 0;
+            continue;
+        }
+        float delta = x[c] - mean[c];
+        mean[c] += delta / count;
+        m2[c] += delta * (x[c] - mean[c]);
+    }
+    return true;
+}
+
+void CalibrationAccumulator::average(uint16_t* avgR, uint16_t* avgG, uint16_t* avgB) const {
+    if (count == 0) {
+        *avgR = *avgG = *avgB = 0;
+        return;
+    }
+    *avgR = (uint16_t)constrain(mean[0] + 0.5f, 0.0f, 65535.0f);
+    *avgG = (uint16_t)constrain(mean[1] + 0.5f, 0.0f, 65535.0f);
+    *avgB = (uint16_t)constrain(mean[2] + 0.5f, 0.0f, 65535.0f);
+}
+
+void CalibrationAccumulator::variance(float* varR, float* varG, float* varB) const {
+    if (count < 2) {
+        *varR = *varG = *varB = 0;
+        return;
+    }
+    *varR = m2[0] / (count - 1);
+    *varG = m2[1] / (count - 1);
+    *varB = m2[2] / (count - 1);
+}
+
+uint16_t CalibrationAccumulator::spread() const {
+    if (count < 2) {
+        return CALIBRATION_SPREAD_UNKNOWN;
+    }
+    float varR, varG, varB;
+    variance(&varR, &varG, &varB);
+    // Keep 0xFFFF free for "unknown", and 0 for never written (see loadCalibrationSpread)
+    return (uint16_t)constrain(sqrtf((varR + varG + varB) / 3.0f), 1.0f, 65534.0f);
+}
+
+bool CalibrationAccumulator::converged() const {
+    if (count < CALIBRATION_MIN_SAMPLES) {
+        return false;
+    }
+    // Half-width of the CI on the mean is z * sd / sqrt(n); compare squared
+    float limit = CALIBRATION_CI_HALF_WIDTH * CALIBRATION_CI_HALF_WIDTH / (CALIBRATION_CI_Z * CALIBRATION_CI_Z);
+    for (int c = 0; c < 3; c++) {
+        float varOfMean = m2[c] / (count - 1) / count;
+        if (varOfMean > limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColorHelper::sampleCalibrated(CalibrationAccumulator& acc) {
+    float r, g, b;
+    if (!getCalibratedData(&r, &g, &b)) {
+        acc.failed++;
+        return false;
+    }
+    acc.add(r, g, b);
+    return true;
+}
+
+bool ColorHelper::sampleWhite(CalibrationAccumulator& acc) {
+    uint16_t r, g, b, c;
+    if (!getRawData(&r, &g, &b, &c)) {
+        acc.failed++;
+        return false;
+    }
+
+    // I think maybe I shouldn't be normalizing here.
+    if (this->normalize && c != 0) {  // avoid divide-by-zero
+        acc.add((float)r / c * 65535, (float)g / c * 65535, (float)b / c * 65535);
+    } else {
+        acc.add(r, g, b);
+    }
+    return true;
+}
+
+void ColorHelper::getSamplesAverage(uint16_t* avgR, uint16_t* avgG, uint16_t* avgB){
+    CalibrationAccumulator acc;
+    getSamplesStats(acc, false);
+    acc.average(avgR, avgG, avgB);
 
     Serial.println("Averages were: ");
     Serial.print(*avgR);
@@ -275,6 +541,34 @@ void ColorHelper::getSamplesAverage(uint16_t* avgR, uint16_t* avgG, uint16_t* av
 
 }
 
+void ColorHelper::getSamplesStats(CalibrationAccumulator& acc, bool white){
+    delay(50);
+    int i = 0;
+    for(; i < NUM_CALIBRATION_STEPS && !acc.converged(); i++){
+        Serial.print("Sample # ");
+        Serial.println(i);
+        menu->calibrationIncrementProgressBar(i);
+        if (white) {
+            sampleWhite(acc);
+        } else {
+            sampleCalibrated(acc);
+        }
+        delay(100);
+    }
+    menu->calibrationIncrementProgressBar(NUM_CALIBRATION_STEPS);
+
+    Serial.print("Used ");
+    Serial.print(acc.count);
+    Serial.print(" of ");
+    Serial.print(i);
+    Serial.print(" samples (");
+    Serial.print(acc.rejected);
+    Serial.print(" rejected, ");
+    Serial.print(acc.failed);
+    Serial.print(" failed reads), spread ");
+    Serial.println(acc.spread());
+}
+
 void ColorHelper::calibrateDark(){
     Serial.println("Not currently working, need to install LED off pins");
     return;
@@ -284,30 +578,13 @@ void ColorHelper::calibrateDark(){
     bDark = 0;
 
     // save to EEPROM
-    switch(SensorNum){
-        case 0:
-            EEPROM.put(SENSOR_A_RDARK_ADDR, rDark);
-            EEPROM.put(SENSOR_A_GDARK_ADDR, gDark);
-            EEPROM.put(SENSOR_A_BDARK_ADDR, bDark);
-            break;
-        case 1:
-            EEPROM.put(SENSOR_B_RDARK_ADDR, rDark);
-            EEPROM.put(SENSOR_B_GDARK_ADDR, gDark);
-            EEPROM.put(SENSOR_B_BDARK_ADDR, bDark);
-            break;
-        case 2:
-            EEPROM.put(SENSOR_C_RDARK_ADDR, rDark);
-            EEPROM.put(SENSOR_C_GDARK_ADDR, gDark);
-            EEPROM.put(SENSOR_C_BDARK_ADDR, bDark);
-            break;
-        case 3:
-            EEPROM.put(SENSOR_D_RDARK_ADDR, rDark);
-            EEPROM.put(SENSOR_D_GDARK_ADDR, gDark);
-            EEPROM.put(SENSOR_D_BDARK_ADDR, bDark);
-            break;
-        default:
-            Serial.println("ERROR: Invalid sensor number for dark calibration");
+    int addr = calibrationAddress(SensorNum, CAL_DARK_OFFSET);
+    if (addr < 0) {
+        Serial.println("ERROR: Invalid sensor number for dark calibration");
+        return;
     }
+    putCounts(addr, rDark, gDark, bDark);
+    forgetColorSpreads();
     EEPROM.commit();
     */
 }
@@ -317,45 +594,36 @@ void ColorHelper::calibrateWhiteGains(){
 
     //todo: menu should tell you what to do and that this should be done AFTER dark offset
  
-    Serial.println("WARNING: NEEDS TO BE UPDATED");
+    CalibrationAccumulator acc;
+    menu->calibrationStartProgressBar();
+    getSamplesStats(acc, true);
+    if (acc.count == 0) {
+        Serial.println("White calibration failed: no good reads, nothing changed");
+        return;
+    }
+    uint16_t avgRw, avgGw, avgBw;
+    acc.average(&avgRw, &avgGw, &avgBw);
+    applyWhiteCalibration(avgRw, avgGw, avgBw, acc.spread());
+    EEPROM.commit();
+    Serial.println("White calibration complete!");
+}
 
+void ColorHelper::applyWhiteCalibration(uint16_t avgRw, uint16_t avgGw, uint16_t avgBw, uint16_t spread){
     Serial.print("Pre Cal Wvals: ");
     Serial.print(rW);
     Serial.print(", ");
     Serial.print(gW);
     Serial.print(", ");
     Serial.println(bW);
-  uint16_t avgRw, avgGw, avgBw;
-  uint16_t sumRw, sumGw, sumBw;
-    sumRw = 0;
-    sumGw = 0;
-    sumBw = 0;
-    delay(50);
-    menu->calibrationStartProgressBar();
-    for(int i = 0; i < NUM_CALIBRATION_STEPS; i++){
-        Serial.print("Sample # ");
-        Serial.println(i);
-        uint16_t r, g, b, c;
-        getRawData(&r, &g, &b, &c);
-
-        // I think maybe I shouldn't be normalizing here.
 
-        if (this->normalize && c != 0) {  // avoid divide-by-zero
-            sumRw += (uint32_t)((float)r / c * 65535);
-            sumGw += (uint32_t)((float)g / c * 65535);
-            sumBw += (uint32_t)((float)b / c * 65535);
-        } else {
-            sumRw += r;
-            sumGw += g;
-            sumBw += b;
-        }
-        menu->calibrationIncrementProgressBar(i);
-        delay(100);
+    // A zero channel would turn its gain into inf; keep the old reference instead
+    if (avgRw == 0 || avgGw == 0 || avgBw == 0) {
+        Serial.println("ERROR: white reference has an empty channel, keeping previous gains");
+        return;
     }
-    // Compute averages
-    rW = sumRw / NUM_CALIBRATION_STEPS;
-    gW = sumGw / NUM_CALIBRATION_STEPS;
-    bW = sumBw / NUM_CALIBRATION_STEPS;
+    rW = avgRw;
+    gW = avgGw;
+    bW = avgBw;
 
     Serial.print("Post Cal wVals: ");
     Serial.print(rW);
@@ -364,46 +632,45 @@ void ColorHelper::calibrateWhiteGains(){
     Serial.print(", ");
     Serial.println(bW);
 
-
-    float avg = (rW + gW + bW) / 3.0f;
-    rGain = avg / rW;
-    gGain = avg / gW;
-    bGain = avg / bW;
+    updateGains();
 
     //save W values
-    switch(SensorNum){
-        case 0:
-            EEPROM.put(SENSOR_A_RW_ADDR, rW);
-            EEPROM.put(SENSOR_A_GW_ADDR, gW);
-            EEPROM.put(SENSOR_A_BW_ADDR, bW);
-            break;
-        case 1:
-            EEPROM.put(SENSOR_B_RW_ADDR, rW);
-            EEPROM.put(SENSOR_B_GW_ADDR, gW);
-            EEPROM.put(SENSOR_B_BW_ADDR, bW);
-            break;
-        case 2:
-            EEPROM.put(SENSOR_C_RW_ADDR, rW);
-            EEPROM.put(SENSOR_C_GW_ADDR, gW);
-            EEPROM.put(SENSOR_C_BW_ADDR, bW);
-            break;
-        case 3:
-            EEPROM.put(SENSOR_D_RW_ADDR, rW);
-            EEPROM.put(SENSOR_D_GW_ADDR, gW);
-            EEPROM.put(SENSOR_D_BW_ADDR, bW);
-            break;
-        default:
-            Serial.println("ERROR: Invalid sensor number for white calibration");
+    int addr = calibrationAddress(SensorNum, CAL_WHITE_OFFSET);
+    if (addr < 0) {
+        Serial.println("ERROR: Invalid sensor number for white calibration");
+        return;
     }
-    EEPROM.commit();
-    Serial.println("White calibration complete!");
+    putCounts(addr, rW, gW, bW);
+
+    whiteSpread = spread;
+    forgetColorSpreads();
+}
+
+void ColorHelper::forgetColorSpreads(){
+    // Centroids measured under the old dark offset or gains no longer count
+    // as measured on this sensor (transferCalibrationFrom's references)
+    for (int i = 0; i < NUM_COLORS; i++) {
+        calibrationSpread[i] = CALIBRATION_SPREAD_UNKNOWN;
+    }
+    saveCalibrationSpread();
+}
+
+void ColorHelper::updateGains(){
+    avgW = (rW + gW + bW) / 3.0f;
+    rGain = avgW / (float)rW;
+    gGain = avgW / (float)gW;
+    bGain = avgW / (float)bW;
 }
 
 void ColorHelper::calibrateColor(Color color){
 
     Serial.print("Calibrating color ");
     Serial.println(colorToString(color));
-    byte colorIndex = colorToIndex(color);
+    int colorIndex = colorToIndex(color);
+    if (colorIndex == -1) {
+        Serial.println("Invalid color for calibration!");
+        return;
+    }
     Serial.print("Color index: ");
     Serial.println(colorIndex);
   
@@ -414,18 +681,34 @@ void ColorHelper::calibrateColor(Color color){
     Serial.print(", b: ");
     Serial.println(this->calibrationDatabase[colorIndex].blue);
     Serial.println("Starting color calibration...");
-  uint16_t avgR, avgG, avgB;
+  CalibrationAccumulator acc;
   menu->calibrationStartProgressBar();
-  getSamplesAverage(&avgR, &avgG, &avgB);
+  getSamplesStats(acc, false);
+  if (acc.count == 0) {
+    Serial.println("Calibration failed: no good reads, nothing changed");
+    return;
+  }
+  uint16_t avgR, avgG, avgB;
+  acc.average(&avgR, &avgG, &avgB);
 
   Serial.println("Calibration complete!");
-  Serial.print("Average R: "); Serial.println(avgR);
-  Serial.print("Average G: "); Serial.println(avgG);
-  Serial.print("Average B: "); Serial.println(avgB);
+  applyColorCalibration(color, avgR, avgG, avgB, acc.spread());
+  EEPROM.commit();
+}
 
-  
-  ColorCalibration newCal{avgR, avgG, avgB};
-  this->calibrationDatabase[colorIndex] = newCal;
+void ColorHelper::applyColorCalibration(Color color, uint16_t avgR, uint16_t avgG, uint16_t avgB, uint16_t spread){
+    int colorIndex = colorToIndex(color);
+    if (colorIndex == -1) {
+        Serial.println("Invalid color for calibration!");
+        return;
+    }
+
+    Serial.print("Average R: "); Serial.println(avgR);
+    Serial.print("Average G: "); Serial.println(avgG);
+    Serial.print("Average B: "); Serial.println(avgB);
+
+    ColorCalibration newCal{avgR, avgG, avgB};
+    this->calibrationDatabase[colorIndex] = newCal;
 
     Serial.print("new vals r,g,b: ");
     Serial.print(this->calibrationDatabase[colorIndex].red);
@@ -434,109 +717,137 @@ void ColorHelper::calibrateColor(Color color){
     Serial.print(",");
     Serial.println(this->calibrationDatabase[colorIndex].blue);
 
-//save results to EEPROM
-uint redAddr, greenAddr, purpleAddr, blueAddr, orangeAddr, yellowAddr, silverAddr, whiteAddr;
-switch(SensorNum){
-//     enum class Color : uint8_t {
-//     RED = 0,
-//     GREEN = 1,
-//     PURPLE = 2,
-//     BLUE = 3,
-//     ORANGE = 4,
-//     YELLOW = 5,
-//     SILVER = 6,
-//     WHITE = 7,      // Special color - ignore this
-//     UNKNOWN = 255   // Special value for unrecognized colors
-// };
-    case 0:
-        redAddr = SENSOR_A_RED_CAL_ADDR;
-        greenAddr = SENSOR_A_GREEN_CAL_ADDR;
-        purpleAddr = SENSOR_A_PURPLE_CAL_ADDR;
-        blueAddr = SENSOR_A_BLUE_CAL_ADDR;
-        orangeAddr = SENSOR_A_ORANGE_CAL_ADDR;
-        yellowAddr = SENSOR_A_YELLOW_CAL_ADDR;
-        silverAddr = SENSOR_A_SILVER_CAL_ADDR;
-        whiteAddr = SENSOR_A_WHITE_CAL_ADDR;
-        break;
-    case 1:
-        redAddr = SENSOR_B_RED_CAL_ADDR;
-        greenAddr = SENSOR_B_GREEN_CAL_ADDR;
-        purpleAddr = SENSOR_B_PURPLE_CAL_ADDR;
-        blueAddr = SENSOR_B_BLUE_CAL_ADDR;
-        orangeAddr = SENSOR_B_ORANGE_CAL_ADDR;
-        yellowAddr = SENSOR_B_YELLOW_CAL_ADDR;
-        silverAddr = SENSOR_B_SILVER_CAL_ADDR;
-        whiteAddr = SENSOR_B_WHITE_CAL_ADDR;
-        break;
-    case 2:
-        redAddr = SENSOR_C_RED_CAL_ADDR;
-        greenAddr = SENSOR_C_GREEN_CAL_ADDR;
-        purpleAddr = SENSOR_C_PURPLE_CAL_ADDR;
-        blueAddr = SENSOR_C_BLUE_CAL_ADDR;
-        orangeAddr = SENSOR_C_ORANGE_CAL_ADDR;
-        yellowAddr = SENSOR_C_YELLOW_CAL_ADDR;
-        silverAddr = SENSOR_C_SILVER_CAL_ADDR;
-        whiteAddr = SENSOR_C_WHITE_CAL_ADDR;
-        break;
-    case 3:
-        redAddr = SENSOR_D_RED_CAL_ADDR;
-        greenAddr = SENSOR_D_GREEN_CAL_ADDR;
-        purpleAddr = SENSOR_D_PURPLE_CAL_ADDR;
-        blueAddr = SENSOR_D_BLUE_CAL_ADDR;
-        orangeAddr = SENSOR_D_ORANGE_CAL_ADDR;
-        yellowAddr = SENSOR_D_YELLOW_CAL_ADDR;
-        silverAddr = SENSOR_D_SILVER_CAL_ADDR;
-        whiteAddr = SENSOR_D_WHITE_CAL_ADDR;
-        break;
-    default:
+    //save results to EEPROM
+    int addr = colorCalibrationAddress(SensorNum, color);
+    if (addr < 0) {
         Serial.println("ERROR: Invalid sensor number for color calibration");
         return;
+    }
     Serial.print("Saving for sensor #");
     Serial.println(SensorNum);
+    putColorCalibration(addr, newCal);
+
+    calibrationSpread[colorIndex] = spread;
+    EEPROM.put(spreadAddress(SensorNum) + 2 * colorIndex, spread);
 }
 
-/*
-    RED,
-    GREEN,
-    PURPLE,
-    BLUE,
-    ORANGE,
-    YELLOW,
-    SILVER,
-    WHITE,
-    */
-    switch(color){
-        case Color::RED:
-            EEPROM.put(redAddr, newCal);
-            break;
-        case Color::GREEN:
-            EEPROM.put(greenAddr, newCal);
-            break;
-        case Color::PURPLE:
-            EEPROM.put(purpleAddr, newCal);
-            break;
-        case Color::BLUE:
-            EEPROM.put(blueAddr, newCal);
-            break;
-        case Color::ORANGE:
-            EEPROM.put(orangeAddr, newCal);
-            break;
-        case Color::YELLOW:
-            EEPROM.put(yellowAddr, newCal);
-            break;
-        case Color::SILVER:
-            EEPROM.put(silverAddr, newCal);
-            break;
-        case Color::WHITE:
-            EEPROM.put(whiteAddr, newCal);
-            break;
-        default:
-            Serial.println("Invalid color for calirbation!");
-            break;
-    Serial.print("Color: ");
-    Serial.println(colorToString(color));
+void ColorHelper::resetCalibrationDefaults(){
+    setColorDatabase(colorCalibrationDefaultDatabase, NUM_COLORS);
+    rDark = 0;
+    gDark = 0;
+    bDark = 0;
+    rW = DEFAULT_RW;
+    gW = DEFAULT_GW;
+    bW = DEFAULT_BW;
+    updateGains();
+
+    for (int i = 0; i < NUM_COLORS; i++) {
+        calibrationSpread[i] = CALIBRATION_SPREAD_UNKNOWN;
     }
-    EEPROM.commit();
+    whiteSpread = CALIBRATION_SPREAD_UNKNOWN;
+    saveCalibration();
+    Serial.print("Restored default calibration for sensor #");
+    Serial.println(SensorNum);
 }
 
-    
+TransferModel ColorHelper::transferCalibrationFrom(const ColorHelper& source){
+    bool isReference[NUM_COLORS];
+    for (int i = 0; i < NUM_COLORS; i++) {
+        isReference[i] = calibrationSpread[i] != CALIBRATION_SPREAD_UNKNOWN;
+    }
+    if (!isReference[colorToIndex(Color::WHITE)]) {
+        Serial.print("ERROR: calibrate white on sensor #");
+        Serial.print(SensorNum);
+        Serial.println(" before transferring");
+        return TransferModel::NONE;
+    }
+
+    AffineMap map;
+    TransferModel model = solveCalibrationTransfer(source.calibrationDatabase, calibrationDatabase, isReference, map);
+    if (model == TransferModel::NONE) {
+        return model;
+    }
+
+    Serial.print("Transfer to sensor #");
+    Serial.print(SensorNum);
+    Serial.print(" using ");
+    Serial.println(transferModelName(model));
+    for (int i = 0; i < NUM_COLORS; i++) {
+        if (isReference[i]) {
+            // Check how well the mapping reproduces what was actually measured
+            ColorCalibration predicted = map.apply(source.calibrationDatabase[i]);
+            Serial.print("  ref ");
+            Serial.print(colorToString(indexToColor(i)));
+            Serial.print(" error ");
+            Serial.print((int)predicted.red - (int)calibrationDatabase[i].red);
+            Serial.print(", ");
+            Serial.print((int)predicted.green - (int)calibrationDatabase[i].green);
+            Serial.print(", ");
+            Serial.println((int)predicted.blue - (int)calibrationDatabase[i].blue);
+            continue;
+        }
+        calibrationDatabase[i] = map.apply(source.calibrationDatabase[i]);
+        putColorCalibration(colorCalibrationAddress(SensorNum, indexToColor(i)), calibrationDatabase[i]);
+    }
+    return model;
+}
+
+void ColorHelper::loadCalibration(){
+    if (SensorNum >= NUM_SENSORS) {
+        Serial.println("ERROR: Invalid sensor number for calibration load");
+        return;
+    }
+    getCounts(calibrationAddress(SensorNum, CAL_DARK_OFFSET), &rDark, &gDark, &bDark);
+    getCounts(calibrationAddress(SensorNum, CAL_WHITE_OFFSET), &rW, &gW, &bW);
+    updateGains();
+
+    ColorCalibration stored[NUM_COLORS];
+    for (int i = 0; i < NUM_COLORS; i++) {
+        getColorCalibration(colorCalibrationAddress(SensorNum, indexToColor(i)), stored[i]);
+    }
+    setColorDatabase(stored, NUM_COLORS);
+    loadCalibrationSpread();
+}
+
+void ColorHelper::saveCalibration(){
+    if (SensorNum >= NUM_SENSORS) {
+        Serial.println("ERROR: Invalid sensor number for calibration save");
+        return;
+    }
+    putCounts(calibrationAddress(SensorNum, CAL_DARK_OFFSET), rDark, gDark, bDark);
+    putCounts(calibrationAddress(SensorNum, CAL_WHITE_OFFSET), rW, gW, bW);
+    for (int i = 0; i < NUM_COLORS; i++) {
+        putColorCalibration(colorCalibrationAddress(SensorNum, indexToColor(i)), calibrationDatabase[i]);
+    }
+    saveCalibrationSpread();
+}
+
+void ColorHelper::loadCalibrationSpread(){
+    int addr = spreadAddress(SensorNum);
+    if (addr < 0) {
+        return;
+    }
+    for (int i = 0; i < NUM_COLORS; i++) {
+        EEPROM.get(addr + 2 * i, calibrationSpread[i]);
+        if (calibrationSpread[i] == 0) {
+            calibrationSpread[i] = CALIBRATION_SPREAD_UNKNOWN;
+        }
+    }
+    EEPROM.get(addr + 2 * NUM_COLORS, whiteSpread);
+    // The ESP32's EEPROM emulation reads never-written bytes as 0, and a
+    // measured spread is never 0 (see CalibrationAccumulator::spread)
+    if (whiteSpread == 0) {
+        whiteSpread = CALIBRATION_SPREAD_UNKNOWN;
+    }
+}
+
+void ColorHelper::saveCalibrationSpread(){
+    int addr = spreadAddress(SensorNum);
+    if (addr < 0) {
+        return;
+    }
+    for (int i = 0; i < NUM_COLORS; i++) {
+        EEPROM.put(addr + 2 * i, calibrationSpread[i]);
+    }
+    EEPROM.put(addr + 2 * NUM_COLORS, whiteSpread);
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "DiskTempo.h"
+
+static_assert(DISK_TEMPO_MAX_REV_MS <= 65535, "candidates are stored as 16-bit ms");
+
+static bool agree(uint32_t a, uint32_t b) {
+    uint32_t diff = (a > b) ? a - b : b - a;
+    return diff * 100 <= a * DISK_TEMPO_TOLERANCE_PERCENT;
+}
+
+void DiskTempo::colorChange(uint8_t sensor, Color from, Color to, unsigned long nowMs) {
+    uint8_t f = static_cast<uint8_t>(from);
+    uint8_t t = static_cast<uint8_t>(to);
+    if (sensor >= DISK_TEMPO_SENSORS || f >= NUM_COLORS || t >= NUM_COLORS || f == t) {
+        return;
+    }
+    uint32_t& seen = lastSeen[sensor][f][t];
+    uint32_t previous = seen;
+    seen = nowMs;
+    if (previous == 0) {
+        return;
+    }
+    uint32_t period = nowMs - previous;
+    if (period < DISK_TEMPO_MIN_REV_MS || period > DISK_TEMPO_MAX_REV_MS) {
+        return;
+    }
+    candidates[nextCandidate] = period;
+    nextCandidate = (nextCandidate + 1) % DISK_TEMPO_CANDIDATES;
+    if (candidateCount < DISK_TEMPO_CANDIDATES) {
+        candidateCount++;
+    }
+    lastCandidateMs = nowMs;
+    estimate();
+}
+
+void DiskTempo::estimate() {
+    // The candidate with the most others in agreement; ties go to the longer,
+    // since a repeat within a turn is always shorter than the turn
+    uint8_t bestVotes = 0;
+    uint16_t best = 0;
+    for (uint8_t i = 0; i < candidateCount; i++) {
+        uint8_t votes = 0;
+        for (uint8_t j = 0; j < candidateCount; j++) {
+            votes += agree(candidates[i], candidates[j]) ? 1 : 0;
+        }
+        if (votes > bestVotes || (votes == bestVotes && candidates[i] > best)) {
+            bestVotes = votes;
+            best = candidates[i];
+        }
+    }
+    if (bestVotes < DISK_TEMPO_MIN_VOTES) {
+        estimateMs = 0;
+        return;
+    }
+    uint32_t sum = 0;
+    uint8_t n = 0;
+    for (uint8_t j = 0; j < candidateCount; j++) {
+        if (agree(best, candidates[j])) {
+            sum += candidates[j];
+            n++;
+        }
+    }
+    estimateMs = sum / n;
+}
+
+uint32_t DiskTempo::revolutionMs(unsigned long nowMs) const {
+    if (estimateMs == 0 || nowMs - lastCandidateMs > 3 * estimateMs) {
+        return 0;
+    }
+    return estimateMs;
+}
+
+float DiskTempo::bpm(unsigned long nowMs) const {
+    uint32_t rev = revolutionMs(nowMs);
+    return (rev == 0) ? 0 : DISK_TEMPO_BEATS_PER_REV * 60000.0f / rev;
+}
@@ -0,0 +1,101 @@
+#include "GateWheel.h"
+
+static_assert((GATE_WHEEL_SLOTS & (GATE_WHEEL_SLOTS - 1)) == 0 && GATE_WHEEL_SLOTS <= 32768,
+              "GATE_WHEEL_SLOTS must be a power of two");
+static_assert(GATE_MAX_EVENTS < 255, "GateWheel nodes are linked by 8-bit index (0xFF = none)");
+
+GateWheel::GateWheel() {
+    for (uint16_t s = 0; s < GATE_WHEEL_SLOTS; s++) {
+        head[s] = NONE;
+        tail[s] = NONE;
+    }
+    for (uint8_t i = 0; i < GATE_MAX_EVENTS; i++) {
+        nodes[i].next = (i + 1 < GATE_MAX_EVENTS) ? i + 1 : NONE;
+    }
+    freeList = 0;
+}
+
+void GateWheel::append(uint16_t slot, uint8_t index) {
+    nodes[index].next = NONE;
+    if (head[slot] == NONE) {
+        head[slot] = index;
+    } else {
+        nodes[tail[slot]].next = index;
+    }
+    tail[slot] = index;
+}
+
+bool GateWheel::schedule(uint32_t delayTicks, const GateEvent& event) {
+    if (freeList == NONE) {
+        overflowCount++;
+        return false;
+    }
+    if (delayTicks == 0) {
+        delayTicks = 1;
+    }
+    uint8_t index = freeList;
+    freeList = nodes[index].next;
+
+    Node& node = nodes[index];
+    node.event = event;
+    // The slot comes round every GATE_WHEEL_SLOTS ticks; the last time is the one
+    uint32_t rounds = (delayTicks - 1) / GATE_WHEEL_SLOTS;
+    node.rounds = (rounds > 0xFFFF) ? 0xFFFF : (uint16_t)rounds;
+    append((currentTick + delayTicks) & (GATE_WHEEL_SLOTS - 1), index);
+
+    pendingCount++;
+    if (pendingCount > pendingMax) {
+        pendingMax = pendingCount;
+    }
+    return true;
+}
+
+void GateWheel::expireSlot(uint16_t slot, GateFireFunction fire, void* context) {
+    // Take the whole list first: `fire` may schedule, even into this slot
+    uint8_t index = head[slot];
+    head[slot] = NONE;
+    tail[slot] = NONE;
+    while (index != NONE) {
+        Node& node = nodes[index];
+        uint8_t next = node.next;
+        if (node.rounds > 0) {
+            node.rounds--;
+            append(slot, index);
+        } else {
+            GateEvent event = node.event;
+            node.next = freeList;
+            freeList = index;
+            pendingCount--;
+            fire(event, context);
+        }
+        index = next;
+    }
+}
+
+void GateWheel::advanceTo(uint32_t tick, GateFireFunction fire, void* context) {
+    while (currentTick != tick) {
+        currentTick++;
+        if (pendingCount > 0) {
+            expireSlot(currentTick & (GATE_WHEEL_SLOTS - 1), fire, context);
+        }
+    }
+}
+
+void GateWheel::flush(GateFireFunction fire, void* context) {
+    for (uint16_t k = 1; k <= GATE_WHEEL_SLOTS; k++) {
+        uint16_t slot = (currentTick + k) & (GATE_WHEEL_SLOTS - 1);
+        uint8_t index = head[slot];
+        head[slot] = NONE;
+        tail[slot] = NONE;
+        while (index != NONE) {
+            Node& node = nodes[index];
+            uint8_t next = node.next;
+            GateEvent event = node.event;
+            node.next = freeList;
+            freeList = index;
+            pendingCount--;
+            fire(event, context);
+            index = next;
+        }
+    }
+}
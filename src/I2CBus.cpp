@@ -0,0 +1,45 @@
+#include "I2CBus.h"
+#include "PinDefinitions.h"
+#include <Wire.h>
+
+// Half an SCL period at 100 kHz; slow enough for anything on the bus
+#define BUS_CLEAR_HALF_PERIOD_US 5
+
+void beginI2CBus() {
+    Wire.begin(OLED_SDA, OLED_SCL);
+    Wire.setClock(I2C_CLOCK_HZ);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+}
+
+bool i2cBusHeld() {
+    return digitalRead(OLED_SDA) == LOW || digitalRead(OLED_SCL) == LOW;
+}
+
+bool clearI2CBus() {
+    Wire.end();
+    pinMode(OLED_SDA, INPUT_PULLUP);
+    pinMode(OLED_SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(OLED_SCL, HIGH);
+    delayMicroseconds(BUS_CLEAR_HALF_PERIOD_US);
+
+    // Each pulse lets the stuck slave shift out one more bit; after at most
+    // 9 it has finished its byte (plus ACK) and lets go of SDA
+    for (int i = 0; i < 9 && digitalRead(OLED_SDA) == LOW; i++) {
+        digitalWrite(OLED_SCL, LOW);
+        delayMicroseconds(BUS_CLEAR_HALF_PERIOD_US);
+        digitalWrite(OLED_SCL, HIGH);
+        delayMicroseconds(BUS_CLEAR_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA low -> high while SCL is high
+    pinMode(OLED_SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(OLED_SDA, LOW);
+    delayMicroseconds(BUS_CLEAR_HALF_PERIOD_US);
+    digitalWrite(OLED_SDA, HIGH);
+    delayMicroseconds(BUS_CLEAR_HALF_PERIOD_US);
+    pinMode(OLED_SDA, INPUT_PULLUP);
+
+    bool released = digitalRead(OLED_SDA) == HIGH && digitalRead(OLED_SCL) == HIGH;
+    beginI2CBus();
+    return released;
+}
@@ -12,33 +12,51 @@ const MenuHandlers menuHandlersTable[] = {
     { &MenuManager::troubleshootMenuEncoder, &MenuManager::troubleshootMenuEncoderButton, &MenuManager::troubleshootMenuConButton, &MenuManager::troubleshootMenuBackButton }, // TROUBLESHOOT_MENU
     { &MenuManager::calibrationMenuEncoder, &MenuManager::calibrationMenuEncoderButton, &MenuManager::calibrationMenuConButton, &MenuManager::calibrationMenuBackButton }, // CALIBRATION_MENU
     { &MenuManager::octaveMenuEncoder, &MenuManager::octaveMenuEncoderButton, &MenuManager::octaveMenuConButton, &MenuManager::octaveMenuBackButton },  // OCTAVE_MENU
-    { &MenuManager::calibrationMenuAEncoder, &MenuManager::calibrationMenuAEncoderButton, &MenuManager::calibrationMenuAConButton, &MenuManager::calibrationMenuABackButton }, // CALIBRATION_A_MENU
-    { &MenuManager::calibrationMenuBEncoder, &MenuManager::calibrationMenuBEncoderButton, &MenuManager::calibrationMenuBConButton, &MenuManager::calibrationMenuBBackButton }, // CALIBRATION_B_MENU
-    { &MenuManager::calibrationMenuCEncoder, &MenuManager::calibrationMenuCEncoderButton, &MenuManager::calibrationMenuCConButton, &MenuManager::calibrationMenuCBackButton }, // CALIBRATION_C_MENU
-    { &MenuManager::calibrationMenuDEncoder, &MenuManager::calibrationMenuDEncoderButton, &MenuManager::calibrationMenuDConButton, &MenuManager::calibrationMenuDBackButton },  // CALIBRATION_D_MENU
+    { &MenuManager::calibrationSensorMenuEncoder, &MenuManager::calibrationSensorMenuEncoderButton, &MenuManager::calibrationSensorMenuConButton, &MenuManager::calibrationSensorMenuBackButton }, // CALIBRATION_SENSOR_MENU
     { &MenuManager::scaleMenuEncoder, &MenuManager::scaleMenuEncoderButton, &MenuManager::scaleMenuConButton, &MenuManager::scaleMenuBackButton },  // SCALE_MENU
-    { &MenuManager::rootNoteMenuEncoder, &MenuManager::rootNoteMenuEncoderButton, &MenuManager::rootNoteMenuConButton, &MenuManager::rootNoteMenuBackButton }  // ROOT_NOTE_MENU
+    { &MenuManager::rootNoteMenuEncoder, &MenuManager::rootNoteMenuEncoderButton, &MenuManager::rootNoteMenuConButton, &MenuManager::rootNoteMenuBackButton },  // ROOT_NOTE_MENU
+    { &MenuManager::calibrationQueueMenuEncoder, &MenuManager::calibrationQueueMenuEncoderButton, &MenuManager::calibrationQueueMenuConButton, &MenuManager::calibrationQueueMenuBackButton },  // CALIBRATION_QUEUE_MENU
+    { &MenuManager::tempoMenuEncoder, &MenuManager::tempoMenuEncoderButton, &MenuManager::tempoMenuConButton, &MenuManager::tempoMenuBackButton },  // TEMPO_MENU
+    { &MenuManager::userScaleMenuEncoder, &MenuManager::userScaleMenuEncoderButton, &MenuManager::userScaleMenuConButton, &MenuManager::userScaleMenuBackButton }  // USER_SCALE_MENU
 };
 
+static const char* const noteNames[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+static_assert(SensorChannel::NO_NOTE == ScaleManager::MIDI_NOTE_OFF,
+              "note tables mark the note-off color with ScaleManager's sentinel");
+
 MenuManager::MenuManager(Adafruit_SH1106G& disp) : display(disp), currentMenu(TROUBLESHOOT_MENU) {
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        rebuildNotes(i);
+    }
 }
 
 void MenuManager::showCenteredMessage(const char* msg, uint8_t textSize,
                                      uint8_t padX, uint8_t padY,
                                      uint16_t durMs)
 {
+    messageText = msg;
+    messageTextSize = textSize;
+    messagePadX = padX;
+    messagePadY = padY;
+    messageDurMs = durMs;
+    messageShownMs = millis();
+    requestRender();
+}
+
+void MenuManager::drawCenteredMessage() {
     // Option A: overlay on top of existing screen contents (no clear)
     // Option B: clear the screen first (uncomment if you want)
     display.clearDisplay();
 
-    display.setTextSize(textSize);
+    display.setTextSize(messageTextSize);
 
     int16_t x1, y1;
     uint16_t textW, textH;
-    display.getTextBounds(msg, 0, 0, &x1, &y1, &textW, &textH);
+    display.getTextBounds(messageText, 0, 0, &x1, &y1, &textW, &textH);
 
-    int boxW = textW + padX * 2;
-    int boxH = textH + padY * 2;
+    int boxW = textW + messagePadX * 2;
+    int boxH = textH + messagePadY * 2;
 
     int boxX = (SCREEN_WIDTH - boxW) / 2;
     int boxY = (SCREEN_HEIGHT - boxH) / 2;
@@ -55,52 +73,42 @@ void MenuManager::showCenteredMessage(const char* msg, uint8_t textSize,
 
     display.setCursor(textX, textY);
     display.setTextColor(OLED_WHITE, OLED_BLACK); // white text on black background
-    display.print(msg);
+    display.print(messageText);
 
     // Show on display
     display.display();
-
-    delay(durMs);
-
-    // Optionally restore previous screen by re-rendering your menu
-    render();
-}
-
-void MenuManager::updateCurrentColorA(const char* color) {
-    currentDetectedColorA = String(color);
-}
-
-void MenuManager::updateCurrentColorB(const char* color) {
-    currentDetectedColorB = String(color);
-}
-
-void MenuManager::updateCurrentColorC(const char* color) {
-    currentDetectedColorC = String(color);
-}
-
-void MenuManager::updateCurrentColorD(const char* color) {
-    currentDetectedColorD = String(color);
-}
-
-void MenuManager::updateCurrentMIDINoteA(uint8_t midiNote) {
-    currentMIDINoteA = midiNote;
 }
 
-void MenuManager::updateCurrentMIDINoteB(uint8_t midiNote) {
-    currentMIDINoteB = midiNote;
-}
+bool MenuManager::serviceRender(unsigned long now) {
+    // The menu comes back once the message has had its time
+    if (messageText != nullptr && now - messageShownMs >= messageDurMs) {
+        messageText = nullptr;
+        renderPending = true;
+    }
+    if (!renderPending || now - lastRenderMs < 1000 / MENU_MAX_FPS) {
+        return false;
+    }
+    renderPending = false;
+    lastRenderMs = now;
 
-void MenuManager::updateCurrentMIDINoteC(uint8_t midiNote) {
-    currentMIDINoteC = midiNote;
+    uint32_t start = micros();
+    render();
+    uint32_t elapsed = micros() - start;
+    renderUsTotal += elapsed;
+    if (elapsed > renderUsMax) {
+        renderUsMax = elapsed;
+    }
+    frameCount++;
+    return true;
 }
 
-void MenuManager::updateCurrentMIDINoteD(uint8_t midiNote) {
-    currentMIDINoteD = midiNote;
+void MenuManager::resetRenderStats() {
+    frameCount = 0;
+    renderRequestCount = 0;
+    renderUsTotal = 0;
+    renderUsMax = 0;
 }
 
-
-
-
 // Text centering helper functions
 void MenuManager::centerTextAt(int y, String text, int textSize) {
     display.setTextSize(textSize);
@@ -165,10 +173,14 @@ void MenuManager::handleEncoder(int turns){
 }
 
 void MenuManager::render() {
+    if (messageText != nullptr) {
+        drawCenteredMessage();
+        return;
+    }
     if (currentMenu == MAIN_MENU) {
     display.clearDisplay();
     display.setTextSize(1);
-    const char* menus[NUM_MAIN_MENU_ITEMS] = {"Grid View", "Troubleshoot", "Calibration", "Octave", "Scale","Root Notes"};
+    const char* menus[NUM_MAIN_MENU_ITEMS] = {"Grid View", "Troubleshoot", "Calibration", "Octave", "Scale","Root Notes", "Tempo", "User Scales"};
     int yStart = 5;
     display.setCursor(10,yStart);
     display.setTextColor(OLED_WHITE);
@@ -202,16 +214,7 @@ void MenuManager::render() {
         display.setTextColor(OLED_WHITE);
         display.setCursor(SCREEN_WIDTH - 20, 5); // Position in top right
         
-        // Convert enum to character for display
-        char sensorChar;
-        switch (activeMIDIGridSensor) {
-            case SENSOR_A: sensorChar = 'A'; break;
-            case SENSOR_B: sensorChar = 'B'; break;
-            case SENSOR_C: sensorChar = 'C'; break;
-            case SENSOR_D: sensorChar = 'D'; break;
-            default: sensorChar = 'A'; break;
-        }
-        display.print(sensorChar);
+        display.print(sensorLetter(activeMIDIGridSensor));
         display.setTextSize(1); // Reset text size for grid
         
         for (int i = 0; i < 16; i++) {
@@ -223,17 +226,7 @@ void MenuManager::render() {
             
             bool isSelected = (gridSelectedIdx == channel);
             
-            // Determine which channel is active based on current sensor selection
-            int currentActiveMIDIChannel;
-            switch (activeMIDIGridSensor) {
-                case SENSOR_A: currentActiveMIDIChannel = activeMIDIChannelA; break;
-                case SENSOR_B: currentActiveMIDIChannel = activeMIDIChannelB; break;
-                case SENSOR_C: currentActiveMIDIChannel = activeMIDIChannelC; break;
-                case SENSOR_D: currentActiveMIDIChannel = activeMIDIChannelD; break;
-                default: currentActiveMIDIChannel = activeMIDIChannelA; break;
-            }
-            
-            bool isActiveChannel = (currentActiveMIDIChannel == channel);
+            bool isActiveChannel = (sensorChannels[activeMIDIGridSensor].midiChannel == channel);
             
             // Draw cell border
             display.drawRect(x, y, cellWidth, cellHeight, OLED_WHITE);
@@ -266,7 +259,9 @@ void MenuManager::render() {
     } else if (currentMenu == TROUBLESHOOT_MENU) {
         display.clearDisplay();
         
-        // Draw 2x2 grid for troubleshooting
+        // Draw a 2x2 grid for troubleshooting, one cell per sensor on this page
+        int firstSensor = troubleshootPage * TROUBLESHOOT_SENSORS_PER_PAGE;
+        int pageSensors = min(+TROUBLESHOOT_SENSORS_PER_PAGE, NUM_SENSORS - firstSensor);
         int gridCols = 2;
         int gridRows = 2;
         int cellWidth = SCREEN_WIDTH / gridCols;
@@ -282,12 +277,10 @@ void MenuManager::render() {
             display.drawLine(0, y, SCREEN_WIDTH - 1, y, OLED_WHITE);
         }
         
-        // Array of colors and labels for each sensor
-        String sensorColors[4] = {currentDetectedColorA, currentDetectedColorB, currentDetectedColorC, currentDetectedColorD};
-        String sensorLabels[4] = {"A", "B", "C", "D"};
-        
         // Draw each sensor's data in its respective cell
-        for (int cellIndex = 0; cellIndex < 4; cellIndex++) {
+        for (int cellIndex = 0; cellIndex < pageSensors; cellIndex++) {
+            int sensor = firstSensor + cellIndex;
+            const SensorChannel& channel = sensorChannels[sensor];
             int row = cellIndex / 2;
             int col = cellIndex % 2;
             int cellX = col * cellWidth;
@@ -303,11 +296,11 @@ void MenuManager::render() {
             
             // Draw label letter (no box)
             display.setCursor(labelX, labelY);
-            display.print(sensorLabels[cellIndex]);
+            display.print(sensorLetter(sensor));
             
             if (troubleshootMode == 0) {
                 // Mode 0: Color names (centered)
-                String displayText = sensorColors[cellIndex];
+                String displayText = channel.online ? colorToString(channel.currentColor) : "offline";
                 int16_t x1, y1;
                 uint16_t textWidth, textHeight;
                 display.getTextBounds(displayText, 0, 0, &x1, &y1, &textWidth, &textHeight);
@@ -319,14 +312,8 @@ void MenuManager::render() {
                 display.print(displayText);
             } else if (troubleshootMode == 1) {
                 // Mode 1: RGB values in three rows (no labels, drop C value)
-                uint16_t* rgbValues = nullptr;
-                switch (cellIndex) {
-                    case 0: rgbValues = currentRGBA; break;
-                    case 1: rgbValues = currentRGBB; break;
-                    case 2: rgbValues = currentRGBC; break;
-                    case 3: rgbValues = currentRGBD; break;
-                }
-                if (rgbValues) {
+                const uint16_t* rgbValues = channel.rgb;
+                {
                     // Display RGB values in three rows, starting at top of cell (aligned with sensor label)
                     String rValue = String(rgbValues[0]);
                     String gValue = String(rgbValues[1]);
@@ -351,21 +338,10 @@ void MenuManager::render() {
                     display.getTextBounds(bValue, 0, 0, &x1, &y1, &textWidth, &textHeight);
                     display.setCursor(cellCenterX - (textWidth / 2), startY + (2 * lineHeight));
                     display.print(bValue);
-                } else {
-                    // Fallback if no RGB data
-                    display.setCursor(cellCenterX - 6, cellCenterY);
-                    display.print("N/A");
                 }
             } else if (troubleshootMode == 2) {
                 // Mode 2: MIDI Note values (centered)
-                uint8_t midiNote = 0;
-                switch (cellIndex) {
-                    case 0: midiNote = currentMIDINoteA; break;
-                    case 1: midiNote = currentMIDINoteB; break;
-                    case 2: midiNote = currentMIDINoteC; break;
-                    case 3: midiNote = currentMIDINoteD; break;
-                }
-                String displayText = String(midiNote);
+                String displayText = String(channel.lastNote);
                 int16_t x1, y1;
                 uint16_t textWidth, textHeight;
                 display.getTextBounds(displayText, 0, 0, &x1, &y1, &textWidth, &textHeight);
@@ -384,11 +360,12 @@ void MenuManager::render() {
         display.clearDisplay();
         display.setTextSize(1);
         
-        // Sensor options: A, B, C, D (no title, start from top to fit all 4)
-        const char* sensorNames[4] = {"A", "B", "C", "D"};
-        
-        for (int i = 0; i < 4; i++) {
-            display.setCursor(10, 5 + (i * 10)); // Start at y=5 instead of y=20
+        // Sensor options: one row per ring, then the transfer (no title, start
+        // from top; scrolls when there are more rings than rows)
+        for (int row = 0; row < CALIBRATION_MENU_VISIBLE_ROWS; row++) {
+            int i = calibrationScrollIdx + row;
+            if (i > CAL_ITEM_TRANSFER) break;
+            display.setCursor(10, 5 + (row * 10)); // Start at y=5 instead of y=20
             
             // Highlight selected sensor
             if (calibrationSelectedIdx == i) {
@@ -397,35 +374,40 @@ void MenuManager::render() {
                 display.setTextColor(OLED_WHITE);
             }
             
-            display.print("Ring ");
-            display.print(sensorNames[i]);
+            if (i == CAL_ITEM_TRANSFER) {
+                display.print(NUM_SENSORS == 4 ? "A->BCD" : "A->all");
+            } else {
+                display.print("Ring ");
+                display.print(sensorLetter(i));
+            }
         }
-        if(calibrationSelectedIdx==4){
-            display.setTextColor(OLED_BLACK, OLED_WHITE);
-        } else {
-            display.setTextColor(OLED_WHITE);
+
+        // Queue entries share the right-hand column so all rows fit
+        const char* queueItems[3] = {"Queue All", "Run Queue", "Auto Spin"};
+        for (int i = 0; i < 3; i++) {
+            if (calibrationSelectedIdx == CAL_ITEM_QUEUE_ALL + i) {
+                display.setTextColor(OLED_BLACK, OLED_WHITE);
+            } else {
+                display.setTextColor(OLED_WHITE);
+            }
+            display.setCursor(70, 5 + (i * 10));
+            display.print(queueItems[i]);
         }
-        display.setCursor(10, 5+(4*10));
-        display.print("A->BCD");
+        display.setTextColor(OLED_WHITE);
+        display.setCursor(70, 5 + (3 * 10));
+        display.print("(");
+        display.print(calibrationQueue.size());
+        display.print(" jobs)");
         
         display.display(); // Send buffer to screen
     } else if(currentMenu == OCTAVE_MENU) {
         display.clearDisplay();
-                // Convert enum to character for display
-        char sensorChar;
-        int octaveToDisplay;
-        switch (activeOctaveSensor) {
-            case SENSOR_A: sensorChar = 'A'; octaveToDisplay = octaveA; break;
-            case SENSOR_B: sensorChar = 'B'; octaveToDisplay = octaveB; break;
-            case SENSOR_C: sensorChar = 'C'; octaveToDisplay = octaveC; break;
-            case SENSOR_D: sensorChar = 'D'; octaveToDisplay = octaveD; break;
-            default: sensorChar = 'A'; octaveToDisplay = octaveA; break;
-        }
+        int octaveToDisplay = sensorChannels[activeOctaveSensor].octave;
 
         display.setTextSize(2);
         display.setTextColor(OLED_WHITE);
         display.setCursor(SCREEN_WIDTH - 20, 5); // Position in top right
-        display.print(sensorChar);
+        display.print(sensorLetter(activeOctaveSensor));
 
         // display.setTextSize(4);
         // display.setCursor(10,10);
@@ -434,60 +416,107 @@ void MenuManager::render() {
 
         display.display();
     }
-    else if(currentMenu == CALIBRATION_A_MENU){
-        SharedCalibrationMenuRender(calibrationMenuASelectedIdx, calibrationMenuAScrollIdx);
-    }
-    else if(currentMenu == CALIBRATION_B_MENU){
-        SharedCalibrationMenuRender(calibrationMenuBSelectedIdx, calibrationMenuBScrollIdx);
-    }
-    else if(currentMenu == CALIBRATION_C_MENU){
-        SharedCalibrationMenuRender(calibrationMenuCSelectedIdx, calibrationMenuCScrollIdx);
-    }
-    else if(currentMenu == CALIBRATION_D_MENU){
-        SharedCalibrationMenuRender(calibrationMenuDSelectedIdx, calibrationMenuDScrollIdx);
+    else if(currentMenu == CALIBRATION_SENSOR_MENU){
+        SharedCalibrationMenuRender(calibrationSubmenuSelectedIdx, calibrationSubmenuScrollIdx);
     }
     else if(currentMenu == SCALE_MENU){
         display.clearDisplay();
     display.setTextSize(1);
 
-    const char* options[] = {"Major Scale", "Minor Scale"};
-    const int numOptions = 2;
-    int yStart = 10;
-    int lineHeight = 12;
+    int yStart = 5;
+    uint8_t activeScale = (noteTargetSensor < 0) ? scaleActiveIdx : sensorChannels[noteTargetSensor].scale;
 
-    for (int i = 0; i < numOptions; ++i) {
-        int y = yStart + i * lineHeight;
+    // Row 0 is the ring, row n is scale n - 1
+    int itemIdx = scaleScrollIdx;
+    int y = yStart;
+    for (int visible = 0; visible < SCALE_MENU_VISIBLE_ITEMS && itemIdx <= ScaleManager::NUM_SCALES; ++visible, ++itemIdx) {
         display.setCursor(10, y);
 
         // highlight the selection (encoder focus)
-        if (i == scaleSelectedIdx) {
+        if (itemIdx == scaleSelectedIdx) {
             display.setTextColor(OLED_BLACK, OLED_WHITE);
         } else {
             display.setTextColor(OLED_WHITE, OLED_BLACK);
         }
 
-        // arrow prefix for the active scale
-        if (i == scaleActiveIdx) {
-            display.print("*");
+        if (itemIdx == 0) {
+            display.print(" Ring: ");
+            if (noteTargetSensor < 0) {
+                display.print("All");
+            } else {
+                display.print(sensorLetter(noteTargetSensor));
+            }
         } else {
-            display.print(" "); // keep columns aligned
+            // arrow prefix for the active scale
+            if (itemIdx - 1 == activeScale) {
+                display.print("*");
+            } else {
+                display.print(" "); // keep columns aligned
+            }
+            display.print(ScaleManager::scaleName(itemIdx - 1));
         }
-
-        display.print(options[i]);
+        y += 9;
     }
 
     display.display();
     }
+    else if(currentMenu == CALIBRATION_QUEUE_MENU){
+        display.clearDisplay();
+        display.setTextSize(1);
+        display.setTextColor(OLED_WHITE, OLED_BLACK);
+
+        CalibrationJob next;
+        if (!calibrationQueue.peek(next)) {
+            centerTextAt(20, "Queue empty", 1);
+            centerTextAt(40, "BAK to return", 1);
+        } else {
+            // What to do next, and which rings will be sampled together
+            display.setCursor(5, 5);
+            display.print("Next: ");
+            display.print(calibrationStepName(next.step));
+
+            display.setCursor(5, 17);
+            display.print("Rings: ");
+            if (next.sensorMask == ALL_SENSORS_MASK && NUM_SENSORS > 4) {
+                display.print("all");
+            } else {
+                int shown = 0;
+                for (int i = 0; i < NUM_SENSORS; i++) {
+                    if (!(next.sensorMask & sensorBit(i))) continue;
+                    if (++shown > 13) {
+                        display.print("..");
+                        break;
+                    }
+                    display.print(sensorLetter(i));
+                }
+            }
+
+            display.setCursor(5, 29);
+            display.print("Jobs left: ");
+            display.print(calibrationQueue.size());
+
+            Color patch = calibrationStepPatch(next.step);
+            display.setCursor(5, 45);
+            if (patch != Color::UNKNOWN) {
+                display.print("Place ");
+                display.print(colorToString(patch));
+                display.print(", press enc");
+            } else {
+                display.print("Press enc to run");
+            }
+        }
+        display.display();
+    }
     if (currentMenu == ROOT_NOTE_MENU) {
     display.clearDisplay();
     display.setTextSize(1);
-    const char* menus[NUM_ROOT_NOTES] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
     int yStart = 5;
     display.setCursor(10,yStart);
     display.setTextColor(OLED_WHITE);
 
     int itemIdx = rootNoteScrollIdx;
     int y = yStart;
+    uint8_t activeRoot = (noteTargetSensor < 0) ? rootNoteActiveIdx : sensorChannels[noteTargetSensor].root;
     for(int visible = 0; visible < ROOT_MENU_VISIBLE_ITEMS; ++visible,++itemIdx){
         display.setCursor(10,y);
         if(itemIdx == rootNoteSelectedIdx){
@@ -495,17 +524,77 @@ void MenuManager::render() {
         } else {
             display.setTextColor(OLED_WHITE, OLED_BLACK);
         }
-        if(itemIdx == rootNoteActiveIdx){
-            display.print("*");
+        if(itemIdx == 0){
+            display.print(" Ring: ");
+            if (noteTargetSensor < 0) {
+                display.print("All");
+            } else {
+                display.print(sensorLetter(noteTargetSensor));
+            }
         }
         else{
-            display.print(" ");
+            if(itemIdx - 1 == activeRoot){
+                display.print("*");
+            }
+            else{
+                display.print(" ");
+            }
+            display.print(noteNames[itemIdx - 1]);
         }
-        display.print(menus[itemIdx]);
     y+=9;
     }
     display.display();
     }
+    if (currentMenu == TEMPO_MENU) {
+        display.clearDisplay();
+        display.setTextSize(1);
+        display.setTextColor(OLED_WHITE, OLED_BLACK);
+        display.setCursor(5, 5);
+        display.print(tempoFromDisk ? "Tempo: disk" : "Tempo: manual");
+        if (tempoFromDisk) {
+            centerTextInContent(diskBpm > 0 ? String((int)(diskBpm + 0.5f)) : String("--"), 4);
+        } else {
+            centerTextInContent(String(tempoBpm), 4);
+        }
+        display.setTextSize(1);
+        display.setCursor(5, BOTTOM_LINE - 8);
+        display.print("BPM  enc: source");
+        display.display();
+    }
+    if (currentMenu == USER_SCALE_MENU) {
+        display.clearDisplay();
+        display.setTextSize(1);
+        uint16_t mask = ScaleManager::userScaleMask(userScaleSlot);
+
+        display.setCursor(5, 5);
+        display.setTextColor(userScaleCursor == 0 ? OLED_BLACK : OLED_WHITE, userScaleCursor == 0 ? OLED_WHITE : OLED_BLACK);
+        display.print(ScaleManager::scaleName(ScaleManager::NUM_BUILTIN_SCALES + userScaleSlot));
+        display.setTextColor(OLED_WHITE, OLED_BLACK);
+
+        // One key per semitone from the root, filled when it's in the scale
+        const int keyW = 10;
+        const int keyX = (SCREEN_WIDTH - 12 * keyW) / 2;
+        for (int i = 0; i < 12; i++) {
+            int x = keyX + i * keyW;
+            if (mask & (1 << i)) {
+                display.fillRect(x + 1, 20, keyW - 2, 16, OLED_WHITE);
+            } else {
+                display.drawRect(x + 1, 20, keyW - 2, 16, OLED_WHITE);
+            }
+            if (i == userScaleCursor && i > 0) {
+                display.fillRect(x + 1, 39, keyW - 2, 2, OLED_WHITE);
+            }
+        }
+
+        display.setCursor(5, 46);
+        if (userScaleCursor > 0) {
+            display.print(noteNames[userScaleCursor]);
+            display.print("  enc: in/out");
+        } else {
+            display.print("enc: next slot");
+        }
+        display.display();
+    }
 }
 
 void MenuManager::startCalibrationCountdown(){
@@ -550,6 +639,12 @@ void MenuManager::mainMenuEncoderButton() {
     else if (mainMenuSelectedIdx==5){
         currentMenu = ROOT_NOTE_MENU;
     }
+    else if (mainMenuSelectedIdx==6){
+        currentMenu = TEMPO_MENU;
+    }
+    else if (mainMenuSelectedIdx==7){
+        currentMenu = USER_SCALE_MENU;
+    }
 }
 
 void MenuManager::mainMenuConButton() {
@@ -567,24 +662,12 @@ void MenuManager::gridMenuEncoder(int turns) {
 
 void MenuManager::gridMenuEncoderButton() {
     // Encoder button cycles through active sensors: A -> B -> C -> D -> A
-    switch (activeMIDIGridSensor) {
-        case SENSOR_A: activeMIDIGridSensor = SENSOR_B; break;
-        case SENSOR_B: activeMIDIGridSensor = SENSOR_C; break;
-        case SENSOR_C: activeMIDIGridSensor = SENSOR_D; break;
-        case SENSOR_D: activeMIDIGridSensor = SENSOR_A; break;
-        default: activeMIDIGridSensor = SENSOR_A; break;
-    }
+    activeMIDIGridSensor = (activeMIDIGridSensor + 1) % NUM_SENSORS;
 }
 
 void MenuManager::gridMenuConButton() {
     // CON button sets selected channel as active MIDI channel for current sensor
-    // Send ALL NOTES OFF to current channel before switching
-    if (allNotesOffCallback != nullptr) {
-        allNotesOffCallback(*getActiveSensorMIDIChannel());
-    }
-    
-    // Set selected channel as active MIDI channel for current sensor
-    setActiveSensorMIDIChannel(gridSelectedIdx);
+    setSensorChannel(activeMIDIGridSensor, gridSelectedIdx);
     saveMIDIGrid();
     Serial.println("MIDI grid saved!");
 }
@@ -596,7 +679,9 @@ void MenuManager::gridMenuBackButton() {
 
 // TROUBLESHOOT_MENU
 void MenuManager::troubleshootMenuEncoder(int turns) {
-    // Encoder rotation does nothing in troubleshoot menu
+    // Encoder rotation pages through the sensors (nothing to do with four or fewer)
+    int pages = (NUM_SENSORS + TROUBLESHOOT_SENSORS_PER_PAGE - 1) / TROUBLESHOOT_SENSORS_PER_PAGE;
+    troubleshootPage = constrain(troubleshootPage + turns, 0, pages - 1);
 }
 
 void MenuManager::troubleshootMenuEncoderButton() {
@@ -620,40 +705,52 @@ void MenuManager::troubleshootMenuBackButton() {
 
 // CALIBRATION_MENU
 void MenuManager::calibrationMenuEncoder(int turns){
-    calibrationSelectedIdx = constrain(calibrationSelectedIdx + turns, 0, 4);
+    calibrationSelectedIdx = constrain(calibrationSelectedIdx + turns, 0, CALIBRATION_MENU_ITEMS - 1);
+    // Keep the selection visible when it's in the scrolling left column
+    int leftIdx = min(calibrationSelectedIdx, +CAL_ITEM_TRANSFER);
+    if (leftIdx < calibrationScrollIdx) {
+        calibrationScrollIdx = leftIdx;
+    }
+    if (leftIdx > calibrationScrollIdx + CALIBRATION_MENU_VISIBLE_ROWS - 1) {
+        calibrationScrollIdx = leftIdx - CALIBRATION_MENU_VISIBLE_ROWS + 1;
+    }
 }
 
 void MenuManager::calibrationMenuEncoderButton() {
     Serial.println("Encoder button clicked!");
     // Encoder button enters calibration for selected sensor
+    if (calibrationSelectedIdx < NUM_SENSORS) {
+        currentMenu = CALIBRATION_SENSOR_MENU;
+        calibrationSensor = calibrationSelectedIdx;
+        calibrationSubmenuSelectedIdx = 0;
+        calibrationSubmenuScrollIdx = 0;
+        Serial.print("Calibration ");
+        Serial.print(sensorLetter(calibrationSensor));
+        Serial.println(" selected");
+        return;
+    }
     switch(calibrationSelectedIdx){
-        case 0:
-            currentMenu = CALIBRATION_A_MENU;
-            calibrationMenuASelectedIdx = 0;
-            calibrationMenuAScrollIdx = 0;
-            Serial.println("Calibration A selected");
-            break;
-        case 1:
-            currentMenu = CALIBRATION_B_MENU;
-            calibrationMenuBSelectedIdx = 0;
-            calibrationMenuBScrollIdx = 0;
-            Serial.println("Calibration B selected");
+        case CAL_ITEM_TRANSFER:
+            // A must already be fully calibrated; the other rings need the white
+            // patch and the reference colors (plus any colors queued for them)
+            calibrationQueue.enqueueTransferPass(ALL_SENSORS_MASK & ~sensorBit(0), TRANSFER_REFERENCE_COLORS);
+            currentMenu = CALIBRATION_QUEUE_MENU;
+            Serial.println("Queued A->BCD transfer");
             break;
-        case 2:
-            currentMenu = CALIBRATION_C_MENU;
-            calibrationMenuCSelectedIdx = 0;
-            calibrationMenuCScrollIdx = 0;
-            Serial.println("Calibration C selected");
+        case CAL_ITEM_QUEUE_ALL:
+            // White + every color on all rings; each patch is sampled by all rings at once
+            calibrationQueue.enqueueFullPass(ALL_SENSORS_MASK);
+            currentMenu = CALIBRATION_QUEUE_MENU;
+            Serial.println("Queued full calibration for all rings");
             break;
-        case 3:
-            currentMenu = CALIBRATION_D_MENU;
-            calibrationMenuDSelectedIdx = 0;
-            calibrationMenuDScrollIdx = 0;
-            Serial.println("Calibration D selected");
+        case CAL_ITEM_RUN_QUEUE:
+            currentMenu = CALIBRATION_QUEUE_MENU;
             break;
-        case 4:
-            pendingCalibrationA = PendingCalibrationA::APPLY_TO_BCD;
-            Serial.println("A-> BCD selected");
+        case CAL_ITEM_AUTO_SPIN:
+            // Disk must be spinning; all rings are recorded and clustered together
+            calibrationQueue.enqueueFront(CalibrationStep::AUTO_ROTATION, ALL_SENSORS_MASK);
+            calibrationRunRequested = true;
+            Serial.println("Auto spin calibration selected");
             break;
     }
 }
@@ -667,28 +764,45 @@ void MenuManager::calibrationMenuBackButton() {
     currentMenu = MAIN_MENU;
 }
 
-//TODO: need to redo all of this. I think I'll make a 2x2 grid for the sensors.
-//Turnign the encoder will change the selected sensor.  Encoder press will cycle through
-//scales for that sensor. Lock in scales as we select them.  CON saves?
+// Row 0 picks the ring(s), the rest are the scales
 void MenuManager::scaleMenuEncoder(int turns){
-    scaleSelectedIdx = constrain(scaleSelectedIdx + turns, 0, NUM_SCALES - 1);
+    scaleSelectedIdx = constrain(scaleSelectedIdx + turns, 0, ScaleManager::NUM_SCALES);
+    if (scaleSelectedIdx < scaleScrollIdx) {
+        scaleScrollIdx = scaleSelectedIdx;
+    } else if (scaleSelectedIdx > scaleScrollIdx + SCALE_MENU_VISIBLE_ITEMS - 1) {
+        scaleScrollIdx = scaleSelectedIdx - SCALE_MENU_VISIBLE_ITEMS + 1;
+    }
 }
 void MenuManager::scaleMenuEncoderButton(){
-        scaleActiveIdx = scaleSelectedIdx;
-    switch(scaleActiveIdx){
-        case 0:
-            scaleManager.setScale(ScaleManager::ScaleType::MAJOR);
-            Serial.println("Scale set to major");
-            break;
-        case 1:
-            scaleManager.setScale(ScaleManager::ScaleType::MINOR);
-            Serial.println("Scale set to minor");
-            break;
-        default:
-            Serial.println("ERROR: Scale setting hit default!");
-            break;
+    if (scaleSelectedIdx == 0) {
+        noteTargetSensor = (noteTargetSensor + 1 >= NUM_SENSORS) ? -1 : noteTargetSensor + 1;
+    } else if (noteTargetSensor < 0) {
+        selectScale(scaleSelectedIdx - 1);
+    } else {
+        setSensorScale(noteTargetSensor, scaleSelectedIdx - 1);
     }
+}
 
+void MenuManager::selectScale(uint8_t scaleIdx){
+    if (scaleIdx >= ScaleManager::NUM_SCALES) {
+        return;
+    }
+    scaleActiveIdx = scaleIdx;
+    scaleManager.setScale(static_cast<ScaleManager::ScaleType>(scaleIdx));
+    Serial.print("Scale set to ");
+    Serial.println(ScaleManager::scaleName(scaleIdx));
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        setSensorScale(i, scaleIdx);
+    }
+}
+
+void MenuManager::setSensorScale(uint8_t sensor, uint8_t scaleIdx) {
+    if (sensor >= NUM_SENSORS || scaleIdx >= ScaleManager::NUM_SCALES || scaleIdx == sensorChannels[sensor].scale) {
+        return;
+    }
+    releaseNotes(sensor); // its sounding note belongs to the old scale
+    sensorChannels[sensor].scale = scaleIdx;
+    rebuildNotes(sensor);
 }
 
 void MenuManager::scaleMenuConButton(){
@@ -701,8 +815,9 @@ void MenuManager::scaleMenuBackButton(){
     currentMenu = MAIN_MENU;
 }
 
+// Row 0 picks the ring(s), the rest are the notes
 void MenuManager::rootNoteMenuEncoder(int turns){
-    rootNoteSelectedIdx = constrain(rootNoteSelectedIdx + turns, 0, NUM_ROOT_NOTES - 1);
+    rootNoteSelectedIdx = constrain(rootNoteSelectedIdx + turns, 0, NUM_ROOT_NOTES);
     if (rootNoteSelectedIdx < rootNoteScrollIdx) {
         rootNoteScrollIdx = rootNoteSelectedIdx;
     } else if (rootNoteSelectedIdx > rootNoteScrollIdx + ROOT_MENU_VISIBLE_ITEMS - 1) {
@@ -712,16 +827,41 @@ void MenuManager::rootNoteMenuEncoder(int turns){
 }
 
 void MenuManager::rootNoteMenuEncoderButton(){
-    rootNoteActiveIdx = rootNoteSelectedIdx;
+    if (rootNoteSelectedIdx == 0) {
+        noteTargetSensor = (noteTargetSensor + 1 >= NUM_SENSORS) ? -1 : noteTargetSensor + 1;
+    } else if (noteTargetSensor < 0) {
+        selectRootNote(rootNoteSelectedIdx - 1);
+    } else {
+        setSensorRoot(noteTargetSensor, rootNoteSelectedIdx - 1);
+    }
+}
+
+void MenuManager::selectRootNote(uint8_t rootIdx){
+    if (rootIdx >= NUM_ROOT_NOTES) {
+        return;
+    }
+    rootNoteActiveIdx = rootIdx;
     Serial.print("Root note set to: ");
     RootNote selected = static_cast<RootNote>(static_cast<uint8_t>(RootNote::C4) + rootNoteActiveIdx);
     Serial.println(static_cast<uint8_t>(selected));
     scaleManager.setRootNote(selected);
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        setSensorRoot(i, rootIdx);
+    }
+}
+
+void MenuManager::setSensorRoot(uint8_t sensor, uint8_t rootIdx) {
+    if (sensor >= NUM_SENSORS || rootIdx >= NUM_ROOT_NOTES || rootIdx == sensorChannels[sensor].root) {
+        return;
+    }
+    releaseNotes(sensor); // its sounding note belongs to the old root
+    sensorChannels[sensor].root = rootIdx;
+    rebuildNotes(sensor);
 }
 
 void MenuManager::rootNoteMenuConButton(){
     showCenteredMessage("Root Note saved!", 1, 8, 6, 150);
-    scaleManager.saveRootNote();
+    saveRootNotes();
 }
 
 void MenuManager::rootNoteMenuBackButton(){
@@ -730,227 +870,64 @@ void MenuManager::rootNoteMenuBackButton(){
 
 
 //// Calibration submenu commands
-void MenuManager::calibrationMenuAEncoder(int turns){
-    calibrationMenuASelectedIdx = constrain(calibrationMenuASelectedIdx+turns, 0, CALIBRATION_SUBMENU_TOTAL_ITEMS-1);
-    if (calibrationMenuASelectedIdx < calibrationMenuAScrollIdx) {
-            calibrationMenuAScrollIdx = calibrationMenuASelectedIdx;
+void MenuManager::calibrationSensorMenuEncoder(int turns){
+    calibrationSubmenuSelectedIdx = constrain(calibrationSubmenuSelectedIdx+turns, 0, CALIBRATION_SUBMENU_TOTAL_ITEMS-1);
+    if (calibrationSubmenuSelectedIdx < calibrationSubmenuScrollIdx) {
+            calibrationSubmenuScrollIdx = calibrationSubmenuSelectedIdx;
         }
-    if (calibrationMenuASelectedIdx > calibrationMenuAScrollIdx + CALIBRATION_SUBMENU_VISIBLE_ITEMS - 1) {
-            calibrationMenuAScrollIdx = calibrationMenuASelectedIdx - CALIBRATION_SUBMENU_VISIBLE_ITEMS + 1;
+    if (calibrationSubmenuSelectedIdx > calibrationSubmenuScrollIdx + CALIBRATION_SUBMENU_VISIBLE_ITEMS - 1) {
+            calibrationSubmenuScrollIdx = calibrationSubmenuSelectedIdx - CALIBRATION_SUBMENU_VISIBLE_ITEMS + 1;
         }
 }
 
-/*      EEPROM.put(SENSOR_B_RED_CAL_ADDR, colorHelperB.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_B_GREEN_CAL_ADDR, colorHelperB.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_B_PURPLE_CAL_ADDR, colorHelperB.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_B_BLUE_CAL_ADDR, colorHelperB.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_B_ORANGE_CAL_ADDR, colorHelperB.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_B_YELLOW_CAL_ADDR, colorHelperB.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_B_SILVER_CAL_ADDR, colorHelperB.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_B_WHITE_CAL_ADDR, colorHelperB.calibrationDatabase[7]);
-*/
-void MenuManager::calibrationMenuAEncoderButton(){
-    switch(calibrationMenuASelectedIdx){
-        case 0:
-            pendingCalibrationA = PendingCalibrationA::NONE;
-            break;
-        case 1:
-            pendingCalibrationA = PendingCalibrationA::DARK_OFFSET;
-            break;
-        case 2:
-            pendingCalibrationA = PendingCalibrationA::GAINS;
-            break;
-        case 3:
-            pendingCalibrationA = PendingCalibrationA::RED;
-            break;
-        case 4:
-            pendingCalibrationA = PendingCalibrationA::GREEN;
-            break;
-        case 5:
-            pendingCalibrationA = PendingCalibrationA::PURPLE;
-            break;
-        case 6:
-            pendingCalibrationA = PendingCalibrationA::BLUE;
-            break;
-        case 7:
-            pendingCalibrationA = PendingCalibrationA::ORANGE;
-            break;
-        case 8:
-            pendingCalibrationA = PendingCalibrationA::YELLOW;
-            break;
-        case 9:
-            pendingCalibrationA = PendingCalibrationA::SILVER;
-            break;
-        case 10:
-            pendingCalibrationA = PendingCalibrationA::WHITE;
-            break;
-        default:
-            Serial.println("WARNING: SOMEHOW HIT UNSUPPORTED CALIBRATION CASE");
-    }
+void MenuManager::calibrationSensorMenuEncoderButton(){
+    queueCalibrationFromSubmenu(calibrationSensor, calibrationSubmenuSelectedIdx, true);
 }
 
-void MenuManager::calibrationMenuAConButton(){
+void MenuManager::calibrationSensorMenuConButton(){
+    queueCalibrationFromSubmenu(calibrationSensor, calibrationSubmenuSelectedIdx, false);
 }
-void MenuManager::calibrationMenuABackButton(){
+
+void MenuManager::calibrationSensorMenuBackButton(){
     currentMenu = CALIBRATION_MENU;
 }
 
-void MenuManager::calibrationMenuBEncoder(int turns){
-    calibrationMenuBSelectedIdx = constrain(calibrationMenuBSelectedIdx+turns, 0, CALIBRATION_SUBMENU_TOTAL_ITEMS-1);
-    if (calibrationMenuBSelectedIdx < calibrationMenuBScrollIdx) {
-            calibrationMenuBScrollIdx = calibrationMenuBSelectedIdx;
-        }
-    if (calibrationMenuBSelectedIdx > calibrationMenuBScrollIdx + CALIBRATION_SUBMENU_VISIBLE_ITEMS - 1) {
-            calibrationMenuBScrollIdx = calibrationMenuBSelectedIdx - CALIBRATION_SUBMENU_VISIBLE_ITEMS + 1;
-        }
-}
-void MenuManager::calibrationMenuBEncoderButton(){
-    switch(calibrationMenuBSelectedIdx){
-          case 0:
-            pendingCalibrationB = PendingCalibrationB::NONE;
-            break;
-        case 1:
-            pendingCalibrationB = PendingCalibrationB::DARK_OFFSET;
-            break;
-        case 2:
-            pendingCalibrationB = PendingCalibrationB::GAINS;
-            break;
-        case 3:
-            pendingCalibrationB = PendingCalibrationB::RED;
-            break;
-        case 4:
-            pendingCalibrationB = PendingCalibrationB::GREEN;
-            break;
-        case 5:
-            pendingCalibrationB = PendingCalibrationB::PURPLE;
-            break;
-        case 6:
-            pendingCalibrationB = PendingCalibrationB::BLUE;
-            break;
-        case 7:
-            pendingCalibrationB = PendingCalibrationB::ORANGE;
-            break;
-        case 8:
-            pendingCalibrationB = PendingCalibrationB::YELLOW;
-            break;
-        case 9:
-            pendingCalibrationB = PendingCalibrationB::SILVER;
-            break;
-        case 10:
-            pendingCalibrationB = PendingCalibrationB::WHITE;
-            break;
-        default:
+// Row index == CalibrationStep value ("No-Op" is row 0).
+void MenuManager::queueCalibrationFromSubmenu(uint8_t sensor, int selectedIdx, bool runNow){
+    if (selectedIdx <= 0 || selectedIdx > static_cast<int>(CalibrationStep::RESET_DEFAULTS)) {
+        if (selectedIdx != 0) {
             Serial.println("WARNING: SOMEHOW HIT UNSUPPORTED CALIBRATION CASE");
+        }
+        return;
+    }
+    CalibrationStep step = static_cast<CalibrationStep>(selectedIdx);
+    if (runNow) {
+        calibrationQueue.enqueueFront(step, sensorBit(sensor));
+        calibrationRunRequested = true;
+    } else if (calibrationQueue.enqueue(step, sensorBit(sensor))) {
+        showCenteredMessage("Queued!", 1, 8, 6, 150);
     }
-}
-void MenuManager::calibrationMenuBConButton(){}
-void MenuManager::calibrationMenuBBackButton(){
-    currentMenu = CALIBRATION_MENU;
 }
 
-void MenuManager::calibrationMenuCEncoder(int turns){
-    calibrationMenuCSelectedIdx = constrain(calibrationMenuCSelectedIdx+turns, 0, CALIBRATION_SUBMENU_TOTAL_ITEMS-1);
-    if (calibrationMenuCSelectedIdx < calibrationMenuCScrollIdx) {
-            calibrationMenuCScrollIdx = calibrationMenuCSelectedIdx;
-        }
-    if (calibrationMenuCSelectedIdx > calibrationMenuCScrollIdx + CALIBRATION_SUBMENU_VISIBLE_ITEMS - 1) {
-            calibrationMenuCScrollIdx = calibrationMenuCSelectedIdx - CALIBRATION_SUBMENU_VISIBLE_ITEMS + 1;
-        }
+// CALIBRATION_QUEUE_MENU
+void MenuManager::calibrationQueueMenuEncoder(int turns){
+    // Nothing to scroll, the screen only shows the next job
 }
-void MenuManager::calibrationMenuCEncoderButton(){
-    switch(calibrationMenuCSelectedIdx){
-          case 0:
-            pendingCalibrationC = PendingCalibrationC::NONE;
-            break;
-        case 1:
-            pendingCalibrationC = PendingCalibrationC::DARK_OFFSET;
-            break;
-        case 2:
-            pendingCalibrationC = PendingCalibrationC::GAINS;
-            break;
-        case 3:
-            pendingCalibrationC = PendingCalibrationC::RED;
-            break;
-        case 4:
-            pendingCalibrationC = PendingCalibrationC::GREEN;
-            break;
-        case 5:
-            pendingCalibrationC = PendingCalibrationC::PURPLE;
-            break;
-        case 6:
-            pendingCalibrationC = PendingCalibrationC::BLUE;
-            break;
-        case 7:
-            pendingCalibrationC = PendingCalibrationC::ORANGE;
-            break;
-        case 8:
-            pendingCalibrationC = PendingCalibrationC::YELLOW;
-            break;
-        case 9:
-            pendingCalibrationC = PendingCalibrationC::SILVER;
-            break;
-        case 10:
-            pendingCalibrationC = PendingCalibrationC::WHITE;
-            break;
-        default:
-            Serial.println("WARNING: SOMEHOW HIT UNSUPPORTED CALIBRATION CASE");
+
+void MenuManager::calibrationQueueMenuEncoderButton(){
+    // Patch is in place, run the next job (and any following jobs on the same patch)
+    if (!calibrationQueue.isEmpty()) {
+        calibrationRunRequested = true;
     }
 }
-void MenuManager::calibrationMenuCConButton(){}
-void MenuManager::calibrationMenuCBackButton(){
-    currentMenu = CALIBRATION_MENU;
-}
 
-void MenuManager::calibrationMenuDEncoder(int turns){
-    calibrationMenuDSelectedIdx = constrain(calibrationMenuDSelectedIdx+turns, 0, CALIBRATION_SUBMENU_TOTAL_ITEMS-1);
-    if (calibrationMenuDSelectedIdx < calibrationMenuDScrollIdx) {
-            calibrationMenuDScrollIdx = calibrationMenuDSelectedIdx;
-        }
-    if (calibrationMenuDSelectedIdx > calibrationMenuDScrollIdx + CALIBRATION_SUBMENU_VISIBLE_ITEMS - 1) {
-            calibrationMenuDScrollIdx = calibrationMenuDSelectedIdx - CALIBRATION_SUBMENU_VISIBLE_ITEMS + 1;
-        }
-}
-void MenuManager::calibrationMenuDEncoderButton(){
-    switch(calibrationMenuDSelectedIdx){
-          case 0:
-            pendingCalibrationD = PendingCalibrationD::NONE;
-            break;
-        case 1:
-            pendingCalibrationD = PendingCalibrationD::DARK_OFFSET;
-            break;
-        case 2:
-            pendingCalibrationD = PendingCalibrationD::GAINS;
-            break;
-        case 3:
-            pendingCalibrationD = PendingCalibrationD::RED;
-            break;
-        case 4:
-            pendingCalibrationD = PendingCalibrationD::GREEN;
-            break;
-        case 5:
-            pendingCalibrationD = PendingCalibrationD::PURPLE;
-            break;
-        case 6:
-            pendingCalibrationD = PendingCalibrationD::BLUE;
-            break;
-        case 7:
-            pendingCalibrationD = PendingCalibrationD::ORANGE;
-            break;
-        case 8:
-            pendingCalibrationD = PendingCalibrationD::YELLOW;
-            break;
-        case 9:
-            pendingCalibrationD = PendingCalibrationD::SILVER;
-            break;
-        case 10:
-            pendingCalibrationD = PendingCalibrationD::WHITE;
-            break;
-        default:
-            Serial.println("WARNING: SOMEHOW HIT UNSUPPORTED CALIBRATION CASE");
-    }
+void MenuManager::calibrationQueueMenuConButton(){
+    calibrationQueue.clear();
+    showCenteredMessage("Queue cleared", 1, 8, 6, 150);
 }
-void MenuManager::calibrationMenuDConButton(){}
-void MenuManager::calibrationMenuDBackButton(){
+
+void MenuManager::calibrationQueueMenuBackButton(){
+    // Queue is kept, "Run Queue" picks it back up
     currentMenu = CALIBRATION_MENU;
 }
 
@@ -960,25 +937,44 @@ void MenuManager::calibrationMenuDBackButton(){
 
 // OCTAVE MENU
 void MenuManager::octaveMenuEncoder(int turns) {
-    switch (activeOctaveSensor) {
-        case SENSOR_A: octaveA = constrain(octaveA + turns, 0, 8); break;
-        case SENSOR_B: octaveB = constrain(octaveB + turns, 0, 8); break;
-        case SENSOR_C: octaveC = constrain(octaveC + turns, 0, 8); break;
-        case SENSOR_D: octaveD = constrain(octaveD + turns, 0, 8); break;
-        default: octaveA = constrain(octaveA + turns, 0, 8); break;
+    setSensorOctave(activeOctaveSensor, constrain(sensorChannels[activeOctaveSensor].octave + turns, 0, 8));
+}
+
+void MenuManager::setSensorOctave(uint8_t sensor, uint8_t octave) {
+    if (sensor >= NUM_SENSORS || octave > 8) {
+        return;
+    }
+    if (octave == sensorChannels[sensor].octave) {
+        return;
+    }
+    releaseNotes(sensor);
+    sensorChannels[sensor].octave = octave;
+    rebuildNotes(sensor);
+}
+
+void MenuManager::rebuildNotes(uint8_t sensor) {
+    SensorChannel& channel = sensorChannels[sensor];
+    ScaleManager::ScaleType scale = static_cast<ScaleManager::ScaleType>(channel.scale);
+    uint8_t rootNote = static_cast<uint8_t>(RootNote::C4) + channel.root;
+    ScaleManager::buildNoteTable(scale, rootNote, channel.octave, channel.notes);
+    ScaleManager::buildChordTable(scale, rootNote, channel.octave, channel.chords);
+}
+
+void MenuManager::setSensorChannel(uint8_t sensor, uint8_t channel) {
+    if (sensor >= NUM_SENSORS || channel < 1 || channel > 16) {
+        return;
+    }
+    // Release its note on the old channel before switching
+    if (channel != sensorChannels[sensor].midiChannel) {
+        releaseNotes(sensor);
     }
+    sensorChannels[sensor].midiChannel = channel;
 }
 
 void MenuManager::octaveMenuEncoderButton(
 
 ){
-       switch (activeOctaveSensor) {
-        case SENSOR_A: activeOctaveSensor = SENSOR_B; break;
-        case SENSOR_B: activeOctaveSensor = SENSOR_C; break;
-        case SENSOR_C: activeOctaveSensor = SENSOR_D; break;
-        case SENSOR_D: activeOctaveSensor = SENSOR_A; break;
-        default: activeOctaveSensor = SENSOR_A; break;
-    }
+    activeOctaveSensor = (activeOctaveSensor + 1) % NUM_SENSORS;
 }
 
 void MenuManager::octaveMenuConButton(){
@@ -991,6 +987,59 @@ void MenuManager::octaveMenuBackButton(){
 }
 
 
+//// Tempo menu commands
+void MenuManager::tempoMenuEncoder(int turns) {
+    if (!tempoFromDisk) {
+        tempoBpm = constrain(tempoBpm + turns, MIDI_CLOCK_MIN_BPM, MIDI_CLOCK_MAX_BPM);
+    }
+}
+
+void MenuManager::tempoMenuEncoderButton() {
+    tempoFromDisk = !tempoFromDisk;
+}
+
+void MenuManager::tempoMenuConButton() {
+    saveTempo();
+    showCenteredMessage("Tempo saved!", 1, 8, 6, 150);
+}
+
+void MenuManager::tempoMenuBackButton() {
+    currentMenu = MAIN_MENU;
+}
+
+//// User scale editor
+void MenuManager::userScaleMenuEncoder(int turns) {
+    userScaleCursor = constrain(userScaleCursor + turns, 0, 11);
+}
+
+void MenuManager::userScaleMenuEncoderButton() {
+    if (userScaleCursor == 0) {
+        userScaleSlot = (userScaleSlot + 1) % USER_SCALE_COUNT;
+        return;
+    }
+    uint16_t mask = ScaleManager::userScaleMask(userScaleSlot) ^ (1 << userScaleCursor);
+    ScaleManager::setUserScale(userScaleSlot, mask);
+
+    // Rings playing this scale pick up the edit straight away
+    uint8_t scaleIdx = ScaleManager::NUM_BUILTIN_SCALES + userScaleSlot;
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        if (sensorChannels[i].scale == scaleIdx) {
+            releaseNotes(i);
+            rebuildNotes(i);
+        }
+    }
+}
+
+void MenuManager::userScaleMenuConButton() {
+    ScaleManager::saveUserScale(userScaleSlot);
+    showCenteredMessage("Scale saved!", 1, 8, 6, 150);
+}
+
+void MenuManager::userScaleMenuBackButton() {
+    currentMenu = MAIN_MENU;
+}
+
+
 //// helper functions
 void MenuManager::SharedCalibrationMenuRender(int selectedIdx, int scrollIdx){
     display.clearDisplay();
@@ -1035,108 +1084,67 @@ void MenuManager::calibrationIncrementProgressBar(uint8_t tick){
 
 
 
-// Set the callback function for ALL NOTES OFF
-void MenuManager::setAllNotesOffCallback(AllNotesOffCallback callback) {
-    allNotesOffCallback = callback;
+// Set the callback function for releasing notes
+void MenuManager::setNoteReleaseCallback(NoteReleaseCallback callback) {
+    noteReleaseCallback = callback;
 }
 
-// Helper functions for working with active sensor
-byte* MenuManager::getActiveSensorMIDIChannel() {
-    switch (activeMIDIGridSensor) {
-        case SENSOR_A: return &activeMIDIChannelA;
-        case SENSOR_B: return &activeMIDIChannelB;
-        case SENSOR_C: return &activeMIDIChannelC;
-        case SENSOR_D: return &activeMIDIChannelD;
-        default: return &activeMIDIChannelA;
-    }
-}
-
-void MenuManager::setActiveSensorMIDIChannel(int channel) {
-    switch (activeMIDIGridSensor) {
-        case SENSOR_A: activeMIDIChannelA = channel; break;
-        case SENSOR_B: activeMIDIChannelB = channel; break;
-        case SENSOR_C: activeMIDIChannelC = channel; break;
-        case SENSOR_D: activeMIDIChannelD = channel; break;
-        default: activeMIDIChannelA = channel; break;
+void MenuManager::releaseNotes(int sensor) {
+    if (noteReleaseCallback != nullptr) {
+        noteReleaseCallback(sensor);
     }
 }
 
 // save functions
 void MenuManager::saveMIDIGrid(){
-    switch(activeMIDIGridSensor){
-        case SENSOR_A:
-            EEPROM.put(ACTIVE_MIDI_CHANNEL_A_ADDR, activeMIDIChannelA);
-            Serial.print("Saved sensor A to channel ");
-            Serial.println(activeMIDIChannelA);
-            break;
-        case SENSOR_B:
-            EEPROM.put(ACTIVE_MIDI_CHANNEL_B_ADDR, activeMIDIChannelB);
-            Serial.print("Saved sensor B to channel ");
-            Serial.println(activeMIDIChannelB);
-            break;
-        case SENSOR_C:
-            EEPROM.put(ACTIVE_MIDI_CHANNEL_C_ADDR, activeMIDIChannelC);
-            Serial.print("Saved sensor C to channel ");
-            Serial.println(activeMIDIChannelC);
-            break;
-        case SENSOR_D:
-            EEPROM.put(ACTIVE_MIDI_CHANNEL_D_ADDR, activeMIDIChannelD);
-            Serial.print("Saved sensor D to channel ");
-            Serial.println(activeMIDIChannelD);
-            break;
-    }
+    EEPROM.put(ACTIVE_MIDI_CHANNEL_ADDR(activeMIDIGridSensor), sensorChannels[activeMIDIGridSensor].midiChannel);
+    Serial.print("Saved sensor ");
+    Serial.print(sensorLetter(activeMIDIGridSensor));
+    Serial.print(" to channel ");
+    Serial.println(sensorChannels[activeMIDIGridSensor].midiChannel);
     EEPROM.write(EEPROM_MAGIC_ADDRESS, EEPROM_MAGIC_VALUE);
     Serial.println("Committing MIDI Channels...");
     EEPROM.commit();
 
     byte check;
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_A_ADDR, check);
+    EEPROM.get(ACTIVE_MIDI_CHANNEL_ADDR(0), check);
     Serial.print("Read back from EEPROM for A: ");
     Serial.println(check);
 }
 
 void MenuManager::saveOctaves(){
-    switch(activeOctaveSensor){
-        case SENSOR_A:
-            EEPROM.put(OCTAVE_A_ADDR, octaveA);
-            break;
-        case SENSOR_B:
-            EEPROM.put(OCTAVE_B_ADDR, octaveB);
-            break;
-        case SENSOR_C:
-            EEPROM.put(OCTAVE_C_ADDR, octaveC);
-            break;
-        case SENSOR_D:
-            EEPROM.put(OCTAVE_D_ADDR, octaveD);
-            break;
-    }
+    EEPROM.put(OCTAVE_ADDR(activeOctaveSensor), sensorChannels[activeOctaveSensor].octave);
     EEPROM.write(EEPROM_MAGIC_ADDRESS, EEPROM_MAGIC_VALUE);
     EEPROM.commit();
 }
 
+void MenuManager::saveTempo() {
+    EEPROM.put(TEMPO_ADDR, tempoBpm);
+    EEPROM.write(TEMPO_SOURCE_ADDR, tempoFromDisk ? 1 : 0);
+    EEPROM.commit();
+}
+
+// The global setting is what a sensor without its own byte falls back to
 void MenuManager::saveScale() {
     uint8_t v = static_cast<uint8_t>(scaleManager.getCurrentScale());
     EEPROM.put(SCALE_ADDR, v);   // stores 1 byte
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        EEPROM.write(SENSOR_SCALE_ADDR(i), NOTE_SETTING_STORED | sensorChannels[i].scale);
+    }
     EEPROM.commit();       // required for ESP32 emulated EEPROM
 }
 
-
-void MenuManager::updateCurrentRGBA(float r, float g, float b) {
-    currentRGBA[0] = r; currentRGBA[1] = g; currentRGBA[2] = b;
-    render();
+void MenuManager::saveRootNotes() {
+    scaleManager.saveRootNote();
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        EEPROM.write(SENSOR_ROOT_ADDR(i), NOTE_SETTING_STORED | sensorChannels[i].root);
+    }
+    EEPROM.commit();
 }
 
-void MenuManager::updateCurrentRGBB(float r, float g, float b) {
-    currentRGBB[0] = r; currentRGBB[1] = g; currentRGBB[2] = b;
-    render();
-}
 
-void MenuManager::updateCurrentRGBC(float r, float g, float b) {
-    currentRGBC[0] = r; currentRGBC[1] = g; currentRGBC[2] = b;
-    render();
+void MenuManager::updateCurrentRGB(uint8_t sensor, float r, float g, float b) {
+    uint16_t* rgb = sensorChannels[sensor].rgb;
+    rgb[0] = r; rgb[1] = g; rgb[2] = b;
+    requestRender();
 }
-
-void MenuManager::updateCurrentRGBD(float r, float g, float b) {
-    currentRGBD[0] = r; currentRGBD[1] = g; currentRGBD[2] = b;
-    render();
-}
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <Adafruit_SH110X.h>
 #include "SystemConfig.h"
 #include "ScaleManager.h"
+#include "CalibrationQueue.h"
+#include "SensorChannel.h"
 
 class MenuManager;
 
@@ -25,14 +27,14 @@ enum MenuState {
     TROUBLESHOOT_MENU,
     CALIBRATION_MENU,
     OCTAVE_MENU, 
-    CALIBRATION_A_MENU,
-    CALIBRATION_B_MENU,
-    CALIBRATION_C_MENU,
-    CALIBRATION_D_MENU, 
+    CALIBRATION_SENSOR_MENU, // per-sensor calibration steps, for calibrationSensor
     SCALE_MENU,
-    ROOT_NOTE_MENU
+    ROOT_NOTE_MENU,
+    CALIBRATION_QUEUE_MENU,
+    TEMPO_MENU,
+    USER_SCALE_MENU
 };
-static const int NUM_MAIN_MENU_ITEMS = 6; //don't count main menu or calibration_x_menus
+static const int NUM_MAIN_MENU_ITEMS = 8; //don't count main menu or calibration sub menus
 
 enum MenuButton {
     BUTTON_NONE,
@@ -43,95 +45,55 @@ enum MenuButton {
     BAK_BUTTON
 };
 
-enum ActiveSensor {
-    SENSOR_A,
-    SENSOR_B,
-    SENSOR_C,
-    SENSOR_D
-};
-/*
-      EEPROM.put(SENSOR_A_RED_CAL_ADDR, colorHelperA.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_A_GREEN_CAL_ADDR, colorHelperA.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_A_PURPLE_CAL_ADDR, colorHelperA.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_A_BLUE_CAL_ADDR, colorHelperA.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_A_ORANGE_CAL_ADDR, colorHelperA.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_A_YELLOW_CAL_ADDR, colorHelperA.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_A_SILVER_CAL_ADDR, colorHelperA.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_A_WHITE_CAL_ADDR, colorHelperA.calibrationDatabase[7]);
-*/
-enum class PendingCalibrationA{
-    NONE,
-    DARK_OFFSET,
-    GAINS,
-    RED,
-    GREEN,
-    PURPLE,
-    BLUE,
-    ORANGE,
-    YELLOW,
-    SILVER,
-    WHITE,
-    RESET_DEFAULTS,
-    APPLY_TO_BCD
-};
-enum class PendingCalibrationB{
-     NONE,
-    DARK_OFFSET,
-    GAINS,
-    RED,
-    GREEN,
-    PURPLE,
-    BLUE,
-    ORANGE,
-    YELLOW,
-    SILVER,
-    WHITE,
-    RESET_DEFAULTS
-};
-enum class PendingCalibrationC{
-      NONE,
-    DARK_OFFSET,
-    GAINS,
-    RED,
-    GREEN,
-    PURPLE,
-    BLUE,
-    ORANGE,
-    YELLOW,
-    SILVER,
-    WHITE,
-    RESET_DEFAULTS
-};
-enum class PendingCalibrationD{
-    NONE,
-    DARK_OFFSET,
-    GAINS,
-    RED,
-    GREEN,
-    PURPLE,
-    BLUE,
-    ORANGE,
-    YELLOW,
-    SILVER,
-    WHITE,
-    RESET_DEFAULTS
-};
-
-// Function pointer type for MIDI ALL NOTES OFF callback
-typedef void (*AllNotesOffCallback)(uint8_t channel);
+// Function pointer type for releasing a sensor's sounding note before a
+// setting that changes it (channel, octave, scale, root); -1 = every sensor
+typedef void (*NoteReleaseCallback)(int sensor);
 
 class MenuManager {
 public:
     MenuManager(Adafruit_SH1106G& display);
+    // Draw the current menu now; only serviceRender() should need this
     void render();
+    // Ask for a redraw. Any number of requests before the next frame are one frame.
+    void requestRender() { renderPending = true; renderRequestCount++; }
+    /**
+     * Draw the frame asked for, if one was and 1/MENU_MAX_FPS s has passed
+     * since the last. loop() calls it outside the sensor path.
+     * @return true if it drew
+     */
+    bool serviceRender(unsigned long now);
+
+    // Rendering cost since the last reset: frames drawn, requests they
+    // served, time spent drawing and sending them (us), and the longest frame
+    uint32_t framesRendered() const { return frameCount; }
+    uint32_t renderRequests() const { return renderRequestCount; }
+    uint32_t renderTimeUs() const { return renderUsTotal; }
+    uint32_t maxRenderUs() const { return renderUsMax; }
+    void resetRenderStats();
     void handleInput(MenuButton btn);
     void handleEncoder(int turns);
 
     // RGB update flag for troubleshoot mode
     bool requestRGBUpdate = true;
 
-    // Set callback for sending ALL NOTES OFF
-    void setAllNotesOffCallback(AllNotesOffCallback callback);
+    // Set callback for releasing sounding notes
+    void setNoteReleaseCallback(NoteReleaseCallback callback);
+
+    // Note settings, from the menus or MIDI remote control. Each releases the
+    // notes the change affects first; none of them saves to EEPROM.
+    // selectScale / selectRootNote set every sensor; setSensorScale /
+    // setSensorRoot just one.
+    void selectScale(uint8_t scaleIdx);
+    void selectRootNote(uint8_t rootIdx);   // 0-11 semitones above C
+    void setSensorScale(uint8_t sensor, uint8_t scaleIdx);
+    void setSensorRoot(uint8_t sensor, uint8_t rootIdx);
+    void setSensorOctave(uint8_t sensor, uint8_t octave);
+    void setSensorChannel(uint8_t sensor, uint8_t channel);
+
+    // Recompute a sensor's color -> note and chord tables from its
+    // scale, root and octave. The setters above call it; call it after
+    // writing those fields directly (EEPROM load).
+    void rebuildNotes(uint8_t sensor);
 
     // Text centering helper functions
     void centerTextAt(int y, String text, int textSize = 2);
@@ -169,27 +131,17 @@ public:
     void scaleMenuBackButton();
     void saveScale();
 
-    // Handler functions for calibration submenus
-    void calibrationMenuAEncoder(int turns);
-    void calibrationMenuAEncoderButton();
-    void calibrationMenuAConButton();
-    void calibrationMenuABackButton();
-
-    void calibrationMenuBEncoder(int turns);
-    void calibrationMenuBEncoderButton();
-    void calibrationMenuBConButton();
-    void calibrationMenuBBackButton();
+    // Handler functions for CALIBRATION_SENSOR_MENU
+    void calibrationSensorMenuEncoder(int turns);
+    void calibrationSensorMenuEncoderButton();
+    void calibrationSensorMenuConButton();
+    void calibrationSensorMenuBackButton();
 
-
-    void calibrationMenuCEncoder(int turns);
-    void calibrationMenuCEncoderButton();
-    void calibrationMenuCConButton();
-    void calibrationMenuCBackButton();
-
-    void calibrationMenuDEncoder(int turns);
-    void calibrationMenuDEncoderButton();
-    void calibrationMenuDConButton();
-    void calibrationMenuDBackButton();
+    // Handler functions for CALIBRATION_QUEUE_MENU
+    void calibrationQueueMenuEncoder(int turns);
+    void calibrationQueueMenuEncoderButton();
+    void calibrationQueueMenuConButton();
+    void calibrationQueueMenuBackButton();
     
     // Handler functions for OCTAVE_MENU
     void octaveMenuEncoder(int turns);
@@ -203,10 +155,33 @@ public:
     void rootNoteMenuEncoderButton();
     void rootNoteMenuConButton();
     void rootNoteMenuBackButton();
+    void saveRootNotes();
+    // Handler functions for TEMPO_MENU
+    void tempoMenuEncoder(int turns);
+    void tempoMenuEncoderButton();
+    void tempoMenuConButton();
+    void tempoMenuBackButton();
+    void saveTempo();
+    // Handler functions for USER_SCALE_MENU
+    void userScaleMenuEncoder(int turns);
+    void userScaleMenuEncoderButton();
+    void userScaleMenuConButton();
+    void userScaleMenuBackButton();
+    // Slot being edited, and the cursor: 0 = slot row, 1-11 = semitones above the root
+    uint8_t userScaleSlot = 0;
+    uint8_t userScaleCursor = 0;
+    // MIDI clock tempo: set with the encoder, or followed from the disk spin
+    uint16_t tempoBpm = MIDI_CLOCK_DEFAULT_BPM;
+    bool tempoFromDisk = false;
+    float diskBpm = 0; // measured, shown in disk mode; 0 = not locked yet
+
     uint8_t rootNoteSelectedIdx = 0;
     uint8_t rootNoteActiveIdx = 0;
     uint8_t rootNoteScrollIdx = 0;
     const uint8_t NUM_ROOT_NOTES = 12;
+    // Scale and root menus: row 0 picks the ring the choice applies to, the
+    // rest are the choices. -1 = every ring.
+    int8_t noteTargetSensor = -1;
     static const uint8_t ROOT_MENU_VISIBLE_ITEMS = 5;
 
     MenuState currentMenu;
@@ -220,90 +195,50 @@ public:
     // Grid menu selection (1-16 = numbers, no "..." anymore)
     int gridSelectedIdx = 1;
     
-    // Active MIDI Grid Sensor (A, B, C, or D) - which sensor we're configuring
-    ActiveSensor activeMIDIGridSensor = SENSOR_A; // Default to sensor A
+    // Active MIDI Grid Sensor - which sensor we're configuring
+    uint8_t activeMIDIGridSensor = 0; // Default to sensor A
 
-    // Calibration menu selection (0 =NONE, 1-4 = A, B, C, D, 5=A->BCD)
+    // Calibration menu selection: 0..NUM_SENSORS-1 = rings, then the CAL_ITEM_* entries
     int calibrationSelectedIdx = 0; // Default to sensor A
-    
-    // Active MIDI channels (1-16) for each sensor
-    byte activeMIDIChannelA = 3; // Default to channel 3
-    byte activeMIDIChannelB = 2; // Default to channel 2
-    byte activeMIDIChannelC = 7; // Default to channel 7
-    byte activeMIDIChannelD = 12; // Default to channel 12
+    static const int CAL_ITEM_TRANSFER = NUM_SENSORS;  // A->BCD
+    static const int CAL_ITEM_QUEUE_ALL = NUM_SENSORS + 1;
+    static const int CAL_ITEM_RUN_QUEUE = NUM_SENSORS + 2;
+    static const int CAL_ITEM_AUTO_SPIN = NUM_SENSORS + 3;
+    static const int CALIBRATION_MENU_ITEMS = NUM_SENSORS + 4;
+    // Left column (rings + transfer) scrolls once there are more rings than fit
+    static const int CALIBRATION_MENU_VISIBLE_ROWS = 5;
+    int calibrationScrollIdx = 0;
 
-    byte velocityA = 127; // Default velocity for notes
-    byte velocityB = 127; // Default velocity for notes
-    byte velocityC = 127; // Default velocity for notes
-    byte velocityD = 127; // Default velocity for notes
+    // Per-sensor note state (MIDI channel, octave, velocity, last note...),
+    // indexed by sensor number. main.cpp's note path reads and updates it.
+    SensorChannel sensorChannels[NUM_SENSORS];
     
     // Troubleshoot mode: 0 = color names, 1 = RGB values
     int troubleshootMode = 0;
-    
-    // Current detected colors for troubleshoot menu
-    String currentDetectedColorA = "unknown";
-    String currentDetectedColorB = "unknown";
-    String currentDetectedColorC = "unknown";
-    String currentDetectedColorD = "unknown";
-    
-    // Current RGB values for troubleshoot menu (mode 1)
-    uint16_t currentRGBA[3] = {0}; // R,G,B for sensor A
-    uint16_t currentRGBB[3] = {0}; // R,G,B for sensor B
-    uint16_t currentRGBC[3] = {0}; // R,G,B for sensor C
-    uint16_t currentRGBD[3] = {0}; // R,G,B for sensor D
-
-    // Current MIDI notes for each sensor
-    uint8_t currentMIDINoteA = 60;
-    uint8_t currentMIDINoteB = 60;
-    uint8_t currentMIDINoteC = 60;
-    uint8_t currentMIDINoteD = 60;
-
-    
-    // Update current color and MIDI note (called from main.cpp)
-    void updateCurrentColorA(const char* color);
-    void updateCurrentColorB(const char* color);
-    void updateCurrentColorC(const char* color);
-    void updateCurrentColorD(const char* color);
-    
-    void updateCurrentMIDINoteA(uint8_t midiNote);
-    void updateCurrentMIDINoteB(uint8_t midiNote);
-    void updateCurrentMIDINoteC(uint8_t midiNote);
-    void updateCurrentMIDINoteD(uint8_t midiNote);
+    // Troubleshoot grid shows TROUBLESHOOT_SENSORS_PER_PAGE sensors; the encoder pages through the rest
+    static const int TROUBLESHOOT_SENSORS_PER_PAGE = 4;
+    int troubleshootPage = 0;
     
     // Update RGB values for troubleshoot mode 1
-    void updateCurrentRGBA(float r, float g, float b);
-    void updateCurrentRGBB(float r, float g, float b);
-    void updateCurrentRGBC(float r, float g, float b);
-    void updateCurrentRGBD(float r, float g, float b);
+    void updateCurrentRGB(uint8_t sensor, float r, float g, float b);
 
-    uint8_t octaveA; // Current octave for sensor A
-    uint8_t octaveB; // Current octave for sensor B
-    uint8_t octaveC; // Current octave for sensor C
-    uint8_t octaveD; // Current octave for sensor D
-
-    int activeOctaveSensor = SENSOR_A; //0: A, 1: B, 2: C, 3: D
-    
-    // Helper functions for working with active sensor
-    byte* getActiveSensorMIDIChannel(); // Returns pointer to the active sensor's MIDI channel
-    void setActiveSensorMIDIChannel(int channel); // Sets the MIDI channel for the active sensor
-    
-    // int calibrationMenuSelectedIdx = 0; //there will only be four so this is fine.
+    uint8_t activeOctaveSensor = 0;
 
     static const int CALIBRATION_SUBMENU_VISIBLE_ITEMS = 5;
-    static const int CALIBRATION_SUBMENU_TOTAL_ITEMS = 14;
-    int calibrationMenuASelectedIdx = 0;
-    int calibrationMenuAScrollIdx = 0;
-    int calibrationMenuBSelectedIdx = 0;
-    int calibrationMenuBScrollIdx = 0;
-    int calibrationMenuCSelectedIdx = 0;
-    int calibrationMenuCScrollIdx = 0;
-    int calibrationMenuDSelectedIdx = 0;
-    int calibrationMenuDScrollIdx = 0;
+    static const int CALIBRATION_SUBMENU_TOTAL_ITEMS = 12;
+    // Sensor whose calibration submenu is open
+    uint8_t calibrationSensor = 0;
+    int calibrationSubmenuSelectedIdx = 0;
+    int calibrationSubmenuScrollIdx = 0;
 
-    PendingCalibrationA pendingCalibrationA;
-    PendingCalibrationB pendingCalibrationB;
-    PendingCalibrationC pendingCalibrationC;
-    PendingCalibrationD pendingCalibrationD;
+    // Pending calibration jobs. main.cpp runs the job at the head of the queue
+    // whenever calibrationRunRequested is set, then clears the flag.
+    CalibrationQueue calibrationQueue;
+    bool calibrationRunRequested = false;
+
+    // Submenu row -> job. runNow puts it at the front and starts it,
+    // otherwise it's appended to the queue for a later combined pass.
+    void queueCalibrationFromSubmenu(uint8_t sensor, int selectedIdx, bool runNow);
     
     void SharedCalibrationMenuRender(int selectedIdx, int scrollIdx);
     void startCalibrationCountdown();
@@ -311,17 +246,36 @@ public:
     void calibrationIncrementProgressBar(uint8_t i);
 
     uint8_t scaleSelectedIdx = 0;
-    uint8_t scaleActiveIdx = 0;
-    //one scale for all sensors
-    // uint8_t scaleActiveSensor = SENSOR_A;
-    uint8_t NUM_SCALES=2;
+    uint8_t scaleActiveIdx = 0; // last scale set for every sensor
+    uint8_t scaleScrollIdx = 0;
+    static const uint8_t SCALE_MENU_VISIBLE_ITEMS = 5;
     ScaleManager scaleManager = ScaleManager(ScaleManager::MAJOR, 4, 60);
 private:
-    // Callback for sending ALL NOTES OFF messages
-    AllNotesOffCallback allNotesOffCallback = nullptr;
+    // Callback for releasing sounding notes
+    NoteReleaseCallback noteReleaseCallback = nullptr;
+    void releaseNotes(int sensor);
 
+    // Show `msg` (a string literal) in a box over the screen for durMs,
+    // then the menu again; doesn't wait for it
     void showCenteredMessage(const char* msg, uint8_t textSize = 2,
                                      uint8_t padX = 8, uint8_t padY = 6,
                                      uint16_t durMs = 200);
+    void drawCenteredMessage();
+
+    // Frame scheduling (see serviceRender)
+    bool renderPending = true;
+    unsigned long lastRenderMs = 0;
+    uint32_t frameCount = 0;
+    uint32_t renderRequestCount = 0;
+    uint32_t renderUsTotal = 0;
+    uint32_t renderUsMax = 0;
+
+    // Message shown by showCenteredMessage, nullptr = none
+    const char* messageText = nullptr;
+    uint8_t messageTextSize = 2;
+    uint8_t messagePadX = 8;
+    uint8_t messagePadY = 6;
+    uint16_t messageDurMs = 0;
+    unsigned long messageShownMs = 0;
 
 };
\ No newline at end of file
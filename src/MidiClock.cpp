@@ -0,0 +1,72 @@
+#include "MidiClock.h"
+
+#define MIDI_CLOCK_PPQN 24
+
+MidiClock* MidiClock::instance = nullptr;
+
+MidiClock::MidiClock(MidiTxQueue& queue) : txQueue(queue) {}
+
+uint32_t MidiClock::periodUs(float bpm) {
+    bpm = constrain(bpm, (float)MIDI_CLOCK_MIN_BPM, (float)MIDI_CLOCK_MAX_BPM);
+    return (uint32_t)(60e6f / (bpm * MIDI_CLOCK_PPQN) + 0.5f);
+}
+
+void MidiClock::begin() {
+    instance = this;
+    period.store(periodUs(bpmSetting), std::memory_order_relaxed);
+    timer = timerBegin(MIDI_CLOCK_TIMER, 80, true); // 80 MHz APB / 80 = 1 us per count
+    timerAttachInterrupt(timer, &MidiClock::onTimer, true);
+}
+
+void MidiClock::setTempo(float bpm) {
+    bpmSetting = constrain(bpm, (float)MIDI_CLOCK_MIN_BPM, (float)MIDI_CLOCK_MAX_BPM);
+    uint32_t us = periodUs(bpmSetting);
+    if (!isRunning) {
+        period.store(us, std::memory_order_relaxed);
+        return;
+    }
+    if (us != period.load(std::memory_order_relaxed)) {
+        pendingPeriod.store(us, std::memory_order_release);
+    }
+}
+
+void MidiClock::start() {
+    if (timer == nullptr || isRunning) {
+        return;
+    }
+    uint32_t us = period.load(std::memory_order_relaxed);
+    tickCount.store(0, std::memory_order_relaxed);
+    txQueue.scheduleClockTick(micros() + us);
+    timerWrite(timer, 0);
+    timerAlarmWrite(timer, us, true);
+    timerAlarmEnable(timer);
+    isRunning = true;
+}
+
+void MidiClock::stop() {
+    if (!isRunning) {
+        return;
+    }
+    timerAlarmDisable(timer);
+    txQueue.clockStopped();
+    isRunning = false;
+    uint32_t pending = pendingPeriod.exchange(0, std::memory_order_acq_rel);
+    if (pending != 0) {
+        period.store(pending, std::memory_order_relaxed);
+    }
+}
+
+void IRAM_ATTR MidiClock::onTimer() {
+    MidiClock* clock = instance;
+    uint32_t now = micros();
+    uint32_t us = clock->pendingPeriod.exchange(0, std::memory_order_acq_rel);
+    if (us != 0) {
+        // The counter has just reloaded to 0, so the new alarm can't be behind it
+        timerAlarmWrite(clock->timer, us, true);
+        clock->period.store(us, std::memory_order_relaxed);
+    } else {
+        us = clock->period.load(std::memory_order_relaxed);
+    }
+    clock->tickCount.fetch_add(1, std::memory_order_relaxed);
+    clock->txQueue.clockTickFromISR(now, now + us);
+}
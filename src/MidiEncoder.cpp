@@ -0,0 +1,87 @@
+#include "MidiEncoder.h"
+
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_CONTROL_CHANGE 0xB0
+
+MidiEncoder::MidiEncoder(Print& port) : out(port) {}
+
+void MidiEncoder::noteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
+    channelMessage(MIDI_NOTE_ON, note, velocity, channel);
+}
+
+void MidiEncoder::noteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
+    if (noteOffAsNoteOn) {
+        // Release velocity is lost, but nothing here sends anything but 0
+        channelMessage(MIDI_NOTE_ON, note, 0, channel);
+        return;
+    }
+    channelMessage(MIDI_NOTE_OFF, note, velocity, channel);
+}
+
+void MidiEncoder::controlChange(uint8_t control, uint8_t value, uint8_t channel) {
+    channelMessage(MIDI_CONTROL_CHANGE, control, value, channel);
+}
+
+void MidiEncoder::message(uint8_t status, uint8_t data1, uint8_t data2) {
+    if (status < 0x80 || status >= 0xF0) {
+        return;
+    }
+    uint8_t type = status & 0xF0;
+    send(status, data1, data2, (type == 0xC0 || type == 0xD0) ? 1 : 2); // program change, channel pressure
+}
+
+void MidiEncoder::realTime(uint8_t status) {
+    out.write(status);
+    sent++;
+}
+
+void MidiEncoder::setRunningStatus(bool enabled) {
+    runningStatus = enabled;
+    lastStatus = 0;
+}
+
+void MidiEncoder::setNoteOffAsNoteOn(bool enabled) {
+    noteOffAsNoteOn = enabled;
+}
+
+void MidiEncoder::resetRunningStatus() {
+    lastStatus = 0;
+}
+
+float MidiEncoder::wireTimeSavedMsPerMinute(unsigned long elapsedMs) const {
+    if (elapsedMs == 0) {
+        return 0;
+    }
+    return saved * (MIDI_BYTE_US / 1000.0f) * 60000.0f / elapsedMs;
+}
+
+void MidiEncoder::channelMessage(uint8_t status, uint8_t data1, uint8_t data2, uint8_t channel) {
+    if (channel < 1 || channel > 16) {
+        return;
+    }
+    send(status | (channel - 1), data1, data2, 2);
+}
+
+void MidiEncoder::send(uint8_t status, uint8_t data1, uint8_t data2, uint8_t dataBytes) {
+    unsigned long now = millis();
+    uint8_t bytes[3];
+    uint8_t n = 0;
+    if (!runningStatus || status != lastStatus ||
+        now - lastStatusMs >= MIDI_RUNNING_STATUS_REFRESH_MS) {
+        bytes[n++] = status;
+        lastStatus = runningStatus ? status : 0;
+        lastStatusMs = now;
+    } else {
+        saved++;
+    }
+    bytes[n++] = data1 & 0x7F;
+    if (dataBytes == 2) {
+        bytes[n++] = data2 & 0x7F;
+    }
+    out.write(bytes, n);
+    sent += n;
+    if (recorder != nullptr) {
+        recorder->record(now, status, data1, data2);
+    }
+}
@@ -0,0 +1,57 @@
+#include "MidiInParser.h"
+
+#define MIDI_SYSTEM_RESET 0xFF
+
+// Data bytes that follow a channel status byte
+static uint8_t dataBytes(uint8_t status) {
+    uint8_t type = status & 0xF0;
+    return (type == 0xC0 || type == 0xD0) ? 1 : 2; // program change, channel pressure
+}
+
+bool MidiInParser::feed(uint8_t byte, MidiInMessage& out) {
+    if (byte >= 0xF8) {
+        // Real-time: passes straight through, whatever is in progress
+        if (byte == MIDI_SYSTEM_RESET) {
+            reset();
+        }
+        out.status = byte;
+        out.data1 = 0;
+        out.data2 = 0;
+        return true;
+    }
+    if (byte >= 0xF0) {
+        // System common or SysEx start/end: nothing here uses them, and their
+        // data bytes must not be taken for running status
+        status = 0;
+        count = 0;
+        skipped++;
+        return false;
+    }
+    if (byte & 0x80) {
+        status = byte;
+        needed = dataBytes(byte);
+        count = 0;
+        return false;
+    }
+
+    // Data byte
+    if (status == 0) {
+        skipped++;
+        return false;
+    }
+    if (count == 0 && needed == 2) {
+        data1 = byte;
+        count = 1;
+        return false;
+    }
+    out.status = status;
+    out.data1 = (needed == 2) ? data1 : byte;
+    out.data2 = (needed == 2) ? byte : 0;
+    count = 0; // running status: the next data byte starts another message
+    return true;
+}
+
+void MidiInParser::reset() {
+    status = 0;
+    count = 0;
+}
@@ -0,0 +1,184 @@
+#include "MidiInput.h"
+
+static_assert((MIDI_IN_QUEUE_LENGTH & (MIDI_IN_QUEUE_LENGTH - 1)) == 0 && MIDI_IN_QUEUE_LENGTH <= 128,
+              "MIDI_IN_QUEUE_LENGTH must be a power of two (free-running 8-bit indices)");
+
+#define MIDI_CONTROL_CHANGE 0xB0
+#define MIDI_CLOCK 0xF8
+#define MIDI_START 0xFA
+#define MIDI_CONTINUE 0xFB
+#define MIDI_STOP 0xFC
+
+#define CC_DATA_ENTRY_MSB 6
+#define CC_NRPN_LSB 98
+#define CC_NRPN_MSB 99
+#define CC_RPN_LSB 100
+#define CC_RPN_MSB 101
+
+#define NRPN_GLOBAL 0  // LSB 0 = scale, 1 = root
+#define NRPN_OCTAVE 1  // LSB = sensor
+#define NRPN_CHANNEL 2 // LSB = sensor
+#define NRPN_SENSOR_SCALE 3 // LSB = sensor
+#define NRPN_SENSOR_ROOT 4  // LSB = sensor
+
+// Ticks further apart than this are a restarted clock, not a slow one (< 10 BPM)
+#define MIDI_IN_CLOCK_MAX_PERIOD_US 250000UL
+
+MidiInput::MidiInput(HardwareSerial& serialPort) : port(serialPort) {}
+
+void MidiInput::begin() {
+    // Callback for every byte rather than every 120, so clock ticks are
+    // timed to the byte
+    port.setRxFIFOFull(1);
+    port.onReceive([this]() { receive(); });
+}
+
+void MidiInput::receive() {
+    uint32_t nowUs = micros();
+    int n = 0;
+    uint32_t start = ESP.getCycleCount();
+    while (port.available() > 0) {
+        feed((uint8_t)port.read(), nowUs);
+        n++;
+    }
+    parseCycles += ESP.getCycleCount() - start;
+    timedBytes += n;
+}
+
+uint32_t MidiInput::cyclesPerByte() const {
+    return (timedBytes == 0) ? 0 : (uint32_t)(parseCycles / timedBytes);
+}
+
+void MidiInput::feed(uint8_t byte, uint32_t nowUs) {
+    bytes++;
+    MidiInMessage msg;
+    if (!parser.feed(byte, msg)) {
+        return;
+    }
+    if (thru != nullptr) {
+        thru(msg);
+    }
+    switch (msg.status) {
+        case MIDI_CLOCK:
+            clock(nowUs);
+            return;
+        case MIDI_START:
+            ticks.store(0, std::memory_order_relaxed);
+            transportState.store(MIDI_TRANSPORT_RUNNING, std::memory_order_relaxed);
+            return;
+        case MIDI_CONTINUE:
+            transportState.store(MIDI_TRANSPORT_RUNNING, std::memory_order_relaxed);
+            return;
+        case MIDI_STOP:
+            transportState.store(MIDI_TRANSPORT_STOPPED, std::memory_order_relaxed);
+            return;
+        default:
+            break;
+    }
+    if (msg.status != (MIDI_CONTROL_CHANGE | (MIDI_IN_CONTROL_CHANNEL - 1))) {
+        return;
+    }
+    uint8_t h = head.load(std::memory_order_relaxed);
+    if ((uint8_t)(h - tail.load(std::memory_order_acquire)) >= MIDI_IN_QUEUE_LENGTH) {
+        dropped++;
+        return;
+    }
+    queue[h & (MIDI_IN_QUEUE_LENGTH - 1)] = msg;
+    head.store(h + 1, std::memory_order_release);
+}
+
+void MidiInput::clock(uint32_t nowUs) {
+    ticks.fetch_add(1, std::memory_order_relaxed);
+    uint32_t last = lastClockUs.load(std::memory_order_relaxed);
+    lastClockUs.store(nowUs, std::memory_order_relaxed);
+    uint32_t period = nowUs - last;
+    if (last == 0 || period > MIDI_IN_CLOCK_MAX_PERIOD_US) {
+        return;
+    }
+    // Smoothed over ~8 ticks: a third of a beat, enough to ride out UART jitter
+    uint32_t smoothed = clockPeriodUs.load(std::memory_order_relaxed);
+    if (smoothed != 0) {
+        uint32_t jitter = (period > smoothed) ? period - smoothed : smoothed - period;
+        if (jitter > jitterMaxUs.load(std::memory_order_relaxed)) {
+            jitterMaxUs.store(jitter, std::memory_order_relaxed);
+        }
+    }
+    smoothed = (smoothed == 0) ? period : smoothed + ((int32_t)(period - smoothed) >> 3);
+    clockPeriodUs.store(smoothed, std::memory_order_relaxed);
+}
+
+float MidiInput::bpm() const {
+    uint32_t period = clockPeriodUs.load(std::memory_order_relaxed);
+    uint32_t last = lastClockUs.load(std::memory_order_relaxed);
+    if (period == 0 || micros() - last > MIDI_IN_CLOCK_TIMEOUT_MS * 1000UL) {
+        return 0;
+    }
+    return 60e6f / (24.0f * period);
+}
+
+bool MidiInput::nextCommand(RemoteCommand& command) {
+    uint8_t t = tail.load(std::memory_order_relaxed);
+    while (head.load(std::memory_order_acquire) != t) {
+        MidiInMessage msg = queue[t & (MIDI_IN_QUEUE_LENGTH - 1)];
+        tail.store(++t, std::memory_order_release);
+        if (decode(msg, command)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MidiInput::decode(const MidiInMessage& msg, RemoteCommand& command) {
+    uint8_t control = msg.data1;
+    uint8_t value = msg.data2;
+    command.sensor = 0;
+    command.value = value;
+    switch (control) {
+        case MIDI_IN_CC_SCALE:
+            command.target = REMOTE_SCALE;
+            return true;
+        case MIDI_IN_CC_ROOT:
+            command.target = REMOTE_ROOT;
+            return true;
+        case CC_NRPN_MSB:
+            nrpnMsb = value;
+            return false;
+        case CC_NRPN_LSB:
+            nrpnLsb = value;
+            return false;
+        case CC_RPN_MSB:
+        case CC_RPN_LSB:
+            nrpnMsb = nrpnLsb = 0x7F; // data entry now addresses an RPN, not ours
+            return false;
+        case CC_DATA_ENTRY_MSB:
+            break;
+        default:
+            return false;
+    }
+
+    switch (nrpnMsb) {
+        case NRPN_GLOBAL:
+            if (nrpnLsb > 1) return false;
+            command.target = (nrpnLsb == 0) ? REMOTE_SCALE : REMOTE_ROOT;
+            return true;
+        case NRPN_OCTAVE:
+            if (nrpnLsb >= NUM_SENSORS) return false;
+            command.target = REMOTE_OCTAVE;
+            command.sensor = nrpnLsb;
+            return true;
+        case NRPN_CHANNEL:
+            if (nrpnLsb >= NUM_SENSORS || value > 15) return false;
+            command.target = REMOTE_CHANNEL;
+            command.sensor = nrpnLsb;
+            command.value = value + 1;
+            return true;
+        case NRPN_SENSOR_SCALE:
+        case NRPN_SENSOR_ROOT:
+            if (nrpnLsb >= NUM_SENSORS) return false;
+            command.target = (nrpnMsb == NRPN_SENSOR_SCALE) ? REMOTE_SENSOR_SCALE : REMOTE_SENSOR_ROOT;
+            command.sensor = nrpnLsb;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,232 @@
+#include "MidiRecorder.h"
+
+static_assert((MIDI_RECORDER_BYTES & (MIDI_RECORDER_BYTES - 1)) == 0 && MIDI_RECORDER_BYTES <= 32768,
+              "MIDI_RECORDER_BYTES must be a power of two (16-bit ring indices)");
+
+#define MAX_DELTA_MS 0x0FFFFFFFUL // 4-byte variable-length quantity, ~74 hours
+#define HEX_BYTES_PER_LINE 32
+
+// Data bytes after a status byte: program change and channel pressure have one
+static uint8_t dataBytes(uint8_t status) {
+    uint8_t type = status & 0xF0;
+    return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+// Counts what would be written (for the SMF track length)
+class CountingPrint : public Print {
+public:
+    uint32_t count = 0;
+    size_t write(uint8_t) override {
+        count++;
+        return 1;
+    }
+};
+
+// Writes each byte as two hex digits, HEX_BYTES_PER_LINE to a line, and sums them
+class HexLinePrint : public Print {
+public:
+    explicit HexLinePrint(Print& port) : out(port) {}
+    uint16_t sum = 0;
+
+    size_t write(uint8_t b) override {
+        static const char digits[] = "0123456789ABCDEF";
+        out.write(digits[b >> 4]);
+        out.write(digits[b & 0x0F]);
+        sum += b;
+        if (++column == HEX_BYTES_PER_LINE) {
+            out.println();
+            column = 0;
+        }
+        return 1;
+    }
+    void endLine() {
+        if (column > 0) {
+            out.println();
+            column = 0;
+        }
+    }
+
+private:
+    Print& out;
+    uint8_t column = 0;
+};
+
+// Whole ms per quarter note, so a division of that many ticks is exactly 1 ms each
+static uint32_t msPerQuarter(float bpm) {
+    bpm = constrain(bpm, (float)MIDI_CLOCK_MIN_BPM, (float)MIDI_CLOCK_MAX_BPM);
+    return (uint32_t)(60000.0f / bpm + 0.5f);
+}
+
+static void writeBig(Print& out, uint32_t value, uint8_t bytes) {
+    while (bytes-- > 0) {
+        out.write((uint8_t)(value >> (8 * bytes)));
+    }
+}
+
+uint8_t MidiRecorder::at(uint16_t offset) const {
+    return ring[(tail + offset) & (MIDI_RECORDER_BYTES - 1)];
+}
+
+void MidiRecorder::record(uint32_t ms, uint8_t status, uint8_t data1, uint8_t data2) {
+    // Paired with pause(): either this sees the pause, or pause() sees the write
+    writing.store(true);
+    if (paused.load()) {
+        writing.store(false);
+        missedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint8_t bytes[7];
+    uint8_t n = 0;
+    uint32_t delta = (eventCount > 0) ? ms - lastMs : 0;
+    if (delta > MAX_DELTA_MS) {
+        delta = MAX_DELTA_MS;
+    }
+    // Variable-length quantity, most significant group first
+    uint8_t groups = 1;
+    while (groups < 4 && (delta >> (7 * groups)) != 0) {
+        groups++;
+    }
+    while (groups-- > 0) {
+        bytes[n++] = ((delta >> (7 * groups)) & 0x7F) | (groups > 0 ? 0x80 : 0);
+    }
+    bytes[n++] = status;
+    bytes[n++] = data1 & 0x7F;
+    if (dataBytes(status) == 2) {
+        bytes[n++] = data2 & 0x7F;
+    }
+
+    while (MIDI_RECORDER_BYTES - used < n) {
+        dropOldest();
+    }
+    for (uint8_t i = 0; i < n; i++) {
+        ring[head] = bytes[i];
+        head = (head + 1) & (MIDI_RECORDER_BYTES - 1);
+    }
+    used += n;
+    if (eventCount == 0) {
+        firstMs = ms;
+    }
+    eventCount++;
+    lastMs = ms;
+    writing.store(false);
+}
+
+void MidiRecorder::dropOldest() {
+    uint16_t length = 0;
+    while (at(length) & 0x80) {
+        length++;
+    }
+    length++;
+    length += 1 + dataBytes(at(length));
+    tail = (tail + length) & (MIDI_RECORDER_BYTES - 1);
+    used -= length;
+    eventCount--;
+    overwrittenCount++;
+
+    // The next event's delta now leads the capture
+    uint32_t delta = 0;
+    uint16_t i = 0;
+    if (eventCount > 0) {
+        do {
+            delta = (delta << 7) | (at(i) & 0x7F);
+        } while (at(i++) & 0x80);
+    }
+    firstMs += delta;
+}
+
+void MidiRecorder::pause() {
+    paused.store(true);
+    while (writing.load()) {
+        delay(1); // the transmit task is part way through record()
+    }
+}
+
+void MidiRecorder::resume() {
+    paused.store(false);
+}
+
+void MidiRecorder::clear() {
+    pause();
+    head = 0;
+    tail = 0;
+    used = 0;
+    eventCount = 0;
+    firstMs = 0;
+    lastMs = 0;
+    resume();
+}
+
+void MidiRecorder::writeTrack(Print& out, float bpm) {
+    out.write((uint8_t)0x00); // tempo
+    out.write((uint8_t)0xFF);
+    out.write((uint8_t)0x51);
+    out.write((uint8_t)0x03);
+    writeBig(out, msPerQuarter(bpm) * 1000, 3);
+
+    uint16_t i = 0;
+    bool first = true;
+    while (i < used) {
+        // Deltas are stored as SMF writes them; the first one becomes 0
+        uint16_t start = i;
+        while (at(i) & 0x80) {
+            i++;
+        }
+        i++;
+        if (first) {
+            out.write((uint8_t)0x00);
+            first = false;
+        } else {
+            for (uint16_t k = start; k < i; k++) {
+                out.write(at(k));
+            }
+        }
+        uint8_t status = at(i);
+        uint8_t length = 1 + dataBytes(status);
+        for (uint8_t k = 0; k < length; k++) {
+            out.write(at(i + k));
+        }
+        i += length;
+    }
+
+    out.write((uint8_t)0x00); // end of track
+    out.write((uint8_t)0xFF);
+    out.write((uint8_t)0x2F);
+    out.write((uint8_t)0x00);
+}
+
+uint32_t MidiRecorder::writeFile(Print& out, float bpm) {
+    CountingPrint track;
+    writeTrack(track, bpm);
+
+    writeBig(out, 0x4D546864, 4); // "MThd"
+    writeBig(out, 6, 4);
+    writeBig(out, 0, 2); // format 0: one track
+    writeBig(out, 1, 2);
+    writeBig(out, msPerQuarter(bpm), 2); // ticks per quarter note
+    writeBig(out, 0x4D54726B, 4); // "MTrk"
+    writeBig(out, track.count, 4);
+    writeTrack(out, bpm);
+    return 22 + track.count;
+}
+
+uint32_t MidiRecorder::writeSmf(Print& out, float bpm) {
+    pause();
+    uint32_t bytes = writeFile(out, bpm);
+    resume();
+    return bytes;
+}
+
+void MidiRecorder::dump(Print& out, float bpm) {
+    pause();
+    CountingPrint size;
+    writeFile(size, bpm);
+    out.print("MIDIREC BEGIN ");
+    out.println(size.count);
+    HexLinePrint hex(out);
+    writeFile(hex, bpm);
+    hex.endLine();
+    out.print("MIDIREC END ");
+    out.println(hex.sum, HEX);
+    resume();
+}
@@ -0,0 +1,608 @@
+#include "MidiTxQueue.h"
+
+static_assert((MIDI_TX_QUEUE_LENGTH & (MIDI_TX_QUEUE_LENGTH - 1)) == 0 && MIDI_TX_QUEUE_LENGTH <= 32768,
+              "MIDI_TX_QUEUE_LENGTH must be a power of two (free-running 16-bit indices)");
+
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_GATED_NOTE_ON 0x91   // queue only: note-on whose note-off the gate engine sends
+#define MIDI_RELEASE_GATES 0x00   // queue only: panic for the gate engine
+#define MIDI_ARP_NOTE_ON 0xA0     // queue only, | step (bits 0-2), | MIDI_ARP_GATED: a later arpeggio step
+#define MIDI_ARP_GATED 0x08
+#define MIDI_CONTROL_CHANGE 0xB0
+#define MIDI_CLOCK 0xF8
+#define MIDI_START 0xFA
+#define MIDI_CONTINUE 0xFB
+#define MIDI_STOP 0xFC
+
+static_assert(MIDI_TX_CC_SLOTS <= 255, "MIDI_TX_CC_SLOTS must fit the round-robin index");
+
+#define CC_PENDING 0x80000000UL
+#define CC_WIDE 0x40000000UL
+#define CC_KEY_MASK 0x00007F0FUL // controller and channel
+#define CC_BUCKET_US ((int32_t)MIDI_TX_CC_BURST_BYTES * MIDI_BYTE_US)
+
+MidiTxQueue* MidiTxQueue::gateInstance = nullptr;
+
+MidiTxQueue::MidiTxQueue(HardwareSerial& serialPort, MidiEncoder& midiEncoder)
+    : port(serialPort), encoder(midiEncoder) {
+    for (uint8_t c = 0; c < 16; c++) {
+        for (uint8_t n = 0; n < 128; n++) {
+            noteOffGen[c][n].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MidiTxQueue::begin() {
+    // loop() runs on core 1; the UART gets core 0 to itself
+    xTaskCreatePinnedToCore(drainTask, "midiTx", MIDI_TX_TASK_STACK, this, MIDI_TX_TASK_PRIORITY, &task, 0);
+}
+
+bool MidiTxQueue::noteOn(uint8_t note, uint8_t velocity, uint8_t channel, bool gated) {
+    return push(MIDI_PRIORITY_NOTE, gated ? MIDI_GATED_NOTE_ON : MIDI_NOTE_ON, note, velocity, channel,
+                offGenFor(note, channel));
+}
+
+bool MidiTxQueue::arpNoteOn(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t step, bool gated) {
+    if (step == 0 || step > 7) {
+        return false;
+    }
+    return push(MIDI_PRIORITY_NOTE, MIDI_ARP_NOTE_ON | step | (gated ? MIDI_ARP_GATED : 0), note, velocity, channel,
+                offGenFor(note, channel));
+}
+
+bool MidiTxQueue::noteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
+    if (channel >= 1 && channel <= 16) {
+        // Before the push, so the drain task sees it once it has the note-off
+        std::atomic<uint8_t>& gen = noteOffGen[channel - 1][note & 0x7F];
+        gen.store(gen.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    return push(MIDI_PRIORITY_URGENT, MIDI_NOTE_OFF, note, velocity, channel);
+}
+
+uint8_t MidiTxQueue::offGenFor(uint8_t note, uint8_t channel) const {
+    if (channel < 1 || channel > 16) {
+        return 0;
+    }
+    return noteOffGen[channel - 1][note & 0x7F].load(std::memory_order_relaxed);
+}
+
+// A note-on whose note-off has been queued since: the note-off may already
+// be out, and sending this now would leave the note stuck on
+bool MidiTxQueue::isStaleNoteOn(const MidiMessage& msg) const {
+    return msg.type != MIDI_CONTROL_CHANGE && msg.offGen != offGenFor(msg.data1, msg.channel);
+}
+
+bool MidiTxQueue::controlChange(uint8_t control, uint8_t value, uint8_t channel, MidiPriority priority) {
+    if (priority == MIDI_PRIORITY_CONTROL) {
+        return pushControl(control, value & 0x7F, false, channel);
+    }
+    return push(priority, MIDI_CONTROL_CHANGE, control, value, channel);
+}
+
+bool MidiTxQueue::controlChange14(uint8_t control, uint16_t value, uint8_t channel) {
+    if (control >= 32) {
+        return false; // no LSB controller
+    }
+    return pushControl(control, value & 0x3FFF, true, channel);
+}
+
+void MidiTxQueue::setGate(uint16_t gate, uint8_t repeats, uint16_t ratchetMs) {
+    gateRepeats.store(repeats, std::memory_order_relaxed);
+    gateRatchetMs.store(ratchetMs, std::memory_order_relaxed);
+    gateMs.store(gate, std::memory_order_relaxed);
+    if (gate > 0) {
+        startGateTimer();
+    }
+}
+
+void MidiTxQueue::setArpeggio(uint16_t stepMs) {
+    arpStepMs.store(stepMs, std::memory_order_relaxed);
+    startGateTimer();
+}
+
+void MidiTxQueue::startGateTimer() {
+    if (gateTimer != nullptr) {
+        return;
+    }
+    gateInstance = this;
+    gateTimer = timerBegin(GATE_TIMER, 80, true); // 1 us per count
+    timerAttachInterrupt(gateTimer, &MidiTxQueue::onGateTimer, true);
+    timerAlarmWrite(gateTimer, GATE_TICK_US, true);
+    timerAlarmEnable(gateTimer);
+}
+
+bool MidiTxQueue::releaseGates() {
+    return push(MIDI_PRIORITY_URGENT, MIDI_RELEASE_GATES, 0, 0, 0);
+}
+
+void IRAM_ATTR MidiTxQueue::onGateTimer() {
+    MidiTxQueue* queue = gateInstance;
+    queue->gateTickUs.store(micros(), std::memory_order_relaxed);
+    queue->gateTicks.fetch_add(1, std::memory_order_release);
+    if (queue->gatesBusy.load(std::memory_order_relaxed) && queue->task != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(queue->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+// Wheel delay for `us` from now, to the nearest tick
+uint32_t MidiTxQueue::ticksAfterNow(uint32_t us) const {
+    uint32_t sinceTick = micros() - gateTickUs.load(std::memory_order_relaxed);
+    if (sinceTick >= GATE_TICK_US) {
+        sinceTick = 0; // timer not started yet, or its interrupt is due any moment
+    }
+    return (sinceTick + us + GATE_TICK_US / 2) / GATE_TICK_US;
+}
+
+void MidiTxQueue::scheduleGate(uint8_t note, uint8_t velocity, uint8_t channel, uint8_t repeats, uint8_t seq) {
+    // Timed from now, the note-on just written
+    uint32_t gateTicks = ticksAfterNow(gateMs.load(std::memory_order_relaxed) * 1000UL);
+    uint32_t ratchetTicks = ticksAfterNow(gateRatchetMs.load(std::memory_order_relaxed) * 1000UL);
+    bool ratchets = gateRepeats.load(std::memory_order_relaxed) > 0 && ratchetTicks >= 2;
+    if (ratchets && gateTicks >= ratchetTicks) {
+        gateTicks = ratchetTicks - 1; // off before the next on, the last strike too
+    }
+    if (!ratchets) {
+        repeats = 0; // no room for an off between two ons
+    }
+    GateEvent event = {note, channel, velocity, false, 0, seq, false};
+    gates.schedule(gateTicks, event);
+    if (repeats > 0) {
+        event.on = true;
+        event.repeats = repeats - 1;
+        event.gated = true;
+        gates.schedule(ratchetTicks, event);
+    }
+    gatesBusy.store(true, std::memory_order_relaxed);
+}
+
+void MidiTxQueue::scheduleArpStep(const MidiMessage& msg) {
+    uint8_t note = msg.data1 & 0x7F;
+    bool gated = msg.type & MIDI_ARP_GATED;
+    // Due this many steps after the chord's first note went out; already
+    // due (a step time of 0, or a long wait for the FIFO) goes on the next tick
+    uint32_t dueUs = arpAnchorUs + (msg.type & 0x07) * arpStepMs.load(std::memory_order_relaxed) * 1000UL;
+    int32_t wait = (int32_t)(dueUs - micros());
+    GateEvent event = {note, msg.channel, msg.data2, true,
+                       gated ? gateRepeats.load(std::memory_order_relaxed) : (uint8_t)0,
+                       noteSeq[msg.channel - 1][note], gated};
+    gates.schedule(wait > 0 ? ticksAfterNow(wait) : 1, event);
+    gatesBusy.store(true, std::memory_order_relaxed);
+}
+
+void MidiTxQueue::queueDue(const GateEvent& event, uint32_t dueUs) {
+    if (gateDueCount >= GATE_MAX_EVENTS) {
+        gateDueDropped++;
+        return;
+    }
+    GateDue& due = gateDue[(gateDueHead + gateDueCount) % GATE_MAX_EVENTS];
+    due.event = event;
+    due.dueUs = dueUs;
+    gateDueCount++;
+}
+
+void MidiTxQueue::gateFired(const GateEvent& event, void* self) {
+    MidiTxQueue* queue = static_cast<MidiTxQueue*>(self);
+    if (event.seq != queue->noteSeq[event.channel - 1][event.note]) {
+        return; // the note has been struck or released since
+    }
+    // When this event's tick happened, counting back from the latest
+    uint32_t behind = queue->gateTicks.load(std::memory_order_relaxed) - queue->gates.now();
+    queue->queueDue(event, queue->gateTickUs.load(std::memory_order_relaxed) - behind * GATE_TICK_US);
+}
+
+void MidiTxQueue::gateReleased(const GateEvent& event, void* self) {
+    MidiTxQueue* queue = static_cast<MidiTxQueue*>(self);
+    if (!event.on && event.seq == queue->noteSeq[event.channel - 1][event.note]) {
+        queue->queueDue(event, micros());
+    }
+}
+
+void MidiTxQueue::serviceGates() {
+    uint32_t tick = gateTicks.load(std::memory_order_acquire);
+    if (tick != gates.now()) {
+        gates.advanceTo(tick, gateFired, this);
+    }
+    gatesBusy.store(gates.pending() > 0 || gateDueCount > 0, std::memory_order_relaxed);
+}
+
+void MidiTxQueue::flushGates() {
+    // Note-offs already due stay; repeats still waiting to go out don't
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < gateDueCount; i++) {
+        const GateDue& due = gateDue[(gateDueHead + i) % GATE_MAX_EVENTS];
+        if (!due.event.on) {
+            gateDue[(gateDueHead + kept++) % GATE_MAX_EVENTS] = due;
+        }
+    }
+    gateDueCount = kept;
+    gates.flush(gateReleased, this);
+}
+
+bool MidiTxQueue::sendGateEvent(int fifoUsed) {
+    while (gateDueCount > 0) {
+        if (fifoUsed > MIDI_TX_FIFO_SIZE - 3) {
+            return false;
+        }
+        GateDue due = gateDue[gateDueHead];
+        gateDueHead = (gateDueHead + 1) % GATE_MAX_EVENTS;
+        gateDueCount--;
+        const GateEvent& event = due.event;
+        uint8_t& seq = noteSeq[event.channel - 1][event.note];
+        if (event.seq != seq) {
+            continue; // superseded while it waited for FIFO room
+        }
+        uint32_t before = encoder.bytesSent();
+        if (event.on) {
+            encoder.noteOn(event.note, event.velocity, event.channel);
+            seq++;
+            if (event.gated) {
+                scheduleGate(event.note, event.velocity, event.channel, event.repeats, seq);
+            }
+        } else {
+            encoder.noteOff(event.note, 0, event.channel);
+        }
+        uint32_t bytes = encoder.bytesSent() - before;
+        ccTokensUs -= (int32_t)(bytes * MIDI_BYTE_US);
+        if (ccTokensUs < -CC_BUCKET_US) {
+            ccTokensUs = -CC_BUCKET_US;
+        }
+        gateSent++;
+        uint32_t lateness = (micros() - due.dueUs) + fifoUsed * MIDI_BYTE_US;
+        if (lateness > gateLatenessMaxUs) {
+            gateLatenessMaxUs = lateness;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool MidiTxQueue::forward(uint8_t status, uint8_t data1, uint8_t data2) {
+    bool clockMessage = status == MIDI_CLOCK || status == MIDI_START ||
+                        status == MIDI_CONTINUE || status == MIDI_STOP;
+    if (clockMessage && clockRunning.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return push(MIDI_PRIORITY_THRU, status, data1, data2, 0);
+}
+
+void IRAM_ATTR MidiTxQueue::clockTickFromISR(uint32_t nowUs, uint32_t nextTickUs) {
+    if (clockPending.load(std::memory_order_relaxed) == 0) {
+        clockDueUs.store(nowUs, std::memory_order_relaxed);
+    }
+    clockPending.fetch_add(1, std::memory_order_release);
+    nextClockUs.store(nextTickUs, std::memory_order_relaxed);
+    if (task != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+void MidiTxQueue::scheduleClockTick(uint32_t nextTickUs) {
+    nextClockUs.store(nextTickUs, std::memory_order_relaxed);
+    clockRunning.store(true, std::memory_order_release);
+}
+
+void MidiTxQueue::clockStopped() {
+    clockRunning.store(false, std::memory_order_release);
+}
+
+bool MidiTxQueue::sendClockTick(int fifoUsed) {
+    if (clockPending.load(std::memory_order_acquire) == 0 || fifoUsed >= MIDI_TX_FIFO_SIZE) {
+        return false;
+    }
+    uint32_t due = clockDueUs.load(std::memory_order_relaxed);
+    clockPending.fetch_sub(1, std::memory_order_acq_rel);
+    encoder.realTime(MIDI_CLOCK); // real-time: leaves running status alone
+    clockSent++;
+    // Its start bit goes out once the FIFO ahead of it has drained
+    uint32_t lateness = (micros() - due) + fifoUsed * MIDI_BYTE_US;
+    if (lateness > clockLatenessMaxUs) {
+        clockLatenessMaxUs = lateness;
+    }
+    return true;
+}
+
+bool MidiTxQueue::clockGuard(int fifoUsed) const {
+    if (!clockRunning.load(std::memory_order_acquire)) {
+        return false;
+    }
+    // Time left before the next tick, against the wire time of what's in the
+    // FIFO plus the longest message we might add. A tick that is slightly
+    // overdue (interrupt not in yet) still counts as upcoming.
+    int32_t until = (int32_t)(nextClockUs.load(std::memory_order_relaxed) - micros());
+    int32_t busy = (fifoUsed + 3) * MIDI_BYTE_US + MIDI_CLOCK_GUARD_US;
+    return until > -(int32_t)MIDI_CLOCK_GUARD_US && until < busy;
+}
+
+bool MidiTxQueue::push(MidiPriority priority, uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel,
+                       uint8_t offGen) {
+    Ring& ring = rings[priority];
+    Stats& st = stats[priority];
+    uint16_t head = ring.head.load(std::memory_order_relaxed);
+    uint16_t depth = head - ring.tail.load(std::memory_order_acquire);
+    if (depth >= MIDI_TX_QUEUE_LENGTH) {
+        st.dropped++;
+        return false;
+    }
+    MidiMessage& slot = ring.slots[head & (MIDI_TX_QUEUE_LENGTH - 1)];
+    slot.type = type;
+    slot.channel = channel;
+    slot.data1 = data1;
+    slot.data2 = data2;
+    slot.offGen = offGen;
+    slot.queuedUs = micros();
+    ring.head.store(head + 1, std::memory_order_release);
+
+    if (depth + 1 > st.maxDepth) {
+        st.maxDepth = depth + 1;
+    }
+    wake();
+    return true;
+}
+
+bool MidiTxQueue::pushControl(uint8_t control, uint16_t value, bool wide, uint8_t channel) {
+    if (channel < 1 || channel > 16) {
+        return false;
+    }
+    uint32_t key = (uint32_t)(control & 0x7F) << 8 | (channel - 1);
+    uint32_t word = CC_PENDING | (wide ? CC_WIDE : 0) | (uint32_t)value << 16 | key;
+    Stats& st = stats[MIDI_PRIORITY_CONTROL];
+
+    // The slot already holding this controller, else the first idle one.
+    // Only this side ever changes a slot's key, and only while it is idle.
+    int match = -1;
+    int idle = -1;
+    uint16_t waiting = 0;
+    for (int i = 0; i < MIDI_TX_CC_SLOTS; i++) {
+        uint32_t w = ccSlots[i].word.load(std::memory_order_acquire);
+        if (w & CC_PENDING) {
+            waiting++;
+        } else if (idle < 0) {
+            idle = i;
+        }
+        if (match < 0 && (w & CC_KEY_MASK) == key) {
+            match = i;
+        }
+    }
+    int i = (match >= 0) ? match : idle;
+    if (i < 0) {
+        st.dropped++;
+        return false;
+    }
+
+    CcSlot& slot = ccSlots[i];
+    if (!(slot.word.load(std::memory_order_relaxed) & CC_PENDING)) {
+        slot.queuedUs.store(micros(), std::memory_order_relaxed);
+        waiting++;
+    }
+    uint32_t old = slot.word.exchange(word, std::memory_order_acq_rel);
+    if ((old & CC_PENDING) && (old & CC_KEY_MASK) == key) {
+        ccCoalesced++; // the older value never went out
+    }
+
+    if (waiting > st.maxDepth) {
+        st.maxDepth = waiting;
+    }
+    wake();
+    return true;
+}
+
+void MidiTxQueue::wake() {
+    if (task != nullptr) {
+        xTaskNotifyGive(task); // wake the drain task now rather than on its next tick
+    }
+}
+
+bool MidiTxQueue::popMessage(MidiPriority priority, MidiMessage& msg) {
+    Ring& ring = rings[priority];
+    uint16_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (ring.head.load(std::memory_order_acquire) == tail) {
+        return false;
+    }
+    msg = ring.slots[tail & (MIDI_TX_QUEUE_LENGTH - 1)];
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool MidiTxQueue::nextIsRealTime(MidiPriority priority) const {
+    const Ring& ring = rings[priority];
+    uint16_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (ring.head.load(std::memory_order_acquire) == tail) {
+        return false;
+    }
+    return ring.slots[tail & (MIDI_TX_QUEUE_LENGTH - 1)].type >= MIDI_CLOCK;
+}
+
+bool MidiTxQueue::popControl(uint32_t& word, uint32_t& queuedUs) {
+    for (uint8_t k = 0; k < MIDI_TX_CC_SLOTS; k++) {
+        uint8_t i = (ccNextSlot + k) % MIDI_TX_CC_SLOTS;
+        CcSlot& slot = ccSlots[i];
+        uint32_t w = slot.word.load(std::memory_order_acquire);
+        if (ccTokensUs < ((w & CC_WIDE) ? 6 : 3) * MIDI_BYTE_US) {
+            continue; // can't afford it yet (a pair costs up to 6 bytes)
+        }
+        // A failed exchange means loop() just wrote a newer value: take that one
+        while ((w & CC_PENDING) &&
+               !slot.word.compare_exchange_weak(w, w & ~CC_PENDING, std::memory_order_acq_rel)) {
+        }
+        if (!(w & CC_PENDING)) {
+            continue;
+        }
+        word = w;
+        queuedUs = slot.queuedUs.load(std::memory_order_relaxed);
+        ccNextSlot = (i + 1) % MIDI_TX_CC_SLOTS;
+        return true;
+    }
+    return false;
+}
+
+void MidiTxQueue::refillTokens() {
+    uint32_t now = micros();
+    uint32_t elapsed = now - ccRefilledUs;
+    ccRefilledUs = now;
+    if (elapsed > 1000000) {
+        elapsed = 1000000; // long idle: the bucket is full anyway, and this can't overflow
+    }
+    ccTokensUs += (int32_t)(elapsed * MIDI_TX_CC_SHARE_PERCENT / 100);
+    if (ccTokensUs > CC_BUCKET_US) {
+        ccTokensUs = CC_BUCKET_US;
+    }
+}
+
+bool MidiTxQueue::drainOnce() {
+    // Assumes no TX ring buffer on the port, so this is the hardware FIFO
+    int fifoUsed = MIDI_TX_FIFO_SIZE - port.availableForWrite();
+    if (fifoUsed < 0) {
+        fifoUsed = 0;
+    }
+    refillTokens();
+
+    if (sendClockTick(fifoUsed)) {
+        return true;
+    }
+    if (clockGuard(fifoUsed)) {
+        return false; // keep the wire clear for the tick; its interrupt wakes us
+    }
+    // Scheduled note-offs and repeats are due now: same rule as note-offs
+    serviceGates();
+    if (sendGateEvent(fifoUsed)) {
+        return true;
+    }
+
+    // Note-offs and forwarded real-time bytes only need room in the FIFO;
+    // everything else waits for the FIFO to run down to the lead so a
+    // note-off never queues behind it, and CCs also need the tokens for a
+    // full message
+    MidiMessage msg;
+    uint32_t cc = 0;
+    MidiPriority p;
+    if (fifoUsed <= MIDI_TX_FIFO_SIZE - 3 && popMessage(MIDI_PRIORITY_URGENT, msg)) {
+        if (msg.type == MIDI_RELEASE_GATES) {
+            flushGates();
+            return true;
+        }
+        p = MIDI_PRIORITY_URGENT;
+    } else if (fifoUsed < MIDI_TX_FIFO_SIZE && nextIsRealTime(MIDI_PRIORITY_THRU) &&
+               popMessage(MIDI_PRIORITY_THRU, msg)) {
+        p = MIDI_PRIORITY_THRU;
+    } else if (fifoUsed > MIDI_TX_FIFO_LEAD_BYTES) {
+        return false;
+    } else if (popMessage(MIDI_PRIORITY_THRU, msg)) {
+        p = MIDI_PRIORITY_THRU;
+    } else if (popMessage(MIDI_PRIORITY_NOTE, msg)) {
+        if (isStaleNoteOn(msg)) {
+            staleNoteOnCount++;
+            return true;
+        }
+        if ((msg.type & 0xF0) == MIDI_ARP_NOTE_ON) {
+            if (msg.channel >= 1 && msg.channel <= 16) {
+                scheduleArpStep(msg); // no bytes yet
+            }
+            return true;
+        }
+        p = MIDI_PRIORITY_NOTE;
+    } else if (popControl(cc, msg.queuedUs)) {
+        p = MIDI_PRIORITY_CONTROL;
+    } else {
+        return false;
+    }
+
+    uint32_t before = encoder.bytesSent();
+    if (p == MIDI_PRIORITY_CONTROL) {
+        uint8_t channel = (cc & 0x0F) + 1;
+        uint8_t control = (cc >> 8) & 0x7F;
+        uint16_t value = (cc >> 16) & 0x3FFF;
+        if (cc & CC_WIDE) {
+            encoder.controlChange(control, value >> 7, channel);
+            encoder.controlChange(control + 32, value & 0x7F, channel);
+        } else {
+            encoder.controlChange(control, value, channel);
+        }
+    } else if (p == MIDI_PRIORITY_THRU) {
+        if (msg.type >= MIDI_CLOCK) {
+            encoder.realTime(msg.type);
+        } else {
+            encoder.message(msg.type, msg.data1, msg.data2);
+        }
+    } else {
+        switch (msg.type) {
+            case MIDI_NOTE_ON:
+            case MIDI_GATED_NOTE_ON:
+                encoder.noteOn(msg.data1, msg.data2, msg.channel);
+                break;
+            case MIDI_NOTE_OFF:
+                encoder.noteOff(msg.data1, msg.data2, msg.channel);
+                break;
+            default:
+                encoder.controlChange(msg.data1, msg.data2, msg.channel);
+                break;
+        }
+        if (msg.type != MIDI_CONTROL_CHANGE && msg.channel >= 1 && msg.channel <= 16) {
+            // Whatever is still scheduled for this note belongs to an older strike
+            uint8_t& seq = noteSeq[msg.channel - 1][msg.data1 & 0x7F];
+            seq++;
+            if (msg.type == MIDI_GATED_NOTE_ON) {
+                scheduleGate(msg.data1 & 0x7F, msg.data2, msg.channel, gateRepeats.load(std::memory_order_relaxed), seq);
+            }
+            if (msg.type != MIDI_NOTE_OFF) {
+                arpAnchorUs = micros(); // any steps queued behind it count from here
+            }
+        }
+    }
+    uint32_t bytes = encoder.bytesSent() - before;
+
+    // Every byte counts against the CC budget; the debt is capped so CCs
+    // come back within a few ms once the notes stop
+    ccTokensUs -= (int32_t)(bytes * MIDI_BYTE_US);
+    if (ccTokensUs < -CC_BUCKET_US) {
+        ccTokensUs = -CC_BUCKET_US;
+    }
+
+    // Until its last byte has left the wire
+    uint32_t latency = (micros() - msg.queuedUs) + (fifoUsed + bytes) * MIDI_BYTE_US;
+    Stats& st = stats[p];
+    st.sent++;
+    if (latency > st.maxLatencyUs) {
+        st.maxLatencyUs = latency;
+    }
+    st.averageLatencyUs = (st.sent == 1) ? latency
+                                         : st.averageLatencyUs + ((int32_t)(latency - st.averageLatencyUs) >> 4);
+    return true;
+}
+
+uint16_t MidiTxQueue::depth(MidiPriority priority) const {
+    if (priority == MIDI_PRIORITY_CONTROL) {
+        uint16_t waiting = 0;
+        for (int i = 0; i < MIDI_TX_CC_SLOTS; i++) {
+            waiting += (ccSlots[i].word.load(std::memory_order_relaxed) & CC_PENDING) ? 1 : 0;
+        }
+        return waiting;
+    }
+    const Ring& ring = rings[priority];
+    return ring.head.load(std::memory_order_relaxed) - ring.tail.load(std::memory_order_relaxed);
+}
+
+void MidiTxQueue::resetMaxima() {
+    for (uint8_t p = 0; p < MIDI_PRIORITY_COUNT; p++) {
+        stats[p].maxDepth = 0;
+        stats[p].maxLatencyUs = 0;
+    }
+    clockLatenessMaxUs = 0;
+    gateLatenessMaxUs = 0;
+    gates.resetMaxima();
+}
+
+void MidiTxQueue::drainTask(void* self) {
+    MidiTxQueue* queue = static_cast<MidiTxQueue*>(self);
+    for (;;) {
+        if (!queue->drainOnce()) {
+            // Nothing to send, or the FIFO is still full: sleep until a new
+            // message arrives or a tick passes (3 bytes' worth of wire time)
+            ulTaskNotifyTake(pdTRUE, 1);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include "NoteBurst.h"
+
+#define NOTE_BURST_WINDOW_US ((uint32_t)NOTE_BURST_WINDOW_MS * 1000)
+
+void NoteBurst::add(const NoteChange& change, uint32_t nowUs, NoteSendCallback send) {
+    if (count > 0) {
+        bool sameSensor = false;
+        for (uint8_t i = 0; i < count; i++) {
+            sameSensor = sameSensor || changes[i].sensor == change.sensor;
+        }
+        // Onsets are estimates, so compare in both directions
+        int32_t apart = (int32_t)(change.onsetUs - changes[0].onsetUs);
+        if (sameSensor || apart > (int32_t)NOTE_BURST_WINDOW_US || -apart > (int32_t)NOTE_BURST_WINDOW_US) {
+            flush(send);
+        }
+    }
+    if (count == 0) {
+        openedUs = nowUs;
+        readMask = 0;
+        readCount = 0;
+    }
+    changes[count++] = change;
+    sensorRead(change.sensor);
+
+    if (NOTE_BURST_WINDOW_MS == 0 || count == NUM_SENSORS) {
+        flush(send);
+    }
+}
+
+void NoteBurst::sensorRead(uint8_t sensor) {
+    if (count == 0 || sensor >= NUM_SENSORS || (readMask & sensorBit(sensor))) {
+        return;
+    }
+    readMask |= sensorBit(sensor);
+    readCount++;
+}
+
+void NoteBurst::service(uint32_t nowUs, uint8_t activeSensors, NoteSendCallback send) {
+    if (count == 0) {
+        return;
+    }
+    if (readCount >= activeSensors || nowUs - openedUs >= NOTE_BURST_WINDOW_US) {
+        flush(send);
+    }
+}
+
+// Indices of `changes` ordered by (channel, first note); n <= NUM_SENSORS, so a plain insertion sort
+static uint8_t sortByChannel(const NoteChange changes[], uint8_t count, bool offs, uint8_t order[]) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        const Voicing& v = offs ? changes[i].off : changes[i].on;
+        if (v.count == 0) continue;
+        uint16_t key = (offs ? changes[i].offChannel : changes[i].onChannel) << 8 | v.notes[0];
+        uint8_t j = n++;
+        while (j > 0) {
+            const NoteChange& prev = changes[order[j - 1]];
+            uint16_t prevKey = offs ? (prev.offChannel << 8 | prev.off.notes[0])
+                                    : (prev.onChannel << 8 | prev.on.notes[0]);
+            if (prevKey <= key) break;
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    return n;
+}
+
+void NoteBurst::flush(NoteSendCallback send) {
+    if (count == 0) {
+        return;
+    }
+    uint8_t order[NUM_SENSORS];
+    // Releases first, so a voice-limited synth has room for the new notes
+    uint8_t n = sortByChannel(changes, count, true, order);
+    for (uint8_t i = 0; i < n; i++) {
+        const NoteChange& c = changes[order[i]];
+        for (uint8_t v = 0; v < c.off.count; v++) {
+            send(false, c.off.notes[v], 0, c.offChannel, 0);
+        }
+    }
+    n = sortByChannel(changes, count, false, order);
+    for (uint8_t i = 0; i < n; i++) {
+        const NoteChange& c = changes[order[i]];
+        for (uint8_t v = 0; v < c.on.count; v++) {
+            send(true, c.on.notes[v], c.velocity, c.onChannel, c.arpeggio ? v : 0);
+        }
+    }
+    largest = max(largest, count);
+    count = 0;
+}
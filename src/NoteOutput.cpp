@@ -0,0 +1,61 @@
+#include "NoteOutput.h"
+
+NoteOutput* NoteOutput::instance = nullptr;
+
+NoteOutput::NoteOutput(MidiTxQueue& txQueue, ActiveNotes& activeNotes, NoteBurst& noteBurst)
+    : queue(txQueue), notes(activeNotes), burst(noteBurst) {
+    instance = this;
+}
+
+void NoteOutput::send(bool on, uint8_t note, uint8_t velocity, uint8_t channel, uint8_t step) {
+    MidiTxQueue& queue = instance->queue;
+    ActiveNotes& notes = instance->notes;
+    bool gated = queue.gateTimeMs() > 0;
+    if (on && gated) {
+        if (step > 0) {
+            queue.arpNoteOn(note, velocity, channel, step, true);
+        } else {
+            queue.noteOn(note, velocity, channel, true);
+        }
+    } else if (on) {
+        bool queued = (step > 0) ? queue.arpNoteOn(note, velocity, channel, step)
+                                 : queue.noteOn(note, velocity, channel);
+        if (queued) {
+            notes.noteOn(channel, note);
+        }
+    } else if (notes.owners(channel, note) > 1) {
+        notes.noteOff(channel, note); // still held by another sensor
+    } else if (notes.isOn(channel, note)) { // already off: nothing to send
+        if (queue.noteOff(note, velocity, channel)) {
+            notes.noteOff(channel, note);
+        }
+    }
+}
+
+bool NoteOutput::queueNoteOff(uint8_t note, uint8_t channel) {
+    return instance->queue.noteOff(note, 0, channel);
+}
+
+void NoteOutput::releasePlaying(SensorChannel& channel) {
+    for (uint8_t v = 0; v < channel.playing.count; v++) {
+        send(false, channel.playing.notes[v], 0, channel.midiChannel);
+    }
+    channel.playing.count = 0;
+}
+
+void NoteOutput::releaseSensor(SensorChannel& channel) {
+    flush(); // a held note-on would otherwise sound after its release
+    releasePlaying(channel);
+    channel.currentColor = Color::UNKNOWN;
+}
+
+uint16_t NoteOutput::panic(SensorChannel channels[], uint8_t count) {
+    flush(); // so nothing held back sounds after the panic
+    // Only the notes actually sounding, instead of All Notes Off on all 16 channels
+    uint16_t released = notes.releaseAll(queueNoteOff);
+    queue.releaseGates(); // gated notes and their repeats
+    for (uint8_t i = 0; i < count; i++) {
+        channels[i].playing.count = 0;
+    }
+    return released;
+}
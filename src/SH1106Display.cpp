@@ -0,0 +1,88 @@
+#include "SH1106Display.h"
+
+#define SH1106_SET_PAGE 0xB0
+#define SH1106_COLUMN_HIGH 0x10
+#define SH1106_COLUMN_LOW 0x00
+#define CONTROL_COMMANDS 0x00 // Co = 0, D/C = 0: command bytes follow
+#define CONTROL_DATA 0x40     // Co = 0, D/C = 1: display RAM bytes follow
+// I2C bytes to address a run before its data: address + control + 3
+// commands, then address + control for the data
+#define RUN_START_BYTES 7
+
+SH1106Display::SH1106Display(uint16_t width, uint16_t height, TwoWire* wire, int8_t resetPin)
+    : Adafruit_SH1106G(width, height, wire, resetPin, I2C_CLOCK_HZ, I2C_CLOCK_HZ) {}
+
+bool SH1106Display::begin(uint8_t address, bool reset) {
+    invalidate();
+    return Adafruit_SH1106G::begin(address, reset);
+}
+
+uint32_t SH1106Display::runBytes(uint16_t length) const {
+    uint16_t chunk = i2c_dev->maxBufferSize() - 1; // the control byte takes one
+    uint16_t chunks = (length + chunk - 1) / chunk;
+    return (RUN_START_BYTES - 2) + length + 2 * chunks;
+}
+
+void SH1106Display::sendRun(uint8_t page, uint8_t first, uint8_t last) {
+    uint8_t column = first + _page_start_offset; // the SH1106 has 132 columns, the panel shows 128
+    uint8_t commands[3] = {
+        (uint8_t)(SH1106_SET_PAGE | page),
+        (uint8_t)(SH1106_COLUMN_HIGH | (column >> 4)),
+        (uint8_t)(SH1106_COLUMN_LOW | (column & 0x0F)),
+    };
+    uint8_t control = CONTROL_COMMANDS;
+    i2c_dev->write(commands, sizeof(commands), true, &control, 1);
+
+    control = CONTROL_DATA;
+    uint16_t chunk = i2c_dev->maxBufferSize() - 1;
+    const uint8_t* data = buffer + (uint16_t)page * SCREEN_WIDTH + first;
+    uint16_t remaining = last - first + 1;
+    while (remaining > 0) {
+        uint16_t n = min(remaining, chunk);
+        i2c_dev->write(data, n, true, &control, 1);
+        data += n;
+        remaining -= n;
+    }
+    memcpy(&shadow[page][first], buffer + (uint16_t)page * SCREEN_WIDTH + first, last - first + 1);
+    sentBytes += runBytes(last - first + 1);
+}
+
+void SH1106Display::display() {
+    for (uint8_t page = 0; page < PAGES; page++) {
+        if (!shadowValid) {
+            sendRun(page, 0, SCREEN_WIDTH - 1);
+            continue;
+        }
+        const uint8_t* row = buffer + (uint16_t)page * SCREEN_WIDTH;
+        uint16_t column = 0;
+        while (column < SCREEN_WIDTH) {
+            if (row[column] == shadow[page][column]) {
+                column++;
+                continue;
+            }
+            // Extend the run over gaps cheaper to resend than to skip
+            uint16_t first = column;
+            uint16_t last = column;
+            for (column++; column < SCREEN_WIDTH && column - last <= RUN_START_BYTES; column++) {
+                if (row[column] != shadow[page][column]) {
+                    last = column;
+                }
+            }
+            sendRun(page, first, last);
+        }
+    }
+    shadowValid = true;
+    frameCount++;
+}
+
+void SH1106Display::resetStats() {
+    frameCount = 0;
+    sentBytes = 0;
+}
+
+uint32_t SH1106Display::busTimeSavedMs() const {
+    uint32_t full = fullFrameBytes();
+    uint32_t skipped = (full > sentBytes) ? full - sentBytes : 0;
+    // 9 clocks per byte (8 bits + ACK)
+    return (uint32_t)((uint64_t)skipped * 9 * 1000 / I2C_CLOCK_HZ);
+}
@@ -0,0 +1,53 @@
+#include "SampleHistory.h"
+
+void SampleRing::push(uint32_t time, const uint16_t rawCRGB[4], const float calibratedRGB[3],
+                      Color sampleColor, float sampleMargin) {
+    uint16_t i = written & SAMPLE_HISTORY_MASK;
+    timeUs[i] = time;
+    for (int ch = 0; ch < 4; ch++) {
+        raw[ch][i] = rawCRGB[ch];
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        // Corrected values can overshoot 16 bits with a large gain
+        calibrated[ch][i] = (uint16_t)constrain(calibratedRGB[ch], 0.0f, 65535.0f);
+    }
+    color[i] = sampleColor;
+    margin[i] = (uint8_t)(constrain(sampleMargin, 0.0f, 1.0f) * 255.0f + 0.5f);
+    written++;
+}
+
+uint16_t SampleRing::size() const {
+    return (written < SAMPLE_HISTORY_LENGTH) ? written : SAMPLE_HISTORY_LENGTH;
+}
+
+template <typename T>
+RingView<T> SampleRing::view(const T* field, uint16_t count) const {
+    if (count > size()) {
+        count = size();
+    }
+    RingView<T> v;
+    v.data = field;
+    v.start = (written - count) & SAMPLE_HISTORY_MASK;
+    v.count = count;
+    return v;
+}
+
+RingView<uint32_t> SampleRing::times(uint16_t count) const {
+    return view(timeUs, count);
+}
+
+RingView<uint16_t> SampleRing::rawChannel(SampleChannel channel, uint16_t count) const {
+    return view(raw[channel], count);
+}
+
+RingView<uint16_t> SampleRing::calibratedChannel(uint8_t channel, uint16_t count) const {
+    return view(calibrated[channel < 3 ? channel : 0], count);
+}
+
+RingView<Color> SampleRing::colors(uint16_t count) const {
+    return view(color, count);
+}
+
+RingView<uint8_t> SampleRing::margins(uint16_t count) const {
+    return view(margin, count);
+}
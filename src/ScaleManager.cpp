@@ -7,22 +7,111 @@
 // Must NOT be 0 because 0 is a valid offset (root). Use 0xFF (255) as an out-of-band sentinel.
 const uint8_t MIDI_NOTE_OFF = 0xFF;
 
-// Major scale intervals (semitones from root)
-// Maps to Color enum order: PINK, ORANGE, BLUE, YELLOW, GREEN, RED, PURPLE, BROWN, WHITE
-// C=0, D=2, E=4, F=5, G=7, A=9, B=11, WHITE=special
-static const uint8_t majorScaleOffsets[] = {
-    0, 2, 4, 5, 7, 9, 11, MIDI_NOTE_OFF  // Maps to: C, D, E, F, G, A, B, OFF
+// Interval mask from the semitones above the root: intervals(0, 2, 4, ...)
+static constexpr uint16_t intervals() { return 0; }
+template <typename... Rest>
+static constexpr uint16_t intervals(uint8_t semitone, Rest... rest) {
+    return (1u << semitone) | intervals(rest...);
+}
+
+static constexpr uint8_t noteCount(uint16_t mask) {
+    return mask == 0 ? 0 : (mask & 1) + noteCount(mask >> 1);
+}
+
+// Semitone of the n-th note (from 0) of a mask, searching from `semitone`
+static constexpr uint8_t nthSemitone(uint16_t mask, uint8_t n, uint8_t semitone) {
+    return semitone >= 12 ? 0
+         : !((mask >> semitone) & 1) ? nthSemitone(mask, n, semitone + 1)
+         : n == 0 ? semitone
+         : nthSemitone(mask, n - 1, semitone + 1);
+}
+
+// Offset of a scale degree; degrees past the last note go up an octave
+static constexpr uint8_t degreeOffset(uint16_t mask, uint8_t degree) {
+    return 12 * (degree / noteCount(mask)) + nthSemitone(mask, degree % noteCount(mask), 0);
+}
+
+// Color index -> offset; colors before WHITE are the degrees in order
+static constexpr uint8_t colorOffset(uint16_t mask, uint8_t color) {
+    return color == static_cast<uint8_t>(Color::WHITE) ? MIDI_NOTE_OFF : degreeOffset(mask, color);
+}
+
+static_assert(static_cast<uint8_t>(Color::WHITE) == NUM_COLORS - 1,
+              "colors before WHITE take the scale degrees in order");
+static_assert(NUM_COLORS == 8, "ScaleDef lists one offset per color");
+
+struct ScaleDef {
+    const char* name;
+    uint16_t mask;
+    uint8_t offsets[NUM_COLORS]; // Color enum order
 };
 
-static_assert(sizeof(majorScaleOffsets) / sizeof(majorScaleOffsets[0]) == NUM_COLORS,
-              "majorScaleOffsets must have NUM_COLORS entries");
+static constexpr ScaleDef makeScale(const char* name, uint16_t mask) {
+    return ScaleDef{name, mask, {colorOffset(mask, 0), colorOffset(mask, 1), colorOffset(mask, 2),
+                                 colorOffset(mask, 3), colorOffset(mask, 4), colorOffset(mask, 5),
+                                 colorOffset(mask, 6), colorOffset(mask, 7)}};
+}
 
-static const uint8_t minorScaleOffsets[] = {
-    0, 2, 3, 5, 7, 8, 10, MIDI_NOTE_OFF  // Maps to: C, D, D#, F, G, G#, A#,  OFF
+// New scales go at the end: a row's index is what EEPROM and MIDI remote
+// control store. Names fit the scale menu (17 characters).
+static constexpr ScaleDef builtinScales[] = {
+    makeScale("Major",             intervals(0, 2, 4, 5, 7, 9, 11)),
+    makeScale("Minor",             intervals(0, 2, 3, 5, 7, 8, 10)),
+    makeScale("Dorian",            intervals(0, 2, 3, 5, 7, 9, 10)),
+    makeScale("Phrygian",          intervals(0, 1, 3, 5, 7, 8, 10)),
+    makeScale("Lydian",            intervals(0, 2, 4, 6, 7, 9, 11)),
+    makeScale("Mixolydian",        intervals(0, 2, 4, 5, 7, 9, 10)),
+    makeScale("Locrian",           intervals(0, 1, 3, 5, 6, 8, 10)),
+    makeScale("Harmonic Minor",    intervals(0, 2, 3, 5, 7, 8, 11)),
+    makeScale("Melodic Minor",     intervals(0, 2, 3, 5, 7, 9, 11)),
+    makeScale("Major Pentatonic",  intervals(0, 2, 4, 7, 9)),
+    makeScale("Minor Pentatonic",  intervals(0, 3, 5, 7, 10)),
+    makeScale("Blues",             intervals(0, 3, 5, 6, 7, 10)),
+    makeScale("Major Blues",       intervals(0, 2, 3, 4, 7, 9)),
+    makeScale("Harmonic Major",    intervals(0, 2, 4, 5, 7, 8, 11)),
+    makeScale("Phrygian Dominant", intervals(0, 1, 4, 5, 7, 8, 10)),
+    makeScale("Lydian Dominant",   intervals(0, 2, 4, 6, 7, 9, 10)),
+    makeScale("Ukrainian Dorian",  intervals(0, 2, 3, 6, 7, 9, 10)),
+    makeScale("Altered",           intervals(0, 1, 3, 4, 6, 8, 10)),
+    makeScale("Locrian #2",        intervals(0, 2, 3, 5, 6, 8, 10)),
+    makeScale("Lydian Augmented",  intervals(0, 2, 4, 6, 8, 9, 11)),
+    makeScale("Hungarian Minor",   intervals(0, 2, 3, 6, 7, 8, 11)),
+    makeScale("Double Harmonic",   intervals(0, 1, 4, 5, 7, 8, 11)),
+    makeScale("Neapolitan Minor",  intervals(0, 1, 3, 5, 7, 8, 11)),
+    makeScale("Neapolitan Major",  intervals(0, 1, 3, 5, 7, 9, 11)),
+    makeScale("Persian",           intervals(0, 1, 4, 5, 6, 8, 11)),
+    makeScale("Enigmatic",         intervals(0, 1, 4, 6, 8, 10, 11)),
+    makeScale("Whole Tone",        intervals(0, 2, 4, 6, 8, 10)),
+    makeScale("Augmented",         intervals(0, 3, 4, 7, 8, 11)),
+    makeScale("Prometheus",        intervals(0, 2, 4, 6, 9, 10)),
+    makeScale("Hirajoshi",         intervals(0, 2, 3, 7, 8)),
+    makeScale("In Sen",            intervals(0, 1, 5, 7, 10)),
+    makeScale("Iwato",             intervals(0, 1, 5, 6, 10)),
+    makeScale("Yo",                intervals(0, 2, 5, 7, 9)),
+    makeScale("Egyptian",          intervals(0, 2, 5, 7, 10)),
+    makeScale("Pelog",             intervals(0, 1, 3, 7, 8)),
 };
 
-static_assert(sizeof(minorScaleOffsets) / sizeof(majorScaleOffsets[0]) == NUM_COLORS,
-              "majorScaleOffsets must have NUM_COLORS entries");
+#define BUILTIN_SCALE_COUNT (sizeof(builtinScales) / sizeof(builtinScales[0]))
+
+// Every row must contain its root, or the degrees have nothing to count from
+static constexpr bool scalesRooted(uint8_t i) {
+    return i >= BUILTIN_SCALE_COUNT || ((builtinScales[i].mask & 1) && scalesRooted(i + 1));
+}
+static_assert(scalesRooted(0), "every built-in scale includes its root (bit 0)");
+static_assert(builtinScales[ScaleManager::MAJOR].offsets[2] == 4 && builtinScales[ScaleManager::MINOR].offsets[2] == 3,
+              "MAJOR and MINOR keep their rows");
+static_assert(BUILTIN_SCALE_COUNT + USER_SCALE_COUNT < NOTE_SETTING_STORED,
+              "a scale index is stored in 7 bits");
+
+const uint8_t ScaleManager::NUM_BUILTIN_SCALES = BUILTIN_SCALE_COUNT;
+const uint8_t ScaleManager::NUM_SCALES = BUILTIN_SCALE_COUNT + USER_SCALE_COUNT;
+
+static const char* const userScaleNames[] = {"User 1", "User 2", "User 3", "User 4", "User 5", "User 6", "User 7", "User 8"};
+static_assert(USER_SCALE_COUNT <= sizeof(userScaleNames) / sizeof(userScaleNames[0]), "name every user scale");
+
+static uint16_t userScaleMasks[USER_SCALE_COUNT];
+static uint8_t userScaleOffsets[USER_SCALE_COUNT][NUM_COLORS];
 
 ScaleManager::ScaleManager(ScaleType initialScale, uint8_t initialOctave, uint8_t initialRootNote)
     : currentScale(initialScale), 
@@ -110,16 +199,54 @@ uint8_t ScaleManager::getRootNote() const {
 }
 
 const char* ScaleManager::getScaleName() const {
-    switch (currentScale) {
-        case MAJOR:
-            return "Major";
-        case MINOR:
-            return "Minor";
-        default:
-            return "Unknown";
+    return scaleName(currentScale);
+}
+
+const char* ScaleManager::scaleName(uint8_t scale) {
+    if (scale < BUILTIN_SCALE_COUNT) {
+        return builtinScales[scale].name;
+    }
+    if (scale < NUM_SCALES) {
+        return userScaleNames[scale - BUILTIN_SCALE_COUNT];
+    }
+    return "Unknown";
+}
+
+void ScaleManager::setUserScale(uint8_t slot, uint16_t mask) {
+    if (slot >= USER_SCALE_COUNT) {
+        return;
+    }
+    mask = (mask & 0x0FFF) | 1; // the root is always in
+    userScaleMasks[slot] = mask;
+    for (uint8_t i = 0; i < NUM_COLORS; i++) {
+        userScaleOffsets[slot][i] = colorOffset(mask, i);
     }
 }
 
+uint16_t ScaleManager::userScaleMask(uint8_t slot) {
+    return (slot < USER_SCALE_COUNT) ? userScaleMasks[slot] : 0;
+}
+
+void ScaleManager::loadUserScales() {
+    for (uint8_t slot = 0; slot < USER_SCALE_COUNT; slot++) {
+        uint16_t mask;
+        EEPROM.get(USER_SCALE_ADDR(slot), mask);
+        // Blank EEPROM reads 0x0000 or 0xFFFF, neither of which is a valid mask
+        if (!(mask & 1) || mask > 0x0FFF) {
+            mask = builtinScales[MAJOR].mask;
+        }
+        setUserScale(slot, mask);
+    }
+}
+
+void ScaleManager::saveUserScale(uint8_t slot) {
+    if (slot >= USER_SCALE_COUNT) {
+        return;
+    }
+    EEPROM.put(USER_SCALE_ADDR(slot), userScaleMasks[slot]);
+    EEPROM.commit();
+}
+
 bool ScaleManager::isNoteOffColor(Color color) const {
     return color == Color::WHITE;
 }
@@ -131,12 +258,56 @@ uint8_t ScaleManager::getScaleOffset(int colorIndex) {
         return 0; // Default to root note
     }
     
-    switch (currentScale) {
-        case MAJOR:
-            return majorScaleOffsets[colorIndex];
-        case MINOR:
-            return minorScaleOffsets[colorIndex];
-        default:
-            return 0;
-    }
-}
\ No newline at end of file
+    return scaleOffsets(currentScale)[colorIndex];
+}
+
+uint16_t ScaleManager::scaleMask(uint8_t scale) {
+    if (scale < BUILTIN_SCALE_COUNT) {
+        return builtinScales[scale].mask;
+    }
+    if (scale < NUM_SCALES) {
+        return userScaleMasks[scale - BUILTIN_SCALE_COUNT];
+    }
+    return builtinScales[MAJOR].mask;
+}
+
+const uint8_t* ScaleManager::scaleOffsets(ScaleType scale) {
+    if (scale < BUILTIN_SCALE_COUNT) {
+        return builtinScales[scale].offsets;
+    }
+    if (scale < NUM_SCALES) {
+        return userScaleOffsets[scale - BUILTIN_SCALE_COUNT];
+    }
+    return builtinScales[MAJOR].offsets;
+}
+void ScaleManager::buildNoteTable(ScaleType scale, uint8_t rootNote, uint8_t octave, uint8_t table[NUM_COLORS]) {
+    const uint8_t* offsets = scaleOffsets(scale);
+    int shift = (int(octave) - 4) * 12;
+    for (uint8_t i = 0; i < NUM_COLORS; i++) {
+        if (offsets[i] == MIDI_NOTE_OFF) {
+            table[i] = MIDI_NOTE_OFF;
+            continue;
+        }
+        int note = rootNote + offsets[i] + shift;
+        table[i] = (uint8_t)constrain(note, 0, 127);
+    }
+}
+void ScaleManager::buildChordTable(ScaleType scale, uint8_t rootNote, uint8_t octave,
+                                   uint8_t table[][VOICING_MAX_NOTES]) {
+    uint16_t mask = scaleMask(scale);
+    int shift = (int(octave) - 4) * 12;
+    for (uint8_t i = 0; i < NUM_COLORS; i++) {
+        for (uint8_t v = 0; v < VOICING_MAX_NOTES; v++) {
+            if (colorOffset(mask, i) == MIDI_NOTE_OFF) {
+                table[i][v] = MIDI_NOTE_OFF;
+                continue;
+            }
+            int note = rootNote + degreeOffset(mask, i + 2 * v) + shift;
+            if (v == 0) {
+                table[i][v] = (uint8_t)constrain(note, 0, 127); // as in buildNoteTable
+            } else {
+                table[i][v] = (note >= 0 && note <= 127) ? note : MIDI_NOTE_OFF;
+            }
+        }
+    }
+}
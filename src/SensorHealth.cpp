@@ -0,0 +1,122 @@
+#include "SensorHealth.h"
+
+// Polls of one step that may come back PENDING before the probe gives up
+// (WARMING_UP normally needs one integration period, a few polls at most)
+#define PROBE_MAX_PENDING 20
+
+bool SensorHealth::reportRead(uint8_t sensor, bool ok, uint16_t repeats) {
+    if (sensor >= NUM_SENSORS || state[sensor].status != SensorStatus::ONLINE) {
+        return false;
+    }
+    State& st = state[sensor];
+    if (ok) {
+        st.consecutiveErrors = 0;
+        busErrorRun = 0;
+        return repeats >= SENSOR_STUCK_READS;
+    }
+    st.errors++;
+    if (st.consecutiveErrors < 255) st.consecutiveErrors++;
+    if (busErrorRun < 255) busErrorRun++;
+    return st.consecutiveErrors >= SENSOR_MAX_CONSECUTIVE_ERRORS;
+}
+
+void SensorHealth::takeOffline(uint8_t sensor, unsigned long now) {
+    if (sensor >= NUM_SENSORS) return;
+    State& st = state[sensor];
+    st.status = SensorStatus::OFFLINE;
+    st.drops++;
+    st.consecutiveErrors = 0;
+    st.pendingSteps = 0;
+    st.probeInterval = SENSOR_REPROBE_INTERVAL_MS;
+    st.nextProbe = now + st.probeInterval;
+}
+
+bool SensorHealth::nextProbe(unsigned long now, uint8_t& sensor) {
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        uint8_t s = (probeCursor + i) % NUM_SENSORS;
+        const State& st = state[s];
+        if (st.status != SensorStatus::ONLINE && (long)(now - st.nextProbe) >= 0) {
+            probeCursor = (s + 1) % NUM_SENSORS;
+            sensor = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SensorHealth::reportProbe(uint8_t sensor, unsigned long now, ProbeResult result) {
+    if (sensor >= NUM_SENSORS || state[sensor].status == SensorStatus::ONLINE) {
+        return false;
+    }
+    State& st = state[sensor];
+
+    if (result == ProbeResult::PENDING && ++st.pendingSteps > PROBE_MAX_PENDING) {
+        result = ProbeResult::FAILED;
+    }
+
+    switch (result) {
+        case ProbeResult::FAILED:
+            st.errors++;
+            st.status = SensorStatus::OFFLINE;
+            st.pendingSteps = 0;
+            st.nextProbe = now + st.probeInterval;
+            st.probeInterval = min(st.probeInterval * 2, SENSOR_REPROBE_MAX_INTERVAL_MS);
+            return false;
+
+        case ProbeResult::PENDING:
+            st.nextProbe = now + SENSOR_POWER_ON_MS;
+            return false;
+
+        case ProbeResult::PASSED:
+            st.pendingSteps = 0;
+            if (st.status == SensorStatus::OFFLINE) {
+                st.status = SensorStatus::POWERING_UP;
+                st.nextProbe = now + SENSOR_POWER_ON_MS;
+                return false;
+            }
+            if (st.status == SensorStatus::POWERING_UP) {
+                st.status = SensorStatus::WARMING_UP;
+                st.nextProbe = now + SENSOR_INTEGRATION_MS;
+                return false;
+            }
+            st.status = SensorStatus::ONLINE;
+            st.probeInterval = SENSOR_REPROBE_INTERVAL_MS;
+            return true;
+    }
+    return false;
+}
+
+bool SensorHealth::busSuspect() const {
+    return busErrorRun >= I2C_BUS_ERROR_LIMIT;
+}
+
+void SensorHealth::busCleared() {
+    busErrorRun = 0;
+    numBusClears++;
+}
+
+SensorStatus SensorHealth::status(uint8_t sensor) const {
+    return (sensor < NUM_SENSORS) ? state[sensor].status : SensorStatus::OFFLINE;
+}
+
+uint32_t SensorHealth::errorCount(uint8_t sensor) const {
+    return (sensor < NUM_SENSORS) ? state[sensor].errors : 0;
+}
+
+uint16_t SensorHealth::dropCount(uint8_t sensor) const {
+    return (sensor < NUM_SENSORS) ? state[sensor].drops : 0;
+}
+
+uint16_t SensorHealth::busClears() const {
+    return numBusClears;
+}
+
+const char* sensorStatusName(SensorStatus status) {
+    switch (status) {
+        case SensorStatus::ONLINE: return "online";
+        case SensorStatus::OFFLINE: return "offline";
+        case SensorStatus::POWERING_UP: return "powering up";
+        case SensorStatus::WARMING_UP: return "warming up";
+        default: return "?";
+    }
+}
@@ -0,0 +1,101 @@
+#include "SensorScanner.h"
+
+void SensorScanner::setActive(uint8_t sensor, bool active) {
+    if (sensor >= NUM_SENSORS || state[sensor].active == active) {
+        return;
+    }
+    state[sensor].active = active;
+    // Sensor order is also topology order, so ties stay on the same mux
+    numActive = 0;
+    for (uint8_t s = 0; s < NUM_SENSORS; s++) {
+        if (state[s].active) {
+            order[numActive++] = s;
+        }
+    }
+}
+
+bool SensorScanner::isActive(uint8_t sensor) const {
+    return sensor < NUM_SENSORS && state[sensor].active;
+}
+
+uint8_t SensorScanner::activeCount() const {
+    return numActive;
+}
+
+float SensorScanner::attention(const SensorState& s, unsigned long now) const {
+    // Recent color change, fading out linearly over the hold time
+    unsigned long sinceChange = now - s.lastChange;
+    float recent = (sinceChange < SCAN_ATTENTION_HOLD_MS)
+                       ? 1.0f - (float)sinceChange / SCAN_ATTENTION_HOLD_MS
+                       : 0.0f;
+    // Reading near a boundary: the next one may well flip
+    float boundary = (s.margin < SCAN_ATTENTION_MARGIN)
+                         ? 1.0f - s.margin / SCAN_ATTENTION_MARGIN
+                         : 0.0f;
+    return max(recent, boundary);
+}
+
+bool SensorScanner::next(unsigned long now, uint8_t& sensor) {
+    int best = -1;
+    float bestScore = 0;
+    for (uint8_t i = 0; i < numActive; i++) {
+        uint8_t s = order[i];
+        const SensorState& st = state[s];
+        unsigned long age = now - st.lastRead;
+        if (age < SENSOR_INTEGRATION_MS) {
+            continue; // would just read the same conversion again
+        }
+        float score;
+        if (age >= SCAN_MAX_INTERVAL_MS) {
+            // Starving: ahead of everything, oldest first
+            score = 1000.0f + age;
+        } else {
+            float target = SCAN_IDLE_INTERVAL_MS -
+                           (SCAN_IDLE_INTERVAL_MS - SENSOR_INTEGRATION_MS) * attention(st, now);
+            score = age / target;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = s;
+        }
+    }
+    if (best == -1) {
+        return false;
+    }
+
+    SensorState& st = state[best];
+    unsigned long age = now - st.lastRead;
+    if (age >= SCAN_MAX_INTERVAL_MS && st.lastRead != 0) {
+        numForced++;
+    }
+    if (st.lastRead != 0) {
+        st.avgInterval += 0.1f * ((float)age - st.avgInterval);
+    }
+    st.lastRead = now;
+    sensor = best;
+    return true;
+}
+
+void SensorScanner::report(uint8_t sensor, unsigned long now, bool changed, float margin) {
+    if (sensor >= NUM_SENSORS) return;
+    if (changed) {
+        state[sensor].lastChange = now;
+    }
+    state[sensor].margin = margin;
+}
+
+float SensorScanner::averageIntervalMs(uint8_t sensor) const {
+    return (sensor < NUM_SENSORS) ? state[sensor].avgInterval : 0;
+}
+
+uint32_t SensorScanner::forcedReads() const {
+    return numForced;
+}
+
+float estimateSampleRateHz(uint8_t numSensors, float perSensorUs) {
+    if (numSensors == 0) {
+        return 0;
+    }
+    float sweepMs = max((float)SENSOR_INTEGRATION_MS, numSensors * perSensorUs / 1000.0f);
+    return 1000.0f / sweepMs;
+}
@@ -0,0 +1,60 @@
+#include "SensorTopology.h"
+#include <Wire.h>
+
+// Eight sensors per mux, filled in mux order. Sensors 0-3 keep their original
+// channels on the first mux.
+#define MUX_CHANNELS(addr) \
+    {addr, 0}, {addr, 1}, {addr, 2}, {addr, 3}, {addr, 4}, {addr, 5}, {addr, 6}, {addr, 7}
+
+const SensorLocation sensorTopology[MAX_SENSORS] = {
+    MUX_CHANNELS(TCA_BASE_ADDR + 0),
+    MUX_CHANNELS(TCA_BASE_ADDR + 1),
+    MUX_CHANNELS(TCA_BASE_ADDR + 2),
+    MUX_CHANNELS(TCA_BASE_ADDR + 3),
+    MUX_CHANNELS(TCA_BASE_ADDR + 4),
+    MUX_CHANNELS(TCA_BASE_ADDR + 5),
+    MUX_CHANNELS(TCA_BASE_ADDR + 6),
+    MUX_CHANNELS(TCA_BASE_ADDR + 7),
+};
+
+// Mux with an open channel (0 = none) and the channel mask written to it
+static uint8_t openMux = 0;
+static uint8_t openChannelMask = 0;
+
+static void writeMux(uint8_t address, uint8_t channelMask) {
+    Wire.beginTransmission(address);
+    Wire.write(channelMask);
+    Wire.endTransmission();
+}
+
+void selectSensor(uint8_t sensor) {
+    if (sensor >= NUM_SENSORS) return;
+    const SensorLocation& location = sensorTopology[sensor];
+    uint8_t channelMask = 1 << location.muxChannel;
+    if (openMux == location.muxAddress && openChannelMask == channelMask) {
+        return;
+    }
+    if (openMux != 0 && openMux != location.muxAddress) {
+        writeMux(openMux, 0);
+    }
+    writeMux(location.muxAddress, channelMask);
+    openMux = location.muxAddress;
+    openChannelMask = channelMask;
+}
+
+void deselectSensors() {
+    if (openMux != 0) {
+        writeMux(openMux, 0);
+    }
+    openMux = 0;
+    openChannelMask = 0;
+}
+
+void deselectAllMuxes() {
+    // Muxes that aren't fitted just NAK
+    for (uint8_t i = 0; i < TCA_MAX_MUXES; i++) {
+        writeMux(TCA_BASE_ADDR + i, 0);
+    }
+    openMux = 0;
+    openChannelMask = 0;
+}
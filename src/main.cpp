@@ -37,16 +37,32 @@ TODO:
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SH110X.h>
+#include "SH1106Display.h"
 #include "MenuManager.h"
 #include "PinDefinitions.h"
 #include "ColorHelper.h"
 #include "ColorEnum.h"
-#include <MIDI.h>
 #include "SystemConfig.h"
 #include <ESP32Encoder.h>
 #include <EEPROM.h>
 #include "EEPROMAddresses.h"
 #include "ColorInfo.h"
+#include "CalibrationQueue.h"
+#include "AutoCalibrator.h"
+#include "SensorTopology.h"
+#include "SensorScanner.h"
+#include "SensorHealth.h"
+#include "I2CBus.h"
+#include "NoteBurst.h"
+#include "MidiEncoder.h"
+#include "MidiTxQueue.h"
+#include "ActiveNotes.h"
+#include "MidiClock.h"
+#include "DiskTempo.h"
+#include "ColorCcStream.h"
+#include "MidiInput.h"
+#include "MidiRecorder.h"
+#include "NoteOutput.h"
 
 //checks
 // static_assert(sizeof(ColorHelper) == 124, "ColorHelper struct size must be 124 bytes for EEPROM layout!");
@@ -57,7 +73,33 @@ TODO:
 
 // MIDI setup
 HardwareSerial MIDIserial(1);
-MIDI_CREATE_INSTANCE(HardwareSerial, MIDIserial, MIDI);
+// Running status and note-off as velocity 0 (see MidiEncoder.h); only the
+// transmit task writes through it
+MidiEncoder midiOut(MIDIserial);
+// Everything else queues here and never waits for the UART
+MidiTxQueue midiTx(MIDIserial, midiOut);
+// Every note switched on and not yet off, per channel
+ActiveNotes activeNotes;
+// Clock, transport and remote control from the MIDI input
+MidiInput midiIn(MIDIserial);
+// MIDI clock out, ticked by a hardware timer (see MidiClock.h)
+MidiClock midiClock(midiTx);
+#if MIDI_RECORDER
+// The latest part of what went out, for saving as a MIDI file (see MidiRecorder.h)
+MidiRecorder midiRecorder;
+#endif
+// Revolution time of the disk, from the color changes it produces
+DiskTempo diskTempo;
+
+// Note changes of the current scan cycle, sent together (see NoteBurst.h)
+NoteBurst noteBurst;
+// All note output, so activeNotes always matches the wire (see NoteOutput.h)
+NoteOutput noteOutput(midiTx, activeNotes, noteBurst);
+// One note, a chord or an arpeggio per color (see Voicing.h)
+VoicingMode voicingMode = static_cast<VoicingMode>(VOICING_MODE);
+
+// Hue, saturation and brightness of every sensor as CCs (see ColorCcStream.h)
+ColorCcStream colorCc;
 
 // Button debouncing helper
 struct ButtonHelper {
@@ -98,18 +140,30 @@ struct ButtonHelper {
   }
 };
 
-// Display setup - SH1106 OLED
-Adafruit_SH1106G display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// Display setup - SH1106 OLED, sending only what changed (see SH1106Display.h)
+SH1106Display display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 MenuManager menu(display);
 
-// Color sensor setup
-ColorHelper colorHelperA(true, &menu); // Enable normalization
-ColorHelper colorHelperB(true, &menu);
-ColorHelper colorHelperC(true, &menu);
-ColorHelper colorHelperD(true, &menu);
-
-ColorHelper* colorHelpers[4]{&colorHelperA, &colorHelperB, &colorHelperC, &colorHelperD};
+// Color sensor setup, indexed by sensor number (== mux channel)
+ColorHelper colorHelpers[NUM_SENSORS]; // normalization on, menu attached in setup()
 ColorHelper* activeColorSensor = nullptr;
+// Recent readings of every sensor, filled by colorHelpers[i] (RAM: see SystemConfig.h)
+SampleRing sampleHistory[NUM_SENSORS];
+
+// Sensors that answered at startup, in the order the loop reads them
+SensorScanner scanner;
+// I2C error counts and background re-probe for sensors that drop out
+SensorHealth sensorHealth;
+
+// Rotation auto-calibration sample buffers, one per sensor of a recording batch
+const int autoCalBatchSize = (NUM_SENSORS < AUTO_CAL_BATCH_SENSORS) ? NUM_SENSORS : AUTO_CAL_BATCH_SENSORS;
+AutoCalibrator autoCalibrators[autoCalBatchSize];
+
+// Power-on defaults for the per-sensor menu values, used when EEPROM is blank.
+// Sensors past the original four get channels in order and no octave shift.
+const uint8_t defaultMIDIChannels[] = {3, 6, 7, 12};
+const uint8_t defaultOctaves[] = {1, 3, 4, 6};
+const int numSensorDefaults = sizeof(defaultMIDIChannels);
 
 // extern SensorCalibration sensorCalibrations[4];
 
@@ -126,18 +180,6 @@ ButtonHelper conBtn(CON_BTN);
 ButtonHelper bakBtn(BAK_BTN);
 ButtonHelper panicBtn(PANIC_BTN);
 
-// Script States
-Color currentColorA = Color::UNKNOWN;
-Color currentColorB = Color::UNKNOWN;
-Color currentColorC = Color::UNKNOWN;
-Color currentColorD = Color::UNKNOWN;
-
-byte oldMidiNote = 0;
-byte lastNoteA = 0;
-byte lastNoteB = 0;
-byte lastNoteC = 0;
-byte lastNoteD = 0;
-
 // Interrupt flags
 bool encoderButtonFlag = false;
 bool conButtonFlag = false;
@@ -158,44 +200,129 @@ void IRAM_ATTR backButtonISR() {
   backButtonFlag = true;
 }
 
-void saveBCD();
+void runCalibrationJob(const CalibrationJob& job);
+void runAutoRotationCalibration(SensorMask sensorMask);
+void recordRotationBatch(const uint8_t sensors[], uint8_t count);
+void takeSensorOffline(uint8_t sensor, unsigned long now);
+void serviceSensorHealth(unsigned long now);
 
-// TCA9548A I2C Multiplexer functions
-void tcaSelect(uint8_t channel) {
-  if (channel > 7) return;
-  Wire.beginTransmission(TCA_ADDR);
-  Wire.write(1 << channel);
-  Wire.endTransmission();
+//helper functions
+// MIDI Thru: received messages merged into the output (receive callback)
+void forwardMidi(const MidiInMessage& msg) {
+  midiTx.forward(msg.status, msg.data1, msg.data2);
 }
 
-// Optional: disable all channels
-void tcaDisableAll() {
-  Wire.beginTransmission(TCA_ADDR);
-  Wire.write(0); // no bits set
-  Wire.endTransmission();
+bool sendColorCc(uint8_t control, uint16_t value, bool wide, uint8_t channel) {
+  if (wide) {
+    return midiTx.controlChange14(control, value, channel);
+  }
+  return midiTx.controlChange(control, value >> 7, channel);
 }
 
-//helper functions
 void midiPanic(){
-  // Send All Notes Off message on all channels
-  for (uint8_t channel = 1; channel <= 16; channel++) {
-    MIDI.sendControlChange(123, 0, channel); // 123 = All Notes Off
+  uint16_t released = noteOutput.panic(menu.sensorChannels, NUM_SENSORS);
+  Serial.print("Panic released ");
+  Serial.print(released);
+  Serial.println(" notes");
+}
+
+// Menu callback: a setting that decides this sensor's note (channel, octave,
+// scale, root) is about to change. Release its note now; the next reading
+// starts it again with the new setting.
+void releaseSensorNotes(int sensor) {
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    if (sensor >= 0 && i != sensor) continue;
+    noteOutput.releaseSensor(menu.sensorChannels[i]);
+    colorCc.resend(i); // the channel may be new too
+  }
+}
+
+void takeSensorOffline(uint8_t sensor, unsigned long now) {
+  bool stuck = colorHelpers[sensor].rawRepeats >= SENSOR_STUCK_READS;
+  SensorChannel& channel = menu.sensorChannels[sensor];
+  noteOutput.releaseSensor(channel); // don't leave it hanging
+  channel.online = false;
+  colorCc.resend(sensor); // full set of controllers once it's back
+  scanner.setActive(sensor, false);
+  colorHelpers[sensor].setAvailable(false);
+  sensorHealth.takeOffline(sensor, now);
+
+  Serial.print("Sensor ");
+  Serial.print(sensorLetter(sensor));
+  Serial.print(" offline (");
+  Serial.print(stuck ? "stuck" : "I2C errors");
+  Serial.print(", ");
+  Serial.print(sensorHealth.errorCount(sensor));
+  Serial.print(" errors, ");
+  Serial.print(sensorHealth.dropCount(sensor));
+  Serial.println(" drops)");
+}
+
+void serviceSensorHealth(unsigned long now) {
+  // Reads failing on sensor after sensor point at the bus, not the heads
+  if (sensorHealth.busSuspect()) {
+    bool held = i2cBusHeld();
+    bool released = clearI2CBus();
+    deselectAllMuxes(); // a mux may have latched a garbage channel mask
+    sensorHealth.busCleared();
+    Serial.print("I2C bus cleared (");
+    Serial.print(held ? "was held low" : "lines were high");
+    Serial.print(released ? ", released" : ", STILL HELD");
+    Serial.print("), total ");
+    Serial.println(sensorHealth.busClears());
+  }
+
+  uint8_t sensor;
+  if (!sensorHealth.nextProbe(now, sensor)) {
+    return;
+  }
+  selectSensor(sensor);
+  ColorHelper& helper = colorHelpers[sensor];
+  ProbeResult result;
+  switch (sensorHealth.status(sensor)) {
+    case SensorStatus::OFFLINE:     result = helper.probe(); break;
+    case SensorStatus::POWERING_UP: result = helper.enableConversions(); break;
+    default:                        result = helper.conversionReady(); break;
+  }
+  if (sensorHealth.reportProbe(sensor, now, result)) {
+    helper.setAvailable(true);
+    scanner.setActive(sensor, true);
+    menu.sensorChannels[sensor].online = true;
+    Serial.print("Sensor ");
+    Serial.print(sensorLetter(sensor));
+    Serial.println(" back online");
   }
 }
 
-void sendAllNotesOff(uint8_t channel) {
-  // Send All Notes Off message to specific channel
-  MIDI.sendControlChange(123, 0, channel); // 123 = All Notes Off
-  Serial.print("Sent ALL NOTES OFF to channel ");
-  Serial.println(channel);
+// A setting change from MIDI remote control goes through the same menu
+// functions as the knobs, so the notes it affects are released the same way
+void applyRemoteCommand(const RemoteCommand& command) {
+  switch (command.target) {
+    case REMOTE_SCALE:   menu.selectScale(command.value); break;
+    case REMOTE_ROOT:    menu.selectRootNote(command.value); break;
+    case REMOTE_OCTAVE:  menu.setSensorOctave(command.sensor, command.value); break;
+    case REMOTE_CHANNEL: menu.setSensorChannel(command.sensor, command.value); break;
+    case REMOTE_SENSOR_SCALE: menu.setSensorScale(command.sensor, command.value); break;
+    case REMOTE_SENSOR_ROOT:  menu.setSensorRoot(command.sensor, command.value); break;
+  }
+  static const char* const targetNames[] = {"scale", "root", "octave", "channel", "scale", "root"};
+  Serial.print("MIDI remote: ");
+  Serial.print(targetNames[command.target]);
+  if (command.target >= REMOTE_OCTAVE) {
+    Serial.print(" of ");
+    Serial.print(sensorLetter(command.sensor));
+  }
+  Serial.print(" = ");
+  Serial.println(command.value);
 }
 
 void resetOLED() {
   Serial.println("Starting OLED reset...");
+  display.invalidate();        // Resend every page, whatever the panel holds
   display.clearDisplay();      // Clear the display buffer
   display.display();           // Send clear buffer to display
   delay(50);                   // Minimal delay
-  menu.render();               // Redraw the UI
+  menu.requestRender();        // Redraw the UI
   Serial.println("OLED reset complete");
 }
 
@@ -213,16 +340,33 @@ Serial.println(sizeof(ColorHelper));
 
   Serial.println("Setting up MIDI...");
   MIDIserial.begin(MIDI_BAUD_RATE, SERIAL_8N1, MIDI_IN_PIN, MIDI_OUT_PIN);
+  midiTx.begin();
+  midiTx.setGate(GATE_TIME_MS, GATE_REPEATS, GATE_RATCHET_MS);
+  if (voicingMode == VOICING_ARPEGGIO) {
+    midiTx.setArpeggio(VOICING_ARP_STEP_MS);
+  }
+#if MIDI_RECORDER
+  midiOut.setRecorder(&midiRecorder);
+  Serial.print("MIDI recorder: ");
+  Serial.print(MidiRecorder::budgetBytes());
+  Serial.println(" bytes ('d' dumps it, 'c' clears it)");
+#endif
+  midiIn.begin();
+#if MIDI_THRU
+  midiIn.setThru(forwardMidi);
+#endif
   
   // Initialize I2C for OLED display
   Serial.println("Initializing I2C for display...");
-  Wire.begin(OLED_SDA, OLED_SCL);
+  beginI2CBus(); // every transaction bounded by I2C_TIMEOUT_MS
   Serial.println("I2C initialized");
 
-  EEPROM.begin(1024); // Initialize EEPROM with 1KB size
+  EEPROM.begin(EEPROM_SIZE); // sized for NUM_SENSORS calibration records
+  Serial.print("EEPROM bytes: ");
+  Serial.println(EEPROM_SIZE);
   //DEBUG: immediately check midi channel
   byte check;
-  EEPROM.get(ACTIVE_MIDI_CHANNEL_A_ADDR, check);
+  EEPROM.get(ACTIVE_MIDI_CHANNEL_ADDR(0), check);
   Serial.print("Read back from EEPROM for A at startup, immediately after begin(): ");
   Serial.println(check);
 
@@ -291,7 +435,8 @@ Serial.println(sizeof(ColorHelper));
   
   //load from EEPROM or initialize if not available
   byte storedMagicValue = EEPROM.read(EEPROM_MAGIC_ADDRESS);
-  bool calibrationValid = storedMagicValue==EEPROM_MAGIC_VALUE;
+  bool calibrationValid = storedMagicValue==EEPROM_MAGIC_VALUE &&
+                          EEPROM.read(EEPROM_SENSOR_COUNT_ADDR) == NUM_SENSORS;
   Serial.print("Stored magic value was: ");
   Serial.print(storedMagicValue);
   Serial.print(" set magic val: ");
@@ -303,242 +448,59 @@ Serial.println(sizeof(ColorHelper));
   else{Serial.println("Stored values not found!");
   }
 
-  for (int i = 0; i < 4; i++) {
-    colorHelpers[i]->setColorDatabase(colorCalibrationDefaultDatabase, NUM_COLORS);
-    tcaSelect(i);
+  deselectAllMuxes(); // muxes keep their channel across an ESP32 reset
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    colorHelpers[i].setMenu(&menu);
+    colorHelpers[i].setHistory(&sampleHistory[i]);
+    colorHelpers[i].SensorNum = i; // selects this sensor's EEPROM block when calibrating
+    colorHelpers[i].setColorDatabase(colorCalibrationDefaultDatabase, NUM_COLORS);
+    selectSensor(i);
     delay(50);
-    // Always begin the sensor
-    colorHelpers[i]->begin();
+    // Always begin the sensor; only the ones that answer get scanned
+    bool found = colorHelpers[i].begin();
+    scanner.setActive(i, found);
+    if (!found) {
+      // Re-probed in the background, so a head plugged in later still joins
+      sensorHealth.takeOffline(i, millis());
+      menu.sensorChannels[i].online = false;
+    }
     Serial.print("Sensor # ");
     Serial.print(i);
     Serial.println(" begun");
     }
+  Serial.print("Scanning ");
+  Serial.print(scanner.activeCount());
+  Serial.print(" of ");
+  Serial.print(NUM_SENSORS);
+  Serial.print(" sensors, est. ");
+  Serial.print(estimateSampleRateHz(scanner.activeCount(), SENSOR_READ_ESTIMATE_US));
+  Serial.println(" Hz each");
+    // Before any scale is selected: a ring may be on a user scale
+    ScaleManager::loadUserScales();
+
     //if we have valid calibrations, we overwrite the default values with the stored ones. 
     if(calibrationValid){
       
-      //// setup A
-      //dark
-      EEPROM.get(SENSOR_A_RDARK_ADDR, colorHelperA.rDark);
-      EEPROM.get(SENSOR_A_GDARK_ADDR, colorHelperA.gDark);
-      EEPROM.get(SENSOR_A_BDARK_ADDR, colorHelperA.bDark);
-      //gains
-      EEPROM.get(SENSOR_A_RW_ADDR, colorHelperA.rW);
-      EEPROM.get(SENSOR_A_GW_ADDR, colorHelperA.gW);
-      EEPROM.get(SENSOR_A_BW_ADDR, colorHelperA.bW);
-      //recalculate gains
-      float avgW = (colorHelperA.rW + colorHelperA.gW + colorHelperA.bW) / 3.0f;
-      colorHelperA.rGain = avgW / (float)colorHelperA.rW;
-      colorHelperA.gGain = avgW / (float)colorHelperA.gW;
-      colorHelperA.bGain = avgW / (float)colorHelperA.bW;
-      
-      //new calibration database
-      ColorCalibration calibrationDatabaseA[NUM_COLORS];
-
-//       enum class Color : uint8_t {
-//     RED = 0,
-//     GREEN = 1,
-//     PURPLE = 2,
-//     BLUE = 3,
-//     ORANGE = 4,
-//     YELLOW = 5,
-//     SILVER = 6,
-//     WHITE = 7,      // Special color - ignore this
-//     UNKNOWN = 255   // Special value for unrecognized colors
-// };
-
-      EEPROM.get(SENSOR_A_RED_CAL_ADDR,calibrationDatabaseA[0]);
-      EEPROM.get(SENSOR_A_GREEN_CAL_ADDR, calibrationDatabaseA[1]);
-      EEPROM.get(SENSOR_A_PURPLE_CAL_ADDR, calibrationDatabaseA[2]);
-      EEPROM.get(SENSOR_A_BLUE_CAL_ADDR, calibrationDatabaseA[3]);
-      EEPROM.get(SENSOR_A_ORANGE_CAL_ADDR, calibrationDatabaseA[4]);
-      EEPROM.get(SENSOR_A_YELLOW_CAL_ADDR, calibrationDatabaseA[5]);
-      EEPROM.get(SENSOR_A_SILVER_CAL_ADDR, calibrationDatabaseA[6]);
-      EEPROM.get(SENSOR_A_WHITE_CAL_ADDR, calibrationDatabaseA[7]);
-      
-      colorHelperA.setColorDatabase(calibrationDatabaseA, NUM_COLORS);
-
-      //// setup B
-      //dark
-      EEPROM.get(SENSOR_B_RDARK_ADDR, colorHelperB.rDark);
-      EEPROM.get(SENSOR_B_GDARK_ADDR, colorHelperB.gDark);
-      EEPROM.get(SENSOR_B_BDARK_ADDR, colorHelperB.bDark);
-      //gains
-      EEPROM.get(SENSOR_B_RW_ADDR, colorHelperB.rW);
-      EEPROM.get(SENSOR_B_GW_ADDR, colorHelperB.gW);
-      EEPROM.get(SENSOR_B_BW_ADDR, colorHelperB.bW);
-      //recalculate gains
-      avgW = (colorHelperB.rW + colorHelperB.gW + colorHelperB.bW) / 3.0f;
-      colorHelperB.rGain = avgW / (float)colorHelperB.rW;
-      colorHelperB.gGain = avgW / (float)colorHelperB.gW;
-      colorHelperB.bGain = avgW / (float)colorHelperB.bW;
-      //new calibration database
-      ColorCalibration calibrationDatabaseB[NUM_COLORS];
-      EEPROM.get(SENSOR_B_RED_CAL_ADDR,calibrationDatabaseB[0]);
-      EEPROM.get(SENSOR_B_GREEN_CAL_ADDR, calibrationDatabaseB[1]);
-      EEPROM.get(SENSOR_B_PURPLE_CAL_ADDR, calibrationDatabaseB[2]);
-      EEPROM.get(SENSOR_B_BLUE_CAL_ADDR, calibrationDatabaseB[3]);
-      EEPROM.get(SENSOR_B_ORANGE_CAL_ADDR, calibrationDatabaseB[4]);
-      EEPROM.get(SENSOR_B_YELLOW_CAL_ADDR, calibrationDatabaseB[5]);
-      EEPROM.get(SENSOR_B_SILVER_CAL_ADDR, calibrationDatabaseB[6]);
-      EEPROM.get(SENSOR_B_WHITE_CAL_ADDR, calibrationDatabaseB[7]);
-
-      colorHelperB.setColorDatabase(calibrationDatabaseB, NUM_COLORS);
-
-      //// setup C
-      //dark
-      EEPROM.get(SENSOR_C_RDARK_ADDR, colorHelperC.rDark);
-      EEPROM.get(SENSOR_C_GDARK_ADDR, colorHelperC.gDark);
-      EEPROM.get(SENSOR_C_BDARK_ADDR, colorHelperC.bDark);
-      //gains
-      EEPROM.get(SENSOR_C_RW_ADDR, colorHelperC.rW);
-      EEPROM.get(SENSOR_C_GW_ADDR, colorHelperC.gW);
-      EEPROM.get(SENSOR_C_BW_ADDR, colorHelperC.bW);
-      //recalculate gains
-      avgW = (colorHelperC.rW + colorHelperC.gW + colorHelperC.bW) / 3.0f;
-      colorHelperC.rGain = avgW / (float)colorHelperC.rW;
-      colorHelperC.gGain = avgW / (float)colorHelperC.gW;
-      colorHelperC.bGain = avgW / (float)colorHelperC.bW;
-      //new calibration database
-      ColorCalibration calibrationDatabaseC[NUM_COLORS];
-      EEPROM.get(SENSOR_C_RED_CAL_ADDR,calibrationDatabaseC[0]);
-      EEPROM.get(SENSOR_C_GREEN_CAL_ADDR, calibrationDatabaseC[1]);
-      EEPROM.get(SENSOR_C_PURPLE_CAL_ADDR, calibrationDatabaseC[2]);
-      EEPROM.get(SENSOR_C_BLUE_CAL_ADDR, calibrationDatabaseC[3]);
-      EEPROM.get(SENSOR_C_ORANGE_CAL_ADDR, calibrationDatabaseC[4]);
-      EEPROM.get(SENSOR_C_YELLOW_CAL_ADDR, calibrationDatabaseC[5]);
-      EEPROM.get(SENSOR_C_SILVER_CAL_ADDR, calibrationDatabaseC[6]);
-      EEPROM.get(SENSOR_C_WHITE_CAL_ADDR, calibrationDatabaseC[7]);
-
-      colorHelperC.setColorDatabase(calibrationDatabaseC, NUM_COLORS);
-
-      //// setup D
-      //dark
-      EEPROM.get(SENSOR_D_RDARK_ADDR, colorHelperD.rDark);
-      EEPROM.get(SENSOR_D_GDARK_ADDR, colorHelperD.gDark);
-      EEPROM.get(SENSOR_D_BDARK_ADDR, colorHelperD.bDark);
-      //gains
-      EEPROM.get(SENSOR_D_RW_ADDR, colorHelperD.rW);
-      EEPROM.get(SENSOR_D_GW_ADDR, colorHelperD.gW);
-      EEPROM.get(SENSOR_D_BW_ADDR, colorHelperD.bW);
-      //recalculate gains
-      avgW = (colorHelperD.rW + colorHelperD.gW + colorHelperD.bW) / 3.0f;
-      colorHelperD.rGain = avgW / (float)colorHelperD.rW; 
-      colorHelperD.gGain = avgW / (float)colorHelperD.gW;
-      colorHelperD.bGain = avgW / (float)colorHelperD.bW;
-      //new calibration database
-      ColorCalibration calibrationDatabaseD[NUM_COLORS];
-      EEPROM.get(SENSOR_D_RED_CAL_ADDR,calibrationDatabaseD[0]);
-      EEPROM.get(SENSOR_D_GREEN_CAL_ADDR, calibrationDatabaseD[1]);
-      EEPROM.get(SENSOR_D_PURPLE_CAL_ADDR, calibrationDatabaseD[2]);
-      EEPROM.get(SENSOR_D_BLUE_CAL_ADDR, calibrationDatabaseD[3]);
-      EEPROM.get(SENSOR_D_ORANGE_CAL_ADDR, calibrationDatabaseD[4]);
-      EEPROM.get(SENSOR_D_YELLOW_CAL_ADDR, calibrationDatabaseD[5]);
-      EEPROM.get(SENSOR_D_SILVER_CAL_ADDR, calibrationDatabaseD[6]);
-      EEPROM.get(SENSOR_D_WHITE_CAL_ADDR, calibrationDatabaseD[7]);
-
-      colorHelperD.setColorDatabase(calibrationDatabaseD, NUM_COLORS);
+      for (int i = 0; i < NUM_SENSORS; i++) {
+        colorHelpers[i].loadCalibration();
+      }
       Serial.println("color calibrations hopefully restored");
 
-      menu.scaleManager.setScale(static_cast<ScaleManager::ScaleType>(EEPROM.read(SCALE_ADDR)));
-      menu.scaleManager.setRootNote(static_cast<RootNote>(EEPROM.read(ROOT_NOTE_ADDR)));
+      // Global scale and root: every sensor starts from these
+      uint8_t scale = EEPROM.read(SCALE_ADDR);
+      uint8_t root = EEPROM.read(ROOT_NOTE_ADDR);
+      menu.selectScale(scale < ScaleManager::NUM_SCALES ? scale : 0);
+      menu.selectRootNote((root >= static_cast<uint8_t>(RootNote::C4) && root <= static_cast<uint8_t>(RootNote::B4))
+                          ? root - static_cast<uint8_t>(RootNote::C4) : 0);
     }
     
 
     if(!calibrationValid){
       //write the default values to eeprom
       Serial.println("Writing default calibration values to EEPROM...");
-      //// setup A
-      // EEPROM.put(EEPROM_MAGIC_ADDRESS,EEPROM_MAGIC_VALUE);
-      //dark
-      EEPROM.put(SENSOR_A_RDARK_ADDR, colorHelperA.rDark);
-      EEPROM.put(SENSOR_A_GDARK_ADDR, colorHelperA.gDark);
-      EEPROM.put(SENSOR_A_BDARK_ADDR, colorHelperA.bDark);
-      //gains
-      EEPROM.put(SENSOR_A_RW_ADDR, colorHelperA.rW);
-      EEPROM.put(SENSOR_A_GW_ADDR, colorHelperA.gW);
-      EEPROM.put(SENSOR_A_BW_ADDR, colorHelperA.bW);
-      
-
-      /*
-      EEPROM.get(SENSOR_A_RED_CAL_ADDR,calibrationDatabaseA[0]);
-      EEPROM.get(SENSOR_A_GREEN_CAL_ADDR, calibrationDatabaseA[1]);
-      EEPROM.get(SENSOR_A_PURPLE_CAL_ADDR, calibrationDatabaseA[2]);
-      EEPROM.get(SENSOR_A_BLUE_CAL_ADDR, calibrationDatabaseA[3]);
-      EEPROM.get(SENSOR_A_ORANGE_CAL_ADDR, calibrationDatabaseA[4]);
-      EEPROM.get(SENSOR_A_YELLOW_CAL_ADDR, calibrationDatabaseA[5]);
-      EEPROM.get(SENSOR_A_SILVER_CAL_ADDR, calibrationDatabaseA[6]);
-      EEPROM.get(SENSOR_A_WHITE_CAL_ADDR, calibrationDatabaseA[7]);
-      */
-      //calibrations
-      EEPROM.put(SENSOR_A_RED_CAL_ADDR, colorHelperA.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_A_GREEN_CAL_ADDR, colorHelperA.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_A_PURPLE_CAL_ADDR, colorHelperA.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_A_BLUE_CAL_ADDR, colorHelperA.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_A_ORANGE_CAL_ADDR, colorHelperA.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_A_YELLOW_CAL_ADDR, colorHelperA.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_A_SILVER_CAL_ADDR, colorHelperA.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_A_WHITE_CAL_ADDR, colorHelperA.calibrationDatabase[7]);
-      //// setup B
-      //dark
-      EEPROM.put(SENSOR_B_RDARK_ADDR, colorHelperB.rDark);
-      EEPROM.put(SENSOR_B_GDARK_ADDR, colorHelperB.gDark);
-      EEPROM.put(SENSOR_B_BDARK_ADDR, colorHelperB.bDark);
-      //gains
-      EEPROM.put(SENSOR_B_RW_ADDR, colorHelperB.rW);
-
-      EEPROM.put(SENSOR_B_GW_ADDR, colorHelperB.gW);
-      EEPROM.put(SENSOR_B_BW_ADDR, colorHelperB.bW);
-
-      //calibrations
-      EEPROM.put(SENSOR_B_RED_CAL_ADDR, colorHelperB.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_B_GREEN_CAL_ADDR, colorHelperB.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_B_PURPLE_CAL_ADDR, colorHelperB.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_B_BLUE_CAL_ADDR, colorHelperB.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_B_ORANGE_CAL_ADDR, colorHelperB.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_B_YELLOW_CAL_ADDR, colorHelperB.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_B_SILVER_CAL_ADDR, colorHelperB.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_B_WHITE_CAL_ADDR, colorHelperB.calibrationDatabase[7]);
-
-      //// setup C
-      //dark
-      EEPROM.put(SENSOR_C_RDARK_ADDR, colorHelperC.rDark);
-      EEPROM.put(SENSOR_C_GDARK_ADDR, colorHelperC.gDark);
-      EEPROM.put(SENSOR_C_BDARK_ADDR, colorHelperC.bDark);
-      //gains
-      EEPROM.put(SENSOR_C_RW_ADDR, colorHelperC.rW);
-      EEPROM.put(SENSOR_C_GW_ADDR, colorHelperC.gW);
-      EEPROM.put(SENSOR_C_BW_ADDR, colorHelperC.bW);
-
-      //calibrations
-      EEPROM.put(SENSOR_C_RED_CAL_ADDR, colorHelperC.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_C_GREEN_CAL_ADDR, colorHelperC.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_C_PURPLE_CAL_ADDR, colorHelperC.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_C_BLUE_CAL_ADDR, colorHelperC.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_C_ORANGE_CAL_ADDR, colorHelperC.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_C_YELLOW_CAL_ADDR, colorHelperC.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_C_SILVER_CAL_ADDR, colorHelperC.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_C_WHITE_CAL_ADDR, colorHelperC.calibrationDatabase[7]);
-
-
-      //// setup D
-      //dark
-      EEPROM.put(SENSOR_D_RDARK_ADDR, colorHelperD.rDark);
-      EEPROM.put(SENSOR_D_GDARK_ADDR, colorHelperD.gDark);
-      EEPROM.put(SENSOR_D_BDARK_ADDR, colorHelperD.bDark);
-      //gains
-      EEPROM.put(SENSOR_D_RW_ADDR, colorHelperD.rW);
-      EEPROM.put(SENSOR_D_GW_ADDR, colorHelperD.gW);
-      EEPROM.put(SENSOR_D_BW_ADDR, colorHelperD.bW);
-
-      //calibrations
-      EEPROM.put(SENSOR_D_RED_CAL_ADDR, colorHelperD.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_D_GREEN_CAL_ADDR, colorHelperD.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_D_PURPLE_CAL_ADDR, colorHelperD.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_D_BLUE_CAL_ADDR, colorHelperD.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_D_ORANGE_CAL_ADDR, colorHelperD.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_D_YELLOW_CAL_ADDR, colorHelperD.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_D_SILVER_CAL_ADDR, colorHelperD.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_D_WHITE_CAL_ADDR, colorHelperD.calibrationDatabase[7]);
+      for (int i = 0; i < NUM_SENSORS; i++) {
+        colorHelpers[i].saveCalibration();
+      }
 
       EEPROM.put(SCALE_ADDR, static_cast<uint8_t>(ScaleManager::ScaleType::MAJOR));
       EEPROM.put(ROOT_NOTE_ADDR, static_cast<uint8_t>(RootNote::C4));
@@ -546,65 +508,75 @@ Serial.println(sizeof(ColorHelper));
     }
 
   // Disable all channels for now
-  tcaDisableAll();
+  deselectSensors();
 
   Serial.println("Loading menu values....");
   //load menu values
   if(calibrationValid){
 
     byte check;
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_A_ADDR, check);
+    EEPROM.get(ACTIVE_MIDI_CHANNEL_ADDR(0), check);
     Serial.print("Read back from EEPROM for A at startup: ");
     Serial.println(check);
 
     Serial.println("Using stored menu values");
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_A_ADDR, menu.activeMIDIChannelA);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      EEPROM.get(ACTIVE_MIDI_CHANNEL_ADDR(i), menu.sensorChannels[i].midiChannel);
+      EEPROM.get(OCTAVE_ADDR(i), menu.sensorChannels[i].octave);
+      // A sensor's own scale/root, if one was saved (out of range is ignored)
+      uint8_t stored = EEPROM.read(SENSOR_SCALE_ADDR(i));
+      if (stored & NOTE_SETTING_STORED) {
+        menu.setSensorScale(i, stored & ~NOTE_SETTING_STORED);
+      }
+      stored = EEPROM.read(SENSOR_ROOT_ADDR(i));
+      if (stored & NOTE_SETTING_STORED) {
+        menu.setSensorRoot(i, stored & ~NOTE_SETTING_STORED);
+      }
+    }
+    // Stored before the tempo setting existed: the bytes are still blank
+    uint16_t bpm;
+    EEPROM.get(TEMPO_ADDR, bpm);
+    menu.tempoBpm = (bpm >= MIDI_CLOCK_MIN_BPM && bpm <= MIDI_CLOCK_MAX_BPM) ? bpm : MIDI_CLOCK_DEFAULT_BPM;
+    menu.tempoFromDisk = EEPROM.read(TEMPO_SOURCE_ADDR) == 1;
     Serial.print("Settting sensor A channel to ");
-    Serial.println(menu.activeMIDIChannelA);
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_B_ADDR, menu.activeMIDIChannelB);
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_C_ADDR, menu.activeMIDIChannelC);
-    EEPROM.get(ACTIVE_MIDI_CHANNEL_D_ADDR, menu.activeMIDIChannelD);
-
-    EEPROM.get(OCTAVE_A_ADDR, menu.octaveA);
-    EEPROM.get(OCTAVE_B_ADDR, menu.octaveB);
-    EEPROM.get(OCTAVE_C_ADDR, menu.octaveC);
-    EEPROM.get(OCTAVE_D_ADDR, menu.octaveD);
+    Serial.println(menu.sensorChannels[0].midiChannel);
 
   }
   else{
     Serial.println("EEPROM not valid, using default values");
-    menu.activeMIDIChannelA = 3; // Default to channel 3
-    menu.activeMIDIChannelB = 6; // Default to channel 6
-    menu.activeMIDIChannelC = 7; // Default to channel 7
-    menu.activeMIDIChannelD = 12;// Default to channel 12
-
-    menu.octaveA = 1;
-    menu.octaveB = 3;
-    menu.octaveC = 4;
-    menu.octaveD = 6;
-
-    EEPROM.put(ACTIVE_MIDI_CHANNEL_A_ADDR, menu.activeMIDIChannelA);
-    EEPROM.put(ACTIVE_MIDI_CHANNEL_B_ADDR, menu.activeMIDIChannelB);
-    EEPROM.put(ACTIVE_MIDI_CHANNEL_C_ADDR, menu.activeMIDIChannelC);
-    EEPROM.put(ACTIVE_MIDI_CHANNEL_D_ADDR, menu.activeMIDIChannelD);
-
-    EEPROM.put(OCTAVE_A_ADDR, menu.octaveA);
-    EEPROM.put(OCTAVE_B_ADDR, menu.octaveB);
-    EEPROM.put(OCTAVE_C_ADDR, menu.octaveC);
-    EEPROM.put(OCTAVE_D_ADDR, menu.octaveD);
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      menu.sensorChannels[i].midiChannel = (i < numSensorDefaults) ? defaultMIDIChannels[i] : (i % 16) + 1;
+      menu.sensorChannels[i].octave = (i < numSensorDefaults) ? defaultOctaves[i] : 4;
+      EEPROM.put(ACTIVE_MIDI_CHANNEL_ADDR(i), menu.sensorChannels[i].midiChannel);
+      EEPROM.put(OCTAVE_ADDR(i), menu.sensorChannels[i].octave);
+    }
+    menu.saveTempo();
 
     EEPROM.put(EEPROM_MAGIC_ADDRESS,EEPROM_MAGIC_VALUE);
+    EEPROM.put(EEPROM_SENSOR_COUNT_ADDR, (uint8_t)NUM_SENSORS);
     EEPROM.commit();
   
 
     Serial.println("Default menus settings now saved to EEPROM");
   }
+  // Octaves were loaded straight into the channels
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    menu.rebuildNotes(i);
+  }
   
+  // MIDI clock out at the stored tempo; loop() moves it to the disk's speed
+  // when that's the chosen source
+  midiClock.begin();
+  midiClock.setTempo(menu.tempoBpm);
+#if MIDI_CLOCK_OUT
+  midiClock.start();
+#endif
+
   // Set up MIDI callback for MenuManager
-  menu.setAllNotesOffCallback(sendAllNotesOff);
+  menu.setNoteReleaseCallback(releaseSensorNotes);
   
-  // Initial menu render
-  menu.render();
+  // Initial menu render, on the first pass through loop()
+  menu.requestRender();
   
   Serial.println("Setup complete");
 
@@ -612,38 +584,33 @@ Serial.println(sizeof(ColorHelper));
   Serial.println("---------- DEBUG -----------");
   //print out the saved dark offset, gain, and yellow cal values for sensor A
   Serial.print("dark R,G,B: ");
-  Serial.print(colorHelperA.rDark);
+  Serial.print(colorHelpers[0].rDark);
   Serial.print(", ");
-  Serial.print(colorHelperA.gDark);
+  Serial.print(colorHelpers[0].gDark);
   Serial.print(", ");
-  Serial.println(colorHelperA.bDark);
+  Serial.println(colorHelpers[0].bDark);
   
   Serial.print("gain RGB: ");
-  Serial.print(colorHelperA.rGain);
+  Serial.print(colorHelpers[0].rGain);
   Serial.print(", ");
-  Serial.print(colorHelperA.gGain);
+  Serial.print(colorHelpers[0].gGain);
   Serial.print(", ");
-  Serial.println(colorHelperA.bGain);
+  Serial.println(colorHelpers[0].bGain);
 
   Serial.print("Red RGB:");
   byte redIdx = colorToIndex(Color::RED);
-  Serial.print(colorHelperA.calibrationDatabase[redIdx].red);
+  Serial.print(colorHelpers[0].calibrationDatabase[redIdx].red);
   Serial.print(", ");
-  Serial.print(colorHelperA.calibrationDatabase[redIdx].green);
+  Serial.print(colorHelpers[0].calibrationDatabase[redIdx].green);
   Serial.print(", ");
-  Serial.println(colorHelperA.calibrationDatabase[redIdx].blue);
+  Serial.println(colorHelpers[0].calibrationDatabase[redIdx].blue);
 }
 
 void loop() {
   static unsigned long lastPollTime = 0;
-  static unsigned long lastColorTime = 0;
-  static unsigned long lastSensorSettleTime = 0;
   static uint8_t currentSensorIndex = 0;
-  static bool sensorSettling = false;
   
   const unsigned long pollInterval = 5; // Poll every 5ms for better responsiveness
-  const unsigned long colorInterval = 50; // Much faster color checking (50ms)
-  const unsigned long settleTime = 1; // Minimal settle time
 
 
   
@@ -656,7 +623,7 @@ void loop() {
   if (encoderTurns != 0) {
     lastEncoderPos = newEncoderPos;
     menu.handleEncoder(encoderTurns); 
-    menu.render();
+    menu.requestRender();
   }  
 
 #ifdef TROUBLESHOOT
@@ -700,7 +667,7 @@ void loop() {
     } else {
       ignoreNextEncoderButton = true;
       menu.handleInput(ENCODER_BUTTON);
-      menu.render();
+      menu.requestRender();
     }
   }
   
@@ -713,7 +680,7 @@ void loop() {
     } else {
       ignoreNextConButton = true;
       menu.handleInput(CON_BUTTON);
-      menu.render();
+      menu.requestRender();
     }
   }
   
@@ -726,7 +693,7 @@ void loop() {
     } else {
       ignoreNextBackButton = true;
       menu.handleInput(BAK_BUTTON);
-      menu.render();
+      menu.requestRender();
     }
   }
   
@@ -734,26 +701,20 @@ void loop() {
   if (menu.requestRGBUpdate && menu.currentMenu == TROUBLESHOOT_MENU && menu.troubleshootMode == 1) {
     // Serial.println("Force updating RGB for all sensors...");
     
-    // Update RGB for all four sensors
-    for (int sensorIdx = 0; sensorIdx < 4; sensorIdx++) {
-      tcaSelect(sensorIdx);
-      delay(5); // Brief settling time
-      
-      float r, g, b, c;
-      activeColorSensor->getCalibratedData(&r, &g, &b);
-      
-      // Update RGB values in menu
-      switch (sensorIdx) {
-        case 0: menu.updateCurrentRGBA(r, g, b); break;
-        case 1: menu.updateCurrentRGBB(r, g, b); break;
-        case 2: menu.updateCurrentRGBC(r, g, b); break;
-        case 3: menu.updateCurrentRGBD(r, g, b); break;
-      }
+    // Update RGB for the sensors on screen, each through its own calibration
+    int firstSensor = menu.troubleshootPage * MenuManager::TROUBLESHOOT_SENSORS_PER_PAGE;
+    int lastSensor = min(firstSensor + MenuManager::TROUBLESHOOT_SENSORS_PER_PAGE, NUM_SENSORS);
+    // The latest reading is already in the history, no need to go back to the bus
+    for (int sensorIdx = firstSensor; sensorIdx < lastSensor; sensorIdx++) {
+      const SampleRing& history = sampleHistory[sensorIdx];
+      if (!scanner.isActive(sensorIdx) || history.size() == 0) continue;
+      menu.updateCurrentRGB(sensorIdx, history.calibratedChannel(0, 1).latest(),
+                            history.calibratedChannel(1, 1).latest(),
+                            history.calibratedChannel(2, 1).latest());
     }
     
-    // Clear the flag and restore current sensor
+    // Clear the flag
     // menu.requestRGBUpdate = false;
-    tcaSelect(currentSensorIndex);
   }
 
   // Keep panic button as polling since it's hardware-debounced
@@ -768,600 +729,551 @@ void loop() {
     resetOLED();
   }
 
-  // Non-blocking color detection with sensor cycling
-  if (currentTime - lastColorTime >= colorInterval) {
-    // Start sensor settling if not already settling
-    if (!sensorSettling) {
-      // Serial.print("tca select on sensor");
-      // Serial.println(currentSensorIndex);
-      activeColorSensor = colorHelpers[currentSensorIndex]; //trying this added here
-      tcaSelect(currentSensorIndex);
-      lastSensorSettleTime = currentTime;
-      sensorSettling = true;
-      return; // Exit loop to allow other operations
-    }
-    else{
-      // Serial.print("Sensor settling in progress for sensor #");
-      // Serial.println(currentSensorIndex);
-    }
+  // MIDI input: remote setting changes, and start/stop from a DAW. Stop
+  // releases everything and mutes new notes until start or continue.
+  RemoteCommand remote;
+  bool remoteChanged = false;
+  while (midiIn.nextCommand(remote)) {
+    applyRemoteCommand(remote);
+    remoteChanged = true;
+  }
+  if (remoteChanged) {
+    menu.requestRender();
+  }
+  static MidiTransport lastTransport = MIDI_TRANSPORT_FREE;
+  MidiTransport transport = midiIn.transport();
+  if (transport != lastTransport) {
+    lastTransport = transport;
+    releaseSensorNotes(-1); // on start, every ring sounds its color afresh
+    Serial.println(transport == MIDI_TRANSPORT_STOPPED ? "MIDI stop" : "MIDI start");
+  }
 
-    // Check if sensor has settled
-    if (currentTime - lastSensorSettleTime >= settleTime) {
-      // Process current sensor
-      // Serial.println("checking for sensor availability");
-      if (activeColorSensor->isAvailable()) {
-        // Serial.print("Attempting to get color, sensor #");
-        if (!activeColorSensor) {
-          Serial.println("ERROR: activeColorSensor is null!");
-          return;
-        }
-        // Serial.println(currentSensorIndex);
-        // Serial.print("activeColorSensor ptr: "); 
-        // Serial.println((uintptr_t)activeColorSensor, HEX);
-        // Serial.print("colorDatabase ptr: "); 
-        // Serial.println((uintptr_t)activeColorSensor->colorDatabase, HEX);
-
-      //   for (int i = 0; i < 9; i++) {
-      //   Serial.print("colorDatabase["); Serial.print(i); Serial.print("]: ");
-      //   Serial.print(activeColorSensor->colorDatabase[i].avgR); Serial.print(", ");
-      //   Serial.print(activeColorSensor->colorDatabase[i].avgG); Serial.print(", ");
-      //   Serial.println(activeColorSensor->colorDatabase[i].avgB);
-      // }
-
-
-        Color detectedColor = activeColorSensor->getCurrentColorEnum();
-        // Serial.println("Got color");
-        Color* currentColorPtr = nullptr;
-        String sensorName = "";
-        uint8_t activeMIDIChannel = 1;
-        uint8_t velocity = 127;
+  // Non-blocking color detection: one sensor per pass through loop(), so the
+  // buttons and MIDI stay responsive however many sensors there are. The
+  // scanner picks whichever sensor needs it most (see SensorScanner.h).
+  if (scanner.next(currentTime, currentSensorIndex)) {
+    activeColorSensor = &colorHelpers[currentSensorIndex];
+    selectSensor(currentSensorIndex);
+    Color detectedColor = activeColorSensor->getCurrentColorEnum();
+    bool readOk = activeColorSensor->lastI2CError == 0;
+    if (sensorHealth.reportRead(currentSensorIndex, readOk, activeColorSensor->rawRepeats)) {
+      takeSensorOffline(currentSensorIndex, currentTime);
+    } else if (readOk) {
+      // Serial.println("Got color");
+      SensorChannel& channel = menu.sensorChannels[currentSensorIndex];
+      noteBurst.sensorRead(currentSensorIndex);
+      colorCc.update(currentSensorIndex, sampleHistory[currentSensorIndex], channel.midiChannel,
+                     scanner.activeCount(), currentTime, sendColorCc);
+      // Changing or borderline sensors get read more often
+      scanner.report(currentSensorIndex, currentTime,
+                     detectedColor != Color::UNKNOWN && detectedColor != channel.currentColor,
+                     activeColorSensor->lastMargin);
+      
+#ifdef TROUBLESHOOT
+      // Debug: Print sensor readings periodically with raw values
+      static unsigned long lastDebugPrint = 0;
+      if (currentTime - lastDebugPrint > 2000) { // Every 2 seconds
+        const SampleRing& history = sampleHistory[currentSensorIndex];
+        uint16_t r = history.rawChannel(SAMPLE_RED, 1).latest();
+        uint16_t g = history.rawChannel(SAMPLE_GREEN, 1).latest();
+        uint16_t b = history.rawChannel(SAMPLE_BLUE, 1).latest();
+        uint16_t c = history.rawChannel(SAMPLE_CLEAR, 1).latest();
         
-        // Determine which sensor we're processing
-        switch (currentSensorIndex) {
-          case 0:
-            currentColorPtr = &currentColorA;
-            sensorName = "Sensor A";
-            activeMIDIChannel = menu.activeMIDIChannelA;
-            velocity = menu.velocityA;
-            break;
-          case 1:
-            currentColorPtr = &currentColorB;
-            sensorName = "Sensor B";
-            activeMIDIChannel = menu.activeMIDIChannelB;
-            velocity = menu.velocityB;
-            break;
-          case 2:
-            currentColorPtr = &currentColorC;
-            sensorName = "Sensor C";
-            activeMIDIChannel = menu.activeMIDIChannelC;
-            velocity = menu.velocityC;
-            break;
-          case 3:
-            currentColorPtr = &currentColorD;
-            sensorName = "Sensor D";
-            activeMIDIChannel = menu.activeMIDIChannelD;
-            velocity = menu.velocityD;
-            break;
-        }
+        Serial.print("Sensor ");
+        Serial.print(sensorLetter(currentSensorIndex));
+        Serial.print(": ");
+        Serial.print(colorToString(detectedColor));
+        Serial.print(" (R:");
+        Serial.print(r);
+        Serial.print(" G:");
+        Serial.print(g);
+        Serial.print(" B:");
+        Serial.print(b);
+        Serial.print(" C:");
+        Serial.print(c);
+        Serial.print(")");
         
-#ifdef TROUBLESHOOT
-        // Debug: Print sensor readings periodically with raw values
-        static unsigned long lastDebugPrint = 0;
-        if (currentTime - lastDebugPrint > 2000) { // Every 2 seconds
-          uint16_t r, g, b, c;
-          colorSensor.getRawData(&r, &g, &b, &c);
-          
-          Serial.print(sensorName);
-          Serial.print(": ");
-          Serial.print(colorToString(detectedColor));
-          Serial.print(" (R:");
-          Serial.print(r);
-          Serial.print(" G:");
-          Serial.print(g);
-          Serial.print(" B:");
-          Serial.print(b);
-          Serial.print(" C:");
-          Serial.print(c);
-          Serial.print(")");
-          
-          if (currentSensorIndex == 3) { // Print newline after sensor D
-            Serial.println();
-            lastDebugPrint = currentTime;
-          } else {
-            Serial.print(" | ");
-          }
+        if (currentSensorIndex == NUM_SENSORS - 1) { // Print newline after the last sensor
+          Serial.println();
+          lastDebugPrint = currentTime;
+        } else {
+          Serial.print(" | ");
         }
+      }
 #endif
 
-        // Update RGB values if in troubleshoot mode 1 (RGB display) and color changed
-        if (menu.currentMenu == TROUBLESHOOT_MENU && menu.troubleshootMode == 1 && 
-            detectedColor != Color::UNKNOWN && currentColorPtr != nullptr) {
-          float r, g, b;
-          activeColorSensor->getCalibratedData(&r, &g, &b);
-          
-          
-          // Update RGB values in menu for troubleshoot mode
-          switch (currentSensorIndex) {
-            case 0: menu.updateCurrentRGBA(r, g, b); break;
-            case 1: menu.updateCurrentRGBB(r, g, b); break;
-            case 2: menu.updateCurrentRGBC(r, g, b); break;
-            case 3: menu.updateCurrentRGBD(r, g, b); break;
-            Serial.print("updating ");
-            Serial.println(sensorName);
+      // Update RGB values if in troubleshoot mode 1 (RGB display) and color changed
+      if (menu.currentMenu == TROUBLESHOOT_MENU && menu.troubleshootMode == 1 && 
+          detectedColor != Color::UNKNOWN) {
+        const SampleRing& history = sampleHistory[currentSensorIndex];
+        menu.updateCurrentRGB(currentSensorIndex, history.calibratedChannel(0, 1).latest(),
+                              history.calibratedChannel(1, 1).latest(),
+                              history.calibratedChannel(2, 1).latest());
+      }
+      
+      
+      // Process color change if detected and valid
+      if (detectedColor != Color::UNKNOWN && detectedColor != channel.currentColor) {
+      //  Serial.print("New color:");
+      //   Serial.println(colorToString(detectedColor));
+       
+        // Note for new color: scale, root and octave are already in the table
+        uint8_t colorIdx = static_cast<uint8_t>(detectedColor);
+        uint8_t newMidiNote = channel.notes[colorIdx];
+
+        // Note off for the previous color and note on for the new one go out
+        // with any other ring that changed in the same slice of the revolution.
+        // WHITE only releases.
+        NoteChange change;
+        change.onsetUs = sampleHistory[currentSensorIndex].times(1).latest();
+        change.sensor = currentSensorIndex;
+        change.off = channel.playing;
+        change.offChannel = channel.midiChannel;
+        if (newMidiNote != SensorChannel::NO_NOTE && transport != MIDI_TRANSPORT_STOPPED) {
+          if (voicingMode == VOICING_SINGLE) {
+            change.on.notes[0] = newMidiNote;
+            change.on.count = 1;
+          } else {
+            change.on.fromChord(channel.chords[colorIdx], voicingMode, VOICING_NOTES);
           }
         }
+        change.arpeggio = voicingMode == VOICING_ARPEGGIO;
+        change.onChannel = channel.midiChannel;
+        change.velocity = channel.velocity;
+        noteOutput.change(change, micros());
+        diskTempo.colorChange(currentSensorIndex, channel.currentColor, detectedColor, currentTime);
+
+        // Remembered for the next note off and shown on the troubleshoot page
+        channel.playing = change.on;
+        if (change.on.count > 0) {
+          channel.lastNote = newMidiNote;
+        }
         
-        
-        // Process color change if detected and valid
-        if (detectedColor != Color::UNKNOWN && detectedColor != *currentColorPtr && currentColorPtr != nullptr) {
-        //  Serial.print("New color:");
-        //   Serial.println(colorToString(detectedColor));
-          switch(currentSensorIndex){
-            case 0:
-              oldMidiNote = lastNoteA;
-              break;
-            case 1:
-              oldMidiNote = lastNoteB;
-              break;
-            case 2:
-              oldMidiNote = lastNoteC;
-              break;
-            case 3:
-              oldMidiNote = lastNoteD;
-              break;
-          }
-         
-          // Send note off for previous color
-         MIDI.sendNoteOff(oldMidiNote, 0, activeMIDIChannel);
-        //  Serial.print("Sending note off to note ");
-        //  Serial.print(oldMidiNote);
-        //  Serial.print("on channel ");
-        //  Serial.println(activeMIDIChannel);
-          
-          // Send note on for new color
-          int newMidiNote = menu.scaleManager.colorToMIDINote(detectedColor);
-          // Serial.print("new midi note (pre-octave):");
-          // Serial.println(newMidiNote);
-          // Adjust based on octave using signed arithmetic to allow negative offsets
-          int offset;
-          switch (currentSensorIndex){
-            case 0:
-              offset = (int(menu.octaveA) - 4) * 12;
-              newMidiNote += offset;
-              // clamp to valid MIDI range
-              if (newMidiNote < 0) newMidiNote = 0;
-              if (newMidiNote > 127) newMidiNote = 127;
-              lastNoteA = (uint8_t)newMidiNote;
-              break;
-            case 1:
-              offset = (int(menu.octaveB) - 4) * 12;
-              newMidiNote += offset;
-              if (newMidiNote < 0) newMidiNote = 0;
-              if (newMidiNote > 127) newMidiNote = 127;
-              lastNoteB = (uint8_t)newMidiNote;
-              break;  
-            case 2:
-              offset = (int(menu.octaveC) - 4) * 12;
-              newMidiNote += offset;
-              if (newMidiNote < 0) newMidiNote = 0;
-              if (newMidiNote > 127) newMidiNote = 127;
-              lastNoteC = (uint8_t)newMidiNote;
-              break;
-            case 3:
-              offset = (int(menu.octaveD) - 4) * 12;
-              newMidiNote += offset;
-              if (newMidiNote < 0) newMidiNote = 0;
-              if (newMidiNote > 127) newMidiNote = 127;
-              lastNoteD = (uint8_t)newMidiNote;
-              break;
-          }
-   
-
-          byte currentChannel = (detectedColor == Color::WHITE) ? 0 : activeMIDIChannel;
-          MIDI.sendNoteOn((uint8_t)newMidiNote, velocity, currentChannel);
-
-          switch(currentSensorIndex){
-            case 0:
-              lastNoteA = newMidiNote;
-              // Serial.print("Set last note A to ");
-              // Serial.println(lastNoteA);
-              break;
-            case 1:
-              lastNoteB = newMidiNote;
-              // Serial.print("Set last note B to ");
-              // Serial.println(lastNoteB);
-              break;  
-            case 2:
-              lastNoteC = newMidiNote;
-              // Serial.print("Set last note C to ");
-              // Serial.println(lastNoteC);
-              break;
-            case 3:
-              lastNoteD = newMidiNote;
-              // Serial.print("Set last note D to ");
-              // Serial.println(lastNoteD);
-              break;
-          }
-          
-          // Update menu display
-          switch (currentSensorIndex) {
-            case 0:
-              menu.updateCurrentColorA(colorToString(detectedColor));
-              menu.updateCurrentMIDINoteA(newMidiNote);
-              break;
-            case 1:
-              menu.updateCurrentColorB(colorToString(detectedColor));
-              menu.updateCurrentMIDINoteB(newMidiNote);
-              break;
-            case 2:
-              menu.updateCurrentColorC(colorToString(detectedColor));
-              menu.updateCurrentMIDINoteC(newMidiNote);
-              break;
-            case 3:
-              menu.updateCurrentColorD(colorToString(detectedColor));
-              menu.updateCurrentMIDINoteD(newMidiNote);
-              break;
-          }
-          
-          // Update troubleshoot display if active (less frequent)
-          static unsigned long lastTroubleshootUpdate = 0;
-          if (menu.currentMenu == TROUBLESHOOT_MENU && 
-              (currentTime - lastTroubleshootUpdate) > 100) { // Update display max every 100ms
-            menu.render();
-            lastTroubleshootUpdate = currentTime;
-          }
-          
-          *currentColorPtr = detectedColor;
+        // The troubleshoot page picks it up on its next frame
+        if (menu.currentMenu == TROUBLESHOOT_MENU) {
+          menu.requestRender();
         }
-      }
-      
-      // Move to next sensor
-      currentSensorIndex = (currentSensorIndex + 1) % 4;
-      sensorSettling = false;
-      
-      // If we've cycled through all sensors, reset timer
-      if (currentSensorIndex == 0) {
-        tcaDisableAll(); // Disable multiplexer after full cycle
-        lastColorTime = currentTime;
+        
+        channel.currentColor = detectedColor;
       }
     }
+
   }
 
-  //check if we're calibrating A
-  if(menu.pendingCalibrationA!=PendingCalibrationA::NONE){
-    menu.startCalibrationCountdown();
-    ColorHelper* sensorA = colorHelpers[0];
-    tcaSelect(0);
-    if(menu.pendingCalibrationA == PendingCalibrationA::DARK_OFFSET){
-      Serial.print("Initial r,g,b dark offsets:");
-      Serial.print(sensorA->rDark);
-      Serial.print(", ");
-      Serial.print(sensorA->gDark);
-      Serial.print(", ");
-      Serial.println(sensorA->bDark);
-      sensorA->calibrateDark();
-      Serial.print("Adjusted r,g,b dark offsets:");
-      Serial.print(sensorA->rDark);
-      Serial.print(", ");
-      Serial.print(sensorA->gDark);
-      Serial.print(", ");
-      Serial.println(sensorA->bDark);
+  // Clock tempo: the menu setting, or the disk's own speed once it's known
+  static unsigned long lastTempoCheck = 0;
+  if (currentTime - lastTempoCheck >= 250) {
+    lastTempoCheck = currentTime;
+    float measured = diskTempo.bpm(currentTime);
+    float bpm = (menu.tempoFromDisk && measured > 0) ? measured : (float)menu.tempoBpm;
+    if (fabsf(bpm - midiClock.tempo()) >= 0.5f) {
+      midiClock.setTempo(bpm);
     }
-    else if(menu.pendingCalibrationA==PendingCalibrationA::GAINS){
-      Serial.print("Initial r,g,b gains:");
-      Serial.print(sensorA->rGain);
-      Serial.print(", ");
-      Serial.print(sensorA->gGain);
-      Serial.print(", ");
-      Serial.println(sensorA->bGain);
-      sensorA->calibrateWhiteGains();
-      Serial.print("Adjusted r,g,b gains:");
-      Serial.print(sensorA->rGain);
-      Serial.print(", ");
-      Serial.print(sensorA->gGain);
-      Serial.print(", ");
-      Serial.println(sensorA->bGain);
+    if (menu.currentMenu == TEMPO_MENU && fabsf(measured - menu.diskBpm) >= 0.5f) {
+      menu.diskBpm = measured;
+      menu.requestRender();
     }
-    else if(menu.pendingCalibrationA==PendingCalibrationA::APPLY_TO_BCD){
-      Serial.println("Inside A->BCD block");
-      //Apply calibration values from A to B, C, and D
-      ColorHelper* targetHelper;
-      for(int i=1; i<4; i++){
-        Serial.print("Sensor# ");
-        Serial.println(i);
-         targetHelper = colorHelpers[i];
-         //set dark values
-         targetHelper->rDark = colorHelperA.rDark;
-         targetHelper->gDark = colorHelperA.gDark;
-         targetHelper->bDark = colorHelperA.bDark;
-
-         //set gain values
-         targetHelper->rW = colorHelperA.rW;
-         targetHelper->gW = colorHelperA.gW;
-         targetHelper->bW = colorHelperA.bW;
-         targetHelper->rGain = colorHelperA.rGain;
-         targetHelper->gGain = colorHelperA.gGain;
-         targetHelper->bGain = colorHelperA.bGain;
-
-         //set color values
-         for(int j=0; j<NUM_COLORS; j++){
-          menu.display.clearDisplay();
-          menu.display.setCursor(0, 0);
-          menu.display.print(">  ");
-          menu.display.print(colorToString(indexToColor(j)));
-          targetHelper->calibrationDatabase[j] = colorHelperA.calibrationDatabase[j];
-         }
-      }
+  }
+
+  // Send the held note changes once every ring has had its say
+  noteOutput.service(micros(), scanner.activeCount());
+
+  // Clear a stuck bus, and move one offline sensor along its re-probe
+  serviceSensorHealth(currentTime);
 
-      saveBCD();
-      menu.pendingCalibrationA = PendingCalibrationA::NONE;
-      //todo: some kind of menu feedback
-      menu.render();
+  // Redraw the OLED if anything asked for it, at most MENU_MAX_FPS times a
+  // second, and not while a note burst is held (a frame can take a while)
+  if (noteBurst.pending() == 0) {
+    menu.serviceRender(millis());
+  }
 
+#if MIDI_RECORDER
+  // Recorder commands from the serial monitor
+  if (Serial.available() > 0) {
+    int command = Serial.read();
+    if (command == 'd') {
+      midiRecorder.dump(Serial, midiClock.tempo());
+    } else if (command == 'c') {
+      midiRecorder.clear();
+      Serial.println("MIDI recorder cleared");
     }
-    /*
-    EEPROM.put(SENSOR_A_RED_CAL_ADDR, colorHelperA.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_A_GREEN_CAL_ADDR, colorHelperA.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_A_PURPLE_CAL_ADDR, colorHelperA.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_A_BLUE_CAL_ADDR, colorHelperA.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_A_ORANGE_CAL_ADDR, colorHelperA.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_A_YELLOW_CAL_ADDR, colorHelperA.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_A_SILVER_CAL_ADDR, colorHelperA.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_A_WHITE_CAL_ADDR, colorHelperA.calibrationDatabase[7]);
-      */
-    else{
-    Color selectedColor = menu.pendingCalibrationA==PendingCalibrationA::RED?Color::RED:
-                           menu.pendingCalibrationA==PendingCalibrationA::GREEN?Color::GREEN:
-                            menu.pendingCalibrationA==PendingCalibrationA::PURPLE?Color::PURPLE:
-                            menu.pendingCalibrationA==PendingCalibrationA::BLUE?Color::BLUE:
-                            menu.pendingCalibrationA==PendingCalibrationA::ORANGE?Color::ORANGE:
-                            menu.pendingCalibrationA==PendingCalibrationA::YELLOW?Color::YELLOW:
-                            menu.pendingCalibrationA==PendingCalibrationA::SILVER?Color::SILVER:
-                            menu.pendingCalibrationA==PendingCalibrationA::WHITE?Color::WHITE:                          menu.pendingCalibrationA==PendingCalibrationA::WHITE?Color::WHITE:
-                           Color::UNKNOWN;
-    colorHelperA.calibrateColor(selectedColor); //safety
-    
   }
-  menu.pendingCalibrationA = PendingCalibrationA::NONE;
-  menu.render();
-}
-  //check if we're calibrating B
-  if(menu.pendingCalibrationB!=PendingCalibrationB::NONE){
-    menu.startCalibrationCountdown();
-    ColorHelper* sensorB = colorHelpers[1];
-    tcaSelect(1);
-    if(menu.pendingCalibrationB == PendingCalibrationB::DARK_OFFSET){
-      Serial.print("Initial r,g,b dark offsets:");
-      Serial.print(sensorB->rDark);
-      Serial.print(", ");
-      Serial.print(sensorB->gDark);
-      Serial.print(", ");
-      Serial.println(sensorB->bDark);
-      sensorB->calibrateDark();
-      Serial.print("Adjusted r,g,b dark offsets:");
-      Serial.print(sensorB->rDark);
-      Serial.print(", ");
-      Serial.print(sensorB->gDark);
-      Serial.print(", ");
-      Serial.println(sensorB->bDark);
+#endif
+
+  // MIDI wire and display bus usage, once a minute
+  static unsigned long lastMidiReport = 0;
+  if (currentTime - lastMidiReport >= 60000) {
+    lastMidiReport = currentTime;
+    Serial.print("MIDI: ");
+    Serial.print(midiOut.bytesSent());
+    Serial.print(" bytes sent, ");
+    Serial.print(midiOut.bytesSaved());
+    Serial.print(" saved by running status (");
+    Serial.print(midiOut.wireTimeSavedMsPerMinute(currentTime));
+    Serial.println(" ms of wire time per minute)");
+    // Per priority: max depth, average/max latency until the last byte is out
+    static const char* const priorityNames[MIDI_PRIORITY_COUNT] = {"urgent", "thru", "note", "control"};
+    for (uint8_t p = 0; p < MIDI_PRIORITY_COUNT; p++) {
+      MidiPriority priority = (MidiPriority)p;
+      Serial.print("  ");
+      Serial.print(priorityNames[p]);
+      Serial.print(": ");
+      Serial.print(midiTx.sent(priority));
+      Serial.print(" sent, depth max ");
+      Serial.print(midiTx.maxDepth(priority));
+      Serial.print(", latency avg ");
+      Serial.print(midiTx.averageLatencyUs(priority));
+      Serial.print(" us max ");
+      Serial.print(midiTx.maxLatencyUs(priority));
+      Serial.print(" us, dropped ");
+      Serial.println(midiTx.dropped(priority));
     }
-    else if(menu.pendingCalibrationB==PendingCalibrationB::GAINS){
-      Serial.print("Initial r,g,b gains:");
-      Serial.print(sensorB->rGain);
-      Serial.print(", ");
-      Serial.print(sensorB->gGain);
-      Serial.print(", ");
-      Serial.println(sensorB->bGain);
-      sensorB->calibrateWhiteGains();
-      Serial.print("Adjusted r,g,b gains:");
-      Serial.print(sensorB->rGain);
-      Serial.print(", ");
-      Serial.print(sensorB->gGain);
-      Serial.print(", ");
-      Serial.println(sensorB->bGain);
+    Serial.print("  CC values replaced before sending: ");
+    Serial.println(midiTx.coalesced());
+    Serial.print("  Note-ons dropped behind their note-off: ");
+    Serial.println(midiTx.staleNoteOns());
+    Serial.print("  Color CCs: ");
+    Serial.print(colorCc.sent());
+    Serial.print(" sent, ");
+    Serial.print(colorCc.belowThreshold());
+    Serial.print(" below threshold, ");
+    Serial.print(colorCc.rateLimited());
+    Serial.print(" held back (");
+    Serial.print(ColorCcStream::intervalMs(scanner.activeCount()));
+    Serial.println(" ms per sensor)");
+    Serial.print("MIDI in: ");
+    Serial.print(midiIn.bytesReceived());
+    Serial.print(" bytes, ");
+    Serial.print(midiIn.cyclesPerByte());
+    Serial.print(" cycles per byte, clock ");
+    Serial.print(midiIn.bpm());
+    Serial.print(" BPM, ");
+    Serial.print(midiIn.messagesDropped());
+    Serial.print(" control messages dropped, clock jitter ");
+    Serial.print(midiIn.clockJitterUs());
+    Serial.println(" us");
+    Serial.print("MIDI clock: ");
+    Serial.print(midiClock.tempo());
+    Serial.print(" BPM, ");
+    Serial.print(midiTx.clockTicksSent());
+    Serial.print(" ticks sent, ");
+    Serial.print(midiTx.maxClockLatenessUs());
+    Serial.println(" us late at most");
+    if (midiTx.gateTimeMs() > 0) {
+      Serial.print("Gates: ");
+      Serial.print(midiTx.gateEventsSent());
+      Serial.print(" sent, ");
+      Serial.print(midiTx.maxGatesPending());
+      Serial.print(" pending max, ");
+      Serial.print(midiTx.gatesDropped());
+      Serial.print(" dropped, ");
+      Serial.print(midiTx.maxGateLatenessUs());
+      Serial.println(" us late at most");
     }
-    else{
-    Color selectedColor = menu.pendingCalibrationB==PendingCalibrationB::RED?Color::RED:
-                           menu.pendingCalibrationB==PendingCalibrationB::GREEN?Color::GREEN:
-                            menu.pendingCalibrationB==PendingCalibrationB::PURPLE?Color::PURPLE:
-                            menu.pendingCalibrationB==PendingCalibrationB::BLUE?Color::BLUE:
-                            menu.pendingCalibrationB==PendingCalibrationB::ORANGE?Color::ORANGE:
-                            menu.pendingCalibrationB==PendingCalibrationB::YELLOW?Color::YELLOW:
-                            menu.pendingCalibrationB==PendingCalibrationB::SILVER?Color::SILVER:
-                            menu.pendingCalibrationB==PendingCalibrationB::WHITE?Color::WHITE:                          menu.pendingCalibrationB==PendingCalibrationB::WHITE?Color::WHITE:
-                           Color::UNKNOWN;
-
-    sensorB->calibrateColor(selectedColor); //safety
-    
-  }
-  menu.pendingCalibrationB = PendingCalibrationB::NONE;
-  menu.render();
+    Serial.print("Menu: ");
+    Serial.print(menu.framesRendered());
+    Serial.print(" frames for ");
+    Serial.print(menu.renderRequests());
+    Serial.print(" requests, ");
+    Serial.print(menu.renderTimeUs() / 60000.0f);
+    Serial.print(" ms per second rendering, longest frame ");
+    Serial.print(menu.maxRenderUs());
+    Serial.println(" us");
+    menu.resetRenderStats();
+    Serial.print("OLED: ");
+    Serial.print(display.frames());
+    Serial.print(" frames, ");
+    Serial.print(display.bytesSent());
+    Serial.print(" I2C bytes instead of ");
+    Serial.print(display.fullFrameBytes());
+    Serial.print(", ");
+    Serial.print(display.busTimeSavedMs());
+    Serial.println(" ms of bus time freed for the sensors");
+    display.resetStats();
+#if MIDI_RECORDER
+    Serial.print("Recorder: ");
+    Serial.print(midiRecorder.events());
+    Serial.print(" events in ");
+    Serial.print(midiRecorder.bytesUsed());
+    Serial.print(" of ");
+    Serial.print(MidiRecorder::budgetBytes());
+    Serial.print(" bytes, last ");
+    Serial.print(midiRecorder.spanMs() / 1000);
+    Serial.print(" s, ");
+    Serial.print(midiRecorder.overwritten());
+    Serial.print(" overwritten, ");
+    Serial.print(midiRecorder.missed());
+    Serial.println(" missed while dumping");
+#endif
+    midiIn.resetClockJitter();
+    midiTx.resetMaxima();
   }
-  //check if we're calibrating C
-  if(menu.pendingCalibrationC!=PendingCalibrationC::NONE){
-    menu.startCalibrationCountdown();
-    ColorHelper* sensorC = colorHelpers[2];
-    tcaSelect(2);
-    if(menu.pendingCalibrationC == PendingCalibrationC::DARK_OFFSET){
-      Serial.print("Initial r,g,b dark offsets:");
-      Serial.print(sensorC->rDark);
-      Serial.print(", ");
-      Serial.print(sensorC->gDark);
-      Serial.print(", ");
-      Serial.println(sensorC->bDark);
-      sensorC->calibrateDark();
-      Serial.print("Adjusted r,g,b dark offsets:");
-      Serial.print(sensorC->rDark);
-      Serial.print(", ");
-      Serial.print(sensorC->gDark);
-      Serial.print(", ");
-      Serial.println(sensorC->bDark);
-    }
-    else if(menu.pendingCalibrationC==PendingCalibrationC::GAINS){
-      Serial.print("Initial r,g,b gains:");
-      Serial.print(sensorC->rGain);
-      Serial.print(", ");
-      Serial.print(sensorC->gGain);
-      Serial.print(", ");
-      Serial.println(sensorC->bGain);
-      sensorC->calibrateWhiteGains();
-      Serial.print("Adjusted r,g,b gains:");
-      Serial.print(sensorC->rGain);
-      Serial.print(", ");
-      Serial.print(sensorC->gGain);
-      Serial.print(", ");
-      Serial.println(sensorC->bGain);
+
+  // Run queued calibration jobs once the operator has confirmed the patch is in place
+  if (menu.calibrationRunRequested) {
+    menu.calibrationRunRequested = false;
+    CalibrationJob job;
+    if (menu.calibrationQueue.pop(job)) {
+      runCalibrationJob(job);
+      // Keep going while the next job uses the same patch (e.g. Gains then White),
+      // there's nothing for the operator to swap in between.
+      Color patch = calibrationStepPatch(job.step);
+      CalibrationJob next;
+      while (patch != Color::UNKNOWN && menu.calibrationQueue.peek(next) &&
+             calibrationStepPatch(next.step) == patch) {
+        menu.calibrationQueue.pop(next);
+        runCalibrationJob(next);
+      }
+      selectSensor(currentSensorIndex);
     }
-    else{
- Color selectedColor = menu.pendingCalibrationC==PendingCalibrationC::RED?Color::RED:
-                           menu.pendingCalibrationC==PendingCalibrationC::GREEN?Color::GREEN:
-                            menu.pendingCalibrationC==PendingCalibrationC::PURPLE?Color::PURPLE:
-                            menu.pendingCalibrationC==PendingCalibrationC::BLUE?Color::BLUE:
-                            menu.pendingCalibrationC==PendingCalibrationC::ORANGE?Color::ORANGE:
-                            menu.pendingCalibrationC==PendingCalibrationC::YELLOW?Color::YELLOW:
-                            menu.pendingCalibrationC==PendingCalibrationC::SILVER?Color::SILVER:
-                            menu.pendingCalibrationC==PendingCalibrationC::WHITE?Color::WHITE:                          menu.pendingCalibrationC==PendingCalibrationC::WHITE?Color::WHITE:
-                           Color::UNKNOWN;
-
-    sensorC->calibrateColor(selectedColor); //safety
-    
+    menu.requestRender();
   }
-  menu.pendingCalibrationC = PendingCalibrationC::NONE;
-  menu.render();
 }
 
-  //check if we're calibrating D
-  if(menu.pendingCalibrationD!=PendingCalibrationD::NONE){
-    menu.startCalibrationCountdown();
-    ColorHelper* sensorD = colorHelpers[3];
-    tcaSelect(3);
-    if(menu.pendingCalibrationD == PendingCalibrationD::DARK_OFFSET){
-      Serial.print("Initial r,g,b dark offsets:");
-      Serial.print(sensorD->rDark);
-      Serial.print(", ");
-      Serial.print(sensorD->gDark);
-      Serial.print(", ");
-      Serial.println(sensorD->bDark);
-      sensorD->calibrateDark();
-      Serial.print("Adjusted r,g,b dark offsets:");
-      Serial.print(sensorD->rDark);
-      Serial.print(", ");
-      Serial.print(sensorD->gDark);
-      Serial.print(", ");
-      Serial.println(sensorD->bDark);
+// Run one calibration job over every sensor in its mask. Sampling steps read all
+// of those sensors in lockstep, so the per-sample settle delay is paid once per
+// pass instead of once per sensor.
+void runCalibrationJob(const CalibrationJob& job){
+  Serial.print("Running calibration job: ");
+  Serial.print(calibrationStepName(job.step));
+  Serial.print(" mask 0x");
+  Serial.println(job.sensorMask, HEX);
+
+  switch (job.step) {
+    case CalibrationStep::NONE:
+      return;
+
+    case CalibrationStep::TRANSFER_FROM_A:
+      // A's full centroid set, mapped through each target's own reference colors
+      for (int s = 1; s < NUM_SENSORS; s++) {
+        if (!(job.sensorMask & sensorBit(s))) continue;
+        TransferModel model = colorHelpers[s].transferCalibrationFrom(colorHelpers[0]);
+        if (model == TransferModel::NONE) {
+          Serial.print("Sensor #");
+          Serial.print(s);
+          Serial.println(" not transferred");
+        }
+      }
+      EEPROM.commit();
+      return;
+
+    case CalibrationStep::DARK_OFFSET:
+      menu.startCalibrationCountdown();
+      for (int s = 0; s < NUM_SENSORS; s++) {
+        if (!(job.sensorMask & sensorBit(s))) continue;
+        ColorHelper* sensor = &colorHelpers[s];
+        selectSensor(s);
+        Serial.print("Initial r,g,b dark offsets:");
+        Serial.print(sensor->rDark);
+        Serial.print(", ");
+        Serial.print(sensor->gDark);
+        Serial.print(", ");
+        Serial.println(sensor->bDark);
+        sensor->calibrateDark();
+        Serial.print("Adjusted r,g,b dark offsets:");
+        Serial.print(sensor->rDark);
+        Serial.print(", ");
+        Serial.print(sensor->gDark);
+        Serial.print(", ");
+        Serial.println(sensor->bDark);
+      }
+      return;
+
+    case CalibrationStep::RESET_DEFAULTS:
+      for (int s = 0; s < NUM_SENSORS; s++) {
+        if (job.sensorMask & sensorBit(s)) {
+          colorHelpers[s].resetCalibrationDefaults();
+        }
+      }
+      EEPROM.commit();
+      return;
+
+    case CalibrationStep::AUTO_ROTATION:
+      runAutoRotationCalibration(job.sensorMask);
+      return;
+
+    default:
+      break; // GAINS and the color steps sample below
+  }
+
+  bool whitePass = job.step == CalibrationStep::GAINS;
+  Color color = calibrationStepToColor(job.step);
+  if (!whitePass && color == Color::UNKNOWN) {
+    Serial.println("WARNING: SOMEHOW HIT UNSUPPORTED CALIBRATION CASE");
+    return;
+  }
+
+  menu.startCalibrationCountdown();
+  menu.calibrationStartProgressBar();
+  static CalibrationAccumulator acc[NUM_SENSORS]; // too big for the loop task's stack at 64 sensors
+  for (int s = 0; s < NUM_SENSORS; s++) {
+    acc[s] = CalibrationAccumulator();
+  }
+  delay(50);
+  // Keep sampling until every sensor's mean has settled; a quiet patch is
+  // usually done in well under NUM_CALIBRATION_STEPS samples
+  int samplesTaken = 0;
+  for (int i = 0; i < NUM_CALIBRATION_STEPS; i++) {
+    bool allConverged = true;
+    for (int s = 0; s < NUM_SENSORS; s++) {
+      if ((job.sensorMask & sensorBit(s)) && colorHelpers[s].isAvailable() && !acc[s].converged()) {
+        allConverged = false;
+      }
     }
-    else if(menu.pendingCalibrationD==PendingCalibrationD::GAINS){
-      Serial.print("Initial r,g,b gains:");
-      Serial.print(sensorD->rGain);
-      Serial.print(", ");
-      Serial.print(sensorD->gGain);
-      Serial.print(", ");
-      Serial.println(sensorD->bGain);
-      sensorD->calibrateWhiteGains();
-      Serial.print("Adjusted r,g,b gains:");
-      Serial.print(sensorD->rGain);
-      Serial.print(", ");
-      Serial.print(sensorD->gGain);
-      Serial.print(", ");
-      Serial.println(sensorD->bGain);
+    if (allConverged) {
+      break;
     }
-    else{
-Color selectedColor = menu.pendingCalibrationD==PendingCalibrationD::RED?Color::RED:
-                           menu.pendingCalibrationD==PendingCalibrationD::GREEN?Color::GREEN:
-                            menu.pendingCalibrationD==PendingCalibrationD::PURPLE?Color::PURPLE:
-                            menu.pendingCalibrationD==PendingCalibrationD::BLUE?Color::BLUE:
-                            menu.pendingCalibrationD==PendingCalibrationD::ORANGE?Color::ORANGE:
-                            menu.pendingCalibrationD==PendingCalibrationD::YELLOW?Color::YELLOW:
-                            menu.pendingCalibrationD==PendingCalibrationD::SILVER?Color::SILVER:
-                            menu.pendingCalibrationD==PendingCalibrationD::WHITE?Color::WHITE:                          menu.pendingCalibrationD==PendingCalibrationD::WHITE?Color::WHITE:
-                           Color::UNKNOWN;
-
-    sensorD->calibrateColor(selectedColor); //safety
-    
+    samplesTaken++;
+    for (int s = 0; s < NUM_SENSORS; s++) {
+      if (!(job.sensorMask & sensorBit(s)) || !colorHelpers[s].isAvailable() || acc[s].converged()) continue;
+      selectSensor(s);
+      if (whitePass) {
+        colorHelpers[s].sampleWhite(acc[s]);
+      } else {
+        colorHelpers[s].sampleCalibrated(acc[s]);
+      }
+    }
+    menu.calibrationIncrementProgressBar(i);
+    delay(100);
   }
-  menu.pendingCalibrationD = PendingCalibrationD::NONE;
-  menu.render();
-}
+  menu.calibrationIncrementProgressBar(NUM_CALIBRATION_STEPS);
+  Serial.print("Sampling passes: ");
+  Serial.println(samplesTaken);
+
+  for (int s = 0; s < NUM_SENSORS; s++) {
+    if (!(job.sensorMask & sensorBit(s))) continue;
+    if (acc[s].count == 0) {
+      Serial.print("Sensor #");
+      Serial.print(s);
+      Serial.println(" unavailable, skipped");
+      continue;
+    }
+    Serial.print("Sensor #");
+    Serial.print(s);
+    Serial.print(": ");
+    Serial.print(acc[s].count);
+    Serial.print(" samples, ");
+    Serial.print(acc[s].rejected);
+    Serial.print(" rejected, ");
+    Serial.print(acc[s].failed);
+    Serial.print(" failed reads, spread ");
+    Serial.print(acc[s].spread());
+    Serial.println(acc[s].converged() ? "" : " (did not settle)");
+    uint16_t avgR, avgG, avgB;
+    acc[s].average(&avgR, &avgG, &avgB);
+    if (whitePass) {
+      colorHelpers[s].applyWhiteCalibration(avgR, avgG, avgB, acc[s].spread());
+    } else {
+      colorHelpers[s].applyColorCalibration(color, avgR, avgG, avgB, acc[s].spread());
+    }
   }
+  EEPROM.commit(); // one flash write for the whole pass
+  Serial.println("Calibration job complete!");
+}
+
 
+// Record every sensor in the mask while the disk spins, then cluster each
+// sensor's readings into the NUM_COLORS centroids and store them all at once.
+// Sample buffers are ~2 KB per sensor, so large installations are recorded
+// AUTO_CAL_BATCH_SENSORS at a time, one recording window per batch.
+void runAutoRotationCalibration(SensorMask sensorMask){
+  menu.startCalibrationCountdown();
+
+  uint8_t batch[autoCalBatchSize];
+  uint8_t batchCount = 0;
+  for (int s = 0; s < NUM_SENSORS; s++) {
+    if (!(sensorMask & sensorBit(s)) || !colorHelpers[s].isAvailable()) continue;
+    batch[batchCount++] = s;
+    if (batchCount == autoCalBatchSize) {
+      recordRotationBatch(batch, batchCount);
+      batchCount = 0;
+    }
+  }
+  if (batchCount > 0) {
+    recordRotationBatch(batch, batchCount);
+  }
+  EEPROM.commit();
+  Serial.println("Auto calibration complete!");
+}
 
-void saveBCD(){
-      //// setup B
-      //dark
-      EEPROM.put(SENSOR_B_RDARK_ADDR, colorHelperB.rDark);
-      EEPROM.put(SENSOR_B_GDARK_ADDR, colorHelperB.gDark);
-      EEPROM.put(SENSOR_B_BDARK_ADDR, colorHelperB.bDark);
-      //gains
-      EEPROM.put(SENSOR_B_RW_ADDR, colorHelperB.rW);
-
-      EEPROM.put(SENSOR_B_GW_ADDR, colorHelperB.gW);
-      EEPROM.put(SENSOR_B_BW_ADDR, colorHelperB.bW);
-
-
-      /*
-      Color selectedColor = menu.pendingCalibrationA==PendingCalibrationA::RED?Color::RED:
-                           menu.pendingCalibrationA==PendingCalibrationA::GREEN?Color::GREEN:
-                            menu.pendingCalibrationA==PendingCalibrationA::PURPLE?Color::PURPLE:
-                            menu.pendingCalibrationA==PendingCalibrationA::BLUE?Color::BLUE:
-                            menu.pendingCalibrationA==PendingCalibrationA::ORANGE?Color::ORANGE:
-                            menu.pendingCalibrationA==PendingCalibrationA::YELLOW?Color::YELLOW:
-                            menu.pendingCalibrationA==PendingCalibrationA::SILVER?Color::SILVER:
-                            menu.pendingCalibrationA==PendingCalibrationA::WHITE?Color::WHITE:                          menu.pendingCalibrationA==PendingCalibrationA::WHITE?Color::WHITE:
-                           Color::UNKNOWN;
-      */
-      //calibrations
-      EEPROM.put(SENSOR_B_RED_CAL_ADDR, colorHelperB.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_B_GREEN_CAL_ADDR, colorHelperB.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_B_PURPLE_CAL_ADDR, colorHelperB.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_B_BLUE_CAL_ADDR, colorHelperB.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_B_ORANGE_CAL_ADDR, colorHelperB.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_B_YELLOW_CAL_ADDR, colorHelperB.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_B_SILVER_CAL_ADDR, colorHelperB.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_B_WHITE_CAL_ADDR, colorHelperB.calibrationDatabase[7]);
-
-      //// setup C
-      //dark
-      EEPROM.put(SENSOR_C_RDARK_ADDR, colorHelperC.rDark);
-      EEPROM.put(SENSOR_C_GDARK_ADDR, colorHelperC.gDark);
-      EEPROM.put(SENSOR_C_BDARK_ADDR, colorHelperC.bDark);
-      //gains
-      EEPROM.put(SENSOR_C_RW_ADDR, colorHelperC.rW);
-      EEPROM.put(SENSOR_C_GW_ADDR, colorHelperC.gW);
-      EEPROM.put(SENSOR_C_BW_ADDR, colorHelperC.bW);
-
-      //calibrations
-       EEPROM.put(SENSOR_C_RED_CAL_ADDR, colorHelperC.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_C_GREEN_CAL_ADDR, colorHelperC.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_C_PURPLE_CAL_ADDR, colorHelperC.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_C_BLUE_CAL_ADDR, colorHelperC.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_C_ORANGE_CAL_ADDR, colorHelperC.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_C_YELLOW_CAL_ADDR, colorHelperC.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_C_SILVER_CAL_ADDR, colorHelperC.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_C_WHITE_CAL_ADDR, colorHelperC.calibrationDatabase[7]);
-
-
-      //// setup D
-      //dark
-      EEPROM.put(SENSOR_D_RDARK_ADDR, colorHelperD.rDark);
-      EEPROM.put(SENSOR_D_GDARK_ADDR, colorHelperD.gDark);
-      EEPROM.put(SENSOR_D_BDARK_ADDR, colorHelperD.bDark);
-      //gains
-      EEPROM.put(SENSOR_D_RW_ADDR, colorHelperD.rW);
-      EEPROM.put(SENSOR_D_GW_ADDR, colorHelperD.gW);
-      EEPROM.put(SENSOR_D_BW_ADDR, colorHelperD.bW);
-
-      //calibrations
-      EEPROM.put(SENSOR_D_RED_CAL_ADDR, colorHelperD.calibrationDatabase[0]);
-      EEPROM.put(SENSOR_D_GREEN_CAL_ADDR, colorHelperD.calibrationDatabase[1]);
-      EEPROM.put(SENSOR_D_PURPLE_CAL_ADDR, colorHelperD.calibrationDatabase[2]);
-      EEPROM.put(SENSOR_D_BLUE_CAL_ADDR, colorHelperD.calibrationDatabase[3]);
-      EEPROM.put(SENSOR_D_ORANGE_CAL_ADDR, colorHelperD.calibrationDatabase[4]);
-      EEPROM.put(SENSOR_D_YELLOW_CAL_ADDR, colorHelperD.calibrationDatabase[5]);
-      EEPROM.put(SENSOR_D_SILVER_CAL_ADDR, colorHelperD.calibrationDatabase[6]);
-      EEPROM.put(SENSOR_D_WHITE_CAL_ADDR, colorHelperD.calibrationDatabase[7]);
+void recordRotationBatch(const uint8_t sensors[], uint8_t count){
+  Serial.print("Auto calibration: recording rotation for ");
+  Serial.print(count);
+  Serial.println(" sensors...");
+  menu.calibrationStartProgressBar();
 
+  for (int i = 0; i < count; i++) {
+    autoCalibrators[i].reset();
+  }
 
-      EEPROM.commit();
+  // Sweep the sensors no faster than the integration time, otherwise we'd
+  // just record the same conversion several times.
+  const unsigned long sweepInterval = SENSOR_INTEGRATION_MS;
+  unsigned long start = millis();
+  unsigned long lastSweep = 0;
+  uint8_t lastTick = 0;
+  bool buffersFull = false;
+  while (millis() - start < AUTO_CAL_RECORD_MS && !buffersFull) {
+    unsigned long now = millis();
+    if (now - lastSweep < sweepInterval) {
+      continue;
+    }
+    lastSweep = now;
+    buffersFull = true;
+    for (int i = 0; i < count; i++) {
+      uint8_t s = sensors[i];
+      selectSensor(s);
+      float r, g, b;
+      if (!colorHelpers[s].getCalibratedData(&r, &g, &b)) {
+        buffersFull = false; // a failed read is all zeros, not a black patch
+        continue;
+      }
+      if (autoCalibrators[i].addSample(r, g, b)) {
+        buffersFull = false;
+      }
+    }
+    uint8_t tick = (now - start) * NUM_CALIBRATION_STEPS / AUTO_CAL_RECORD_MS;
+    if (tick != lastTick) {
+      menu.calibrationIncrementProgressBar(tick);
+      lastTick = tick;
+    }
+  }
 
-      Serial.println("Saved B, C, and D calibration data to EEPROM");
+  for (int i = 0; i < count; i++) {
+    uint8_t s = sensors[i];
+    if (autoCalibrators[i].sampleCount() == 0) continue;
+#if AUTO_CAL_DUMP_SAMPLES
+    // In disk order, ready to paste into test/test_auto_calibrator
+    Serial.print("// sensor #");
+    Serial.println(s);
+    for (uint16_t n = 0; n < autoCalibrators[i].sampleCount(); n++) {
+      const ColorSample& sample = autoCalibrators[i].sample(n);
+      Serial.printf("    {%u, %u, %u},\n", sample.r, sample.g, sample.b);
+    }
+#endif
+    ColorCalibration centroids[NUM_COLORS];
+    uint16_t counts[NUM_COLORS];
+    uint8_t iterations = autoCalibrators[i].cluster(colorCalibrationDefaultDatabase, centroids, counts);
+
+    Serial.print("Sensor #");
+    Serial.print(s);
+    Serial.print(": ");
+    Serial.print(autoCalibrators[i].sampleCount());
+    Serial.print(" samples (");
+    Serial.print(autoCalibrators[i].boundaryCount());
+    Serial.print(" more on patch boundaries), k-means iterations: ");
+    Serial.println(iterations);
+
+    for (int k = 0; k < NUM_COLORS; k++) {
+      Color color = indexToColor(k);
+      if (counts[k] == 0) {
+        // Patch never showed up under this ring, keep what we had
+        Serial.print("  ");
+        Serial.print(colorToString(color));
+        Serial.println(" not seen, keeping previous centroid");
+        continue;
+      }
+      colorHelpers[s].applyColorCalibration(color, centroids[k].red, centroids[k].green, centroids[k].blue);
     }
+  }
+}
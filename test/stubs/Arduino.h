@@ -0,0 +1,111 @@
+#pragma once
+// Just enough of the ESP32 Arduino core for the hardware-independent modules
+// to build on the host ([env:native]). Time is whatever the test sets
+// stubMicros to; Serial output goes nowhere.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define HEX 16
+#define DEC 10
+
+using std::max;
+using std::min;
+
+template <class T, class L, class H>
+T constrain(T x, L low, H high) {
+    return x < low ? (T)low : (x > high ? (T)high : x);
+}
+
+inline uint32_t stubMicros = 0;
+inline unsigned long micros() { return stubMicros; }
+inline unsigned long millis() { return stubMicros / 1000; }
+inline void delay(unsigned long ms) { stubMicros += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { stubMicros += us; }
+inline void yield() {}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) { return 1; }
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            write(buffer[i]);
+        }
+        return size;
+    }
+    template <class T> size_t print(T) { return 0; }
+    template <class T> size_t print(T, int) { return 0; }
+    template <class T> size_t println(T) { return 0; }
+    template <class T> size_t println(T, int) { return 0; }
+    size_t println() { return 0; }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual int availableForWrite() { return 128; }
+    virtual void flush() {}
+};
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int) {}
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void setTxBufferSize(size_t) {}
+    void setRxBufferSize(size_t) {}
+    void onReceive(std::function<void(void)>, bool = false) {}
+    bool setRxFIFOFull(uint8_t) { return true; }
+};
+
+inline HardwareSerial Serial(0);
+
+// A 240 MHz cycle counter that follows stubMicros
+class EspClass {
+public:
+    uint32_t getCycleCount() { return stubMicros * 240; }
+};
+
+inline EspClass ESP;
+
+// FreeRTOS, as the ESP32 core pulls it in: no tasks run, the test calls
+// what the task would
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, unsigned,
+                                          TaskHandle_t*, int) {
+    return pdTRUE;
+}
+inline void vTaskDelay(TickType_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdTRUE; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+
+// esp32-hal-timer (core 2.x): never fires by itself; the test calls the
+// interrupt attached to timer n through stubTimerIsr[n]
+typedef struct hw_timer_s hw_timer_t;
+inline void (*stubTimerIsr[4])() = {nullptr, nullptr, nullptr, nullptr};
+inline hw_timer_t* timerBegin(uint8_t num, uint16_t, bool) { return (hw_timer_t*)(uintptr_t)(num + 1); }
+inline void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(), bool) {
+    stubTimerIsr[(uintptr_t)timer - 1] = isr;
+}
+inline void timerAlarmWrite(hw_timer_t*, uint64_t, bool) {}
+inline void timerAlarmEnable(hw_timer_t*) {}
+inline void timerAlarmDisable(hw_timer_t*) {}
+inline void timerWrite(hw_timer_t*, uint64_t) {}
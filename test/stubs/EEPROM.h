@@ -0,0 +1,25 @@
+#pragma once
+// ESP32 EEPROM library stand-in: a zeroed block of RAM
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    bool begin(size_t) { return true; }
+    uint8_t read(int address) { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    template <class T> T& get(int address, T& t) {
+        memcpy(&t, data + address, sizeof(T));
+        return t;
+    }
+    template <class T> const T& put(int address, const T& t) {
+        memcpy(data + address, &t, sizeof(T));
+        return t;
+    }
+    bool commit() { return true; }
+    size_t length() { return sizeof(data); }
+
+private:
+    uint8_t data[4096] = {0};
+};
+
+inline EEPROMClass EEPROM;
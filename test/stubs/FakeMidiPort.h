@@ -0,0 +1,56 @@
+#pragma once
+// MIDI OUT as the transmit queue sees it: a UART FIFO that empties at one
+// byte per MIDI_BYTE_US, with a record of every byte and when its start bit
+// went out. runMidi() stands in for the drain task and the gate timer.
+#include <Arduino.h>
+#include <vector>
+#include "SystemConfig.h"
+#include "MidiTxQueue.h"
+
+class FakeMidiPort : public HardwareSerial {
+public:
+    FakeMidiPort() : HardwareSerial(1) {}
+
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> startUs; // when each byte started on the wire
+
+    size_t write(uint8_t b) override {
+        uint32_t start = busy() ? wireFreeUs : stubMicros;
+        wireFreeUs = start + MIDI_BYTE_US;
+        bytes.push_back(b);
+        startUs.push_back(start);
+        return 1;
+    }
+    using Print::write;
+
+    int availableForWrite() override {
+        int queued = busy() ? (wireFreeUs - stubMicros + MIDI_BYTE_US - 1) / MIDI_BYTE_US : 0;
+        return MIDI_TX_FIFO_SIZE - queued;
+    }
+
+    // When the last byte written so far has left the wire
+    uint32_t idleAtUs() const { return wireFreeUs; }
+
+    void clear() {
+        bytes.clear();
+        startUs.clear();
+    }
+
+private:
+    uint32_t wireFreeUs = 0;
+
+    bool busy() const { return (int32_t)(wireFreeUs - stubMicros) > 0; }
+};
+
+// Run the drain task and the gate timer for `us`, polling every `stepUs`
+// (a divisor of GATE_TICK_US)
+inline void runMidi(MidiTxQueue& queue, uint32_t us, uint32_t stepUs = 10) {
+    uint32_t end = stubMicros + us;
+    for (; (int32_t)(end - stubMicros) > 0; stubMicros += stepUs) {
+        if (stubMicros % GATE_TICK_US == 0 && stubTimerIsr[GATE_TIMER] != nullptr) {
+            stubTimerIsr[GATE_TIMER]();
+        }
+        while (queue.drainOnce()) {
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+// Two revolutions of calibrated readings from one sensor, in the order
+// recordRotationBatch() takes them: each patch with the white background
+// after it, and a blend of the two at every boundary.
+//
+// Synthesized, not captured: the sensor reads ~5% more red, ~3% less green
+// and +800 blue against the default database, with 220 counts of noise per
+// channel. Captures made with AUTO_CAL_DUMP_SAMPLES paste in the same way.
+#include "AutoCalibrator.h"
+
+// What the sensor reads on each patch, indexed by Color
+static const ColorCalibration ringPatchReadings[NUM_COLORS] = {
+    {38430, 11010, 15750}, // red
+    {13282, 26287, 26200}, // green
+    {19414, 17557, 33100}, // purple
+    {12390, 20370, 39500}, // blue
+    {34755, 13968, 14700}, // orange
+    {25935, 20952, 14300}, // yellow
+    {22386, 19885, 23090}, // silver
+    {21840, 20195, 22700}, // white
+};
+
+// Every patch on the ring (308 readings)
+static const ColorSample ringAllPatches[] = {
+    {27709, 16946, 20241}, {38645, 10704, 15742}, {38687, 10706, 15850}, {38454, 10915, 16162},
+    {38504, 10670, 15903}, {38669, 11013, 15722}, {38274, 11456, 15590}, {38479, 11020, 15247},
+    {38296, 10897, 15854}, {38383, 11035, 15792}, {38662, 10850, 15754}, {38449, 11163, 15574},
+    {38476, 11426, 15806}, {38134, 10900, 16020}, {39064, 11081, 15664}, {31245, 14988, 18760},
+    {21778, 19854, 22912}, {21750, 20353, 22413}, {21744, 20472, 23015}, {21553, 19902, 22690},
+    {22000, 20230, 22767}, {21622, 20324, 22946}, {29346, 16576, 18050}, {34658, 13778, 14457},
+    {34853, 14015, 14437}, {34555, 14127, 14764}, {34767, 13786, 14098}, {34572, 13846, 14825},
+    {34983, 14343, 14658}, {34332, 13860, 14730}, {35018, 14244, 14615}, {34586, 14012, 14173},
+    {34591, 14353, 14714}, {34952, 13554, 14676}, {34355, 13688, 14667}, {34688, 14001, 14896},
+    {34547, 14049, 14948}, {28375, 17044, 18652}, {21714, 20354, 22401}, {21766, 20010, 22542},
+    {21996, 20223, 22829}, {22102, 20448, 22398}, {21958, 19808, 22686}, {22262, 20152, 22619},
+    {23096, 20427, 20124}, {26303, 20986, 14300}, {26041, 20809, 14157}, {26053, 21007, 14168},
+    {25912, 20902, 14643}, {25749, 21006, 14253}, {25943, 20778, 14450}, {25975, 21050, 14512},
+    {25780, 21028, 14590}, {25953, 20911, 14423}, {25949, 20927, 14172}, {25842, 20634, 14151},
+    {25892, 21341, 14240}, {25779, 20936, 14169}, {25758, 20780, 14211}, {23673, 20534, 18940},
+    {22013, 20262, 23140}, {21750, 20044, 23108}, {21647, 20679, 22691}, {21612, 20195, 22729},
+    {21884, 20153, 22938}, {21330, 20073, 22642}, {16302, 24137, 24965}, {13621, 26231, 25986},
+    {13270, 26202, 26322}, {13175, 26079, 26236}, {13379, 26194, 26041}, {13087, 26287, 26526},
+    {12941, 26433, 26217}, {12978, 26860, 26241}, {13086, 26363, 26521}, {13549, 25852, 25947},
+    {13660, 26190, 25966}, {13442, 26272, 26186}, {13191, 26521, 26624}, {13368, 26648, 25859},
+    {13034, 26151, 26348}, {16846, 23750, 24742}, {22041, 19973, 23141}, {21710, 20379, 22909},
+    {21889, 20233, 23095}, {22036, 20293, 22299}, {21676, 20451, 22743}, {21630, 20054, 22633},
+    {18696, 20253, 28289}, {12341, 20830, 39040}, {12193, 20199, 39546}, {12485, 19968, 39827},
+    {12415, 20461, 39559}, {12437, 20328, 39543}, {13044, 20274, 39552}, {12471, 20512, 39496},
+    {12288, 20552, 39386}, {12864, 20280, 39454}, {12552, 20270, 39515}, {12354, 20319, 40125},
+    {12431, 20286, 39784}, {12209, 20429, 39949}, {12578, 20942, 39390}, {15646, 20310, 33712},
+    {21906, 20493, 22973}, {21805, 20072, 22400}, {21824, 20469, 22642}, {21995, 20351, 22787},
+    {22078, 20170, 22518}, {21582, 20399, 22620}, {20814, 19080, 27096}, {19324, 17727, 33367},
+    {19032, 17492, 33288}, {19136, 17478, 32964}, {19320, 17720, 33121}, {19664, 17679, 33178},
+    {19451, 17437, 32963}, {19481, 17309, 33183}, {19317, 17165, 33096}, {19889, 17807, 33277},
+    {19751, 17964, 33061}, {19370, 17652, 32608}, {19370, 17431, 33549}, {19718, 17933, 33288},
+    {19452, 17883, 32873}, {21022, 19306, 26206}, {22037, 19888, 22649}, {21712, 20077, 22753},
+    {21768, 19876, 22699}, {21920, 20584, 22609}, {21578, 20111, 22844}, {21646, 20036, 22822},
+    {22060, 20070, 22857}, {22700, 19933, 22842}, {22529, 20075, 23169}, {22459, 19972, 23066},
+    {22799, 19707, 23223}, {22264, 19781, 23360}, {22399, 19567, 23088}, {22076, 20012, 23071},
+    {22225, 19634, 23098}, {22421, 20109, 22645}, {22208, 20038, 23003}, {22344, 19830, 23327},
+    {22500, 19978, 23000}, {22432, 19432, 22962}, {22699, 20009, 22918}, {22069, 20065, 22864},
+    {21815, 19900, 22990}, {21472, 20472, 22629}, {21915, 20344, 22758}, {22120, 20199, 22628},
+    {21694, 19877, 22547}, {22056, 20377, 23006}, {27087, 17290, 20502}, {38827, 10963, 15630},
+    {38305, 11486, 15460}, {38674, 11302, 15926}, {38159, 10937, 15523}, {38951, 10742, 15457},
+    {38697, 10890, 15804}, {38378, 11112, 16218}, {38128, 11228, 15953}, {38338, 11070, 15703},
+    {38589, 11010, 15730}, {38517, 11230, 16056}, {38471, 10681, 15493}, {38479, 11183, 15580},
+    {38384, 10866, 15664}, {28917, 16277, 19735}, {21942, 19808, 22972}, {21794, 19763, 22725},
+    {21874, 19911, 22566}, {21960, 20506, 22951}, {22109, 20442, 22153}, {21680, 20236, 22109},
+    {26420, 17987, 19863}, {34468, 13967, 14602}, {34996, 13800, 14911}, {34993, 13969, 14522},
+    {34813, 13658, 14927}, {34651, 13734, 14572}, {34584, 13974, 14719}, {34704, 14261, 15005},
+    {34475, 13321, 14655}, {34350, 14068, 14394}, {34952, 14155, 14685}, {34902, 14236, 14496},
+    {34715, 14186, 14705}, {34555, 14069, 14888}, {34532, 13920, 14232}, {27012, 17701, 19496},
+    {21476, 20212, 22498}, {21594, 20041, 22536}, {21626, 19969, 23055}, {21692, 20409, 22391},
+    {21960, 19920, 22599}, {21980, 20078, 22268}, {23960, 20587, 18351}, {26175, 21292, 14054},
+    {25959, 21204, 14374}, {25927, 20722, 14103}, {26189, 21212, 14332}, {26253, 20840, 14026},
+    {26129, 20833, 14208}, {26055, 21394, 14290}, {26021, 21082, 14066}, {25757, 21146, 14289},
+    {25802, 20753, 14015}, {26004, 20792, 14177}, {25833, 20827, 14249}, {26044, 20524, 14225},
+    {26072, 21288, 14222}, {23324, 20469, 19655}, {22303, 20285, 22562}, {21706, 19856, 22855},
+    {21872, 20056, 22607}, {21746, 20430, 22660}, {22144, 20011, 22565}, {21734, 20076, 22680},
+    {18800, 22359, 23943}, {13238, 26084, 26201}, {13119, 26217, 25857}, {13246, 26385, 25996},
+    {13436, 26401, 26283}, {13561, 26388, 26318}, {13183, 26622, 26274}, {13507, 25766, 26047},
+    {13151, 26345, 26106}, {13247, 26195, 25992}, {13434, 26191, 26293}, {13329, 26692, 25918},
+    {13350, 26370, 26539}, {13140, 26546, 26797}, {12901, 26664, 26313}, {18785, 22370, 23949},
+    {21748, 20391, 22268}, {21602, 19829, 22966}, {21847, 20069, 22733}, {21820, 20394, 22957},
+    {22041, 20270, 22868}, {22019, 20451, 22296}, {18871, 20250, 27978}, {12781, 20527, 39670},
+    {12437, 20441, 39565}, {12699, 20424, 39489}, {12055, 20553, 39232}, {12151, 20568, 39809},
+    {12330, 20373, 39577}, {12660, 20254, 39324}, {12633, 20122, 39401}, {12581, 20447, 39375},
+    {12467, 20539, 39342}, {12208, 20074, 39485}, {12039, 20372, 39333}, {12515, 20351, 39877},
+    {12179, 20413, 39442}, {15570, 20311, 33847}, {21936, 19967, 22264}, {22303, 20457, 22768},
+    {21732, 20235, 22427}, {22051, 20231, 22667}, {21745, 20180, 22729}, {21751, 20407, 22746},
+    {20401, 18631, 28868}, {19369, 17664, 33210}, {19031, 17673, 32953}, {19267, 17632, 32916},
+    {19345, 17353, 33427}, {19695, 17478, 33353}, {19610, 16936, 33308}, {19334, 17147, 33018},
+    {19154, 17888, 32849}, {19381, 17681, 32917}, {19608, 17723, 33216}, {19355, 17527, 33227},
+    {19121, 17485, 33271}, {19297, 17713, 33098}, {19155, 17434, 33080}, {21029, 19313, 26176},
+    {21750, 20369, 23257}, {22097, 19713, 22762}, {22363, 19939, 22901}, {21381, 20544, 22514},
+    {22018, 20396, 22088}, {21525, 20268, 22365}, {22167, 20009, 22933}, {22047, 20287, 22951},
+    {22211, 19286, 23226}, {22255, 19858, 23290}, {22655, 19443, 22906}, {22476, 20093, 23080},
+    {22316, 20109, 23251}, {22376, 19989, 23067}, {22696, 19797, 23075}, {22771, 20074, 23006},
+    {22280, 19915, 23055}, {22098, 20200, 23046}, {22212, 20115, 22903}, {22695, 19537, 22795},
+    {22535, 19376, 22944}, {22048, 20077, 22848}, {21779, 19796, 22869}, {21838, 20305, 23048},
+    {21874, 19933, 22477}, {21858, 20486, 22436}, {21786, 20163, 22845}, {21644, 20264, 22872},
+};
+
+// The same sensor on a ring without the purple patch (308 readings)
+static const ColorSample ringNoPurple[] = {
+    {33161, 13927, 17957}, {38501, 10986, 16110}, {38642, 10981, 15424}, {38323, 11290, 15523},
+    {38250, 11137, 15946}, {38153, 11229, 16287}, {38413, 10780, 15685}, {38423, 11069, 15992},
+    {38472, 10920, 15946}, {38639, 10841, 15600}, {38370, 11203, 15779}, {38602, 11209, 16080},
+    {38427, 11203, 16174}, {38534, 10667, 16061}, {38223, 11061, 15551}, {26943, 17370, 20562},
+    {21967, 20164, 22709}, {21491, 19932, 22765}, {21340, 20226, 22285}, {21838, 19918, 23062},
+    {22038, 20051, 22249}, {21636, 20153, 22449}, {26860, 17774, 19590}, {34601, 14272, 14942},
+    {35170, 13913, 15181}, {34553, 14482, 14629}, {34504, 13651, 14664}, {34593, 13868, 14769},
+    {35009, 14249, 14576}, {35118, 14154, 14628}, {34280, 14099, 15039}, {35053, 14083, 14677},
+    {34911, 14042, 14626}, {34328, 13908, 14705}, {34906, 14137, 14543}, {34743, 13913, 14612},
+    {34858, 13925, 14619}, {25949, 18214, 20155}, {22191, 20251, 22868}, {21862, 20245, 22581},
+    {21976, 20504, 22651}, {21883, 20321, 22692}, {22037, 20241, 22429}, {21600, 20346, 22830},
+    {23119, 20431, 20076}, {25579, 21071, 14270}, {25462, 20968, 13862}, {25866, 20713, 14350},
+    {26255, 20911, 14393}, {25510, 21096, 14503}, {26145, 20745, 14465}, {26280, 21390, 14283},
+    {26235, 20915, 14320}, {25822, 20909, 14354}, {25955, 21004, 14384}, {25762, 20755, 14810},
+    {25882, 21112, 14294}, {25778, 21009, 14041}, {25768, 21059, 13971}, {24286, 20647, 17682},
+    {21602, 20320, 22759}, {21842, 20105, 22758}, {21813, 20034, 22813}, {21922, 20213, 22853},
+    {21596, 20163, 22584}, {22133, 20307, 23166}, {15976, 24370, 25098}, {13251, 26054, 25911},
+    {13261, 26504, 26272}, {13145, 26265, 26529}, {13502, 26109, 26398}, {13548, 26144, 26045},
+    {13893, 26257, 26231}, {13242, 26194, 26055}, {13678, 26269, 26165}, {13066, 26355, 26050},
+    {13295, 26214, 26154}, {13236, 26495, 26281}, {13247, 26292, 26056}, {13084, 26192, 25842},
+    {13366, 26198, 26269}, {16266, 24163, 24980}, {22215, 20403, 22347}, {21408, 20178, 22654},
+    {21634, 19874, 22657}, {21585, 20043, 22890}, {21892, 20029, 22453}, {21799, 20576, 22588},
+    {15482, 20313, 34003}, {12485, 20212, 39529}, {12643, 20356, 39732}, {12178, 19925, 39152},
+    {12181, 20540, 39617}, {12514, 20368, 39429}, {12431, 20771, 39741}, {12707, 20347, 39628},
+    {12523, 20408, 39826}, {12291, 20155, 39394}, {12374, 19849, 39363}, {12394, 20271, 39153},
+    {12354, 20349, 39966}, {12057, 20453, 38908}, {12797, 20429, 39219}, {15772, 20307, 33487},
+    {21790, 20214, 22324}, {21584, 20306, 22938}, {21617, 20220, 22573}, {21339, 20126, 22461},
+    {22032, 20148, 22691}, {21518, 20226, 22271}, {21840, 20195, 22700}, {21678, 20041, 22398},
+    {21315, 20173, 22675}, {21502, 20272, 22937}, {21627, 20211, 22663}, {22173, 20071, 22325},
+    {21544, 20271, 22633}, {21990, 19851, 22813}, {22185, 20072, 22626}, {21880, 20082, 22521},
+    {21688, 20188, 22984}, {21694, 20226, 22784}, {21822, 20449, 22705}, {22008, 19920, 22707},
+    {21587, 20105, 22523}, {21840, 20195, 22700}, {21788, 20194, 23023}, {22017, 20364, 23025},
+    {21888, 19976, 22524}, {21495, 20273, 22611}, {21953, 20379, 22521}, {21880, 20475, 22718},
+    {22215, 19982, 22968}, {22203, 20088, 22914}, {22546, 20015, 22953}, {22236, 19681, 22616},
+    {22269, 20249, 23280}, {22280, 20184, 23181}, {22079, 19555, 23353}, {22646, 20057, 22880},
+    {22557, 20118, 22773}, {22256, 19748, 23116}, {22628, 19905, 23266}, {22489, 19857, 23180},
+    {22191, 19758, 23235}, {22601, 19999, 23209}, {22592, 19763, 23541}, {22021, 20092, 22829},
+    {21546, 20307, 22877}, {21756, 20326, 22795}, {21963, 20503, 22555}, {21987, 20240, 22546},
+    {21952, 19904, 22368}, {22080, 19948, 23078}, {32961, 14038, 18041}, {38093, 11004, 16094},
+    {38315, 11013, 15306}, {38768, 10865, 15931}, {38406, 10775, 15522}, {38282, 11173, 16002},
+    {38923, 10858, 15949}, {38541, 10922, 15861}, {38402, 11211, 15786}, {38119, 11390, 16027},
+    {38180, 10756, 15857}, {38465, 11425, 15611}, {38545, 10929, 15654}, {38227, 11469, 15851},
+    {38499, 11057, 15910}, {30663, 15310, 19004}, {21840, 20397, 22704}, {22003, 20042, 22572},
+    {21578, 20465, 22814}, {21886, 20333, 22512}, {21861, 20079, 22279}, {21779, 19997, 23020},
+    {28868, 16807, 18347}, {34157, 14434, 14506}, {34911, 13828, 14569}, {34910, 13715, 14467},
+    {34611, 14625, 14638}, {34886, 13764, 14472}, {34896, 14069, 14730}, {34870, 13965, 15007},
+    {34628, 14044, 14655}, {34620, 14337, 14804}, {34761, 13888, 14809}, {34953, 14229, 15192},
+    {35075, 13926, 14643}, {34887, 13871, 14420}, {34788, 14135, 14899}, {30569, 15986, 17293},
+    {21993, 20663, 22817}, {21599, 20009, 22291}, {22003, 20392, 22774}, {21921, 20313, 22795},
+    {21985, 20245, 22477}, {22051, 20495, 22330}, {24244, 20639, 17769}, {25445, 20930, 14354},
+    {26024, 21080, 14019}, {25988, 21160, 14231}, {26158, 20753, 14397}, {26054, 20568, 14070},
+    {25840, 20872, 14666}, {26093, 20939, 14201}, {25609, 20922, 14254}, {25795, 20905, 14399},
+    {26207, 20763, 14056}, {25918, 20610, 14232}, {25946, 21009, 13895}, {26087, 20697, 14441},
+    {25970, 21195, 14497}, {23815, 20560, 18649}, {22054, 20701, 23167}, {21775, 20017, 22741},
+    {21945, 20592, 22646}, {21671, 20428, 22536}, {21645, 20314, 22655}, {21602, 20134, 22606},
+    {16868, 23734, 24733}, {13215, 26766, 26244}, {13475, 26074, 26148}, {12789, 26207, 26314},
+    {13643, 26152, 25838}, {13053, 26365, 26059}, {13487, 26283, 26343}, {13140, 26308, 25918},
+    {13337, 26238, 26325}, {12937, 26019, 26253}, {13582, 26039, 25816}, {13204, 26115, 26311},
+    {13686, 26276, 26233}, {13382, 26181, 26126}, {13460, 26274, 26553}, {17023, 23624, 24670},
+    {21626, 20279, 22721}, {21803, 20092, 22644}, {22016, 20439, 22643}, {21897, 19780, 22443},
+    {21682, 19992, 22854}, {21375, 20303, 22851}, {15358, 20315, 34223}, {12522, 20304, 39371},
+    {11961, 20082, 39314}, {12231, 20346, 39518}, {12467, 20309, 39396}, {12232, 20219, 38963},
+    {12618, 20176, 39657}, {12278, 20475, 39544}, {12658, 20409, 39413}, {12701, 20260, 39825},
+    {12504, 20155, 39653}, {12602, 20526, 39119}, {12342, 20070, 39333}, {12375, 20215, 39748},
+    {12429, 20454, 39588}, {16441, 20295, 32298}, {21544, 20124, 22381}, {21422, 20420, 22868},
+    {22120, 20365, 22588}, {21886, 20075, 23000}, {21319, 20284, 22577}, {21998, 20460, 22560},
+    {21840, 20195, 22700}, {21885, 19991, 22996}, {21739, 20353, 22260}, {21266, 20161, 22898},
+    {21872, 20210, 22676}, {21452, 19462, 22605}, {21412, 20438, 22827}, {21658, 20045, 22360},
+    {22029, 20230, 22757}, {21362, 19879, 22853}, {21549, 20063, 23158}, {22000, 20236, 22811},
+    {21387, 19800, 22976}, {22067, 20385, 22846}, {21906, 20204, 22723}, {21840, 20195, 22700},
+    {21661, 20195, 22658}, {21781, 19927, 22671}, {21439, 20474, 22862}, {22006, 19989, 22753},
+    {22123, 20148, 22464}, {21816, 19696, 22907}, {22178, 20003, 22942}, {22307, 19780, 22995},
+    {22322, 19857, 23128}, {22218, 19303, 22905}, {22168, 19884, 23328}, {22161, 19936, 23071},
+    {22540, 19887, 22547}, {22519, 19609, 23274}, {22419, 20201, 22591}, {22113, 19800, 23025},
+    {22233, 19836, 22886}, {22526, 19684, 22945}, {22146, 19646, 23037}, {22738, 19776, 22861},
+    {22512, 20177, 22872}, {22080, 20059, 22871}, {21946, 20167, 22449}, {21662, 19652, 22859},
+    {22054, 20151, 22421}, {21590, 20126, 22503}, {21901, 20001, 22896}, {22099, 20062, 22518},
+};
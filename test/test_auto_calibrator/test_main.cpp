@@ -0,0 +1,102 @@
+// AutoCalibrator on recorded revolutions (revolution.h): the centroids it
+// finds and the colors it maps them to
+#include <unity.h>
+#include "revolution.h"
+
+// colorCalibrationDefaultDatabase (ColorHelper.cpp needs the sensor library)
+static const ColorCalibration defaultSeeds[NUM_COLORS] = {
+    {36600, 11350, 14950}, // red
+    {12650, 27100, 25400}, // green
+    {18490, 18100, 32300}, // purple
+    {11800, 21000, 38700}, // blue
+    {33100, 14400, 13900}, // orange
+    {24700, 21600, 13500}, // yellow
+    {21320, 20500, 22290}, // silver
+    {20800, 20820, 21900}, // white
+};
+
+// A 28-reading patch with 220 counts of noise averages to within ~45
+#define CENTROID_TOLERANCE 150
+
+static AutoCalibrator calibrator;
+static ColorCalibration centroids[NUM_COLORS];
+static uint16_t counts[NUM_COLORS];
+
+static uint8_t clusterRing(const ColorSample* samples, uint16_t n) {
+    calibrator.reset();
+    for (uint16_t i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(calibrator.addSample(samples[i].r, samples[i].g, samples[i].b));
+    }
+    return calibrator.cluster(defaultSeeds, centroids, counts);
+}
+
+static void assertCentroid(uint8_t k) {
+    TEST_ASSERT_UINT_WITHIN(CENTROID_TOLERANCE, ringPatchReadings[k].red, centroids[k].red);
+    TEST_ASSERT_UINT_WITHIN(CENTROID_TOLERANCE, ringPatchReadings[k].green, centroids[k].green);
+    TEST_ASSERT_UINT_WITHIN(CENTROID_TOLERANCE, ringPatchReadings[k].blue, centroids[k].blue);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_every_patch_found_and_named() {
+    uint8_t iterations = clusterRing(ringAllPatches, sizeof(ringAllPatches) / sizeof(ringAllPatches[0]));
+    TEST_ASSERT_GREATER_THAN(0, iterations);
+    TEST_ASSERT_LESS_OR_EQUAL(AUTO_CAL_MAX_ITERATIONS, iterations);
+    // Seven patches, a boundary each side, two revolutions
+    TEST_ASSERT_UINT_WITHIN(4, 28, calibrator.boundaryCount());
+    for (uint8_t k = 0; k < NUM_COLORS; k++) {
+        // Two passes over each patch, less what was trimmed as a boundary
+        TEST_ASSERT_GREATER_OR_EQUAL(20, counts[k]);
+        assertCentroid(k);
+    }
+    // Silver and the white background are ~700 apart: not swapped
+    TEST_ASSERT_GREATER_THAN(centroids[colorToIndex(Color::WHITE)].red, centroids[colorToIndex(Color::SILVER)].red);
+    TEST_ASSERT_GREATER_OR_EQUAL(60, counts[colorToIndex(Color::WHITE)]);
+}
+
+void test_missing_patch_keeps_its_seed() {
+    clusterRing(ringNoPurple, sizeof(ringNoPurple) / sizeof(ringNoPurple[0]));
+    uint8_t purple = colorToIndex(Color::PURPLE);
+    TEST_ASSERT_EQUAL_UINT16(0, counts[purple]);
+    TEST_ASSERT_EQUAL_UINT32(defaultSeeds[purple].red, centroids[purple].red);
+    TEST_ASSERT_EQUAL_UINT32(defaultSeeds[purple].green, centroids[purple].green);
+    TEST_ASSERT_EQUAL_UINT32(defaultSeeds[purple].blue, centroids[purple].blue);
+    for (uint8_t k = 0; k < NUM_COLORS; k++) {
+        if (k != purple) {
+            TEST_ASSERT_GREATER_OR_EQUAL(20, counts[k]);
+            assertCentroid(k);
+        }
+    }
+}
+
+void test_recording_can_start_anywhere_on_the_ring() {
+    const uint16_t n = sizeof(ringAllPatches) / sizeof(ringAllPatches[0]);
+    ColorSample rotated[n];
+    for (uint16_t i = 0; i < n; i++) {
+        rotated[i] = ringAllPatches[(i + 97) % n];
+    }
+    clusterRing(rotated, n);
+    for (uint8_t k = 0; k < NUM_COLORS; k++) {
+        assertCentroid(k);
+    }
+}
+
+void test_buffer_holds_max_samples() {
+    calibrator.reset();
+    for (uint16_t i = 0; i < AUTO_CAL_MAX_SAMPLES; i++) {
+        TEST_ASSERT_TRUE(calibrator.addSample(20000, 20000, 20000));
+    }
+    TEST_ASSERT_FALSE(calibrator.addSample(20000, 20000, 20000));
+    TEST_ASSERT_EQUAL_UINT16(AUTO_CAL_MAX_SAMPLES, calibrator.sampleCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_patch_found_and_named);
+    RUN_TEST(test_missing_patch_keeps_its_seed);
+    RUN_TEST(test_recording_can_start_anywhere_on_the_ring);
+    RUN_TEST(test_buffer_holds_max_samples);
+    return UNITY_END();
+}
@@ -0,0 +1,88 @@
+// CalibrationQueue: merging, and the order a transfer pass runs its steps in
+#include <unity.h>
+#include <vector>
+#include "CalibrationQueue.h"
+
+#define B_C_D (sensorBit(1) | sensorBit(2) | sensorBit(3))
+#define RED_BLUE ((1 << 0) | (1 << 3))
+
+static CalibrationQueue queue;
+
+static std::vector<CalibrationJob> drain() {
+    std::vector<CalibrationJob> jobs;
+    CalibrationJob job;
+    while (queue.pop(job)) {
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+static void assertJob(const CalibrationJob& job, CalibrationStep step, SensorMask mask) {
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)step, (uint8_t)job.step);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)mask, (uint32_t)job.sensorMask);
+}
+
+void setUp() {
+    queue.clear();
+}
+
+void tearDown() {}
+
+void test_same_step_merges() {
+    queue.enqueue(CalibrationStep::RED, sensorBit(0));
+    queue.enqueue(CalibrationStep::GREEN, sensorBit(0));
+    queue.enqueue(CalibrationStep::RED, sensorBit(2));
+    std::vector<CalibrationJob> jobs = drain();
+    TEST_ASSERT_EQUAL_UINT32(2, jobs.size());
+    assertJob(jobs[0], CalibrationStep::RED, sensorBit(0) | sensorBit(2));
+}
+
+void test_transfer_pass_measures_references_after_white() {
+    queue.enqueueTransferPass(B_C_D, RED_BLUE);
+    std::vector<CalibrationJob> jobs = drain();
+    TEST_ASSERT_EQUAL_UINT32(5, jobs.size());
+    assertJob(jobs[0], CalibrationStep::GAINS, B_C_D);
+    assertJob(jobs[1], CalibrationStep::WHITE, B_C_D);
+    assertJob(jobs[2], CalibrationStep::RED, B_C_D);
+    assertJob(jobs[3], CalibrationStep::BLUE, B_C_D);
+    assertJob(jobs[4], CalibrationStep::TRANSFER_FROM_A, B_C_D);
+}
+
+void test_colors_queued_before_move_behind_the_gains() {
+    // Orange on B and A, yellow on C, then the transfer
+    queue.enqueue(CalibrationStep::ORANGE, sensorBit(0) | sensorBit(1));
+    queue.enqueue(CalibrationStep::YELLOW, sensorBit(2));
+    queue.enqueueTransferPass(B_C_D, 0);
+    std::vector<CalibrationJob> jobs = drain();
+    TEST_ASSERT_EQUAL_UINT32(6, jobs.size());
+    assertJob(jobs[0], CalibrationStep::ORANGE, sensorBit(0)); // A's own stays where it was
+    assertJob(jobs[1], CalibrationStep::GAINS, B_C_D);
+    assertJob(jobs[2], CalibrationStep::WHITE, B_C_D);
+    assertJob(jobs[3], CalibrationStep::ORANGE, B_C_D);
+    assertJob(jobs[4], CalibrationStep::YELLOW, B_C_D);
+    assertJob(jobs[5], CalibrationStep::TRANSFER_FROM_A, B_C_D);
+}
+
+void test_transfer_pass_after_a_full_pass() {
+    // A's full pass is waiting: the transfer shares its gains and white, and
+    // its references, but the transfer itself goes last
+    queue.enqueueFullPass(sensorBit(0));
+    queue.enqueueTransferPass(B_C_D, RED_BLUE);
+    std::vector<CalibrationJob> jobs = drain();
+    TEST_ASSERT_EQUAL_UINT32(2 + (NUM_COLORS - 1) + 1, jobs.size());
+    assertJob(jobs[0], CalibrationStep::GAINS, sensorBit(0) | B_C_D);
+    assertJob(jobs[1], CalibrationStep::WHITE, sensorBit(0) | B_C_D);
+    assertJob(jobs[2], CalibrationStep::RED, sensorBit(0) | B_C_D);
+    assertJob(jobs[5], CalibrationStep::BLUE, sensorBit(0) | B_C_D);
+    assertJob(jobs[6], CalibrationStep::ORANGE, sensorBit(0));
+    assertJob(jobs.back(), CalibrationStep::TRANSFER_FROM_A, B_C_D);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_step_merges);
+    RUN_TEST(test_transfer_pass_measures_references_after_white);
+    RUN_TEST(test_colors_queued_before_move_behind_the_gains);
+    RUN_TEST(test_transfer_pass_after_a_full_pass);
+    return UNITY_END();
+}
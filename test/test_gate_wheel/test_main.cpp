@@ -0,0 +1,222 @@
+// GateWheel on its own (due ticks, whole turns, flush), and gate mode through
+// the transmit queue: gate length, ratchet spacing and releaseGates()
+#include <unity.h>
+#include <random>
+#include "FakeMidiPort.h"
+#include "GateWheel.h"
+
+struct Fired {
+    uint32_t tick;
+    GateEvent event;
+};
+
+static std::vector<Fired> fired;
+static GateWheel* wheel;
+
+static void record(const GateEvent& event, void* context) {
+    fired.push_back({wheel->now(), event});
+}
+
+static GateEvent tagged(uint8_t seq) {
+    GateEvent event = {60, 1, 100, false, 0, seq, false};
+    return event;
+}
+
+void setUp() {
+    fired.clear();
+}
+
+void tearDown() {}
+
+void test_fires_on_the_due_tick_in_order() {
+    GateWheel w;
+    wheel = &w;
+    std::mt19937 rng(7);
+    uint32_t due[GATE_MAX_EVENTS];
+    for (uint8_t i = 0; i < GATE_MAX_EVENTS; i++) {
+        uint32_t delay = 1 + rng() % 2000; // up to eight turns
+        TEST_ASSERT_TRUE(w.schedule(delay, tagged(i)));
+        due[i] = w.now() + delay;
+        if (i % 10 == 0) {
+            w.advanceTo(w.now() + rng() % 40, record, nullptr);
+        }
+    }
+    w.advanceTo(w.now() + 2100, record, nullptr);
+
+    TEST_ASSERT_EQUAL_UINT32(GATE_MAX_EVENTS, fired.size());
+    TEST_ASSERT_EQUAL_UINT16(0, w.pending());
+    for (size_t k = 0; k < fired.size(); k++) {
+        TEST_ASSERT_EQUAL_UINT32(due[fired[k].event.seq], fired[k].tick);
+        if (k > 0 && fired[k].tick == fired[k - 1].tick) {
+            TEST_ASSERT_GREATER_THAN(fired[k - 1].event.seq, fired[k].event.seq); // scheduling order
+        }
+    }
+}
+
+void test_delay_beyond_one_turn() {
+    GateWheel w;
+    wheel = &w;
+    w.advanceTo(17, record, nullptr);
+    const uint32_t delays[] = {300, GATE_WHEEL_SLOTS, GATE_WHEEL_SLOTS + 1, 3 * GATE_WHEEL_SLOTS - 1};
+    for (uint32_t delay : delays) {
+        fired.clear();
+        uint32_t start = w.now();
+        w.schedule(delay, tagged(1));
+        w.advanceTo(start + delay - 1, record, nullptr);
+        TEST_ASSERT_EQUAL_UINT32(0, fired.size()); // not a turn early
+        w.advanceTo(start + delay, record, nullptr);
+        TEST_ASSERT_EQUAL_UINT32(1, fired.size());
+        TEST_ASSERT_EQUAL_UINT32(start + delay, fired[0].tick);
+    }
+
+    // 0 counts as the next tick
+    fired.clear();
+    w.schedule(0, tagged(2));
+    w.advanceTo(w.now() + 1, record, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(1, fired.size());
+}
+
+static void ratchet(const GateEvent& event, void* context) {
+    record(event, context);
+    if (event.repeats > 0) {
+        GateEvent next = event;
+        next.repeats--;
+        wheel->schedule(*(uint32_t*)context, next);
+    }
+}
+
+void test_rescheduling_from_fire_keeps_spacing() {
+    GateWheel w;
+    wheel = &w;
+    // A full turn apart too: the repeat lands in the slot being expired
+    const uint32_t spacings[] = {3, 125, GATE_WHEEL_SLOTS};
+    for (uint32_t spacing : spacings) {
+        fired.clear();
+        GateEvent event = {60, 2, 100, true, 3, 0, true};
+        w.schedule(spacing, event);
+        w.advanceTo(w.now() + 5 * spacing, ratchet, &spacing);
+        TEST_ASSERT_EQUAL_UINT32(4, fired.size());
+        for (size_t k = 1; k < fired.size(); k++) {
+            TEST_ASSERT_EQUAL_UINT32(spacing, fired[k].tick - fired[k - 1].tick);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, w.pending());
+}
+
+void test_flush_empties_in_tick_order() {
+    GateWheel w;
+    wheel = &w;
+    w.advanceTo(200, record, nullptr);
+    // Out of order, some further than a turn away
+    const uint32_t delays[] = {400, 10, GATE_WHEEL_SLOTS - 1, 90, 1};
+    for (uint8_t i = 0; i < 5; i++) {
+        w.schedule(delays[i], tagged(i));
+    }
+    w.flush(record, nullptr);
+    TEST_ASSERT_EQUAL_UINT16(0, w.pending());
+    const uint8_t order[] = {4, 1, 3, 0, 2}; // by slot from the next tick; 400 is slot 144
+    TEST_ASSERT_EQUAL_UINT32(5, fired.size());
+    for (uint8_t k = 0; k < 5; k++) {
+        TEST_ASSERT_EQUAL_UINT8(order[k], fired[k].event.seq);
+    }
+
+    // The pool is whole again
+    fired.clear();
+    for (uint8_t i = 0; i < GATE_MAX_EVENTS; i++) {
+        TEST_ASSERT_TRUE(w.schedule(5, tagged(i)));
+    }
+    TEST_ASSERT_FALSE(w.schedule(5, tagged(0)));
+    TEST_ASSERT_EQUAL_UINT32(1, w.overflows());
+    w.advanceTo(w.now() + 5, record, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(GATE_MAX_EVENTS, fired.size());
+}
+
+static FakeMidiPort port;
+static MidiEncoder encoder(port);
+static MidiTxQueue midiTx(port, encoder);
+
+struct WireNote {
+    uint32_t us; // start of its first byte
+    bool on;
+    uint8_t note;
+};
+
+static std::vector<WireNote> wireNotes() {
+    std::vector<WireNote> notes;
+    uint8_t status = 0;
+    uint8_t have = 0;
+    uint8_t note = 0;
+    uint32_t firstUs = 0;
+    for (size_t i = 0; i < port.bytes.size(); i++) {
+        uint8_t b = port.bytes[i];
+        if (b & 0x80) {
+            status = b;
+            have = 0;
+            firstUs = port.startUs[i];
+        } else if (have++ == 0) {
+            note = b;
+            if (i == 0 || !(port.bytes[i - 1] & 0x80)) {
+                firstUs = port.startUs[i]; // running status
+            }
+        } else {
+            have = 0;
+            notes.push_back({firstUs, (status & 0xF0) == 0x90 && b > 0, note});
+        }
+    }
+    port.clear();
+    return notes;
+}
+
+void test_ratchets_through_the_queue() {
+    midiTx.setGate(120, 2, 50); // three strikes 50 ms apart, gate cut to 49 ms
+    runMidi(midiTx, 5000);
+    port.clear();
+    midiTx.noteOn(60, 100, 1, true);
+    runMidi(midiTx, 300000);
+
+    std::vector<WireNote> notes = wireNotes();
+    TEST_ASSERT_EQUAL_UINT32(6, notes.size());
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(notes[2 * i].on);
+        TEST_ASSERT_FALSE(notes[2 * i + 1].on);
+        TEST_ASSERT_UINT_WITHIN(GATE_TICK_US, 49000, notes[2 * i + 1].us - notes[2 * i].us);
+        if (i > 0) {
+            TEST_ASSERT_UINT_WITHIN(GATE_TICK_US, 50000, notes[2 * i].us - notes[2 * i - 2].us);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.gatesDropped());
+}
+
+void test_release_gates_sends_offs_and_drops_repeats() {
+    midiTx.setGate(500, 3, 600);
+    for (uint8_t n = 0; n < 8; n++) {
+        midiTx.noteOn(40 + n, 100, 3, true);
+    }
+    runMidi(midiTx, 10000);
+    uint32_t releasedUs = stubMicros;
+    midiTx.releaseGates();
+    runMidi(midiTx, 2000000);
+
+    std::vector<WireNote> notes = wireNotes();
+    uint8_t ons = 0;
+    for (const WireNote& n : notes) {
+        if (n.on) {
+            ons++;
+        } else {
+            TEST_ASSERT_LESS_THAN(releasedUs + 10000, n.us); // now, not at the gate's end
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8(8, ons);
+    TEST_ASSERT_EQUAL_UINT32(16, notes.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fires_on_the_due_tick_in_order);
+    RUN_TEST(test_delay_beyond_one_turn);
+    RUN_TEST(test_rescheduling_from_fire_keeps_spacing);
+    RUN_TEST(test_flush_empties_in_tick_order);
+    RUN_TEST(test_ratchets_through_the_queue);
+    RUN_TEST(test_release_gates_sends_offs_and_drops_repeats);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+// MIDI clock output through the real transmit queue: drainOnce() and its
+// clock guard against a modelled UART FIFO, under a full load of notes, CCs
+// and thru traffic (tools/midi_clock_sim.py models the same thing in Python)
+#include <unity.h>
+#include <random>
+#include "FakeMidiPort.h"
+
+#define POLL_US 10 // how often the simulated drain task runs
+
+static FakeMidiPort port;
+static MidiEncoder encoder(port);
+static MidiTxQueue midiTx(port, encoder);
+
+struct ClockRun {
+    uint32_t ticks = 0;
+    uint32_t worstLateUs = 0;  // start bit of a tick after it was due
+    uint32_t notesQueued = 0;
+};
+
+// `ms` of traffic with a tick every `periodUs`; `guarded`: the queue is told
+// when ticks are due, as MidiClock does
+static ClockRun runClock(uint32_t periodUs, uint32_t ms, bool guarded) {
+    std::mt19937 rng(7);
+    ClockRun run;
+    std::vector<uint32_t> dueUs;
+    uint32_t nextTickUs = stubMicros + periodUs;
+    if (guarded) {
+        midiTx.scheduleClockTick(nextTickUs);
+    }
+    port.clear();
+
+    uint32_t end = stubMicros + ms * 1000UL;
+    for (; (int32_t)(end - stubMicros) > 0; stubMicros += POLL_US) {
+        uint32_t r = rng() % 1000;
+        if (r < 4) {
+            uint8_t note = 36 + rng() % 48;
+            uint8_t channel = 1 + rng() % 4;
+            midiTx.noteOff(note, 0, channel);
+            midiTx.noteOn(note + 1, 100, channel);
+            run.notesQueued += 2;
+        } else if (r < 6) {
+            midiTx.forward(0x95, 60 + rng() % 12, 90); // thru from the input
+        }
+        midiTx.controlChange(20 + rng() % 8, rng() & 0x7F, 2); // a busy CC stream
+        if ((int32_t)(stubMicros - nextTickUs) >= 0) {
+            midiTx.clockTickFromISR(nextTickUs, nextTickUs + periodUs);
+            dueUs.push_back(nextTickUs);
+            nextTickUs += periodUs;
+        }
+        while (midiTx.drainOnce()) {
+        }
+    }
+    if (guarded) {
+        midiTx.clockStopped();
+    }
+    runMidi(midiTx, 100000);
+
+    for (size_t i = 0; i < port.bytes.size(); i++) {
+        if (port.bytes[i] != 0xF8) {
+            continue;
+        }
+        uint32_t late = port.startUs[i] - dueUs[run.ticks++];
+        if (late > run.worstLateUs) {
+            run.worstLateUs = late;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(dueUs.size(), run.ticks);
+    return run;
+}
+
+void setUp() {
+    runMidi(midiTx, 100000);
+    midiTx.resetMaxima();
+}
+
+void tearDown() {}
+
+void test_tick_finds_the_wire_idle_at_120_bpm() {
+    uint32_t sentBefore = midiTx.sent(MIDI_PRIORITY_URGENT) + midiTx.sent(MIDI_PRIORITY_NOTE);
+    ClockRun run = runClock(20833, 4000, true);
+    TEST_ASSERT_GREATER_THAN(180, run.ticks);
+    // Nothing on the wire when a tick comes due: it goes on the next poll
+    TEST_ASSERT_LESS_OR_EQUAL(POLL_US, run.worstLateUs);
+    TEST_ASSERT_LESS_OR_EQUAL(POLL_US, midiTx.maxClockLatenessUs());
+    // and the guard holds the rest back without losing any of it
+    uint32_t sent = midiTx.sent(MIDI_PRIORITY_URGENT) + midiTx.sent(MIDI_PRIORITY_NOTE) - sentBefore;
+    TEST_ASSERT_EQUAL_UINT32(run.notesQueued, sent + midiTx.staleNoteOns());
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.dropped(MIDI_PRIORITY_NOTE));
+}
+
+void test_tick_finds_the_wire_idle_at_300_bpm() {
+    ClockRun run = runClock(8333, 2000, true);
+    TEST_ASSERT_GREATER_THAN(230, run.ticks);
+    TEST_ASSERT_LESS_OR_EQUAL(POLL_US, run.worstLateUs);
+}
+
+void test_without_the_guard_ticks_wait_for_the_wire() {
+    ClockRun guarded = runClock(20833, 4000, true);
+    ClockRun unguarded = runClock(20833, 4000, false);
+    // Whatever is in the FIFO goes first: note-offs and thru fill it up
+    TEST_ASSERT_GREATER_THAN(3 * MIDI_BYTE_US, unguarded.worstLateUs);
+    TEST_ASSERT_LESS_OR_EQUAL(MIDI_TX_FIFO_SIZE * MIDI_BYTE_US + POLL_US, unguarded.worstLateUs);
+    TEST_ASSERT_LESS_OR_EQUAL(POLL_US, guarded.worstLateUs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_tick_finds_the_wire_idle_at_120_bpm);
+    RUN_TEST(test_tick_finds_the_wire_idle_at_300_bpm);
+    RUN_TEST(test_without_the_guard_ticks_wait_for_the_wire);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+// MidiEncoder: the exact bytes it puts on the wire
+#include <unity.h>
+#include <vector>
+#include "MidiEncoder.h"
+
+class Capture : public Print {
+public:
+    std::vector<uint8_t> bytes;
+    size_t write(uint8_t b) override {
+        bytes.push_back(b);
+        return 1;
+    }
+    using Print::write;
+};
+
+static Capture wire;
+
+static void assertWire(const std::vector<uint8_t>& expected) {
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), wire.bytes.size());
+    if (!expected.empty()) { // Unity fails a zero-length array compare
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), wire.bytes.data(), expected.size());
+    }
+    wire.bytes.clear();
+}
+
+void setUp() {
+    stubMicros = 0;
+    wire.bytes.clear();
+}
+
+void tearDown() {}
+
+void test_running_status_leaves_out_repeated_status() {
+    MidiEncoder encoder(wire);
+    encoder.noteOn(60, 100, 3);
+    encoder.noteOn(64, 90, 3);
+    encoder.controlChange(1, 5, 3);
+    encoder.controlChange(1, 6, 3);
+    encoder.noteOn(67, 80, 4); // another channel is another status byte
+    assertWire({0x92, 60, 100, 64, 90, 0xB2, 1, 5, 1, 6, 0x93, 67, 80});
+    TEST_ASSERT_EQUAL_UINT32(13, encoder.bytesSent());
+    TEST_ASSERT_EQUAL_UINT32(2, encoder.bytesSaved());
+}
+
+void test_note_off_is_note_on_velocity_zero() {
+    MidiEncoder encoder(wire);
+    // A color change: old note off, new note on, one run
+    encoder.noteOff(60, 64, 3);
+    encoder.noteOn(62, 100, 3);
+    encoder.noteOff(62, 0, 3);
+    assertWire({0x92, 60, 0, 62, 100, 62, 0});
+
+    encoder.setNoteOffAsNoteOn(false);
+    encoder.noteOff(64, 64, 3);
+    encoder.noteOff(65, 0, 3);
+    assertWire({0x82, 64, 64, 65, 0});
+
+    encoder.setRunningStatus(false);
+    encoder.noteOn(5, 6, 3);
+    encoder.noteOn(6, 6, 3);
+    assertWire({0x92, 5, 6, 0x92, 6, 6});
+}
+
+void test_status_refreshed_after_one_second() {
+    MidiEncoder encoder(wire);
+    encoder.noteOn(60, 100, 1);
+    stubMicros = (MIDI_RUNNING_STATUS_REFRESH_MS - 1) * 1000UL;
+    encoder.noteOn(61, 100, 1);
+    assertWire({0x90, 60, 100, 61, 100});
+
+    // Counted from when the status byte last went out, not the last message
+    stubMicros = MIDI_RUNNING_STATUS_REFRESH_MS * 1000UL;
+    encoder.noteOn(62, 100, 1);
+    encoder.noteOn(63, 100, 1);
+    assertWire({0x90, 62, 100, 63, 100});
+
+    stubMicros = (2 * MIDI_RUNNING_STATUS_REFRESH_MS - 1) * 1000UL;
+    encoder.noteOn(64, 100, 1);
+    assertWire({64, 100});
+}
+
+void test_real_time_byte_keeps_running_status() {
+    MidiEncoder encoder(wire);
+    encoder.noteOn(60, 100, 1);
+    encoder.realTime(0xF8);
+    encoder.noteOn(61, 100, 1);
+    encoder.realTime(0xFA);
+    encoder.noteOff(60, 0, 1);
+    assertWire({0x90, 60, 100, 0xF8, 61, 100, 0xFA, 60, 0});
+}
+
+void test_forwarded_message_and_invalid_channel() {
+    MidiEncoder encoder(wire);
+    encoder.noteOn(60, 100, 1);
+    encoder.message(0x90, 61, 100); // forwarded, same status as ours
+    encoder.message(0xC0, 5, 0);    // program change: one data byte
+    encoder.message(0xC0, 6, 0);
+    encoder.noteOn(1, 2, 0);        // channels outside 1-16 are dropped
+    encoder.noteOn(1, 2, 17);
+    encoder.noteOn(62, 100, 1);
+    assertWire({0x90, 60, 100, 61, 100, 0xC0, 5, 6, 0x90, 62, 100});
+
+    encoder.resetRunningStatus();
+    encoder.noteOn(63, 100, 1);
+    assertWire({0x90, 63, 100});
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_running_status_leaves_out_repeated_status);
+    RUN_TEST(test_note_off_is_note_on_velocity_zero);
+    RUN_TEST(test_status_refreshed_after_one_second);
+    RUN_TEST(test_real_time_byte_keeps_running_status);
+    RUN_TEST(test_forwarded_message_and_invalid_channel);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+// MIDI input: MidiInParser and MidiInput::feed() on byte streams
+#include <unity.h>
+#include <vector>
+#include "MidiInput.h"
+
+static std::vector<MidiInMessage> parse(const std::vector<uint8_t>& bytes, MidiInParser& parser) {
+    std::vector<MidiInMessage> out;
+    MidiInMessage msg;
+    for (uint8_t b : bytes) {
+        if (parser.feed(b, msg)) {
+            out.push_back(msg);
+        }
+    }
+    return out;
+}
+
+static std::vector<MidiInMessage> parse(const std::vector<uint8_t>& bytes) {
+    MidiInParser parser;
+    return parse(bytes, parser);
+}
+
+static void assertMessage(const MidiInMessage& msg, uint8_t status, uint8_t data1, uint8_t data2) {
+    TEST_ASSERT_EQUAL_HEX8(status, msg.status);
+    TEST_ASSERT_EQUAL_UINT8(data1, msg.data1);
+    TEST_ASSERT_EQUAL_UINT8(data2, msg.data2);
+}
+
+void setUp() {
+    stubMicros = 0;
+}
+
+void tearDown() {}
+
+void test_running_status() {
+    std::vector<MidiInMessage> out = parse({0x90, 60, 100, 62, 100, 0x80, 60, 0, 61, 0});
+    TEST_ASSERT_EQUAL_UINT32(4, out.size());
+    assertMessage(out[0], 0x90, 60, 100);
+    assertMessage(out[1], 0x90, 62, 100);
+    assertMessage(out[2], 0x80, 60, 0);
+    assertMessage(out[3], 0x80, 61, 0);
+
+    // One data byte per program change
+    out = parse({0xC0, 5, 6});
+    TEST_ASSERT_EQUAL_UINT32(2, out.size());
+    assertMessage(out[1], 0xC0, 6, 0);
+}
+
+void test_real_time_between_data_bytes() {
+    std::vector<MidiInMessage> out = parse({0xB3, 0xF8, 7, 0xFA, 100, 0xF8, 8, 0xFE, 101});
+    TEST_ASSERT_EQUAL_UINT32(6, out.size());
+    assertMessage(out[0], 0xF8, 0, 0);
+    assertMessage(out[1], 0xFA, 0, 0);
+    assertMessage(out[2], 0xB3, 7, 100); // carried on around the real-time bytes
+    assertMessage(out[3], 0xF8, 0, 0);
+    assertMessage(out[4], 0xFE, 0, 0);
+    assertMessage(out[5], 0xB3, 8, 101); // and running status with it
+}
+
+void test_sysex_cancels_running_status() {
+    MidiInParser parser;
+    // F0 ... F7 and its contents are dropped, and so are the data bytes
+    // after it, which must not be taken for running status
+    std::vector<MidiInMessage> out = parse({0x90, 60, 1, 0xF0, 0x7E, 0x01, 0xF7, 60, 1, 0x91, 61, 2}, parser);
+    TEST_ASSERT_EQUAL_UINT32(2, out.size());
+    assertMessage(out[0], 0x90, 60, 1);
+    assertMessage(out[1], 0x91, 61, 2);
+    TEST_ASSERT_EQUAL_UINT32(6, parser.skippedBytes());
+
+    // A real-time byte inside SysEx still comes out
+    out = parse({0xF0, 0x01, 0xF8, 0x02, 0xF7});
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());
+    assertMessage(out[0], 0xF8, 0, 0);
+}
+
+void test_system_common_cancels_running_status() {
+    std::vector<MidiInMessage> out = parse({0x90, 60, 1, 0xF2, 1, 2, 60, 1});
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());
+    out = parse({0x90, 60, 1, 0xF6, 60, 1, 0x90, 62, 1}); // tune request: no data
+    TEST_ASSERT_EQUAL_UINT32(2, out.size());
+    assertMessage(out[1], 0x90, 62, 1);
+
+    // A reset in the middle of a message is sent on; the message is lost
+    out = parse({0x90, 60, 0xFF, 61});
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());
+    assertMessage(out[0], 0xFF, 0, 0);
+}
+
+static std::vector<MidiInMessage> forwarded;
+
+static void collectThru(const MidiInMessage& msg) {
+    forwarded.push_back(msg);
+}
+
+static void feed(MidiInput& input, const std::vector<uint8_t>& bytes) {
+    for (uint8_t b : bytes) {
+        input.feed(b, stubMicros);
+    }
+}
+
+void test_feed_forwards_whole_messages() {
+    MidiInput input(Serial);
+    forwarded.clear();
+    input.setThru(collectThru);
+    feed(input, {0x92, 60, 0xF8, 100, 61, 100, 0xF0, 1, 0xF7, 0xB2, 7});
+    TEST_ASSERT_EQUAL_UINT32(3, forwarded.size());
+    assertMessage(forwarded[0], 0xF8, 0, 0);
+    assertMessage(forwarded[1], 0x92, 60, 100);
+    assertMessage(forwarded[2], 0x92, 61, 100);
+    TEST_ASSERT_EQUAL_UINT32(11, input.bytesReceived());
+}
+
+void test_feed_decodes_remote_control() {
+    MidiInput input(Serial);
+    RemoteCommand command;
+    uint8_t cc = 0xB0 | (MIDI_IN_CONTROL_CHANNEL - 1);
+
+    feed(input, {cc, MIDI_IN_CC_SCALE, 1});
+    TEST_ASSERT_TRUE(input.nextCommand(command));
+    TEST_ASSERT_EQUAL(REMOTE_SCALE, command.target);
+    TEST_ASSERT_EQUAL_UINT8(1, command.value);
+
+    feed(input, {(uint8_t)(cc - 1), MIDI_IN_CC_SCALE, 1}); // another channel
+    TEST_ASSERT_FALSE(input.nextCommand(command));
+
+    // NRPN 1/2 = 7: octave of sensor 2, with running status
+    feed(input, {cc, 99, 1, 98, 2, 6, 7});
+    TEST_ASSERT_TRUE(input.nextCommand(command));
+    TEST_ASSERT_EQUAL(REMOTE_OCTAVE, command.target);
+    TEST_ASSERT_EQUAL_UINT8(2, command.sensor);
+    TEST_ASSERT_EQUAL_UINT8(7, command.value);
+
+    // NRPN 2/3 = 15: channel 16 for sensor 3, a clock tick in the middle
+    feed(input, {cc, 99, 2, 98, 3, 0xF8, 6, 15});
+    TEST_ASSERT_TRUE(input.nextCommand(command));
+    TEST_ASSERT_EQUAL(REMOTE_CHANNEL, command.target);
+    TEST_ASSERT_EQUAL_UINT8(3, command.sensor);
+    TEST_ASSERT_EQUAL_UINT8(16, command.value);
+
+    // Data entry goes on writing the same NRPN
+    feed(input, {cc, 6, 4});
+    TEST_ASSERT_TRUE(input.nextCommand(command));
+    TEST_ASSERT_EQUAL(REMOTE_CHANNEL, command.target);
+    TEST_ASSERT_EQUAL_UINT8(5, command.value);
+
+    feed(input, {cc, 101, 0, 100, 0, 6, 2}); // an RPN is not ours
+    TEST_ASSERT_FALSE(input.nextCommand(command));
+    feed(input, {cc, 99, 1, 98, NUM_SENSORS, 6, 3}); // no such sensor
+    TEST_ASSERT_FALSE(input.nextCommand(command));
+
+    feed(input, {cc, MIDI_IN_CC_ROOT, 5});
+    TEST_ASSERT_TRUE(input.nextCommand(command));
+    TEST_ASSERT_EQUAL(REMOTE_ROOT, command.target);
+    TEST_ASSERT_EQUAL_UINT8(5, command.value);
+}
+
+void test_feed_follows_clock_and_transport() {
+    MidiInput input(Serial);
+    TEST_ASSERT_EQUAL(MIDI_TRANSPORT_FREE, input.transport());
+    feed(input, {0xFA});
+    TEST_ASSERT_EQUAL(MIDI_TRANSPORT_RUNNING, input.transport());
+    // 120 BPM is a tick every 20833 us; +-300 us of jitter
+    for (int i = 0; i < 48; i++) {
+        stubMicros += 20833 + ((i % 2) ? 300 : -300);
+        input.feed(0xF8, stubMicros);
+    }
+    TEST_ASSERT_EQUAL_UINT32(48, input.clockTicks());
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, 120.0f, input.bpm());
+    feed(input, {0xFC});
+    TEST_ASSERT_EQUAL(MIDI_TRANSPORT_STOPPED, input.transport());
+    stubMicros += (MIDI_IN_CLOCK_TIMEOUT_MS + 100) * 1000UL;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, input.bpm());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_running_status);
+    RUN_TEST(test_real_time_between_data_bytes);
+    RUN_TEST(test_sysex_cancels_running_status);
+    RUN_TEST(test_system_common_cancels_running_status);
+    RUN_TEST(test_feed_forwards_whole_messages);
+    RUN_TEST(test_feed_decodes_remote_control);
+    RUN_TEST(test_feed_follows_clock_and_transport);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+// MIDI Thru: random input streams through MidiInput and MidiTxQueue::forward(),
+// merged on the wire with our own notes and CCs. A strict parser of the
+// output must find every message whole, running status valid throughout,
+// and the forwarded messages all there, in the order they arrived.
+#include <unity.h>
+#include <random>
+#include "FakeMidiPort.h"
+#include "MidiInput.h"
+
+#define STREAM_MS 20000
+#define LOCAL_CHANNELS 4 // ours are 1-4, the input's 9-16
+
+static FakeMidiPort port;
+static MidiEncoder encoder(port);
+static MidiTxQueue midiTx(port, encoder);
+
+struct Message {
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+
+    bool operator==(const Message& other) const {
+        return status == other.status && data1 == other.data1 && data2 == other.data2;
+    }
+};
+
+static uint8_t dataBytes(uint8_t status) {
+    uint8_t type = status & 0xF0;
+    return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+// What a keyboard or sequencer might send: running status, real-time bytes
+// between data bytes, SysEx and system common. `expected` gets the channel
+// and real-time messages in the order they complete.
+class InputStream {
+public:
+    std::vector<Message> expected;
+
+    explicit InputStream(uint32_t seed) : rng(seed) {}
+
+    void next(std::vector<uint8_t>& out) {
+        uint8_t r = rng() % 100;
+        if (r < 4) {
+            out.insert(out.end(), {0xF0, 0x7E, (uint8_t)(rng() & 0x7F), 0x06, 0xF7});
+            lastStatus = 0;
+            return;
+        }
+        if (r < 6) {
+            out.insert(out.end(), {0xF2, (uint8_t)(rng() & 0x7F), (uint8_t)(rng() & 0x7F)});
+            lastStatus = 0;
+            return;
+        }
+        if (r < 10) {
+            realTime(out);
+            return;
+        }
+        static const uint8_t types[] = {0x80, 0x90, 0x90, 0xA0, 0xB0, 0xB0, 0xC0, 0xD0, 0xE0};
+        uint8_t status = types[rng() % sizeof(types)] | (8 + rng() % 8);
+        if (rng() % 4 != 0 && lastStatus != 0) {
+            status = lastStatus; // a run
+        }
+        Message msg = {status, (uint8_t)(rng() & 0x7F), 0};
+        if (dataBytes(status) == 2) {
+            msg.data2 = rng() & 0x7F;
+        }
+        if (status != lastStatus) {
+            out.push_back(status);
+        }
+        lastStatus = status;
+        out.push_back(msg.data1);
+        if (dataBytes(status) == 2) {
+            if (rng() % 8 == 0) {
+                realTime(out); // between the data bytes
+            }
+            out.push_back(msg.data2);
+        }
+        expected.push_back(msg);
+    }
+
+private:
+    std::mt19937 rng;
+    uint8_t lastStatus = 0;
+
+    void realTime(std::vector<uint8_t>& out) {
+        static const uint8_t bytes[] = {0xF8, 0xF8, 0xF8, 0xFA, 0xFB, 0xFC, 0xFE};
+        uint8_t b = bytes[rng() % sizeof(bytes)];
+        out.push_back(b);
+        expected.push_back({b, 0, 0});
+    }
+};
+
+// The receiving end, strict: no status byte may cut a message short, and
+// every data byte needs a status to run on
+static void parseWire(const std::vector<uint8_t>& bytes, std::vector<Message>& thru, uint32_t& local) {
+    uint8_t status = 0;
+    uint8_t data[2];
+    uint8_t have = 0;
+    for (uint8_t b : bytes) {
+        if (b >= 0xF8) {
+            thru.push_back({b, 0, 0});
+            continue;
+        }
+        TEST_ASSERT_TRUE_MESSAGE(b < 0xF0, "system common or SysEx on the output");
+        if (b & 0x80) {
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, have, "message split by a status byte");
+            status = b;
+            continue;
+        }
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, status, "data byte without a status");
+        data[have++] = b;
+        if (have < dataBytes(status)) {
+            continue;
+        }
+        have = 0;
+        if ((status & 0x0F) >= 8) {
+            thru.push_back({status, data[0], dataBytes(status) == 2 ? data[1] : (uint8_t)0});
+        } else {
+            local++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, have, "last message cut short");
+}
+
+static void forwardMidi(const MidiInMessage& msg) {
+    midiTx.forward(msg.status, msg.data1, msg.data2);
+}
+
+// `inputPercent`: how busy the input wire is; our own traffic on top
+static void runMerge(uint32_t seed, uint8_t inputPercent) {
+    std::mt19937 rng(seed ^ 0x5A5A);
+    InputStream stream(seed);
+    MidiInput input(Serial);
+    input.setThru(forwardMidi);
+    std::vector<uint8_t> incoming;
+    size_t fed = 0;
+    uint32_t localQueued = 0;
+    uint8_t held[LOCAL_CHANNELS] = {60, 60, 60, 60};
+    uint32_t nextInputUs = stubMicros;
+    uint32_t dropsBefore = midiTx.dropped(MIDI_PRIORITY_THRU);
+    uint32_t staleBefore = midiTx.staleNoteOns();
+    port.clear();
+    encoder.resetRunningStatus(); // the capture starts here
+
+    uint32_t end = stubMicros + STREAM_MS * 1000UL;
+    for (; (int32_t)(end - stubMicros) > 0; stubMicros += 10) {
+        // One byte off the input wire at a time
+        if ((int32_t)(stubMicros - nextInputUs) >= 0) {
+            nextInputUs += MIDI_BYTE_US;
+            if (rng() % 100 < inputPercent) {
+                if (fed == incoming.size()) {
+                    stream.next(incoming);
+                }
+                input.feed(incoming[fed++], stubMicros);
+            }
+        }
+        uint32_t r = rng() % 2000;
+        if (r < 2) {
+            uint8_t c = rng() % LOCAL_CHANNELS;
+            midiTx.noteOff(held[c], 0, c + 1);
+            held[c] = 36 + rng() % 48;
+            midiTx.noteOn(held[c], 100, c + 1);
+            localQueued += 2;
+        } else if (r < 6) {
+            midiTx.controlChange(20 + rng() % 4, rng() & 0x7F, 1 + rng() % LOCAL_CHANNELS);
+        }
+        while (midiTx.drainOnce()) {
+        }
+    }
+    // Finish the message in progress, then let everything out
+    while (fed < incoming.size()) {
+        input.feed(incoming[fed++], stubMicros);
+    }
+    runMidi(midiTx, 200000);
+
+    std::vector<Message> thru;
+    uint32_t local = 0;
+    parseWire(port.bytes, thru, local);
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.dropped(MIDI_PRIORITY_THRU) - dropsBefore);
+    TEST_ASSERT_EQUAL_UINT32(stream.expected.size(), thru.size());
+    for (size_t i = 0; i < thru.size(); i++) {
+        TEST_ASSERT_TRUE_MESSAGE(stream.expected[i] == thru[i], "forwarded message out of order or changed");
+    }
+    // Our notes went out too (bar note-ons overtaken by their note-off), CCs on top
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.dropped(MIDI_PRIORITY_NOTE) + midiTx.dropped(MIDI_PRIORITY_URGENT));
+    TEST_ASSERT_GREATER_THAN(localQueued - (midiTx.staleNoteOns() - staleBefore), local);
+}
+
+void setUp() {
+    runMidi(midiTx, 100000);
+}
+
+void tearDown() {}
+
+void test_light_input_merges_whole() {
+    runMerge(1, 30);
+}
+
+void test_busy_input_merges_whole() {
+    runMerge(2, 70);
+    runMerge(3, 70);
+}
+
+void test_merge_without_running_status() {
+    encoder.setRunningStatus(false);
+    runMerge(4, 50);
+    encoder.setRunningStatus(true);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_light_input_merges_whole);
+    RUN_TEST(test_busy_input_merges_whole);
+    RUN_TEST(test_merge_without_running_status);
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// Property test of the note path: random color changes, channel changes and
+// panics from four sensors that share notes, through NoteOutput (NoteBurst,
+// ActiveNotes) and a transmit queue that is sometimes left to back up. Whenever the output
+// has caught up, the synth on the other end must hold exactly the notes the
+// sensors think are sounding, and at the end nothing.
+#include <unity.h>
+#include <random>
+#include "FakeMidiPort.h"
+#include "ActiveNotes.h"
+#include "NoteOutput.h"
+#include "ScaleManager.h"
+#include "SensorChannel.h"
+
+#define SENSORS 4
+#define STEPS 200000
+#define STEP_US 2000 // ~90 color changes a second, about a third of what the wire carries
+
+static FakeMidiPort port;
+static MidiEncoder encoder(port);
+static MidiTxQueue midiTx(port, encoder);
+static ActiveNotes activeNotes;
+static NoteBurst noteBurst;
+static NoteOutput noteOutput(midiTx, activeNotes, noteBurst);
+static SensorChannel channels[SENSORS];
+
+// What a receiver makes of the bytes: notes held per channel
+class Synth {
+public:
+    bool held[16][128] = {{false}};
+
+    void read(const std::vector<uint8_t>& bytes) {
+        for (; readTo < bytes.size(); readTo++) {
+            uint8_t b = bytes[readTo];
+            if (b >= 0xF8) {
+                continue; // real-time, even between data bytes
+            }
+            if (b & 0x80) {
+                status = b;
+                have = 0;
+                continue;
+            }
+            data[have++] = b;
+            if (have < 2) {
+                continue;
+            }
+            have = 0;
+            uint8_t type = status & 0xF0;
+            if (type == 0x90 && data[1] > 0) {
+                held[status & 0x0F][data[0]] = true;
+            } else if (type == 0x80 || type == 0x90) {
+                held[status & 0x0F][data[0]] = false;
+            }
+        }
+    }
+
+    // The bytes read so far were cleared from the capture
+    void rewind() { readTo = 0; }
+
+    uint16_t count() const {
+        uint16_t n = 0;
+        for (uint8_t c = 0; c < 16; c++) {
+            for (uint8_t note = 0; note < 128; note++) {
+                n += held[c][note] ? 1 : 0;
+            }
+        }
+        return n;
+    }
+
+private:
+    size_t readTo = 0;
+    uint8_t status = 0;
+    uint8_t data[2];
+    uint8_t have = 0;
+};
+
+static Synth synth;
+
+static void change(uint8_t s, uint8_t colorIndex, VoicingMode mode) {
+    NoteChange c;
+    c.onsetUs = stubMicros;
+    c.sensor = s;
+    c.off = channels[s].playing;
+    c.offChannel = channels[s].midiChannel;
+    c.on.fromChord(channels[s].chords[colorIndex], mode, 1 + colorIndex % VOICING_MAX_NOTES);
+    c.onChannel = channels[s].midiChannel;
+    c.velocity = 100;
+    c.arpeggio = (mode == VOICING_ARPEGGIO);
+    noteOutput.change(c, stubMicros);
+    channels[s].playing = c.on;
+    channels[s].currentColor = indexToColor(colorIndex);
+}
+
+// Let the output catch up (arpeggio steps included) and compare both ends
+static void checkSettled() {
+    noteOutput.flush();
+    runMidi(midiTx, (VOICING_MAX_NOTES + 1) * VOICING_ARP_STEP_MS * 1000UL);
+    synth.read(port.bytes);
+
+    uint8_t owners[16][128] = {{0}};
+    for (uint8_t s = 0; s < SENSORS; s++) {
+        for (uint8_t v = 0; v < channels[s].playing.count; v++) {
+            owners[channels[s].midiChannel - 1][channels[s].playing.notes[v]]++;
+        }
+    }
+    for (uint8_t c = 0; c < 16; c++) {
+        for (uint8_t note = 0; note < 128; note++) {
+            TEST_ASSERT_EQUAL_UINT8(owners[c][note], activeNotes.owners(c + 1, note));
+            TEST_ASSERT_EQUAL(owners[c][note] > 0, synth.held[c][note]);
+        }
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_synth_holds_exactly_the_sounding_notes() {
+    std::mt19937 rng(1);
+    midiTx.setArpeggio(VOICING_ARP_STEP_MS);
+    for (uint8_t s = 0; s < SENSORS; s++) {
+        // Same notes on every ring, two channels: plenty of shared notes
+        channels[s].midiChannel = 1 + s % 2;
+        ScaleManager::buildChordTable(ScaleManager::MAJOR, 60, 4, channels[s].chords);
+    }
+
+    uint16_t backedUp = 0; // steps left with the transmit task held off
+    for (uint32_t step = 0; step < STEPS; step++) {
+        uint8_t s = rng() % SENSORS;
+        uint8_t op = rng() % 100;
+        if (op < 20) {
+            uint8_t colorIndex = rng() % NUM_COLORS;
+            noteBurst.sensorRead(s);
+            if (indexToColor(colorIndex) != channels[s].currentColor) {
+                change(s, colorIndex, (VoicingMode)(rng() % 3));
+            }
+        } else if (op < 22) {
+            uint8_t midiChannel = 1 + rng() % 3;
+            if (midiChannel != channels[s].midiChannel) {
+                noteOutput.releaseSensor(channels[s]); // as main.cpp's releaseSensorNotes()
+                channels[s].midiChannel = midiChannel;
+            }
+        } else if (op < 23) {
+            noteOutput.panic(channels, SENSORS);
+        } else if (op < 25 && backedUp == 0) {
+            backedUp = 1 + rng() % 40;
+        } else {
+            noteOutput.service(stubMicros, SENSORS);
+        }
+
+        // Held off until a full round of changes might not fit the rings
+        uint16_t room = MIDI_TX_QUEUE_LENGTH - SENSORS * 2 * VOICING_MAX_NOTES;
+        if (midiTx.depth(MIDI_PRIORITY_URGENT) >= room || midiTx.depth(MIDI_PRIORITY_NOTE) >= room) {
+            backedUp = 0;
+        }
+        if (backedUp > 0) {
+            backedUp--;
+            stubMicros += STEP_US;
+        } else {
+            runMidi(midiTx, STEP_US, 40);
+        }
+
+        if (step % 1000 == 999) {
+            checkSettled();
+            port.clear();
+            synth.rewind();
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.dropped(MIDI_PRIORITY_URGENT));
+    TEST_ASSERT_EQUAL_UINT32(0, midiTx.dropped(MIDI_PRIORITY_NOTE));
+    TEST_ASSERT_GREATER_THAN(0, midiTx.staleNoteOns()); // the backed-up runs did overtake
+
+    for (uint8_t s = 0; s < SENSORS; s++) {
+        noteOutput.releaseSensor(channels[s]);
+    }
+    checkSettled();
+    TEST_ASSERT_EQUAL_UINT16(0, synth.count());
+    TEST_ASSERT_EQUAL_UINT16(0, activeNotes.count());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_synth_holds_exactly_the_sounding_notes);
+    return UNITY_END();
+}
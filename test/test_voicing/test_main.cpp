@@ -0,0 +1,216 @@
+// Chords and arpeggios: the chord tables, the bytes a chord change puts on
+// the wire through NoteOutput and the transmit queue, and how long it takes
+#include <unity.h>
+#include "FakeMidiPort.h"
+#include "ActiveNotes.h"
+#include "NoteOutput.h"
+#include "ScaleManager.h"
+#include "SensorChannel.h"
+
+static FakeMidiPort port;
+static MidiEncoder encoder(port);
+static MidiTxQueue midiTx(port, encoder);
+static ActiveNotes activeNotes;
+static NoteBurst noteBurst;
+static NoteOutput noteOutput(midiTx, activeNotes, noteBurst);
+static SensorChannel channels[4];
+
+// Sensor `s` sees `color`, as main.cpp's note path hands it to NoteOutput
+static void change(uint8_t s, Color color, VoicingMode mode, uint8_t size) {
+    NoteChange c;
+    c.onsetUs = stubMicros;
+    c.sensor = s;
+    c.off = channels[s].playing;
+    c.offChannel = channels[s].midiChannel;
+    c.on.fromChord(channels[s].chords[colorToIndex(color)], mode, size);
+    c.onChannel = channels[s].midiChannel;
+    c.velocity = 127;
+    c.arpeggio = (mode == VOICING_ARPEGGIO);
+    noteOutput.change(c, stubMicros);
+    channels[s].playing = c.on;
+}
+
+static void silenceAll() {
+    for (uint8_t s = 0; s < 4; s++) {
+        change(s, Color::WHITE, VOICING_CHORD, 4);
+    }
+    noteOutput.flush();
+    runMidi(midiTx, 100000);
+    port.clear();
+}
+
+static void assertWire(const std::vector<uint8_t>& expected) {
+    TEST_ASSERT_EQUAL_UINT32(expected.size(), port.bytes.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), port.bytes.data(), expected.size());
+    port.clear();
+}
+
+static uint16_t statusBytes() {
+    uint16_t n = 0;
+    for (uint8_t b : port.bytes) {
+        n += (b & 0x80) ? 1 : 0;
+    }
+    return n;
+}
+
+void setUp() {
+    silenceAll(); // on the channels the last test left
+    for (uint8_t s = 0; s < 4; s++) {
+        channels[s].midiChannel = 1 + s;
+    }
+}
+
+void tearDown() {}
+
+void test_chord_table_stacks_scale_thirds() {
+    const uint8_t red[4] = {60, 64, 67, 71};
+    const uint8_t color6[4] = {71, 74, 77, 81};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(red, channels[0].chords[0], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(color6, channels[0].chords[6], 4);
+    for (uint8_t c = 0; c < NUM_COLORS; c++) {
+        TEST_ASSERT_EQUAL_UINT8(channels[0].notes[c], channels[0].chords[c][0]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(SensorChannel::NO_NOTE, channels[0].chords[colorToIndex(Color::WHITE)][0]);
+
+    // B in octave 8 is note 119: chord notes past 127 are left out
+    uint8_t high[NUM_COLORS][VOICING_MAX_NOTES];
+    ScaleManager::buildChordTable(ScaleManager::MAJOR, 71, 8, high);
+    TEST_ASSERT_EQUAL_UINT8(127, high[6][0]);
+    TEST_ASSERT_EQUAL_UINT8(SensorChannel::NO_NOTE, high[6][1]);
+}
+
+void test_chord_change_is_one_run() {
+    encoder.resetRunningStatus();
+    change(0, Color::RED, VOICING_CHORD, 3);
+    noteOutput.flush();
+    runMidi(midiTx, 20000);
+    assertWire({0x90, 60, 127, 64, 127, 67, 127});
+
+    // The offs (velocity-0 note-ons) and the next chord share the status byte
+    change(0, Color::GREEN, VOICING_CHORD, 3);
+    noteOutput.flush();
+    runMidi(midiTx, 20000);
+    assertWire({60, 0, 64, 0, 67, 0, 62, 127, 65, 127, 69, 127});
+
+    change(0, Color::WHITE, VOICING_CHORD, 3);
+    noteOutput.flush();
+    runMidi(midiTx, 20000);
+    assertWire({62, 0, 65, 0, 69, 0});
+}
+
+// Every ring changes at once, each from one seventh chord to another
+static uint32_t worstCaseChange() {
+    for (uint8_t s = 0; s < 4; s++) {
+        change(s, indexToColor(s), VOICING_CHORD, 4);
+    }
+    noteOutput.flush();
+    runMidi(midiTx, 100000);
+    port.clear();
+
+    uint32_t startUs = stubMicros;
+    for (uint8_t s = 0; s < 4; s++) {
+        change(s, indexToColor(s + 1), VOICING_CHORD, 4);
+    }
+    noteOutput.flush();
+    runMidi(midiTx, 100000);
+    return port.idleAtUs() - startUs;
+}
+
+void test_worst_case_wire_time_four_channels() {
+    uint32_t wireUs = worstCaseChange();
+    // Per channel: a status byte, four offs, a status byte, four ons
+    TEST_ASSERT_EQUAL_UINT16(8, statusBytes());
+    TEST_ASSERT_EQUAL_UINT32(2 * 4 * (1 + 4 * 2), port.bytes.size());
+    // Back to back on the wire: 72 bytes, 23 ms
+    TEST_ASSERT_UINT_WITHIN(100, port.bytes.size() * MIDI_BYTE_US, wireUs);
+    TEST_ASSERT_EQUAL_UINT16(16, activeNotes.count());
+}
+
+void test_worst_case_wire_time_one_channel() {
+    for (uint8_t s = 0; s < 4; s++) {
+        channels[s].midiChannel = 1;
+    }
+    uint32_t wireUs = worstCaseChange();
+    // One run, and notes the rings share are switched off once, by the last
+    // ring to let go
+    TEST_ASSERT_LESS_OR_EQUAL(1, statusBytes());
+    TEST_ASSERT_LESS_OR_EQUAL(1 + 4 * 4 * 2 * 2, port.bytes.size());
+    TEST_ASSERT_UINT_WITHIN(100, port.bytes.size() * MIDI_BYTE_US, wireUs);
+    for (uint8_t s = 0; s < 4; s++) {
+        for (uint8_t v = 0; v < channels[s].playing.count; v++) {
+            TEST_ASSERT_TRUE(activeNotes.isOn(1, channels[s].playing.notes[v]));
+        }
+    }
+}
+
+void test_arpeggio_steps_keep_time() {
+    midiTx.setArpeggio(VOICING_ARP_STEP_MS);
+    change(0, Color::RED, VOICING_ARPEGGIO, 4);
+    noteOutput.flush();
+    uint32_t firstUs = stubMicros;
+    runMidi(midiTx, 300000);
+
+    std::vector<uint32_t> onsUs;
+    for (size_t i = 0; i < port.bytes.size(); i++) {
+        if (port.bytes[i] == 127) {
+            onsUs.push_back(port.startUs[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, onsUs.size());
+    for (size_t i = 1; i < onsUs.size(); i++) {
+        int32_t slotUs = (int32_t)(onsUs[i] - firstUs) - (int32_t)(i * VOICING_ARP_STEP_MS * 1000UL);
+        TEST_ASSERT_INT_WITHIN(GATE_TICK_US, 0, slotUs);
+    }
+}
+
+void test_color_change_cancels_remaining_steps() {
+    midiTx.setArpeggio(VOICING_ARP_STEP_MS);
+    change(0, Color::GREEN, VOICING_ARPEGGIO, 4);
+    noteOutput.flush();
+    runMidi(midiTx, VOICING_ARP_STEP_MS * 1000UL + 10000);
+    change(0, Color::WHITE, VOICING_ARPEGGIO, 4);
+    noteOutput.flush();
+    runMidi(midiTx, 300000);
+
+    uint8_t sounded = 0;
+    for (size_t i = 0; i < port.bytes.size(); i++) {
+        sounded += (port.bytes[i] == 127) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL_UINT8(2, sounded);
+    TEST_ASSERT_EQUAL_UINT16(0, activeNotes.count());
+}
+
+void test_gate_mode_notes_end_on_their_own() {
+    midiTx.setGate(50, 0, GATE_RATCHET_MS);
+    encoder.resetRunningStatus();
+    change(0, Color::RED, VOICING_CHORD, 3);
+    noteOutput.flush();
+    TEST_ASSERT_EQUAL_UINT16(0, activeNotes.count()); // never tracked
+    runMidi(midiTx, 100000);
+    assertWire({0x90, 60, 127, 64, 127, 67, 127, 60, 0, 64, 0, 67, 0});
+
+    // The color change has nothing left to switch off
+    change(0, Color::GREEN, VOICING_CHORD, 3);
+    noteOutput.flush();
+    runMidi(midiTx, 20000);
+    assertWire({62, 127, 65, 127, 69, 127});
+    runMidi(midiTx, 100000);
+    midiTx.setGate(0, 0, GATE_RATCHET_MS);
+    port.clear();
+}
+
+int main() {
+    for (uint8_t s = 0; s < 4; s++) {
+        ScaleManager::buildChordTable(ScaleManager::MAJOR, 60, 4, channels[s].chords);
+        ScaleManager::buildNoteTable(ScaleManager::MAJOR, 60, 4, channels[s].notes);
+    }
+    UNITY_BEGIN();
+    RUN_TEST(test_chord_table_stacks_scale_thirds);
+    RUN_TEST(test_chord_change_is_one_run);
+    RUN_TEST(test_worst_case_wire_time_four_channels);
+    RUN_TEST(test_worst_case_wire_time_one_channel);
+    RUN_TEST(test_arpeggio_steps_keep_time);
+    RUN_TEST(test_color_change_cancels_remaining_steps);
+    RUN_TEST(test_gate_mode_notes_end_on_their_own);
+    return UNITY_END();
+}
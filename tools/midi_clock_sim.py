@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Host simulation of MIDI clock output timing: 24 ticks per quarter note on the
+same 31250-baud wire as the notes and CCs.
+
+Two ways of producing the tick:
+
+  loop   loop() notices the tick is due (millis()) and queues it as an urgent
+         message; it waits for whatever loop() is doing (sensor reads, an
+         OLED frame) and then for the bytes already in the UART FIFO
+  timer  a hardware timer interrupt hands it to the transmit task, which
+         sends it ahead of everything queued; MIDI_CLOCK_GUARD_US before each
+         tick nothing else is started that would still be on the wire
+
+and prints, for each, how far the start bit of every tick is from the ideal
+grid and from the previous tick, plus what the guard costs the notes (note-on
+latency, queued until the last byte is on the wire).
+
+This is a model; test/test_midi_clock (pio test -e native) runs the real
+MidiTxQueue drain and clock guard against a modelled UART FIFO.
+
+The loop() model: each pass takes 0.3-1.5 ms (one sensor read), and every
+--render-ms on average an OLED frame blocks it for --frame-ms (a full SH1106
+frame at 400 kHz is ~25 ms).
+
+    python3 tools/midi_clock_sim.py                 # 120 BPM, 32 CC streams
+    python3 tools/midi_clock_sim.py --bpm 180 --streams 8 --sensors 16
+"""
+import argparse
+import random
+from collections import deque
+
+BYTE_US = 320          # MIDI_BYTE_US
+FIFO_SIZE = 128        # MIDI_TX_FIFO_SIZE
+FIFO_LEAD = 6          # MIDI_TX_FIFO_LEAD_BYTES
+QUEUE_LENGTH = 64      # MIDI_TX_QUEUE_LENGTH
+CC_SLOTS = 32          # MIDI_TX_CC_SLOTS
+CC_SHARE = 0.50        # MIDI_TX_CC_SHARE_PERCENT
+CC_BURST_BYTES = 12    # MIDI_TX_CC_BURST_BYTES
+GUARD_US = 100         # MIDI_CLOCK_GUARD_US
+STEP_US = 10           # simulation step
+ISR_US = (1, 5)        # timer alarm -> tick pending in the queue
+
+
+class Wire:
+    def __init__(self):
+        self.fifo = 0
+        self.credit = 0.0
+        self.last_status = None
+
+    def tick(self, us):
+        self.credit += us
+        while self.credit >= BYTE_US:
+            self.credit -= BYTE_US
+            if self.fifo > 0:
+                self.fifo -= 1
+        if self.fifo == 0:
+            self.credit = 0.0  # an idle wire starts the next byte at once
+
+    def start_of_next(self, now):
+        # when a byte written now starts: after everything in the FIFO
+        return now + max(0.0, self.fifo * BYTE_US - self.credit)
+
+    def send(self, status):
+        n = 2 if status == self.last_status else 3
+        self.last_status = status
+        self.fifo += n
+        return n
+
+    def send_realtime(self):
+        self.fifo += 1  # leaves running status alone
+        return 1
+
+
+def percentile(values, q):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def simulate(args, timer):
+    rng = random.Random(args.seed)
+    wire = Wire()
+    period = 60e6 / (args.bpm * 24)
+    offs, ons, urgent_ticks = deque(), deque(), deque()
+    cc_slots, slot_order = {}, deque()
+    tokens = CC_BURST_BYTES * BYTE_US
+    note_lat, starts = [], []
+
+    sensor_next = [rng.uniform(0, args.change_ms * 1000) for _ in range(args.sensors)]
+    cc_period = 1e6 / args.cc_hz
+    cc_next = [rng.uniform(0, cc_period) for _ in range(args.streams)]
+    next_tick = period      # ideal time of the next tick
+    tick_index = 1
+    isr_pending = deque()   # ticks raised by the interrupt, waiting for the task
+    loop_free_at = 0.0      # loop(): busy until then
+    end = args.seconds * 1e6
+    now = 0.0
+    while now < end:
+        # producers: sensors and CCs only get through when loop() does
+        if now >= loop_free_at:
+            for s in range(args.sensors):
+                if now >= sensor_next[s]:
+                    sensor_next[s] += rng.expovariate(1.0 / (args.change_ms * 1000))
+                    if len(offs) < QUEUE_LENGTH:
+                        offs.append((0x90 | (s % 16), now))
+                    if len(ons) < QUEUE_LENGTH:
+                        ons.append((0x90 | (s % 16), now))
+            for c in range(args.streams):
+                if now >= cc_next[c]:
+                    cc_next[c] += cc_period
+                    key = (c % 16, c // 16)
+                    if key not in cc_slots and len(cc_slots) < CC_SLOTS:
+                        slot_order.append(key)
+                    if key in slot_order:
+                        cc_slots[key] = (0xB0 | key[0], now)
+            if not timer and now >= next_tick:
+                urgent_ticks.append(next_tick)
+                next_tick = tick_index * period + period
+                tick_index += 1
+            loop_free_at = now + rng.uniform(300, 1500)
+            if rng.random() < (loop_free_at - now) / (args.render_ms * 1000):
+                loop_free_at += args.frame_ms * 1000
+
+        if timer and now + STEP_US > next_tick:
+            isr_pending.append((next_tick, next_tick + rng.uniform(*ISR_US)))
+            next_tick = tick_index * period + period
+            tick_index += 1
+
+        # transmit task
+        tokens = min(tokens + STEP_US * CC_SHARE, CC_BURST_BYTES * BYTE_US)
+        while True:
+            if timer and isr_pending and wire.fifo < FIFO_SIZE:
+                ideal, pending_at = isr_pending.popleft()
+                starts.append((ideal, wire.start_of_next(pending_at)))
+                wire.send_realtime()
+                continue
+            if timer:
+                until = next_tick - now
+                if -GUARD_US < until < (wire.fifo + 3) * BYTE_US + GUARD_US:
+                    break
+            if urgent_ticks and wire.fifo < FIFO_SIZE:
+                ideal = urgent_ticks.popleft()
+                starts.append((ideal, wire.start_of_next(now)))
+                wire.send_realtime()
+                continue
+            if offs and wire.fifo <= FIFO_SIZE - 3:
+                status, queued = offs.popleft()
+                n = wire.send(status)
+            elif wire.fifo > FIFO_LEAD:
+                break
+            elif ons:
+                status, queued = ons.popleft()
+                n = wire.send(status)
+                note_lat.append(now - queued + wire.fifo * BYTE_US)
+            elif slot_order and tokens >= 3 * BYTE_US:
+                key = slot_order.popleft()
+                status, _ = cc_slots.pop(key)
+                n = wire.send(status)
+            else:
+                break
+            tokens = max(tokens - n * BYTE_US, -CC_BURST_BYTES * BYTE_US)
+
+        wire.tick(STEP_US)
+        now += STEP_US
+
+    offset = [start - ideal for ideal, start in starts]
+    spacing = [abs((b[1] - a[1]) - period) for a, b in zip(starts, starts[1:])]
+    return {
+        "ticks": len(starts),
+        "late_p99": percentile(offset, 0.99),
+        "late_max": max(offset, default=0),
+        "jit_p99": percentile(spacing, 0.99),
+        "jit_max": max(spacing, default=0),
+        "on_p99": percentile(note_lat, 0.99) / 1000,
+        "on_max": max(note_lat, default=0) / 1000,
+    }
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--bpm", type=float, default=120)
+    p.add_argument("--streams", type=int, default=32, help="CC streams (channel, controller)")
+    p.add_argument("--cc-hz", type=float, default=50, help="updates per second per CC stream")
+    p.add_argument("--sensors", type=int, default=4)
+    p.add_argument("--change-ms", type=float, default=100, help="mean time between color changes per sensor")
+    p.add_argument("--render-ms", type=float, default=200, help="mean time between OLED frames")
+    p.add_argument("--frame-ms", type=float, default=25, help="loop() blocked per OLED frame")
+    p.add_argument("--seconds", type=float, default=20)
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    print("                 tick late us     period error us    note-on ms")
+    print(" mode    ticks     p99     max       p99     max      p99    max")
+    for timer in (False, True):
+        r = simulate(args, timer)
+        print(f" {'timer' if timer else 'loop':6s} {r['ticks']:6d} {r['late_p99']:7.0f} {r['late_max']:7.0f} "
+              f"{r['jit_p99']:9.0f} {r['jit_max']:7.0f} {r['on_p99']:8.1f} {r['on_max']:6.1f}")
+
+
+if __name__ == "__main__":
+    main()
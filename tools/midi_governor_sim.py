@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Host simulation of the MIDI transmit queue under load: note changes from the
+sensors plus continuous controllers, all on one 31250-baud output.
+
+Runs the same drain rules as MidiTxQueue::drainOnce (note-offs first and only
+needing FIFO room, note-ons once the FIFO is down to the lead, CCs last) twice:
+
+  fifo      CCs in a plain queue of MIDI_TX_QUEUE_LENGTH, every value sent
+  governor  CCs coalesced per (channel, controller) and paid for from a token
+            bucket that note traffic also drains
+
+and prints note latency (queued until the last byte is on the wire) and how
+old the CC value is when its last byte is on the wire, i.e. how far behind
+the controller the receiver is.
+
+    python3 tools/midi_governor_sim.py                 # 4, 16, 32 CC streams
+    python3 tools/midi_governor_sim.py 8 32 --cc-hz 100 --sensors 16
+"""
+import argparse
+import random
+from collections import deque
+
+BYTE_US = 320          # MIDI_BYTE_US
+FIFO_SIZE = 128        # MIDI_TX_FIFO_SIZE
+FIFO_LEAD = 6          # MIDI_TX_FIFO_LEAD_BYTES
+QUEUE_LENGTH = 64      # MIDI_TX_QUEUE_LENGTH
+CC_SLOTS = 32          # MIDI_TX_CC_SLOTS
+CC_SHARE = 0.50        # MIDI_TX_CC_SHARE_PERCENT
+CC_BURST_BYTES = 12    # MIDI_TX_CC_BURST_BYTES
+STEP_US = 100          # drain task wake-up granularity
+
+
+class Wire:
+    def __init__(self):
+        self.fifo = 0
+        self.credit = 0.0
+        self.last_status = None
+        self.bytes = 0
+
+    def tick(self, us):
+        self.credit += us
+        while self.credit >= BYTE_US:
+            self.credit -= BYTE_US
+            if self.fifo > 0:
+                self.fifo -= 1
+
+    def send(self, status):
+        # running status, note-off already encoded as note-on velocity 0
+        n = 2 if status == self.last_status else 3
+        self.last_status = status
+        self.fifo += n
+        self.bytes += n
+        return n
+
+
+def percentile(values, q):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def simulate(cc_streams, args, governor):
+    rng = random.Random(args.seed)
+    wire = Wire()
+    offs, ons = deque(), deque()
+    cc_fifo = deque()
+    cc_slots = {}                      # (channel, control) -> (status, latest value's us)
+    slot_order = deque()
+    tokens = CC_BURST_BYTES * BYTE_US
+    note_lat, off_lat, cc_age = [], [], []
+    cc_dropped = cc_coalesced = 0
+
+    sensor_next = [rng.uniform(0, args.change_ms * 1000) for _ in range(args.sensors)]
+    cc_period = 1e6 / args.cc_hz
+    cc_next = [rng.uniform(0, cc_period) for _ in range(cc_streams)]
+    end = args.seconds * 1e6
+    now = 0.0
+    while now < end:
+        # producers (loop())
+        for s in range(args.sensors):
+            if now >= sensor_next[s]:
+                sensor_next[s] += rng.expovariate(1.0 / (args.change_ms * 1000))
+                channel = s % 16
+                if len(offs) < QUEUE_LENGTH:
+                    offs.append((0x90 | channel, now))
+                if len(ons) < QUEUE_LENGTH:
+                    ons.append((0x90 | channel, now))
+        for c in range(cc_streams):
+            if now >= cc_next[c]:
+                cc_next[c] += cc_period
+                key = (c % 16, c // 16)
+                if not governor:
+                    if len(cc_fifo) < QUEUE_LENGTH:
+                        cc_fifo.append((0xB0 | key[0], now))
+                    else:
+                        cc_dropped += 1
+                elif key in cc_slots:
+                    cc_slots[key] = (0xB0 | key[0], now)   # newer value replaces the older
+                    cc_coalesced += 1
+                elif len(cc_slots) < CC_SLOTS:
+                    cc_slots[key] = (0xB0 | key[0], now)
+                    slot_order.append(key)
+                else:
+                    cc_dropped += 1
+
+        # drain task
+        tokens = min(tokens + STEP_US * CC_SHARE, CC_BURST_BYTES * BYTE_US)
+        while True:
+            if offs and (wire.fifo <= FIFO_SIZE - 3 if governor else wire.fifo <= FIFO_LEAD):
+                status, queued = offs.popleft()
+                n = wire.send(status)
+                off_lat.append(now - queued + wire.fifo * BYTE_US)
+            elif wire.fifo > FIFO_LEAD:
+                break
+            elif ons:
+                status, queued = ons.popleft()
+                n = wire.send(status)
+                note_lat.append(now - queued + wire.fifo * BYTE_US)
+            elif not governor and cc_fifo:
+                status, queued = cc_fifo.popleft()
+                n = wire.send(status)
+                cc_age.append(now - queued + wire.fifo * BYTE_US)
+            elif governor and slot_order and tokens >= 3 * BYTE_US:
+                key = slot_order.popleft()
+                status, queued = cc_slots.pop(key)
+                n = wire.send(status)
+                cc_age.append(now - queued + wire.fifo * BYTE_US)
+            else:
+                break
+            tokens = max(tokens - n * BYTE_US, -CC_BURST_BYTES * BYTE_US)
+
+        wire.tick(STEP_US)
+        now += STEP_US
+
+    return {
+        "off_max": max(off_lat, default=0) / 1000,
+        "on_p99": percentile(note_lat, 0.99) / 1000,
+        "on_max": max(note_lat, default=0) / 1000,
+        "cc_age": percentile(cc_age, 0.5) / 1000,
+        "cc_age_max": max(cc_age, default=0) / 1000,
+        "cc_sent": len(cc_age) / args.seconds,
+        "cc_dropped": cc_dropped / args.seconds,
+        "cc_coalesced": cc_coalesced / args.seconds,
+        "wire": wire.bytes * BYTE_US / (args.seconds * 1e6),
+    }
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("streams", nargs="*", type=int, default=[4, 16, 32], help="CC streams (channel, controller)")
+    p.add_argument("--cc-hz", type=float, default=50, help="updates per second per CC stream")
+    p.add_argument("--sensors", type=int, default=4)
+    p.add_argument("--change-ms", type=float, default=100, help="mean time between color changes per sensor")
+    p.add_argument("--seconds", type=float, default=10)
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    print("                       note-off  note-on ms      CC age ms        CCs per second         wire")
+    print(" streams  mode          max ms    p99    max    median    max     sent  dropped  merged   busy")
+    for streams in args.streams:
+        for governor in (False, True):
+            r = simulate(streams, args, governor)
+            print(f"{streams:8d}  {'governor' if governor else 'fifo':8s} {r['off_max']:10.1f} {r['on_p99']:6.1f} "
+                  f"{r['on_max']:6.1f} {r['cc_age']:9.1f} {r['cc_age_max']:6.1f} {r['cc_sent']:8.0f} "
+                  f"{r['cc_dropped']:8.0f} {r['cc_coalesced']:7.0f} {r['wire']:6.0%}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Decode a MIDI recorder dump (MidiRecorder) into a Standard MIDI File.
+
+Typing 'd' on the serial monitor makes the firmware print the capture as hex
+lines between "MIDIREC BEGIN <bytes>" and "MIDIREC END <sum>". Save the
+serial log (or pipe it in) and this picks out the last complete dump, checks
+its length and checksum, writes the .mid file and summarizes what is in it.
+With --port it sends the 'd' itself and reads the dump from the serial port
+(needs pyserial).
+
+    python3 tools/midi_record_decode.py monitor.log -o set.mid
+    python3 tools/midi_record_decode.py --port /dev/ttyUSB0 -o set.mid --list
+"""
+import argparse
+import sys
+
+
+def extract(lines):
+    """Bytes of the last complete dump in `lines`, or raise ValueError."""
+    block, expected, found = None, 0, None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("MIDIREC BEGIN"):
+            block, expected = bytearray(), int(line.split()[2])
+        elif line.startswith("MIDIREC END") and block is not None:
+            checksum = int(line.split()[2], 16)
+            if len(block) != expected:
+                raise ValueError(f"dump has {len(block)} bytes, expected {expected}")
+            if sum(block) & 0xFFFF != checksum:
+                raise ValueError(f"checksum {sum(block) & 0xFFFF:04X}, expected {checksum:04X}")
+            found, block = bytes(block), None
+        elif block is not None and line:
+            block += bytes.fromhex(line)
+    if found is None:
+        raise ValueError("no complete MIDIREC dump found")
+    return found
+
+
+def read_port(port, baud, timeout):
+    import serial  # pyserial
+    with serial.Serial(port, baud, timeout=timeout) as s:
+        s.reset_input_buffer()
+        s.write(b"d")
+        lines = []
+        while True:
+            raw = s.readline()
+            if not raw:
+                raise ValueError("timed out waiting for the dump")
+            line = raw.decode("ascii", "replace")
+            lines.append(line)
+            if line.startswith("MIDIREC END"):
+                return lines
+
+
+def read_vlq(data, i):
+    value = 0
+    while True:
+        b = data[i]
+        i += 1
+        value = (value << 7) | (b & 0x7F)
+        if not b & 0x80:
+            return value, i
+
+
+def parse_smf(data):
+    """(ticks per quarter, us per quarter, [(tick, status, data bytes)])"""
+    if data[:4] != b"MThd" or data[14:18] != b"MTrk":
+        raise ValueError("not a format 0 MIDI file")
+    division = int.from_bytes(data[12:14], "big")
+    length = int.from_bytes(data[18:22], "big")
+    track = data[22:22 + length]
+    tempo, events, tick, i, status = 500000, [], 0, 0, 0
+    while i < len(track):
+        delta, i = read_vlq(track, i)
+        tick += delta
+        if track[i] == 0xFF:
+            kind, size = track[i + 1], track[i + 2]
+            if kind == 0x51:
+                tempo = int.from_bytes(track[i + 3:i + 6], "big")
+            i += 3 + size
+            continue
+        if track[i] & 0x80:
+            status = track[i]
+            i += 1
+        n = 1 if status & 0xF0 in (0xC0, 0xD0) else 2
+        events.append((tick, status, track[i:i + n]))
+        i += n
+    return division, tempo, events
+
+
+def describe(status, data):
+    kind, channel = status & 0xF0, (status & 0x0F) + 1
+    if kind == 0x90 and data[1] > 0:
+        return f"ch{channel:<2} note on  {data[0]:3d} vel {data[1]}"
+    if kind in (0x80, 0x90):
+        return f"ch{channel:<2} note off {data[0]:3d}"
+    if kind == 0xB0:
+        return f"ch{channel:<2} CC {data[0]:3d} = {data[1]}"
+    return f"ch{channel:<2} {status:02X} " + " ".join(f"{b:02X}" for b in data)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("log", nargs="?", help="serial log holding the dump (default: stdin)")
+    p.add_argument("-o", "--output", default="recording.mid")
+    p.add_argument("--port", help="read the dump from this serial port instead")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--timeout", type=float, default=10, help="seconds without a line before giving up (--port)")
+    p.add_argument("--list", action="store_true", help="print every event")
+    args = p.parse_args()
+
+    try:
+        if args.port:
+            lines = read_port(args.port, args.baud, args.timeout)
+        elif args.log:
+            with open(args.log, encoding="ascii", errors="replace") as f:
+                lines = f.readlines()
+        else:
+            lines = sys.stdin.readlines()
+        data = extract(lines)
+        division, tempo, events = parse_smf(data)
+    except ValueError as e:
+        sys.exit(f"error: {e}")
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    ms_per_tick = tempo / division / 1000
+    seconds = events[-1][0] * ms_per_tick / 1000 if events else 0
+    notes = sum(1 for _, s, d in events if s & 0xF0 == 0x90 and d[1] > 0)
+    ccs = sum(1 for _, s, _ in events if s & 0xF0 == 0xB0)
+    channels = sorted({(s & 0x0F) + 1 for _, s, _ in events})
+    print(f"{args.output}: {len(data)} bytes, {len(events)} events over {seconds:.1f} s "
+          f"at {60e6 / tempo:.1f} BPM ({division} ticks per quarter)")
+    print(f"  {notes} note-ons, {ccs} control changes, channels {', '.join(map(str, channels)) or '-'}")
+    if args.list:
+        for tick, status, data in events:
+            print(f"  {tick * ms_per_tick / 1000:10.3f} s  {describe(status, data)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+Host simulation of the color sensor scan: per-sensor sample rate for a given
+number of sensors, using the same sweep rule as SensorScanner (a sweep starts
+at most once per integration period, one sensor read per loop() pass).
+
+Also runs the previous scheduler (library getRawData with its integration-time
+delay, a settle pass per sensor, a 50 ms gap between cycles) for comparison.
+
+With --busy K, the first K sensors change color every --change-ms and the rest
+sit still; the attention scheduler (SensorScanner::next) is then compared with
+a plain sweep on the same bus.
+
+    python3 tools/scan_rate_sim.py            # 8, 16, 32 sensors
+    python3 tools/scan_rate_sim.py 4 64 --render-hz 10
+    python3 tools/scan_rate_sim.py 32 64 --render-hz 10 --busy 4
+"""
+import argparse
+
+INTEGRATION_MS = 24.0   # SENSOR_INTEGRATION_MS
+IDLE_INTERVAL_MS = 72.0  # SCAN_IDLE_INTERVAL_MS
+MAX_INTERVAL_MS = 120.0  # SCAN_MAX_INTERVAL_MS
+HOLD_MS = 1000.0         # SCAN_ATTENTION_HOLD_MS
+BITS_PER_BYTE = 9       # 8 data bits + ACK
+
+
+def transaction_us(nbytes, bus_hz, overhead_us):
+    # start + address byte + payload + stop, plus driver setup per transaction
+    return (1 + nbytes) * BITS_PER_BYTE * 1e6 / bus_hz + 2 * 1e6 / bus_hz + overhead_us
+
+
+def new_read_us(args, mux_change):
+    t = transaction_us(1, args.bus_hz, args.txn_overhead_us)          # open mux channel
+    if mux_change:
+        t += transaction_us(1, args.bus_hz, args.txn_overhead_us)     # close previous mux
+    t += transaction_us(1, args.bus_hz, args.txn_overhead_us)         # command: CDATAL, auto-increment
+    t += transaction_us(8, args.bus_hz, args.txn_overhead_us)         # C,R,G,B burst
+    return t + args.classify_us
+
+
+def old_read_us(args):
+    t = transaction_us(1, args.bus_hz, args.txn_overhead_us)          # tcaSelect
+    for _ in range(4):                                               # read16 x4
+        t += transaction_us(1, args.bus_hz, args.txn_overhead_us)
+        t += transaction_us(2, args.bus_hz, args.txn_overhead_us)
+    return t + INTEGRATION_MS * 1000 + args.classify_us               # library delay()
+
+
+def render_us(args):
+    # SH1106: 8 pages x (3 command bytes + 132 data bytes)
+    return 8 * (transaction_us(4, args.bus_hz, args.txn_overhead_us) +
+                transaction_us(133, args.bus_hz, args.txn_overhead_us))
+
+
+def simulate(n, args, old):
+    now = 0.0                      # us
+    end = args.seconds * 1e6
+    reads = [0] * n
+    next_render = 0.0
+    render_period = 1e6 / args.render_hz if args.render_hz > 0 else None
+    sweep_start = -INTEGRATION_MS * 1000
+    cursor = 0
+    sweeping = False
+    last_cycle_end = -1e9
+
+    while now < end:
+        now += args.loop_us
+        if render_period and now >= next_render:
+            now += render_us(args)
+            next_render += render_period
+        if old:
+            # one pass selects, the next pass reads; 50 ms gap after each cycle
+            if now - last_cycle_end < 50_000:
+                continue
+            now += args.loop_us
+            now += old_read_us(args)
+            reads[cursor] += 1
+            cursor += 1
+            if cursor == n:
+                cursor = 0
+                last_cycle_end = now
+            continue
+        if not sweeping:
+            if now - sweep_start < INTEGRATION_MS * 1000:
+                continue
+            sweep_start = now
+            sweeping = True
+            cursor = 0
+        mux_change = cursor > 0 and cursor % 8 == 0
+        now += new_read_us(args, mux_change)
+        reads[cursor] += 1
+        cursor += 1
+        if cursor == n:
+            sweeping = False
+    return min(reads) / args.seconds, max(reads) / args.seconds
+
+
+def simulate_attention(n, args):
+    """Returns (Hz on busy sensors, Hz on quiet sensors, longest gap ms)."""
+    now = 0.0
+    end = args.seconds * 1e6
+    reads = [0] * n
+    last_read = [0.0] * n
+    last_change = [-1e9] * n
+    seen_flip = [0] * n
+    longest = 0.0
+    next_render = 0.0
+    render_period = 1e6 / args.render_hz if args.render_hz > 0 else None
+    last = -1
+
+    while now < end:
+        now += args.loop_us
+        if render_period and now >= next_render:
+            now += render_us(args)
+            next_render += render_period
+        best, best_score = -1, 0.0
+        for s in range(n):
+            age = (now - last_read[s]) / 1000
+            if age < INTEGRATION_MS:
+                continue
+            if age >= MAX_INTERVAL_MS:
+                score = 1000 + age
+            else:
+                since = (now - last_change[s]) / 1000
+                attention = max(0.0, 1 - since / HOLD_MS)
+                score = age / (IDLE_INTERVAL_MS - (IDLE_INTERVAL_MS - INTEGRATION_MS) * attention)
+            if score > best_score:
+                best, best_score = s, score
+        if best < 0:
+            continue
+        if reads[best]:
+            longest = max(longest, (now - last_read[best]) / 1000)
+        last_read[best] = now      # next() marks the read before it happens
+        now += new_read_us(args, last >= 0 and best // 8 != last // 8)
+        reads[best] += 1
+        last = best
+        if best < args.busy:
+            flip = int(now / 1000 / args.change_ms)
+            if flip != seen_flip[best]:
+                seen_flip[best] = flip
+                last_change[best] = now
+    busy = reads[:args.busy] or [0]
+    quiet = reads[args.busy:] or [0]
+    return min(busy) / args.seconds, min(quiet) / args.seconds, longest
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("sensors", nargs="*", type=int, default=[8, 16, 32])
+    p.add_argument("--bus-hz", type=float, default=400_000)
+    p.add_argument("--txn-overhead-us", type=float, default=60, help="ESP32 I2C driver cost per transaction")
+    p.add_argument("--classify-us", type=float, default=40, help="calibration + nearest-centroid per reading")
+    p.add_argument("--loop-us", type=float, default=20, help="rest of loop(): buttons, encoder, queue")
+    p.add_argument("--render-hz", type=float, default=0, help="full OLED refreshes per second")
+    p.add_argument("--seconds", type=float, default=10)
+    p.add_argument("--busy", type=int, default=0, help="sensors whose color keeps changing")
+    p.add_argument("--change-ms", type=float, default=100, help="time between changes on a busy sensor")
+    args = p.parse_args()
+
+    if args.busy:
+        print(f"bus {args.bus_hz / 1000:.0f} kHz, render {args.render_hz:g} Hz, "
+              f"{args.busy} busy sensors changing every {args.change_ms:g} ms")
+        print(f"{'sensors':>8} {'sweep Hz':>9} {'busy Hz':>8} {'quiet Hz':>9} {'max gap ms':>11}")
+        for n in args.sensors:
+            sweep, _ = simulate(n, args, old=False)
+            busy, quiet, gap = simulate_attention(n, args)
+            print(f"{n:>8} {sweep:>9.1f} {busy:>8.1f} {quiet:>9.1f} {gap:>11.1f}")
+        return
+
+    print(f"bus {args.bus_hz / 1000:.0f} kHz, integration {INTEGRATION_MS:.0f} ms, "
+          f"render {args.render_hz:g} Hz")
+    print(f"per-sensor read: {new_read_us(args, False):.0f} us (was {old_read_us(args) / 1000:.1f} ms)")
+    print(f"{'sensors':>8} {'Hz/sensor':>10} {'sweep ms':>9} {'old Hz/sensor':>14}")
+    for n in args.sensors:
+        lo, _ = simulate(n, args, old=False)
+        old_lo, _ = simulate(n, args, old=True)
+        print(f"{n:>8} {lo:>10.1f} {1000 / lo if lo else 0:>9.1f} {old_lo:>14.2f}")
+
+
+if __name__ == "__main__":
+    main()